@@ -0,0 +1,149 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include "RDIAsyncListener.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	AsyncListener benchmark
+
+	Measures Device::update() with a deliberately slow listener (about 20 us
+	per change, like a logger writing to a file) called inline, or through
+	an AsyncListener running on a ThreadPool with each of the queue 
+	policies. Every update brings 8 changes from 8 axes and the updates
+	are 250 us apart (a 4 kHz poll), which gives the handler just enough 
+	time to keep up on average. The queue depth and the number of dropped 
+	and coalesced changes are reported too.
+*/
+namespace
+{
+
+const unsigned int numUpdates = 1000;
+const unsigned int numChangesPerUpdate = 8;
+const double handlerSeconds = 20e-6;
+const double updatePeriodSeconds = 250e-6;
+const std::size_t queueCapacity = 1024;
+
+void spin( double seconds )
+{
+	Stopwatch stopwatch;
+	while ( stopwatch.getElapsedSeconds()<seconds )
+	{
+	}
+}
+
+class SlowListener : public RDI::Device::Listener
+{
+public:
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ ) 
+	{ 
+		spin( handlerSeconds );
+	}
+};
+
+class SlowHandler : public RDI::AsyncListener::Handler
+{
+public:
+	virtual void onObjectChanged( RDI::Device* /*device*/, const RDI::ObjectChange& /*change*/ ) 
+	{ 
+		spin( handlerSeconds );
+	}
+};
+
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device )
+{
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numChangesPerUpdate; ++j )
+			backend.setObjectData( 0, j, (i & 1) ? 1000 : 2000 );
+		Stopwatch stopwatch;
+		device->update();
+		double updateSeconds = stopwatch.getElapsedSeconds();
+		seconds += updateSeconds;
+		if ( updateSeconds<updatePeriodSeconds )
+			spin( updatePeriodSeconds - updateSeconds );
+	}
+	return seconds;
+}
+
+void run( const char* name, bool async, RDI::AsyncListener::QueuePolicy policy )
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Pad", 8, 16, 1 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	const char* policyNames[] = { "block", "drop-oldest", "coalesce" };
+	std::stringstream caseName;
+	if ( async )
+		caseName << "async " << policyNames[policy];
+	else
+		caseName << "inline";
+
+	if ( !async )
+	{
+		SlowListener listener;
+		device->addListener( &listener );
+		double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device ); } );
+		reportResult( name, caseName.str(), numUpdates, seconds );
+		device->removeListeners();
+		return;
+	}
+
+	RDI::ThreadPool threadPool( 1 );
+	SlowHandler handler;
+	RDI::AsyncListener listener( &handler, &threadPool, queueCapacity, policy );
+	device->addListener( &listener );
+	double seconds = measureBestOf( getParameters().numRuns, [&]() 
+		{
+			double elapsedSeconds = measureUpdates( backend, device );
+			listener.flush();
+			return elapsedSeconds;
+		} );
+	device->removeListeners();
+
+	reportResult( name, caseName.str(), numUpdates, seconds );
+	reportCounter( name, caseName.str() + " max queue depth", static_cast<double>(listener.getMaxQueueDepth()) );
+	reportCounter( name, caseName.str() + " handled changes", static_cast<double>(listener.getNumHandledChanges()) );
+	reportCounter( name, caseName.str() + " dropped changes", static_cast<double>(listener.getNumDroppedChanges()) );
+	reportCounter( name, caseName.str() + " coalesced changes", static_cast<double>(listener.getNumCoalescedChanges()) );
+}
+
+}
+
+void runAsyncListenerBenchmark()
+{
+	const char* name = "AsyncListener";
+	run( name, false, RDI::AsyncListener::Block );
+	run( name, true, RDI::AsyncListener::Block );
+	run( name, true, RDI::AsyncListener::DropOldest );
+	run( name, true, RDI::AsyncListener::Coalesce );
+}
@@ -0,0 +1,144 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <string>
+#include <vector>
+#include "RDIAxisFilter.h"
+
+/*
+	Axis filter benchmark
+
+	Replays a recording of jittery axes (a few counts of noise around a rest
+	position, with an occasional deliberate movement) through the filters 
+	and compares the number of change notifications an Axis would send 
+	without and with filtering. The processing time of the filter bank is 
+	reported per axis and per update.
+*/
+namespace
+{
+
+const int numAxes = 64;
+const int numUpdates = 20000;
+const int updatePeriodInMs = 4;
+const LONG minValue = 0;
+const LONG maxValue = 65535;
+
+struct Recording
+{
+	// Value of each axis at each update, stored update after update
+	std::vector<LONG>	values;
+};
+
+void recordJitter( Recording& recording )
+{
+	Random random( 27 );
+	recording.values.resize( numAxes * numUpdates );
+	for ( int axis=0; axis<numAxes; ++axis )
+	{
+		LONG rest = 32767;
+		for ( int update=0; update<numUpdates; ++update )
+		{
+			// Every 5 seconds or so, the axis is moved to a new rest position
+			if ( (update % 1250)==(axis * 17) % 1250 )
+				rest = random.nextInRange( 4000, 60000 );
+			LONG value = rest + random.nextInRange( -3, 3 );
+			recording.values[update * numAxes + axis] = value;
+		}
+	}
+}
+
+std::size_t countRawNotifications( const Recording& recording )
+{
+	std::size_t numNotifications = 0;
+	for ( int axis=0; axis<numAxes; ++axis )
+	{
+		LONG previous = recording.values[axis];
+		for ( int update=1; update<numUpdates; ++update )
+		{
+			LONG value = recording.values[update * numAxes + axis];
+			if ( value!=previous )
+				++numNotifications;
+			previous = value;
+		}
+	}
+	return numNotifications;
+}
+
+void replay( const char* name, const char* caseName, const RDI::AxisFilter& filter, const Recording& recording, std::size_t numRawNotifications )
+{
+	RDI::AxisFilterBank bank;
+	std::vector<RDI::AxisFilterBank::Id> ids( numAxes );
+	std::vector<LONG> previous( numAxes );
+	for ( int axis=0; axis<numAxes; ++axis )
+	{
+		ids[axis] = bank.addAxis( filter, minValue, maxValue, recording.values[axis] );
+		previous[axis] = recording.values[axis];
+	}
+
+	std::size_t numNotifications = 0;
+	double processingTime = 0;
+	DWORD time = 1000;
+	for ( int update=1; update<numUpdates; ++update )
+	{
+		time += updatePeriodInMs;
+		Stopwatch stopwatch;
+		for ( int axis=0; axis<numAxes; ++axis )
+		{
+			// Like DirectInput, only the values that changed produce a sample
+			LONG value = recording.values[update * numAxes + axis];
+			if ( value!=recording.values[(update-1) * numAxes + axis] )
+				bank.pushSample( ids[axis], value, time - 1 );
+		}
+		bank.process( time );
+		processingTime += stopwatch.getElapsedSeconds();
+
+		for ( int axis=0; axis<numAxes; ++axis )
+		{
+			LONG value = bank.getValue( ids[axis] );
+			if ( value!=previous[axis] )
+				++numNotifications;
+			previous[axis] = value;
+		}
+	}
+
+	reportResult( name, caseName, numAxes * numUpdates, processingTime );
+	reportCounter( name, (std::string(caseName) + " notifications (%)").c_str(), 100.0 * numNotifications / numRawNotifications );
+}
+
+}
+
+void runAxisFilterBenchmark()
+{
+	const char* name = "AxisFilter";
+
+	Recording recording;
+	recordJitter( recording );
+	std::size_t numRawNotifications = countRawNotifications( recording );
+	reportCounter( name, "unfiltered notifications", static_cast<double>(numRawNotifications) );
+
+	replay( name, "ema 5Hz", RDI::AxisFilter::exponentialMovingAverage(5.f), recording, numRawNotifications );
+	replay( name, "lowpass 5Hz", RDI::AxisFilter::lowPass(5.f), recording, numRawNotifications );
+	replay( name, "oneeuro 1Hz beta 10", RDI::AxisFilter::oneEuro(1.f, 10.f), recording, numRawNotifications );
+}
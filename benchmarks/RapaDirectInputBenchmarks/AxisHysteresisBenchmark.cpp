@@ -0,0 +1,113 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <vector>
+#include "RDIAxis.h"
+
+/*
+	Axis hysteresis benchmark
+
+	Runs a synthetic noise stream (a few counts of noise around a slowly
+	drifting position) through the change threshold of an Axis and reports
+	how many listener calls are left for various thresholds.
+*/
+namespace
+{
+
+const int numAxes = 64;
+const int numSamples = 20000;
+const int numListeners = 4;
+const LONG minValue = 0;
+const LONG maxValue = 65535;
+
+void generateNoise( std::vector<LONG>& values )
+{
+	Random random( 28 );
+	values.resize( numAxes * numSamples );
+	for ( int axis=0; axis<numAxes; ++axis )
+	{
+		int position = 32767;
+		for ( int sample=0; sample<numSamples; ++sample )
+		{
+			position += random.nextInRange( -1, 1 );
+			values[sample * numAxes + axis] = position + random.nextInRange( -4, 4 );
+		}
+	}
+}
+
+void run( const char* name, LONG threshold, const std::vector<LONG>& values, std::size_t numRawListenerCalls )
+{
+	std::vector<RDI::AxisHysteresis> hysteresis( numAxes, RDI::AxisHysteresis( minValue, maxValue, 32767 ) );
+	for ( int axis=0; axis<numAxes; ++axis )
+		hysteresis[axis].setThreshold( threshold );
+
+	std::size_t numListenerCalls = 0;
+	Stopwatch stopwatch;
+	for ( int sample=0; sample<numSamples; ++sample )
+	{
+		for ( int axis=0; axis<numAxes; ++axis )
+		{
+			if ( hysteresis[axis].update( values[sample * numAxes + axis] ) )
+				numListenerCalls += numListeners;
+		}
+	}
+	double seconds = stopwatch.getElapsedSeconds();
+
+	char caseName[64];
+	sprintf( caseName, "threshold %d", static_cast<int>(threshold) );
+	reportResult( name, caseName, numAxes * numSamples, seconds );
+	sprintf( caseName, "threshold %d listener calls (%%)", static_cast<int>(threshold) );
+	reportCounter( name, caseName, 100.0 * numListenerCalls / numRawListenerCalls );
+}
+
+}
+
+void runAxisHysteresisBenchmark()
+{
+	const char* name = "AxisHysteresis";
+
+	std::vector<LONG> values;
+	generateNoise( values );
+
+	// Without threshold, every change of value calls every listener
+	std::size_t numRawListenerCalls = 0;
+	for ( int axis=0; axis<numAxes; ++axis )
+	{
+		LONG previous = 32767;
+		for ( int sample=0; sample<numSamples; ++sample )
+		{
+			LONG value = values[sample * numAxes + axis];
+			if ( value!=previous )
+				numRawListenerCalls += numListeners;
+			previous = value;
+		}
+	}
+	reportCounter( name, "listener calls without threshold", static_cast<double>(numRawListenerCalls) );
+
+	const LONG thresholds[] = { 0, 2, 8, 32 };
+	for ( std::size_t i=0; i<sizeof(thresholds)/sizeof(thresholds[0]); ++i )
+		run( name, thresholds[i], values, numRawListenerCalls );
+}
@@ -0,0 +1,137 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	BatchListener benchmark
+
+	Compares the two ways of being notified of the changes of a Device: a
+	Device::Listener called for each change, which queries the new state of 
+	the Object, and a Device::BatchListener called once per update with the
+	array of changes. The device has 32 objects and receives full buffers 
+	of events (124 per update), each of them changing an object. Both kinds 
+	of listeners sum the new states, so they do the same work.
+*/
+namespace
+{
+
+const unsigned int numUpdates = 2000;
+const unsigned int numEntriesPerUpdate = 124;
+
+class SummingListener : public RDI::Device::Listener
+{
+public:
+	SummingListener() : mSum(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* object ) 
+	{ 
+		mSum += object->getData();
+	}
+	unsigned long long int	mSum;
+};
+
+class SummingBatchListener : public RDI::Device::BatchListener
+{
+public:
+	SummingBatchListener() : mSum(0) {}
+	virtual void onObjectsChanged( RDI::Device* /*device*/, const RDI::ObjectChange* changes, std::size_t numChanges ) 
+	{ 
+		for ( std::size_t i=0; i<numChanges; ++i )
+			mSum += changes[i].newData;
+	}
+	unsigned long long int	mSum;
+};
+
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device, Random& random )
+{
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numEntriesPerUpdate; ++j )
+		{
+			unsigned int objectIndex = random.next() % objects.size();
+			const RDI::RecordedObject& object = objects[objectIndex];
+			DWORD data = 0;
+			if ( object.objectInstance.isAxis() )
+				data = object.data==1000 ? 2000 : 1000;
+			else if ( object.objectInstance.isPOV() )
+				data = object.data==9000 ? 18000 : 9000;
+			else
+				data = object.data ? 0 : 0x80;
+			backend.setObjectData( 0, objectIndex, data );
+		}
+		Stopwatch stopwatch;
+		device->update();
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+void run( const char* name, unsigned int numListeners, bool batched )
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Pad", 8, 23, 1 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	std::vector<SummingListener> listeners( batched ? 0 : numListeners );
+	std::vector<SummingBatchListener> batchListeners( batched ? numListeners : 0 );
+	for ( std::size_t i=0; i<listeners.size(); ++i )
+		device->addListener( &listeners[i] );
+	for ( std::size_t i=0; i<batchListeners.size(); ++i )
+		device->addBatchListener( &batchListeners[i] );
+
+	Random random( 35 );
+	double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device, random ); } );
+
+	std::stringstream caseName;
+	caseName << (batched ? "batched " : "per-change ") << numListeners << " listeners";
+	reportResult( name, caseName.str(), numUpdates * numEntriesPerUpdate, seconds );
+	device->removeListeners();
+}
+
+}
+
+void runBatchListenerBenchmark()
+{
+	const char* name = "BatchListener";
+	const Parameters& parameters = getParameters();
+	for ( std::size_t i=0; i<parameters.numListeners.size(); ++i )
+	{
+		unsigned int numListeners = parameters.numListeners[i];
+		if ( numListeners==0 )
+			continue;
+		run( name, numListeners, false );
+		run( name, numListeners, true );
+	}
+}
@@ -0,0 +1,186 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include "RDITime.h"
+
+namespace
+{
+
+struct Result
+{
+	std::string		benchmarkName;
+	std::string		name;
+	bool			isCounter;
+	double			value;			// ns per operation or value of the counter
+	std::size_t		numOperations;
+	double			seconds;
+};
+
+std::vector<Result> results;
+
+void writeJSONString( FILE* file, const std::string& text )
+{
+	fputc( '"', file );
+	for ( std::size_t i=0; i<text.size(); ++i )
+	{
+		char c = text[i];
+		if ( c=='"' || c=='\\' )
+			fprintf( file, "\\%c", c );
+		else if ( static_cast<unsigned char>(c)<0x20 )
+			fprintf( file, "\\u%04x", c );
+		else
+			fputc( c, file );
+	}
+	fputc( '"', file );
+}
+
+}
+
+Parameters::Parameters()
+	: numRuns(5)
+{
+	const unsigned int defaultNumDevices[] = { 1, 4, 16 };
+	const unsigned int defaultNumObjects[] = { 8, 32, 128 };
+	const unsigned int defaultNumListeners[] = { 0, 1, 8, 64 };
+	numDevices.assign( defaultNumDevices, defaultNumDevices + sizeof(defaultNumDevices)/sizeof(defaultNumDevices[0]) );
+	numObjects.assign( defaultNumObjects, defaultNumObjects + sizeof(defaultNumObjects)/sizeof(defaultNumObjects[0]) );
+	numListeners.assign( defaultNumListeners, defaultNumListeners + sizeof(defaultNumListeners)/sizeof(defaultNumListeners[0]) );
+}
+
+Parameters& getParameters()
+{
+	static Parameters parameters;
+	return parameters;
+}
+
+Stopwatch::Stopwatch()
+	: mStartTicks(0)
+{
+	restart();
+}
+
+void Stopwatch::restart()
+{
+	mStartTicks = RDI::Time::getTimeAsTicks();
+}
+
+double Stopwatch::getElapsedSeconds() const
+{
+	unsigned long long int elapsedTicks = RDI::Time::getTimeAsTicks() - mStartTicks;
+	return static_cast<double>(elapsedTicks) / static_cast<double>(RDI::Time::getTickFrequency());
+}
+
+Random::Random( unsigned int seed )
+	: mState( seed ? seed : 1 )
+{
+}
+
+// Xorshift32, see https://en.wikipedia.org/wiki/Xorshift
+unsigned int Random::next()
+{
+	mState ^= mState << 13;
+	mState ^= mState >> 17;
+	mState ^= mState << 5;
+	return mState;
+}
+
+int Random::nextInRange( int minValue, int maxValue )
+{
+	unsigned int range = static_cast<unsigned int>(maxValue - minValue) + 1;
+	if ( range==0 )
+		return static_cast<int>( next() );
+	return minValue + static_cast<int>( next() % range );
+}
+
+float Random::nextFloat()
+{
+	return static_cast<float>( next() & 0xFFFFFF ) / static_cast<float>( 0xFFFFFF );
+}
+
+void reportResult( const char* benchmarkName, const char* caseName, std::size_t numOperations, double seconds )
+{
+	double nsPerOperation = numOperations ? (seconds * 1e9) / static_cast<double>(numOperations) : 0;
+	printf( "%-32s %-48s %12.2f ns/op (%lu ops in %.3f s)\n", benchmarkName, caseName, nsPerOperation, 
+			static_cast<unsigned long>(numOperations), seconds );
+
+	Result result;
+	result.benchmarkName = benchmarkName;
+	result.name = caseName;
+	result.isCounter = false;
+	result.value = nsPerOperation;
+	result.numOperations = numOperations;
+	result.seconds = seconds;
+	results.push_back( result );
+}
+
+void reportResult( const char* benchmarkName, const std::string& caseName, std::size_t numOperations, double seconds )
+{
+	reportResult( benchmarkName, caseName.c_str(), numOperations, seconds );
+}
+
+void reportCounter( const char* benchmarkName, const char* counterName, double value )
+{
+	printf( "%-32s %-48s %12.2f\n", benchmarkName, counterName, value );
+
+	Result result;
+	result.benchmarkName = benchmarkName;
+	result.name = counterName;
+	result.isCounter = true;
+	result.value = value;
+	result.numOperations = 0;
+	result.seconds = 0;
+	results.push_back( result );
+}
+
+void reportCounter( const char* benchmarkName, const std::string& counterName, double value )
+{
+	reportCounter( benchmarkName, counterName.c_str(), value );
+}
+
+// The format is read by compare_benchmarks.py
+bool writeResultsAsJSON( const char* fileName )
+{
+	FILE* file = fopen( fileName, "w" );
+	if ( !file )
+		return false;
+
+	fprintf( file, "{\n\t\"results\": [" );
+	for ( std::size_t i=0; i<results.size(); ++i )
+	{
+		const Result& result = results[i];
+		fprintf( file, "%s\n\t\t{ \"benchmark\": ", i>0 ? "," : "" );
+		writeJSONString( file, result.benchmarkName );
+		fprintf( file, result.isCounter ? ", \"counter\": " : ", \"case\": " );
+		writeJSONString( file, result.name );
+		if ( result.isCounter )
+			fprintf( file, ", \"value\": %.6g }", result.value );
+		else
+			fprintf( file, ", \"ns_per_op\": %.6g, \"ops\": %lu, \"seconds\": %.6g }", result.value, 
+					 static_cast<unsigned long>(result.numOperations), result.seconds );
+	}
+	fprintf( file, "\n\t]\n}\n" );
+	return fclose( file )==0;
+}
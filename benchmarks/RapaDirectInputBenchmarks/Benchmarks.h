@@ -0,0 +1,117 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+	Benchmarks
+
+	Helpers shared by the benchmarks: a stopwatch based on RDI::Time, a 
+	deterministic random number generator (so two runs process exactly 
+	the same data), the parameters given on the command line and the 
+	reporting of the results.
+*/
+class Stopwatch
+{
+public:
+	Stopwatch();
+	void					restart();
+	double					getElapsedSeconds() const;
+
+private:
+	unsigned long long int	mStartTicks;
+};
+
+class Random
+{
+public:
+	Random( unsigned int seed );
+	unsigned int			next();
+	int						nextInRange( int minValue, int maxValue );		// Both bounds included
+	float					nextFloat();									// 0..1
+
+private:
+	unsigned int			mState;
+};
+
+// The counts the hot path benchmarks iterate over (see Main.cpp for the
+// command line options that override them)
+struct Parameters
+{
+	Parameters();
+
+	std::vector<unsigned int>	numDevices;
+	std::vector<unsigned int>	numObjects;		// Per device
+	std::vector<unsigned int>	numListeners;	// Per device
+	unsigned int				numRuns;		// The best run is reported
+};
+
+Parameters& getParameters();
+
+// Run a measurement numRuns times and return the shortest time, in seconds.
+// The function returns the time it measured
+template<typename Function> double measureBestOf( unsigned int numRuns, Function function )
+{
+	double bestSeconds = 0;
+	for ( unsigned int i=0; i<numRuns; ++i )
+	{
+		double seconds = function();
+		if ( i==0 || seconds<bestSeconds )
+			bestSeconds = seconds;
+	}
+	return bestSeconds;
+}
+
+// The results are printed and kept so they can be written to a JSON file
+void reportResult( const char* benchmarkName, const char* caseName, std::size_t numOperations, double seconds );
+void reportResult( const char* benchmarkName, const std::string& caseName, std::size_t numOperations, double seconds );
+void reportCounter( const char* benchmarkName, const char* counterName, double value );
+void reportCounter( const char* benchmarkName, const std::string& counterName, double value );
+bool writeResultsAsJSON( const char* fileName );
+
+// The benchmarks
+void runStickBenchmark();
+void runAxisFilterBenchmark();
+void runAxisHysteresisBenchmark();
+void runButtonDebounceBenchmark();
+void runRecorderBenchmark();
+void runReplayBenchmark();
+void runDeviceBenchmark();
+void runDeviceManagerBenchmark();
+void runToStringBenchmark();
+void runBatchListenerBenchmark();
+void runFilteredListenerBenchmark();
+void runThrottledListenerBenchmark();
+void runAsyncListenerBenchmark();
+void runListenerRegistryBenchmark();
+void runDirtyObjectSetBenchmark();
+void runEnumerationTriggerBenchmark();
+void runPollSchedulerBenchmark();
+void runReacquireBenchmark();
+void runResyncBenchmark();
+void runDataFormatBenchmark();
+void runObjectEnableBenchmark();
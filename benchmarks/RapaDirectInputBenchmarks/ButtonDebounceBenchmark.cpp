@@ -0,0 +1,118 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <vector>
+#include "RDIButton.h"
+
+/*
+	Button debounce benchmark
+
+	Generates the events of a worn switch: each press and each release is
+	followed by a burst of bounces a few milliseconds long, and the odd 
+	glitch (a spurious press shorter than a millisecond or two) is thrown in.
+	The time for the events to go through a ButtonDebouncer is reported for
+	both modes (the presses they detect are checked by the tests).
+*/
+namespace
+{
+
+const int numPresses = 100000;
+const DWORD window = 10;
+
+struct Event
+{
+	bool	isPressed;
+	DWORD	timeStamp;
+};
+
+void generateChatter( std::vector<Event>& events )
+{
+	Random random( 29 );
+	DWORD time = 1000;
+	bool isPressed = false;
+	for ( int i=0; i<numPresses*2; ++i )
+	{
+		// The real edge, followed by bounces
+		isPressed = !isPressed;
+		Event event = { isPressed, time };
+		events.push_back( event );
+		int numBounces = random.nextInRange( 0, 4 ) * 2;
+		for ( int j=0; j<numBounces; ++j )
+		{
+			time += random.nextInRange( 0, 1 );
+			Event bounce = { (j % 2)==0 ? !isPressed : isPressed, time };
+			events.push_back( bounce );
+		}
+		
+		// Hold the state, sometimes with a glitch in the middle of a release
+		DWORD hold = static_cast<DWORD>( random.nextInRange( 40, 200 ) );
+		if ( !isPressed && random.nextInRange( 0, 9 )==0 )
+		{
+			Event glitchStart = { true, time + hold/2 };
+			Event glitchEnd = { false, time + hold/2 + 1 };
+			events.push_back( glitchStart );
+			events.push_back( glitchEnd );
+		}
+		time += hold;
+	}
+}
+
+void run( const char* name, const char* caseName, RDI::ButtonDebouncer::Mode mode, const std::vector<Event>& events )
+{
+	RDI::ButtonDebouncer debouncer( false );
+	debouncer.setWindow( window, mode );
+
+	// Like Device::update(), the debouncer is given the current time every
+	// 4 ms along with the events of the period
+	DWORD nextUpdateTime = events.front().timeStamp;
+	Stopwatch stopwatch;
+	for ( std::size_t i=0; i<events.size(); ++i )
+	{
+		const Event& event = events[i];
+		while ( static_cast<int>(event.timeStamp - nextUpdateTime)>0 )
+		{
+			debouncer.update( nextUpdateTime );
+			nextUpdateTime += 4;
+		}
+		debouncer.update( event.timeStamp );
+		debouncer.update( event.isPressed, event.timeStamp );
+	}
+	double seconds = stopwatch.getElapsedSeconds();
+
+	reportResult( name, caseName, events.size(), seconds );
+}
+
+}
+
+void runButtonDebounceBenchmark()
+{
+	const char* name = "ButtonDebounce";
+
+	std::vector<Event> events;
+	generateChatter( events );
+	
+	run( name, "leading edge 10ms", RDI::ButtonDebouncer::LeadingEdge, events );
+	run( name, "trailing edge 10ms", RDI::ButtonDebouncer::TrailingEdge, events );
+}
@@ -0,0 +1,122 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <sstream>
+#include <vector>
+#include "RDIDataFormat.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	DataFormat benchmark
+
+	The state of simulated devices of different sizes is read with the 
+	DIJOYSTATE2 layout (the c_dfDIJoystick2 format the devices used to be 
+	set to) and with the minimal DataFormat built from their objects (the 
+	one Device now sets). The size of the state and the time to read it 
+	(i.e. the GetDeviceState() copy and the decoding of every object) are 
+	reported.
+*/
+namespace
+{
+
+const unsigned int numReads = 200000;
+
+struct Layout
+{
+	unsigned int	numAxes;
+	unsigned int	numButtons;
+	unsigned int	numPOVs;
+};
+
+double run( RDI::SimulatedBackend& backend, unsigned int deviceIndex, bool isMinimal, DWORD& dataSize )
+{
+	RDI::DeviceBackend* deviceBackend = backend.createDeviceBackend( backend.getDeviceInstance( deviceIndex ) );
+	RDI::ObjectInstances objectInstances;
+	deviceBackend->enumerateObjects( objectInstances );
+	
+	RDI::DataFormat dataFormat = RDI::DataFormat::createFromOffsets( objectInstances, RDI::DataFormat::joystick2DataSize );
+	if ( isMinimal )
+	{
+		dataFormat = RDI::DataFormat::createMinimal( objectInstances );
+		deviceBackend->setDataFormat( dataFormat );
+	}
+	dataSize = dataFormat.getDataSize();
+
+	std::vector<DWORD> objectTypes;
+	for ( std::size_t i=0; i<objectInstances.size(); ++i )
+		objectTypes.push_back( objectInstances[i].getDwType() );
+	std::vector<DWORD> states( objectTypes.size() );
+	deviceBackend->acquire();
+
+	DWORD checksum = 0;
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			Stopwatch stopwatch;
+			for ( unsigned int i=0; i<numReads; ++i )
+			{
+				deviceBackend->getObjectStates( &objectTypes[0], &states[0], states.size() );
+				checksum += states[i % states.size()];
+			}
+			return stopwatch.getElapsedSeconds();
+		} );
+	if ( checksum==0xFFFFFFFF )
+		printf( "Unexpected checksum\n" );
+
+	delete deviceBackend;
+	return seconds;
+}
+
+}
+
+void runDataFormatBenchmark()
+{
+	const char* name = "DataFormat";
+
+	const Layout layouts[] = 
+	{
+		{ 2, 6, 0 },		// A basic pad
+		{ 6, 16, 1 },		// A gamepad
+		{ 8, 128, 4 }		// The largest device DIJOYSTATE2 can hold
+	};
+
+	RDI::SimulatedBackend backend;
+	for ( std::size_t i=0; i<sizeof(layouts)/sizeof(layouts[0]); ++i )
+	{
+		const Layout& layout = layouts[i];
+		unsigned int deviceIndex = backend.addDevice( "Benchmark Pad", layout.numAxes, layout.numButtons, layout.numPOVs );
+
+		std::stringstream caseName;
+		caseName << layout.numAxes << " axes " << layout.numButtons << " buttons " << layout.numPOVs << " POVs";
+		for ( int minimal=0; minimal<2; ++minimal )
+		{
+			std::string formatName = minimal ? " minimal" : " DIJOYSTATE2";
+			DWORD dataSize = 0;
+			double seconds = run( backend, deviceIndex, minimal!=0, dataSize );
+			reportResult( name, "read state " + caseName.str() + formatName, numReads, seconds );
+			reportCounter( name, caseName.str() + formatName + " state size (bytes)", dataSize );
+		}
+	}
+}
@@ -0,0 +1,194 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Device benchmark
+
+	Measures the input hot path of a Device driven by a SimulatedBackend:
+	- Device::update() with a full buffer of events (124), for various 
+	  numbers of objects per device
+	- Object::updateFrom() called directly, for each kind of object
+	- the fan-out of the changes to various numbers of Device::Listener
+	The events always change the value of their object, so each one ends up
+	notified.
+*/
+namespace
+{
+
+const unsigned int numUpdates = 1000;
+const unsigned int numEntriesPerUpdate = 124;
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener() : mNumChanges(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ ) { ++mNumChanges; }
+	unsigned long long int	mNumChanges;
+};
+
+void addDevice( RDI::SimulatedBackend& backend, unsigned int numObjects )
+{
+	unsigned int numAxes = std::min( 8u, numObjects/2 );
+	unsigned int numPOVs = numObjects>2 ? 1 : 0;
+	unsigned int numButtons = std::min( 128u, numObjects - numAxes - numPOVs );
+	backend.addDevice( "Benchmark Pad", numAxes, numButtons, numPOVs );
+}
+
+// The data that changes the value of the object
+DWORD nextData( const RDI::RecordedObject& object, unsigned int i )
+{
+	if ( object.objectInstance.isAxis() )
+		return (i & 1) ? 1000 : 2000;
+	if ( object.objectInstance.isPOV() )
+		return (i & 1) ? 9000 : 18000;
+	return (i & 1) ? 0x80 : 0;
+}
+
+// Feed full buffers of events to the Device and time its update
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device, Random& random )
+{
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numEntriesPerUpdate; ++j )
+		{
+			unsigned int objectIndex = random.next() % objects.size();
+			const RDI::RecordedObject& object = objects[objectIndex];
+			DWORD data = nextData( object, 0 );
+			backend.setObjectData( 0, objectIndex, object.data==data ? nextData( object, 1 ) : data );
+		}
+		Stopwatch stopwatch;
+		device->update();
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+void runUpdate( const char* name, unsigned int numObjects, unsigned int numListeners )
+{
+	RDI::SimulatedBackend backend;
+	addDevice( backend, numObjects );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	std::vector<CountingListener> listeners( numListeners );
+	for ( unsigned int i=0; i<numListeners; ++i )
+		device->addListener( &listeners[i] );
+
+	Random random( 33 );
+	double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device, random ); } );
+
+	std::stringstream caseName;
+	caseName << "update " << numObjects << " objects " << numListeners << " listeners";
+	reportResult( name, caseName.str(), numUpdates * numEntriesPerUpdate, seconds );
+	if ( numListeners>1 )
+	{
+		caseName << " per notification";
+		reportResult( name, caseName.str(), numUpdates * numEntriesPerUpdate * numListeners, seconds );
+	}
+	device->removeListeners();
+}
+
+void runUpdateFrom( const char* name, unsigned int numObjects )
+{
+	RDI::SimulatedBackend backend;
+	addDevice( backend, numObjects );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	const RDI::Objects& objects = device->getObjects();
+	const RDI::RecordedObjects& recordedObjects = backend.getObjects( 0 );
+
+	const char* kindNames[] = { "Axis", "Button", "POV" };
+	for ( int kind=0; kind<3; ++kind )
+	{
+		std::vector<std::pair<RDI::Object*, const RDI::RecordedObject*>> kindObjects;
+		for ( std::size_t i=0; i<objects.size(); ++i )
+		{
+			const RDI::ObjectInstance& objectInstance = objects[i]->getObjectInstance();
+			bool isKind = kind==0 ? objectInstance.isAxis() : (kind==1 ? objectInstance.isButton() : objectInstance.isPOV());
+			if ( isKind )
+				kindObjects.push_back( std::make_pair( objects[i], &recordedObjects[i] ) );
+		}
+		if ( kindObjects.empty() )
+			continue;
+
+		const unsigned int numCalls = 1000000;
+		double seconds = measureBestOf( getParameters().numRuns, [&]() 
+			{
+				DIDEVICEOBJECTDATA entry = DIDEVICEOBJECTDATA();
+				Stopwatch stopwatch;
+				for ( unsigned int i=0; i<numCalls; ++i )
+				{
+					const std::pair<RDI::Object*, const RDI::RecordedObject*>& object = kindObjects[i % kindObjects.size()];
+					entry.dwData = nextData( *object.second, i / static_cast<unsigned int>(kindObjects.size()) );
+					entry.dwTimeStamp = i;
+					object.first->updateFrom( entry );
+				}
+				return stopwatch.getElapsedSeconds();
+			} );
+
+		std::stringstream caseName;
+		caseName << "updateFrom " << kindNames[kind];
+		reportResult( name, caseName.str(), numCalls, seconds );
+	}
+}
+
+}
+
+void runDeviceBenchmark()
+{
+	const char* name = "Device";
+	const Parameters& parameters = getParameters();
+
+	// A device needs a few objects to have one of each kind
+	unsigned int numObjects = 0;
+	for ( std::size_t i=0; i<parameters.numObjects.size(); ++i )
+	{
+		unsigned int count = std::max( 4u, parameters.numObjects[i] );
+		runUpdate( name, count, 0 );
+		numObjects = std::max( numObjects, count );
+	}
+
+	// The fan-out is measured with the largest device
+	for ( std::size_t i=0; i<parameters.numListeners.size(); ++i )
+	{
+		if ( parameters.numListeners[i]>0 )
+			runUpdate( name, numObjects, parameters.numListeners[i] );
+	}
+
+	runUpdateFrom( name, numObjects );
+}
@@ -0,0 +1,195 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	DeviceManager benchmark
+
+	Measures, for various numbers of simulated devices:
+	- DeviceManager::updateDeviceList() when the list hasn't changed, which
+	  is what every WM_DEVICECHANGE or timer based enumeration costs. The
+	  number of them caught by the fingerprint check is reported too
+	- DeviceManager::updateDeviceList() when a device is plugged or 
+	  unplugged, which creates or deletes a Device and its objects
+	- the same hot-plug, applied from a DeviceChangeHint instead of an 
+	  enumeration. DeviceManager::update() is also driven by a scripted 
+	  trigger whose hints are sometimes of no use (an unknown device 
+	  arrives), and the number of targeted updates and of the fallback 
+	  enumerations are reported
+	- DeviceManager::update() when the devices have no events, i.e. the 
+	  polling cost
+*/
+namespace
+{
+
+const unsigned int numObjectsPerDevice = 32;
+
+// Fires whenever hints are queued, and passes them on
+class ScriptedHintTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	void			addHint( const RDI::DeviceChangeHint& hint )		{ mHints.push_back( hint ); }
+
+	virtual bool	enumerationNeeded()		{ return !mHints.empty(); }
+	virtual bool	getChangeHints( RDI::DeviceChangeHints& hints )
+	{
+		hints.insert( hints.end(), mHints.begin(), mHints.end() );
+		mHints.clear();
+		return true;
+	}
+
+private:
+	RDI::DeviceChangeHints	mHints;
+};
+
+void runDevices( const char* name, unsigned int numDevices )
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+		backend.addDevice( "Benchmark Pad", 8, numObjectsPerDevice - 9, 1 );
+	
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+
+	std::stringstream caseName;
+	const unsigned int numEnumerations = 2000;
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			Stopwatch stopwatch;
+			for ( unsigned int i=0; i<numEnumerations; ++i )
+				deviceManager.updateDeviceList();
+			return stopwatch.getElapsedSeconds();
+		} );
+	caseName << "updateDeviceList " << numDevices << " devices unchanged";
+	reportResult( name, caseName.str(), numEnumerations, seconds );
+	reportCounter( name, caseName.str() + " fingerprint hits", deviceManager.getNumUnchangedEnumerations() );
+
+	const unsigned int numHotPlugs = 500;
+	seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			double elapsedSeconds = 0;
+			for ( unsigned int i=0; i<numHotPlugs; ++i )
+			{
+				if ( backend.isDeviceConnected( 0 ) )
+					backend.disconnectDevice( 0 );
+				else
+					backend.connectDevice( 0 );
+				Stopwatch stopwatch;
+				deviceManager.updateDeviceList();
+				elapsedSeconds += stopwatch.getElapsedSeconds();
+			}
+			return elapsedSeconds;
+		} );
+	caseName.str( "" );
+	caseName << "updateDeviceList " << numDevices << " devices hot-plug";
+	reportResult( name, caseName.str(), numHotPlugs, seconds );
+
+	RDI::DeviceChangeHints hints( 1 );
+	hints[0].devicePath = RDI::SimulatedBackend::createDevicePath( 0 );
+	seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			double elapsedSeconds = 0;
+			for ( unsigned int i=0; i<numHotPlugs; ++i )
+			{
+				if ( backend.isDeviceConnected( 0 ) )
+				{
+					backend.disconnectDevice( 0 );
+					hints[0].type = RDI::DeviceChangeHint::Removal;
+				}
+				else
+				{
+					backend.connectDevice( 0 );
+					hints[0].type = RDI::DeviceChangeHint::Arrival;
+				}
+				Stopwatch stopwatch;
+				deviceManager.applyChangeHints( hints );
+				elapsedSeconds += stopwatch.getElapsedSeconds();
+			}
+			return elapsedSeconds;
+		} );
+	caseName.str( "" );
+	caseName << "applyChangeHints " << numDevices << " devices hot-plug";
+	reportResult( name, caseName.str(), numHotPlugs, seconds );
+
+	const unsigned int numPolls = 10000;
+	seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			Stopwatch stopwatch;
+			for ( unsigned int i=0; i<numPolls; ++i )
+				deviceManager.update();
+			return stopwatch.getElapsedSeconds();
+		} );
+	caseName.str( "" );
+	caseName << "update " << numDevices << " idle devices";
+	reportResult( name, caseName.str(), numPolls, seconds );
+
+	// One out of 4 notifications is about a device the backend doesn't know, 
+	// which needs an enumeration
+	ScriptedHintTrigger* trigger = new ScriptedHintTrigger();
+	RDI::DeviceManager hintedDeviceManager( &backend, trigger );
+	trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, "USB#UnknownDevice" ) );
+	hintedDeviceManager.update();
+	const unsigned int numNotifications = 400;
+	for ( unsigned int i=0; i<numNotifications; ++i )
+	{
+		if ( i%4==3 )
+		{
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, "USB#UnknownDevice" ) );
+		}
+		else if ( backend.isDeviceConnected( 0 ) )
+		{
+			backend.disconnectDevice( 0 );
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Removal, RDI::SimulatedBackend::createDevicePath(0) ) );
+		}
+		else
+		{
+			backend.connectDevice( 0 );
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, RDI::SimulatedBackend::createDevicePath(0) ) );
+		}
+		hintedDeviceManager.update();
+	}
+	caseName.str( "" );
+	caseName << "update " << numDevices << " devices with hints";
+	reportCounter( name, caseName.str() + " targeted updates", hintedDeviceManager.getNumTargetedUpdates() );
+	reportCounter( name, caseName.str() + " fallback enumerations", hintedDeviceManager.getNumEnumerations() );
+}
+
+}
+
+void runDeviceManagerBenchmark()
+{
+	const char* name = "DeviceManager";
+	const Parameters& parameters = getParameters();
+	for ( std::size_t i=0; i<parameters.numDevices.size(); ++i )
+	{
+		if ( parameters.numDevices[i]>0 )
+			runDevices( name, parameters.numDevices[i] );
+	}
+}
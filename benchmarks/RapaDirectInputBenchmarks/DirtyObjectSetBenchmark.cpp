@@ -0,0 +1,172 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIDirtyObjectSet.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	DirtyObjectSet benchmark
+
+	A consumer polls a device with 8 axes, 128 buttons and 4 POVs once per 
+	tick and needs the objects that changed since the previous tick. It 
+	either compares the data of every Object with the one it saw last time
+	(full scan), or fetches the marks of a DirtyObjectSet and only visits 
+	the marked objects. A few objects change per tick. The time of the 
+	consumer is measured, along with the cost the set adds to update().
+*/
+namespace
+{
+
+const unsigned int numTicks = 20000;
+
+double measureTicks( RDI::SimulatedBackend& backend, RDI::Device* device, RDI::DirtyObjectSet* dirtyObjectSet, 
+					 unsigned int numChangesPerTick, Random& random, unsigned long long int& numChanges )
+{
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	const RDI::Objects& deviceObjects = device->getObjects();
+	std::vector<DWORD> lastData( deviceObjects.size() );
+	for ( std::size_t i=0; i<deviceObjects.size(); ++i )
+		lastData[i] = deviceObjects[i]->getData();
+	RDI::DirtyObjects dirtyObjects;
+
+	double seconds = 0;
+	numChanges = 0;
+	for ( unsigned int i=0; i<numTicks; ++i )
+	{
+		for ( unsigned int j=0; j<numChangesPerTick; ++j )
+		{
+			unsigned int objectIndex = random.next() % objects.size();
+			const RDI::RecordedObject& object = objects[objectIndex];
+			DWORD data = 0;
+			if ( object.objectInstance.isAxis() )
+				data = object.data==1000 ? 2000 : 1000;
+			else if ( object.objectInstance.isPOV() )
+				data = object.data==9000 ? 18000 : 9000;
+			else
+				data = object.data ? 0 : 0x80;
+			backend.setObjectData( 0, objectIndex, data );
+		}
+		device->update();
+
+		Stopwatch stopwatch;
+		if ( dirtyObjectSet )
+		{
+			dirtyObjectSet->fetchAndClear( dirtyObjects );
+			for ( unsigned int index=dirtyObjects.findFirst(); index!=RDI::DirtyObjects::npos; index=dirtyObjects.findNext(index) )
+			{
+				lastData[index] = deviceObjects[index]->getData();
+				++numChanges;
+			}
+		}
+		else
+		{
+			for ( std::size_t index=0; index<deviceObjects.size(); ++index )
+			{
+				DWORD data = deviceObjects[index]->getData();
+				if ( data!=lastData[index] )
+				{
+					lastData[index] = data;
+					++numChanges;
+				}
+			}
+		}
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device, Random& random )
+{
+	const unsigned int numUpdates = 2000;
+	const unsigned int numEntriesPerUpdate = 124;
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numEntriesPerUpdate; ++j )
+		{
+			unsigned int objectIndex = random.next() % objects.size();
+			backend.setObjectData( 0, objectIndex, objects[objectIndex].data ? 0 : 0x80 );
+		}
+		Stopwatch stopwatch;
+		device->update();
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+}
+
+void runDirtyObjectSetBenchmark()
+{
+	const char* name = "DirtyObjectSet";
+
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Panel", 8, 128, 4 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	RDI::DirtyObjectSet dirtyObjectSet( device->getObjects().size() );
+
+	const unsigned int numChangesPerTick[] = { 1, 4, 16 };
+	for ( std::size_t i=0; i<sizeof(numChangesPerTick)/sizeof(numChangesPerTick[0]); ++i )
+	{
+		for ( int useSet=0; useSet<2; ++useSet )
+		{
+			if ( useSet )
+				device->addDirtyObjectSet( &dirtyObjectSet );
+			Random random( 40 );
+			unsigned long long int numChanges = 0;
+			double seconds = measureBestOf( getParameters().numRuns, [&]() 
+				{ 
+					return measureTicks( backend, device, useSet ? &dirtyObjectSet : NULL, numChangesPerTick[i], random, numChanges ); 
+				} );
+			if ( useSet )
+				device->removeDirtyObjectSet( &dirtyObjectSet );
+
+			std::stringstream caseName;
+			caseName << (useSet ? "dirty set " : "full scan ") << device->getObjects().size() << " objects, " << numChangesPerTick[i] << " changes/tick";
+			reportResult( name, caseName.str(), numTicks, seconds );
+			reportCounter( name, caseName.str() + " seen changes", static_cast<double>(numChanges) );
+		}
+	}
+
+	// What marking the set costs to update()
+	for ( int useSet=0; useSet<2; ++useSet )
+	{
+		if ( useSet )
+			device->addDirtyObjectSet( &dirtyObjectSet );
+		Random random( 40 );
+		double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device, random ); } );
+		if ( useSet )
+			device->removeDirtyObjectSet( &dirtyObjectSet );
+		reportResult( name, useSet ? "update with dirty set" : "update without dirty set", 2000 * 124, seconds );
+	}
+}
@@ -0,0 +1,224 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDITime.h"
+
+/*
+	EnumerationTrigger benchmark
+
+	Replays a scripted sequence of device notifications (like the 
+	WM_DEVICECHANGE messages received by the WindowsHookEnumerationTrigger)
+	against a fake clock advancing by one frame (16 ms) per call, over 2 
+	minutes: a hub with 4 controllers plugged in (a burst of 12 messages), 
+	single plugs and unplugs, and a flaky cable producing a message every 
+	100 ms for 5 seconds. The number of enumerations done with and without 
+	the DebouncedEnumerationTrigger is reported, along with the cost of a 
+	call to enumerationNeeded().
+
+	The hand-over of the ThreadedEnumerationTrigger is also measured, with a 
+	thread raising the signal like the window of the 
+	WindowsThreadEnumerationTrigger does: the cost of enumerationNeeded() 
+	when nothing happens, and the number of enumerations and of hints 
+	received when the thread sends a stream of notifications.
+*/
+namespace
+{
+
+const unsigned int frameInMs = 16;
+const unsigned int durationInMs = 120000;
+
+class FakeClock : public RDI::Clock
+{
+public:
+	FakeClock() : mTime(0) {}
+	virtual unsigned int getTimeAsMilliseconds()	{ return mTime; }
+	unsigned int	mTime;
+};
+
+// Fires at the scripted times (in ms), once per call at most for each of them
+class ScriptedTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	ScriptedTrigger( FakeClock* clock, const std::vector<unsigned int>& times ) : mClock(clock), mTimes(times), mNext(0) {}
+	virtual bool enumerationNeeded()
+	{
+		if ( mNext<mTimes.size() && mTimes[mNext]<=mClock->mTime )
+		{
+			++mNext;
+			return true;
+		}
+		return false;
+	}
+	FakeClock*					mClock;
+	std::vector<unsigned int>	mTimes;
+	std::size_t					mNext;
+};
+
+// Raises the signal with a hint for each notification from its thread, then 
+// waits to be stopped
+class NotifierThreadTrigger : public RDI::ThreadedEnumerationTrigger
+{
+public:
+	NotifierThreadTrigger( unsigned int numNotifications ) : mNumNotifications(numNotifications), mIsStopRequested(false) { start(); }
+	virtual ~NotifierThreadTrigger() { stop(); }
+
+protected:
+	virtual void run()
+	{
+		notifyStarted();
+		for ( unsigned int i=0; i<mNumNotifications; ++i )
+		{
+			getSignal().raise( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, "SIM#0" ) );
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> lock( mMutex );
+		while ( !mIsStopRequested )
+			mCondition.wait( lock );
+	}
+
+	virtual void requestStop()
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mIsStopRequested = true;
+		mCondition.notify_all();
+	}
+
+private:
+	unsigned int			mNumNotifications;
+	std::mutex				mMutex;
+	std::condition_variable	mCondition;
+	bool					mIsStopRequested;
+};
+
+void createScript( std::vector<unsigned int>& times )
+{
+	// Hub with 4 controllers: a burst of 12 messages over 80 ms
+	for ( unsigned int i=0; i<12; ++i )
+		times.push_back( 5000 + i * 7 );
+
+	// Single plugs and unplugs
+	times.push_back( 20000 );
+	times.push_back( 20010 );
+	times.push_back( 40000 );
+
+	// Flaky cable
+	for ( unsigned int time=60000; time<65000; time+=100 )
+		times.push_back( time );
+
+	// Hub unplugged
+	for ( unsigned int i=0; i<12; ++i )
+		times.push_back( 90000 + i * 5 );
+}
+
+unsigned int countEnumerations( RDI::DeviceEnumerationTrigger& trigger, FakeClock& clock )
+{
+	unsigned int numEnumerations = 0;
+	for ( clock.mTime=0; clock.mTime<durationInMs; clock.mTime+=frameInMs )
+	{
+		if ( trigger.enumerationNeeded() )
+			++numEnumerations;
+	}
+	return numEnumerations;
+}
+
+}
+
+void runEnumerationTriggerBenchmark()
+{
+	const char* name = "EnumerationTrigger";
+
+	std::vector<unsigned int> times;
+	createScript( times );
+
+	FakeClock clock;
+	ScriptedTrigger rawTrigger( &clock, times );
+	unsigned int numRawEnumerations = countEnumerations( rawTrigger, clock );
+
+	RDI::DebouncedEnumerationTrigger debouncedTrigger( new ScriptedTrigger( &clock, times ), RDI::DebouncedEnumerationTrigger::Settings(), &clock );
+	unsigned int numDebouncedEnumerations = countEnumerations( debouncedTrigger, clock );
+
+	reportCounter( name, "scripted notifications", static_cast<double>(times.size()) );
+	reportCounter( name, "raw enumerations", numRawEnumerations );
+	reportCounter( name, "debounced enumerations", numDebouncedEnumerations );
+	reportCounter( name, "debounced safety enumerations", debouncedTrigger.getNumSafetyEnumerations() );
+	reportCounter( name, "debounced avoided enumerations", debouncedTrigger.getNumAvoidedEnumerations() );
+
+	// The cost of a call when nothing happens
+	const unsigned int numCalls = 1000000;
+	double seconds = measureBestOf( getParameters().numRuns, [&]() 
+		{
+			RDI::DebouncedEnumerationTrigger trigger( new ScriptedTrigger( &clock, std::vector<unsigned int>() ), RDI::DebouncedEnumerationTrigger::Settings(), &clock );
+			Stopwatch stopwatch;
+			for ( unsigned int i=0; i<numCalls; ++i )
+			{
+				clock.mTime = i;
+				trigger.enumerationNeeded();
+			}
+			return stopwatch.getElapsedSeconds();
+		} );
+	reportResult( name, "debounced enumerationNeeded idle", numCalls, seconds );
+
+	// The threaded trigger when nothing happens, once the startup enumeration is done
+	seconds = measureBestOf( getParameters().numRuns, [&]() 
+		{
+			NotifierThreadTrigger trigger( 0 );
+			trigger.enumerationNeeded();
+			Stopwatch stopwatch;
+			for ( unsigned int i=0; i<numCalls; ++i )
+				trigger.enumerationNeeded();
+			return stopwatch.getElapsedSeconds();
+		} );
+	reportResult( name, "threaded enumerationNeeded idle", numCalls, seconds );
+
+	// A stream of notifications, polled by this thread. All the hints must get through
+	const unsigned int numNotifications = 10000;
+	NotifierThreadTrigger trigger( numNotifications );
+	RDI::DeviceChangeHints hints;
+	std::size_t numHints = 0;
+	unsigned int numThreadedEnumerations = 0;
+	unsigned int numIncompleteHints = 0;
+	while ( numHints<numNotifications )
+	{
+		if ( trigger.enumerationNeeded() )
+		{
+			++numThreadedEnumerations;
+			hints.clear();
+			if ( !trigger.getChangeHints( hints ) )
+				++numIncompleteHints;
+			numHints += hints.size();
+		}
+		std::this_thread::yield();
+	}
+	reportCounter( name, "threaded notifications", numNotifications );
+	reportCounter( name, "threaded hints received", static_cast<double>(numHints) );
+	reportCounter( name, "threaded enumerations", numThreadedEnumerations );
+	reportCounter( name, "threaded incomplete hints", numIncompleteHints );
+}
@@ -0,0 +1,177 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include <string.h>
+#include <vector>
+#include "RDIButton.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	FilteredListener benchmark
+
+	A device with 200 objects (8 axes, 188 buttons and 4 POVs) has 32 
+	listeners, each of them interested in 2 buttons only. Most of the events
+	are axis jitter, with an occasional button press or release. The 
+	listeners are either registered with an ObjectFilter selecting their 
+	buttons, or registered without filter and check the Object themselves, 
+	like client code had to do before filters existed.
+*/
+namespace
+{
+
+const unsigned int numListeners = 32;
+const unsigned int numButtonsPerListener = 2;
+const unsigned int numExtraButtons = 60;
+const unsigned int numUpdates = 2000;
+const unsigned int numEntriesPerUpdate = 124;
+const unsigned int buttonEventPeriod = 16;		// One event in 16 is a button change
+
+class ButtonListener : public RDI::Device::Listener
+{
+public:
+	ButtonListener() : mNumPresses(0), mCheckObjects(false) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* object ) 
+	{ 
+		if ( mCheckObjects )
+		{
+			unsigned int index = object->getIndex();
+			if ( index!=mObjectIndices[0] && index!=mObjectIndices[1] )
+				return;
+		}
+		if ( static_cast<RDI::Button*>(object)->isPressed() )
+			++mNumPresses;
+	}
+	unsigned int				mNumPresses;
+	bool						mCheckObjects;
+	std::vector<unsigned int>	mObjectIndices;
+};
+
+// The objects created by SimulatedBackend::createObjects() plus extra buttons 
+// to reach 200 objects
+void createObjects( RDI::RecordedObjects& objects )
+{
+	RDI::SimulatedBackend::createObjects( 8, 128, 4, objects );
+	for ( unsigned int i=0; i<numExtraButtons; ++i )
+	{
+		DIDEVICEOBJECTINSTANCE objectInstance;
+		memset( &objectInstance, 0, sizeof(objectInstance) );
+		objectInstance.dwSize = sizeof(objectInstance);
+		objectInstance.guidType = GUID_Button;
+		objectInstance.dwOfs = 176 + i;
+		objectInstance.dwType = DIDFT_PSHBUTTON | DIDFT_MAKEINSTANCE(128 + i);
+		objectInstance.wUsagePage = 0x09;
+		objectInstance.wUsage = static_cast<WORD>(129 + i);
+		RDI::RecordedObject object;
+		object.objectInstance = RDI::ObjectInstance( &objectInstance );
+		objects.push_back( object );
+	}
+}
+
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device, const std::vector<unsigned int>& axes, 
+					   const std::vector<unsigned int>& buttons, Random& random )
+{
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numEntriesPerUpdate; ++j )
+		{
+			unsigned int objectIndex = 0;
+			DWORD data = 0;
+			if ( random.next() % buttonEventPeriod==0 )
+			{
+				objectIndex = buttons[ random.next() % buttons.size() ];
+				data = objects[objectIndex].data ? 0 : 0x80;
+			}
+			else
+			{
+				objectIndex = axes[ random.next() % axes.size() ];
+				data = objects[objectIndex].data==32767 ? 32768 : 32767;
+			}
+			backend.setObjectData( 0, objectIndex, data );
+		}
+		Stopwatch stopwatch;
+		device->update();
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+void run( const char* name, bool filtered )
+{
+	RDI::SimulatedBackend backend;
+	RDI::RecordedObjects objects;
+	createObjects( objects );
+	backend.addDevice( RDI::SimulatedBackend::createDeviceInstance("Benchmark Panel", 0), objects );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	std::vector<unsigned int> axes;
+	std::vector<unsigned int> buttons;
+	const RDI::Objects& deviceObjects = device->getObjects();
+	for ( std::size_t i=0; i<deviceObjects.size(); ++i )
+	{
+		if ( deviceObjects[i]->getObjectInstance().isAxis() )
+			axes.push_back( static_cast<unsigned int>(i) );
+		else if ( deviceObjects[i]->getObjectInstance().isButton() )
+			buttons.push_back( static_cast<unsigned int>(i) );
+	}
+
+	// Each listener watches 2 buttons spread over the device
+	std::vector<ButtonListener> listeners( numListeners );
+	for ( unsigned int i=0; i<numListeners; ++i )
+	{
+		ButtonListener& listener = listeners[i];
+		for ( unsigned int j=0; j<numButtonsPerListener; ++j )
+			listener.mObjectIndices.push_back( buttons[ (i * numButtonsPerListener + j) * 3 % buttons.size() ] );
+		listener.mCheckObjects = !filtered;
+		if ( filtered )
+			device->addListener( &listener, RDI::ObjectFilter::objects(listener.mObjectIndices) );
+		else
+			device->addListener( &listener );
+	}
+
+	Random random( 36 );
+	double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device, axes, buttons, random ); } );
+
+	std::stringstream caseName;
+	caseName << (filtered ? "filtered " : "unfiltered ") << numListeners << " listeners, " << deviceObjects.size() << " objects";
+	reportResult( name, caseName.str(), numUpdates * numEntriesPerUpdate, seconds );
+	device->removeListeners();
+}
+
+}
+
+void runFilteredListenerBenchmark()
+{
+	const char* name = "FilteredListener";
+	run( name, false );
+	run( name, true );
+}
@@ -0,0 +1,148 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ListenerRegistry benchmark
+
+	Measures the cost of dispatching the changes of a Device to its 
+	listeners, which read the listener snapshot of the ListenerRegistry. 
+	Each update brings a full buffer of changes (124). The dispatch is 
+	measured alone, and while another thread keeps adding and removing a 
+	listener (every 100 us), which replaces the snapshot under the feet of
+	the dispatching thread.
+*/
+namespace
+{
+
+const unsigned int numUpdates = 2000;
+const unsigned int numEntriesPerUpdate = 124;
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener() : mNumCalls(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ ) 
+	{ 
+		++mNumCalls;
+	}
+	unsigned int	mNumCalls;
+};
+
+double measureUpdates( RDI::SimulatedBackend& backend, RDI::Device* device, Random& random )
+{
+	const RDI::RecordedObjects& objects = backend.getObjects( 0 );
+	double seconds = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		for ( unsigned int j=0; j<numEntriesPerUpdate; ++j )
+		{
+			unsigned int objectIndex = random.next() % objects.size();
+			const RDI::RecordedObject& object = objects[objectIndex];
+			DWORD data = 0;
+			if ( object.objectInstance.isAxis() )
+				data = object.data==1000 ? 2000 : 1000;
+			else if ( object.objectInstance.isPOV() )
+				data = object.data==9000 ? 18000 : 9000;
+			else
+				data = object.data ? 0 : 0x80;
+			backend.setObjectData( 0, objectIndex, data );
+		}
+		Stopwatch stopwatch;
+		device->update();
+		seconds += stopwatch.getElapsedSeconds();
+	}
+	return seconds;
+}
+
+void run( const char* name, unsigned int numListeners, bool concurrentRegistration )
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Pad", 8, 23, 1 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	std::vector<CountingListener> listeners( numListeners );
+	for ( std::size_t i=0; i<listeners.size(); ++i )
+		device->addListener( &listeners[i] );
+
+	std::atomic<bool> stopRequested( false );
+	unsigned int numRegistrations = 0;
+	std::thread registrationThread;
+	CountingListener registeredListener;
+	if ( concurrentRegistration )
+	{
+		registrationThread = std::thread( [&]() 
+			{
+				while ( !stopRequested )
+				{
+					device->addListener( &registeredListener );
+					device->removeListener( &registeredListener );
+					++numRegistrations;
+					std::this_thread::sleep_for( std::chrono::microseconds(100) );
+				}
+			} );
+	}
+
+	Random random( 39 );
+	double seconds = measureBestOf( getParameters().numRuns, [&]() { return measureUpdates( backend, device, random ); } );
+
+	if ( concurrentRegistration )
+	{
+		stopRequested = true;
+		registrationThread.join();
+	}
+
+	std::stringstream caseName;
+	caseName << numListeners << " listeners" << (concurrentRegistration ? ", concurrent registration" : "");
+	reportResult( name, caseName.str(), numUpdates * numEntriesPerUpdate, seconds );
+	if ( concurrentRegistration )
+		reportCounter( name, caseName.str() + " registrations", numRegistrations );
+	device->removeListeners();
+}
+
+}
+
+void runListenerRegistryBenchmark()
+{
+	const char* name = "ListenerRegistry";
+	const Parameters& parameters = getParameters();
+	for ( std::size_t i=0; i<parameters.numListeners.size(); ++i )
+	{
+		unsigned int numListeners = parameters.numListeners[i];
+		run( name, numListeners, false );
+		run( name, numListeners, true );
+	}
+}
@@ -0,0 +1,135 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	Usage: RapaDirectInputBenchmarks [options]
+	  --filter <text>        Only run the benchmarks whose name contains the text
+	  --json <file>          Also write the results to a JSON file (see compare_benchmarks.py)
+	  --devices <n,n,...>    The numbers of devices, objects per device and listeners
+	  --objects <n,n,...>    per device the hot path benchmarks iterate over
+	  --listeners <n,n,...>
+	  --runs <n>             The number of runs of each hot path measurement (the best is reported)
+*/
+namespace
+{
+
+struct Benchmark
+{
+	const char*		name;
+	void			(*run)();
+};
+
+const Benchmark benchmarks[] =
+{
+	{ "Stick",				runStickBenchmark },
+	{ "AxisFilter",			runAxisFilterBenchmark },
+	{ "AxisHysteresis",		runAxisHysteresisBenchmark },
+	{ "ButtonDebounce",		runButtonDebounceBenchmark },
+	{ "Recorder",			runRecorderBenchmark },
+	{ "Replay",				runReplayBenchmark },
+	{ "Device",				runDeviceBenchmark },
+	{ "DeviceManager",		runDeviceManagerBenchmark },
+	{ "ToString",			runToStringBenchmark },
+	{ "BatchListener",		runBatchListenerBenchmark },
+	{ "FilteredListener",	runFilteredListenerBenchmark },
+	{ "ThrottledListener",	runThrottledListenerBenchmark },
+	{ "AsyncListener",		runAsyncListenerBenchmark },
+	{ "ListenerRegistry",	runListenerRegistryBenchmark },
+	{ "DirtyObjectSet",		runDirtyObjectSetBenchmark },
+	{ "EnumerationTrigger",	runEnumerationTriggerBenchmark },
+	{ "PollScheduler",		runPollSchedulerBenchmark },
+	{ "Reacquire",			runReacquireBenchmark },
+	{ "Resync",				runResyncBenchmark },
+	{ "DataFormat",			runDataFormatBenchmark },
+	{ "ObjectEnable",		runObjectEnableBenchmark }
+};
+
+bool parseCounts( const char* text, std::vector<unsigned int>& counts )
+{
+	counts.clear();
+	while ( *text )
+	{
+		char* end = NULL;
+		unsigned long count = strtoul( text, &end, 10 );
+		if ( end==text || (*end!=',' && *end!=0) )
+			return false;
+		counts.push_back( static_cast<unsigned int>(count) );
+		text = *end ? end+1 : end;
+	}
+	return !counts.empty();
+}
+
+}
+
+int main( int argc, char** argv )
+{
+	const char* filter = NULL;
+	const char* jsonFileName = NULL;
+	Parameters& parameters = getParameters();
+	for ( int i=1; i<argc; ++i )
+	{
+		const char* option = argv[i];
+		const char* value = i+1<argc ? argv[i+1] : NULL;
+		bool ret = value!=NULL;
+		if ( ret && strcmp(option, "--filter")==0 )
+			filter = value;
+		else if ( ret && strcmp(option, "--json")==0 )
+			jsonFileName = value;
+		else if ( ret && strcmp(option, "--devices")==0 )
+			ret = parseCounts( value, parameters.numDevices );
+		else if ( ret && strcmp(option, "--objects")==0 )
+			ret = parseCounts( value, parameters.numObjects );
+		else if ( ret && strcmp(option, "--listeners")==0 )
+			ret = parseCounts( value, parameters.numListeners );
+		else if ( ret && strcmp(option, "--runs")==0 )
+			ret = (parameters.numRuns = static_cast<unsigned int>( atoi(value) ))>0;
+		else
+			ret = false;
+
+		if ( !ret )
+		{
+			printf( "Usage: %s [--filter <text>] [--json <file>] [--devices <n,n,...>] [--objects <n,n,...>] [--listeners <n,n,...>] [--runs <n>]\n", argv[0] );
+			return 1;
+		}
+		++i;
+	}
+
+	for ( std::size_t i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); ++i )
+	{
+		if ( !filter || strstr( benchmarks[i].name, filter ) )
+			benchmarks[i].run();
+	}
+
+	if ( jsonFileName && !writeResultsAsJSON( jsonFileName ) )
+	{
+		printf( "Can't write %s\n", jsonFileName );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIObject.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ObjectEnable benchmark
+
+	A simulated wheel (6 axes, 30 buttons and a POV) with busy axes and 
+	buttons is updated at 60 Hz for 10 seconds of simulated time, with all
+	its objects enabled, then with fewer and fewer of them. The time per 
+	update, the events read per update and the overflows of the buffer of 
+	the device are reported. A listener counts the changes, like a client 
+	would look at them.
+*/
+namespace
+{
+
+const DWORD frameInMs = 16;
+const DWORD durationInMs = 10000;
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener() : mNumChanges(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ )
+	{
+		++mNumChanges;
+	}
+	unsigned int	mNumChanges;
+};
+
+struct Result
+{
+	double			seconds;
+	unsigned int	numUpdates;
+	unsigned int	numEvents;
+	unsigned int	numOverflows;
+	unsigned int	numEnabledObjects;
+};
+
+RDI::ObjectFilter createFilter( unsigned int numEnabledAxes, unsigned int numEnabledButtons )
+{
+	if ( numEnabledAxes==0 && numEnabledButtons==0 )
+		return RDI::ObjectFilter::types( 0 );
+	
+	// The objects come in the order of the layout: the axes, then the buttons
+	std::vector<unsigned int> objectIndices;
+	for ( unsigned int i=0; i<numEnabledAxes; ++i )
+		objectIndices.push_back( i );
+	for ( unsigned int i=0; i<numEnabledButtons; ++i )
+		objectIndices.push_back( 6 + i );
+	return RDI::ObjectFilter::objects( objectIndices );
+}
+
+Result run( const RDI::ObjectFilter& filter )
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Wheel", 6, 30, 1 );
+	backend.addGenerator( 0, RDI::SimulatedGenerator::buttonStorm( 1500.f ) );
+	backend.addGenerator( 0, RDI::SimulatedGenerator::randomWalk( 4500.f, 100 ) );
+
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	device->setEnabledObjects( filter );
+	
+	CountingListener listener;
+	device->addListener( &listener );
+	backend.advance( frameInMs );
+	deviceManager.update();
+
+	Result result = Result();
+	result.seconds = 0;
+	result.numUpdates = 0;
+	result.numEvents = 0;
+	unsigned int numInitialOverflows = device->getNumOverflows();
+	for ( DWORD time=0; time<durationInMs; time+=frameInMs )
+	{
+		backend.advance( frameInMs );
+		Stopwatch stopwatch;
+		deviceManager.update();
+		result.seconds += stopwatch.getElapsedSeconds();
+		++result.numUpdates;
+		result.numEvents += device->getNumUpdateEvents();
+	}
+	result.numOverflows = device->getNumOverflows() - numInitialOverflows;
+	result.numEnabledObjects = device->getNumEnabledObjects();
+	device->removeListeners();
+	return result;
+}
+
+void report( const char* name, const RDI::ObjectFilter& filter )
+{
+	Result result = Result();
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			result = run( filter );
+			return result.seconds;
+		} );
+
+	std::stringstream caseName;
+	caseName << result.numEnabledObjects << " of 37 objects enabled";
+	reportResult( name, "update " + caseName.str(), result.numUpdates, seconds );
+	reportCounter( name, caseName.str() + " events per update", static_cast<double>(result.numEvents) / result.numUpdates );
+	reportCounter( name, caseName.str() + " overflows", result.numOverflows );
+}
+
+}
+
+void runObjectEnableBenchmark()
+{
+	const char* name = "ObjectEnable";
+
+	report( name, RDI::ObjectFilter() );
+	report( name, createFilter( 3, 15 ) );
+	report( name, createFilter( 1, 6 ) );		// A wheel with 6 mapped buttons
+	report( name, createFilter( 0, 0 ) );
+}
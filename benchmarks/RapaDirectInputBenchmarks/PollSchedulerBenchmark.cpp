@@ -0,0 +1,148 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	PollScheduler benchmark
+
+	64 simulated gamepads, of which only 4 are in use (their axes drift at
+	500 events per second), are updated at 60 Hz for 20 seconds of simulated
+	time. The time of DeviceManager::update() is reported when every device 
+	is polled at every update, with the idle backoff, and with the idle 
+	backoff and a time budget. The number of polls per update and the events
+	lost by the devices (which must stay at 0) are reported too, along with
+	the number of updates it takes, at worst, for the first event of an 
+	idle device to be seen once it is used.
+*/
+namespace
+{
+
+const unsigned int numDevices = 64;
+const unsigned int numActiveDevices = 4;
+const DWORD frameInMs = 16;
+const DWORD durationInMs = 20000;
+
+struct Result
+{
+	double					seconds;
+	unsigned int			numUpdates;
+	unsigned long long int	numPolls;
+	unsigned long long int	numDeferredPolls;
+	unsigned long long int	numLostEvents;
+	unsigned int			numSnapBackUpdates;
+};
+
+Result run( const RDI::PollScheduler::Settings& settings )
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+		backend.addDevice( "Benchmark Pad", 6, 16, 1 );
+	for ( unsigned int i=0; i<numActiveDevices; ++i )
+		backend.addGenerator( i * (numDevices / numActiveDevices), RDI::SimulatedGenerator::randomWalk( 500.f, 300 ) );
+
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.setPollSettings( settings );
+	deviceManager.update();
+
+	Result result = Result();
+	result.seconds = 0;
+	result.numUpdates = 0;
+	for ( DWORD time=0; time<durationInMs; time+=frameInMs )
+	{
+		backend.advance( frameInMs );
+		Stopwatch stopwatch;
+		deviceManager.update();
+		result.seconds += stopwatch.getElapsedSeconds();
+		++result.numUpdates;
+	}
+	result.numPolls = deviceManager.getPollScheduler().getNumPolls();
+	result.numDeferredPolls = deviceManager.getPollScheduler().getNumDeferredPolls();
+	result.numLostEvents = backend.getNumLostEvents();
+
+	// An idle device starts being used: count the updates until its event is 
+	// seen. This is done at various times of its poll interval, the worst 
+	// case is kept
+	const unsigned int idleDevice = 1;
+	const RDI::Object* object = deviceManager.getDevices()[idleDevice].second->getObjects()[0];
+	result.numSnapBackUpdates = 0;
+	for ( unsigned int i=0; i<settings.maxPollInterval; ++i )
+	{
+		// Idle again, and some more updates so the next poll comes at another time
+		for ( unsigned int j=0; j<settings.idleUpdates * 2 + i; ++j )
+		{
+			backend.advance( frameInMs );
+			deviceManager.update();
+		}
+
+		const DWORD data = 1000 + i;
+		backend.setObjectData( idleDevice, 0, data );
+		unsigned int numUpdates = 0;
+		while ( object->getData()!=data )
+		{
+			backend.advance( frameInMs );
+			deviceManager.update();
+			++numUpdates;
+		}
+		result.numSnapBackUpdates = std::max( result.numSnapBackUpdates, numUpdates );
+	}
+	return result;
+}
+
+void report( const char* name, const std::string& caseName, const RDI::PollScheduler::Settings& settings )
+{
+	Result result = Result();
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			result = run( settings );
+			return result.seconds;
+		} );
+	reportResult( name, "update " + caseName, result.numUpdates, seconds );
+	reportCounter( name, caseName + " polls per update", static_cast<double>(result.numPolls) / result.numUpdates );
+	reportCounter( name, caseName + " deferred polls", static_cast<double>(result.numDeferredPolls) );
+	reportCounter( name, caseName + " lost events", static_cast<double>(result.numLostEvents) );
+	reportCounter( name, caseName + " worst snap-back updates", result.numSnapBackUpdates );
+}
+
+}
+
+void runPollSchedulerBenchmark()
+{
+	const char* name = "PollScheduler";
+
+	RDI::PollScheduler::Settings settings;
+	report( name, "all devices", settings );
+
+	settings.idleUpdates = 30;
+	settings.maxPollInterval = 8;
+	report( name, "idle backoff", settings );
+
+	settings.budgetInUs = 5;
+	report( name, "idle backoff 5 us budget", settings );
+}
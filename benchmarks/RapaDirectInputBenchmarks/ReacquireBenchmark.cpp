@@ -0,0 +1,186 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Reacquire benchmark
+
+	16 simulated gamepads are updated at 60 Hz for 20 seconds of simulated 
+	time. During that time, following a script:
+	- 4 devices are held by another application, for 1 to 7 seconds
+	- 4 devices are unplugged for 2 to 8 seconds, but stay in the device 
+	  list (the enumeration trigger doesn't fire)
+	The devices are reacquired at every update (as before the backoff), or
+	with the default ReacquireBackoff. The time per update, the number of 
+	calls made to the device backends per update, the failed acquisitions 
+	and the longest delay between a device coming back and its 
+	reacquisition are reported.
+*/
+namespace
+{
+
+const unsigned int numDevices = 16;
+const DWORD frameInMs = 16;
+const DWORD durationInMs = 20000;
+
+// Only fires for the enumeration at startup
+class StartupTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	StartupTrigger() : mHasFired(false) {}
+	virtual bool enumerationNeeded()
+	{
+		bool ret = !mHasFired;
+		mHasFired = true;
+		return ret;
+	}
+	bool mHasFired;
+};
+
+struct Outage
+{
+	unsigned int	deviceIndex;
+	bool			isUnplugged;		// Otherwise held by another application
+	DWORD			startTime;
+	DWORD			endTime;
+};
+
+void createScript( std::vector<Outage>& outages )
+{
+	for ( unsigned int i=0; i<4; ++i )
+	{
+		Outage held = { i, false, 2000 + i * 250, 3000 + i * 2000 };
+		outages.push_back( held );
+		Outage unplugged = { 8 + i, true, 4000 + i * 100, 6000 + i * 2000 };
+		outages.push_back( unplugged );
+	}
+}
+
+struct Result
+{
+	double					seconds;
+	unsigned int			numUpdates;
+	unsigned long long int	numBackendCalls;
+	unsigned int			numFailures;
+	DWORD					maxReacquireDelay;
+};
+
+Result run( const RDI::ReacquireBackoff::Settings& settings, const std::vector<Outage>& outages )
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+		backend.addDevice( "Benchmark Pad", 6, 16, 1 );
+
+	RDI::DeviceManager deviceManager( &backend, new StartupTrigger() );
+	deviceManager.update();
+	const RDI::DeviceManager::DeviceList& devices = deviceManager.getDevices();
+	for ( std::size_t i=0; i<devices.size(); ++i )
+		devices[i].second->setReacquireSettings( settings );
+
+	Result result = Result();
+	result.seconds = 0;
+	result.numUpdates = 0;
+	result.maxReacquireDelay = 0;
+	unsigned long long int numInitialCalls = backend.getNumAcquireCalls() + backend.getNumDeviceDataCalls();
+	std::vector<bool> isReacquired( outages.size(), false );
+	for ( DWORD time=0; time<durationInMs; time+=frameInMs )
+	{
+		backend.advance( frameInMs );
+		for ( std::size_t i=0; i<outages.size(); ++i )
+		{
+			const Outage& outage = outages[i];
+			bool isOut = backend.getTime()>=outage.startTime && backend.getTime()<outage.endTime;
+			if ( outage.isUnplugged && isOut==backend.isDeviceConnected( outage.deviceIndex ) )
+			{
+				if ( isOut )
+					backend.disconnectDevice( outage.deviceIndex );
+				else
+					backend.connectDevice( outage.deviceIndex );
+			}
+			if ( !outage.isUnplugged )
+				backend.holdDevice( outage.deviceIndex, isOut );
+		}
+
+		Stopwatch stopwatch;
+		deviceManager.update();
+		result.seconds += stopwatch.getElapsedSeconds();
+		++result.numUpdates;
+
+		// The device is reacquired once it doesn't back off anymore
+		for ( std::size_t i=0; i<outages.size(); ++i )
+		{
+			const Outage& outage = outages[i];
+			if ( isReacquired[i] || backend.getTime()<outage.endTime )
+				continue;
+			if ( !devices[outage.deviceIndex].second->getReacquireBackoff().isBackingOff() )
+			{
+				isReacquired[i] = true;
+				result.maxReacquireDelay = std::max( result.maxReacquireDelay, backend.getTime() - outage.endTime );
+			}
+		}
+	}
+
+	result.numBackendCalls = backend.getNumAcquireCalls() + backend.getNumDeviceDataCalls() - numInitialCalls;
+	result.numFailures = 0;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+		result.numFailures += devices[i].second->getReacquireBackoff().getNumFailures();
+	return result;
+}
+
+void report( const char* name, const std::string& caseName, const RDI::ReacquireBackoff::Settings& settings, const std::vector<Outage>& outages )
+{
+	Result result = Result();
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			result = run( settings, outages );
+			return result.seconds;
+		} );
+	reportResult( name, "update " + caseName, result.numUpdates, seconds );
+	reportCounter( name, caseName + " backend calls per update", static_cast<double>(result.numBackendCalls) / result.numUpdates );
+	reportCounter( name, caseName + " failed acquisitions", result.numFailures );
+	reportCounter( name, caseName + " max reacquire delay (ms)", result.maxReacquireDelay );
+}
+
+}
+
+void runReacquireBenchmark()
+{
+	const char* name = "Reacquire";
+
+	std::vector<Outage> outages;
+	createScript( outages );
+
+	RDI::ReacquireBackoff::Settings settings;
+	settings.minDelayInMs = 0;
+	report( name, "every update", settings, outages );
+
+	report( name, "backoff", RDI::ReacquireBackoff::Settings(), outages );
+}
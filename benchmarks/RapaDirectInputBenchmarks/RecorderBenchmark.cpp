@@ -0,0 +1,186 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "RDIRecording.h"
+#include "RDITime.h"
+
+/*
+	Recorder benchmark
+
+	Records a synthetic input stream (the noisy axes, buttons and POV of a 
+	few gamepads) and reports the size of the recording per event and the
+	time spent on the input thread per event. The file itself is written
+	by the background thread of the RecordingWriter.
+*/
+namespace
+{
+
+const int numDevices = 4;
+const int numAxes = 6;
+const int numButtons = 12;
+const int numEvents = 1000000;
+const char* fileName = "RDIRecorderBenchmark.rdi";
+
+struct Event
+{
+	unsigned int	deviceIndex;
+	unsigned int	objectIndex;
+	DWORD			data;
+};
+
+RDI::ObjectInstance makeObjectInstance( const GUID& guidType, DWORD type, DWORD instance, DWORD offset )
+{
+	DIDEVICEOBJECTINSTANCE objectInstance;
+	memset( &objectInstance, 0, sizeof(objectInstance) );
+	objectInstance.dwSize = sizeof(objectInstance);
+	objectInstance.guidType = guidType;
+	objectInstance.dwOfs = offset;
+	objectInstance.dwType = type | DIDFT_MAKEINSTANCE(instance);
+	return RDI::ObjectInstance( &objectInstance );
+}
+
+void makeGamepad( RDI::RecordedObjects& objects )
+{
+	const GUID* axisGuids[numAxes] = { &GUID_XAxis, &GUID_YAxis, &GUID_ZAxis, &GUID_RxAxis, &GUID_RyAxis, &GUID_RzAxis };
+	for ( int i=0; i<numAxes; ++i )
+	{
+		RDI::RecordedObject object;
+		object.objectInstance = makeObjectInstance( *axisGuids[i], DIDFT_ABSAXIS, i, i*4 );
+		object.minValue = 0;
+		object.maxValue = 65535;
+		object.data = 32767;
+		objects.push_back( object );
+	}
+	for ( int i=0; i<numButtons; ++i )
+	{
+		RDI::RecordedObject object;
+		object.objectInstance = makeObjectInstance( GUID_Button, DIDFT_PSHBUTTON, i, 48+i );
+		objects.push_back( object );
+	}
+	RDI::RecordedObject pov;
+	pov.objectInstance = makeObjectInstance( GUID_POV, DIDFT_POV, 0, 32 );
+	pov.data = 0xFFFF;
+	objects.push_back( pov );
+}
+
+// Mostly axes drifting by a few counts, with the occasional button or POV change
+void generateEvents( std::vector<Event>& events )
+{
+	Random random( 30 );
+	std::vector<std::vector<DWORD>> state( numDevices, std::vector<DWORD>( numAxes + numButtons + 1, 0 ) );
+	for ( int device=0; device<numDevices; ++device )
+	{
+		for ( int axis=0; axis<numAxes; ++axis )
+			state[device][axis] = 32767;
+		state[device][numAxes + numButtons] = 0xFFFF;
+	}
+
+	events.resize( numEvents );
+	for ( int i=0; i<numEvents; ++i )
+	{
+		Event& event = events[i];
+		event.deviceIndex = random.next() % numDevices;
+		std::vector<DWORD>& values = state[event.deviceIndex];
+		unsigned int kind = random.next() % 100;
+		if ( kind<90 )
+		{
+			event.objectIndex = random.next() % numAxes;
+			int value = static_cast<int>(values[event.objectIndex]) + random.nextInRange( -64, 64 );
+			value = value<0 ? 0 : (value>65535 ? 65535 : value);
+			values[event.objectIndex] = static_cast<DWORD>(value);
+		}
+		else if ( kind<99 )
+		{
+			event.objectIndex = numAxes + random.next() % numButtons;
+			values[event.objectIndex] = values[event.objectIndex] ? 0 : 0x80;
+		}
+		else
+		{
+			event.objectIndex = numAxes + numButtons;
+			values[event.objectIndex] = values[event.objectIndex]==0xFFFF ? (random.next() % 8) * 4500 : 0xFFFF;
+		}
+		event.data = values[event.objectIndex];
+	}
+}
+
+void run( const char* name, const char* caseName, std::size_t bufferSize, const std::vector<Event>& events )
+{
+	RDI::RecordedObjects objects;
+	makeGamepad( objects );
+
+	RDI::RecordingWriter writer( bufferSize, 1000 );
+	if ( !writer.open( fileName ) )
+	{
+		printf( "%s: can't create %s\n", name, fileName );
+		return;
+	}
+
+	DIDEVICEINSTANCE rawDeviceInstance;
+	memset( &rawDeviceInstance, 0, sizeof(rawDeviceInstance) );
+	rawDeviceInstance.dwSize = sizeof(rawDeviceInstance);
+	RDI::DeviceInstance deviceInstance( &rawDeviceInstance );
+	unsigned int deviceIds[numDevices];
+	for ( int device=0; device<numDevices; ++device )
+		deviceIds[device] = writer.addDevice( deviceInstance, objects );
+
+	Stopwatch stopwatch;
+	for ( std::size_t i=0; i<events.size(); ++i )
+	{
+		const Event& event = events[i];
+		writer.changeObject( deviceIds[event.deviceIndex], event.objectIndex, event.data, RDI::Time::getTimeAsMilliseconds() );
+	}
+	double seconds = stopwatch.getElapsedSeconds();
+
+	for ( int device=0; device<numDevices; ++device )
+		writer.removeDevice( deviceIds[device] );
+	writer.close();
+	remove( fileName );
+
+	char counterName[96];
+	reportResult( name, caseName, events.size(), seconds );
+	sprintf( counterName, "%s bytes per event", caseName );
+	reportCounter( name, counterName, static_cast<double>(writer.getNumBytes()) / events.size() );
+	sprintf( counterName, "%s dropped records", caseName );
+	reportCounter( name, counterName, static_cast<double>(writer.getNumDroppedRecords()) );
+}
+
+}
+
+void runRecorderBenchmark()
+{
+	const char* name = "Recorder";
+
+	std::vector<Event> events;
+	generateEvents( events );
+	reportCounter( name, "raw DIDEVICEOBJECTDATA bytes per event", static_cast<double>(sizeof(DIDEVICEOBJECTDATA)) );
+
+	// The events are pushed much faster than any device produces them, so a 
+	// small buffer overflows and records get dropped
+	run( name, "1 MB buffer", 1024*1024, events );
+	run( name, "4 KB buffer", 4*1024, events );
+}
@@ -0,0 +1,234 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIRecording.h"
+#include "RDIReplayBackend.h"
+#include "RDITime.h"
+
+/*
+	Replay benchmark
+
+	Records a synthetic input stream, then replays it as fast as possible 
+	and reports the number of events replayed per second:
+	- decoded only, by a RecordingReader
+	- through a ReplayBackend driving the Devices of a DeviceManager, up to
+	  the notification of a Device::Listener
+	It also reports the cost of seeking to random positions of the recording.
+*/
+namespace
+{
+
+const int numDevices = 4;
+const int numAxes = 6;
+const int numButtons = 12;
+const int numEvents = 1000000;
+const int numSeeks = 1000;
+const char* fileName = "RDIReplayBenchmark.rdi";
+
+RDI::ObjectInstance makeObjectInstance( const GUID& guidType, DWORD type, DWORD instance, DWORD offset )
+{
+	DIDEVICEOBJECTINSTANCE objectInstance;
+	memset( &objectInstance, 0, sizeof(objectInstance) );
+	objectInstance.dwSize = sizeof(objectInstance);
+	objectInstance.guidType = guidType;
+	objectInstance.dwOfs = offset;
+	objectInstance.dwType = type | DIDFT_MAKEINSTANCE(instance);
+	return RDI::ObjectInstance( &objectInstance );
+}
+
+void makeGamepad( RDI::RecordedObjects& objects )
+{
+	const GUID* axisGuids[numAxes] = { &GUID_XAxis, &GUID_YAxis, &GUID_ZAxis, &GUID_RxAxis, &GUID_RyAxis, &GUID_RzAxis };
+	for ( int i=0; i<numAxes; ++i )
+	{
+		RDI::RecordedObject object;
+		object.objectInstance = makeObjectInstance( *axisGuids[i], DIDFT_ABSAXIS, i, i*4 );
+		object.minValue = 0;
+		object.maxValue = 65535;
+		object.data = 32767;
+		objects.push_back( object );
+	}
+	for ( int i=0; i<numButtons; ++i )
+	{
+		RDI::RecordedObject object;
+		object.objectInstance = makeObjectInstance( GUID_Button, DIDFT_PSHBUTTON, i, 48+i );
+		objects.push_back( object );
+	}
+}
+
+// The DeviceManager tells the devices apart by their DeviceInstance
+RDI::DeviceInstance makeDeviceInstance( int index )
+{
+	DIDEVICEINSTANCE deviceInstance;
+	memset( &deviceInstance, 0, sizeof(deviceInstance) );
+	deviceInstance.dwSize = sizeof(deviceInstance);
+	deviceInstance.guidInstance.Data1 = index + 1;
+	return RDI::DeviceInstance( &deviceInstance );
+}
+
+bool writeRecording()
+{
+	RDI::RecordedObjects objects;
+	makeGamepad( objects );
+
+	// The stream is recorded in a fraction of a second, so keyframes are written
+	// every millisecond to give the seeks something to work with
+	RDI::RecordingWriter writer( 16*1024*1024, 1 );
+	if ( !writer.open( fileName ) )
+		return false;
+
+	unsigned int deviceIds[numDevices];
+	for ( int device=0; device<numDevices; ++device )
+		deviceIds[device] = writer.addDevice( makeDeviceInstance(device), objects );
+
+	Random random( 31 );
+	std::vector<std::vector<DWORD>> state( numDevices, std::vector<DWORD>( objects.size(), 0 ) );
+	for ( int device=0; device<numDevices; ++device )
+		for ( int axis=0; axis<numAxes; ++axis )
+			state[device][axis] = 32767;
+
+	for ( int i=0; i<numEvents; ++i )
+	{
+		int device = random.next() % numDevices;
+		std::vector<DWORD>& values = state[device];
+		unsigned int objectIndex = 0;
+		if ( random.next() % 10 )
+		{
+			objectIndex = random.next() % numAxes;
+			int value = static_cast<int>(values[objectIndex]) + random.nextInRange( -64, 64 );
+			value = value<0 ? 0 : (value>65535 ? 65535 : value);
+			values[objectIndex] = static_cast<DWORD>(value);
+		}
+		else
+		{
+			objectIndex = numAxes + random.next() % numButtons;
+			values[objectIndex] = values[objectIndex] ? 0 : 0x80;
+		}
+		writer.changeObject( deviceIds[device], objectIndex, values[objectIndex], RDI::Time::getTimeAsMilliseconds() );
+	}
+
+	for ( int device=0; device<numDevices; ++device )
+		writer.removeDevice( deviceIds[device] );
+	writer.close();
+	return writer.getNumDroppedRecords()==0 && !writer.hasWriteFailed();
+}
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener() : mNumChanges(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ ) { ++mNumChanges; }
+	unsigned long long int	mNumChanges;
+};
+
+class DeviceListener : public RDI::DeviceManager::Listener
+{
+public:
+	DeviceListener( RDI::Device::Listener* listener ) : mListener(listener) {}
+	virtual void onDeviceConnected( RDI::DeviceManager* /*deviceManager*/, RDI::Device* device ) { device->addListener( mListener ); }
+	virtual void onDeviceDisconnecting( RDI::DeviceManager* /*deviceManager*/, RDI::Device* device ) { device->removeListener( mListener ); }
+	RDI::Device::Listener*	mListener;
+};
+
+void runReader( const char* name )
+{
+	RDI::MappedFile file;
+	RDI::RecordingReader reader;
+	if ( !file.open( fileName ) || !reader.open( file.getData(), file.getSize() ) )
+	{
+		printf( "%s: can't open %s\n", name, fileName );
+		return;
+	}
+
+	Stopwatch stopwatch;
+	std::size_t numChanges = 0;
+	RDI::RecordingReader::Record record;
+	while ( reader.readRecord( record ) )
+	{
+		if ( record.type==RDI::Recording::ObjectChanged )
+			++numChanges;
+	}
+	reportResult( name, "decode only", numChanges, stopwatch.getElapsedSeconds() );
+
+	// Seek to random positions, the keyframes avoid decoding from the beginning
+	unsigned long long int duration = reader.getTime();
+	Random random( 32 );
+	stopwatch.restart();
+	for ( int i=0; i<numSeeks; ++i )
+		reader.seek( static_cast<unsigned long long int>( random.nextFloat() * duration ) );
+	reportResult( name, "seek", numSeeks, stopwatch.getElapsedSeconds() );
+}
+
+void runDeviceManager( const char* name )
+{
+	RDI::ReplayBackend replay;
+	if ( !replay.open( fileName ) )
+	{
+		printf( "%s: can't open %s\n", name, fileName );
+		return;
+	}
+	replay.setSpeed( 0 );
+
+	CountingListener objectListener;
+	DeviceListener deviceListener( &objectListener );
+	RDI::DeviceManager deviceManager( &replay, new RDI::BackendEnumerationTrigger(&replay) );
+	deviceManager.addListener( &deviceListener );
+
+	Stopwatch stopwatch;
+	while ( !replay.isFinished() )
+	{
+		replay.update();
+		deviceManager.update();
+	}
+	deviceManager.update();
+	double seconds = stopwatch.getElapsedSeconds();
+
+	reportResult( name, "through DeviceManager", static_cast<std::size_t>(replay.getNumReplayedEvents()), seconds );
+	reportCounter( name, "notified changes", static_cast<double>(objectListener.mNumChanges) );
+	deviceManager.removeListener( &deviceListener );
+}
+
+}
+
+void runReplayBenchmark()
+{
+	const char* name = "Replay";
+	if ( !writeRecording() )
+	{
+		printf( "%s: can't write %s\n", name, fileName );
+		remove( fileName );
+		return;
+	}
+
+	runReader( name );
+	runDeviceManager( name );
+	remove( fileName );
+}
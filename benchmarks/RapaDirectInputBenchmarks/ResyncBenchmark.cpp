@@ -0,0 +1,164 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Resync benchmark
+
+	8 simulated gamepads with storms of button presses and moving axes are 
+	updated at 60 Hz for 20 seconds of simulated time. Events get lost along
+	the way:
+	- every second, a few events of a device silently vanish (a gap in the 
+	  sequence numbers)
+	- every 1.5 seconds, an update comes late and the buffers overflow
+	- every 5 seconds, a device loses the input
+	A BatchListener counts the changes that come from the resyncs. That no
+	object is left stuck is checked by the Resync tests.
+*/
+namespace
+{
+
+const unsigned int numDevices = 8;
+const DWORD frameInMs = 16;
+const DWORD durationInMs = 20000;
+
+class ResyncListener : public RDI::Device::BatchListener
+{
+public:
+	ResyncListener()
+		: mNumResyncChanges(0)
+	{
+	}
+
+	virtual ~ResyncListener() {}
+
+	virtual void onObjectsChanged( RDI::Device* /*device*/, const RDI::ObjectChange* changes, std::size_t numChanges )
+	{
+		for ( std::size_t i=0; i<numChanges; ++i )
+		{
+			if ( changes[i].isResync )
+				++mNumResyncChanges;
+		}
+	}
+
+	unsigned int		mNumResyncChanges;
+};
+
+struct Result
+{
+	double			seconds;
+	unsigned int	numUpdates;
+	unsigned int	numSequenceGaps;
+	unsigned int	numOverflows;
+	unsigned int	numResyncs;
+	unsigned int	numResyncChanges;
+};
+
+Result run()
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+	{
+		backend.addDevice( "Benchmark Pad", 6, 16, 1 );
+		backend.addGenerator( i, RDI::SimulatedGenerator::buttonStorm( 200.f ) );
+		backend.addGenerator( i, RDI::SimulatedGenerator::randomWalk( 400.f, 500 ) );
+	}
+
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger( &backend ) );
+	deviceManager.update();
+	const RDI::DeviceManager::DeviceList& devices = deviceManager.getDevices();
+
+	std::vector<ResyncListener*> listeners;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		listeners.push_back( new ResyncListener() );
+		devices[i].second->addBatchListener( listeners.back() );
+	}
+
+	Result result;
+	result.seconds = 0;
+	result.numUpdates = 0;
+	for ( DWORD time=frameInMs; time<=durationInMs; time+=frameInMs )
+	{
+		DWORD previousTime = time - frameInMs;
+		unsigned int deviceIndex = (time / frameInMs) % numDevices;
+		if ( time/1000!=previousTime/1000 )
+			backend.dropEvents( deviceIndex, 3 );
+		if ( time/1500!=previousTime/1500 )
+			backend.advance( 400 );
+		if ( time/5000!=previousTime/5000 )
+			backend.loseInput( deviceIndex );
+		backend.advance( frameInMs );
+
+		Stopwatch stopwatch;
+		deviceManager.update();
+		result.seconds += stopwatch.getElapsedSeconds();
+		++result.numUpdates;
+	}
+
+	result.numSequenceGaps = 0;
+	result.numOverflows = 0;
+	result.numResyncs = 0;
+	result.numResyncChanges = 0;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		const RDI::Device* device = devices[i].second;
+		result.numSequenceGaps += device->getNumSequenceGaps();
+		result.numOverflows += device->getNumOverflows();
+		result.numResyncs += device->getNumResyncs();
+		result.numResyncChanges += listeners[i]->mNumResyncChanges;
+	}
+
+	deviceManager.update();
+	for ( std::size_t i=0; i<devices.size(); ++i )
+		devices[i].second->removeBatchListener( listeners[i] );
+	for ( std::size_t i=0; i<listeners.size(); ++i )
+		delete listeners[i];
+	return result;
+}
+
+}
+
+void runResyncBenchmark()
+{
+	const char* name = "Resync";
+
+	Result result;
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			result = run();
+			return result.seconds;
+		} );
+	reportResult( name, "update with lost events", result.numUpdates, seconds );
+	reportCounter( name, "sequence gaps", result.numSequenceGaps );
+	reportCounter( name, "overflows", result.numOverflows );
+	reportCounter( name, "resyncs", result.numResyncs );
+	reportCounter( name, "resync changes", result.numResyncChanges );
+}
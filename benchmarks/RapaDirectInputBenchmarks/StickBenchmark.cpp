@@ -0,0 +1,125 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include "RDIStick.h"
+
+/*
+	Stick benchmark
+
+	Processes a few thousand stick samples (random walks around the center,
+	like real sticks at rest or gently moved), either one sample at a time 
+	like Stick::update() does, or all at once with the batched kernel used 
+	by Stick::updateSticks(). The classic per-axis (square) dead zone is 
+	measured as a reference.
+*/
+namespace
+{
+
+const std::size_t numSamples = 4096;
+const std::size_t numPasses = 2000;
+
+void squareDeadZone( float deadZone, std::size_t count, const float* inX, const float* inY, float* outX, float* outY )
+{
+	for ( std::size_t i=0; i<count; ++i )
+	{
+		outX[i] = fabsf(inX[i]) < deadZone ? 0.f : inX[i];
+		outY[i] = fabsf(inY[i]) < deadZone ? 0.f : inY[i];
+	}
+}
+
+}
+
+void runStickBenchmark()
+{
+	const char* name = "Stick";
+
+	// Generate the samples
+	std::vector<float> inX( numSamples );
+	std::vector<float> inY( numSamples );
+	Random random( 26 );
+	float x = 0.f;
+	float y = 0.f;
+	for ( std::size_t i=0; i<numSamples; ++i )
+	{
+		x += (random.nextFloat() - 0.5f) * 0.2f;
+		y += (random.nextFloat() - 0.5f) * 0.2f;
+		x = x < -1.f ? -1.f : (x > 1.f ? 1.f : x);
+		y = y < -1.f ? -1.f : (y > 1.f ? 1.f : y);
+		inX[i] = x;
+		inY[i] = y;
+	}
+
+	std::vector<float> outX( numSamples );
+	std::vector<float> outY( numSamples );
+	std::vector<float> outMagnitude( numSamples );
+	std::vector<float> outAngle( numSamples );
+	RDI::Stick::Settings settings;
+	double checksum = 0;
+
+	Stopwatch stopwatch;
+	for ( std::size_t pass=0; pass<numPasses; ++pass )
+	{
+		squareDeadZone( settings.deadZone, numSamples, &inX[0], &inY[0], &outX[0], &outY[0] );
+		checksum += outX[pass % numSamples];
+	}
+	reportResult( name, "square dead zone (reference)", numSamples * numPasses, stopwatch.getElapsedSeconds() );
+
+	stopwatch.restart();
+	for ( std::size_t pass=0; pass<numPasses; ++pass )
+	{
+		for ( std::size_t i=0; i<numSamples; ++i )
+			RDI::Stick::processSamples( settings, 1, &inX[i], &inY[i], &outX[i], &outY[i], &outMagnitude[i], &outAngle[i] );
+		checksum += outMagnitude[pass % numSamples];
+	}
+	reportResult( name, "radial, one sample at a time", numSamples * numPasses, stopwatch.getElapsedSeconds() );
+
+	stopwatch.restart();
+	for ( std::size_t pass=0; pass<numPasses; ++pass )
+	{
+		RDI::Stick::processSamples( settings, numSamples, &inX[0], &inY[0], &outX[0], &outY[0], &outMagnitude[0], &outAngle[0] );
+		checksum += outMagnitude[pass % numSamples];
+	}
+	reportResult( name, "radial, batched", numSamples * numPasses, stopwatch.getElapsedSeconds() );
+
+	stopwatch.restart();
+	for ( std::size_t pass=0; pass<numPasses; ++pass )
+	{
+		RDI::Stick::processSamples( settings, numSamples, &inX[0], &inY[0], &outX[0], &outY[0], &outMagnitude[0], NULL );
+		checksum += outMagnitude[pass % numSamples];
+	}
+	reportResult( name, "radial, batched, cartesian only", numSamples * numPasses, stopwatch.getElapsedSeconds() );
+
+	std::size_t numCentered = 0;
+	for ( std::size_t i=0; i<numSamples; ++i )
+		if ( outMagnitude[i]==0.f )
+			++numCentered;
+	reportCounter( name, "samples in dead zone (%)", 100.0 * numCentered / numSamples );
+	
+	if ( checksum==12345.f )	// Keep the results alive
+		printf( "\n" );
+}
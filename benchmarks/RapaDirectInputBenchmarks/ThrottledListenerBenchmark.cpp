@@ -0,0 +1,117 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <sstream>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ThrottledListener benchmark
+
+	A gamepad whose axes drift at 4000 events per second is polled at 1 kHz 
+	for 10 seconds of simulated time. Display-like listeners format the 
+	objects that changed with Object::toString(). They are either called for
+	every change or throttled to 30 Hz. The benchmark reports the time per
+	update and the number of calls the throttling saved.
+*/
+namespace
+{
+
+const DWORD durationInMs = 10000;
+const DWORD throttleIntervalInMs = 33;
+
+class DisplayListener : public RDI::Device::Listener
+{
+public:
+	DisplayListener() : mNumCalls(0), mNumCharacters(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* object ) 
+	{ 
+		++mNumCalls;
+		mNumCharacters += object->toString().size();
+	}
+	unsigned long long int	mNumCalls;
+	std::size_t				mNumCharacters;
+};
+
+unsigned long long int run( const char* name, unsigned int numListeners, DWORD minIntervalInMs )
+{
+	unsigned long long int numCalls = 0;
+	double seconds = measureBestOf( getParameters().numRuns, [&]() 
+		{
+			RDI::SimulatedBackend backend( 37 );
+			unsigned int deviceIndex = backend.addDevice( "Benchmark Pad", 6, 16, 1 );
+			backend.addGenerator( deviceIndex, RDI::SimulatedGenerator::randomWalk(4000, 64) );
+			RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+			deviceManager.update();
+			RDI::Device* device = deviceManager.getDevices()[0].second;
+
+			std::vector<DisplayListener> listeners( numListeners );
+			for ( std::size_t i=0; i<listeners.size(); ++i )
+				device->addListener( &listeners[i], RDI::ObjectFilter(), minIntervalInMs );
+
+			Stopwatch stopwatch;
+			for ( DWORD time=0; time<durationInMs; ++time )
+			{
+				backend.advance( 1 );
+				device->update();
+			}
+			double elapsedSeconds = stopwatch.getElapsedSeconds();
+
+			numCalls = 0;
+			for ( std::size_t i=0; i<listeners.size(); ++i )
+				numCalls += listeners[i].mNumCalls;
+			device->removeListeners();
+			return elapsedSeconds;
+		} );
+
+	std::stringstream caseName;
+	caseName << (minIntervalInMs ? "30 Hz " : "unthrottled ") << numListeners << " listeners";
+	reportResult( name, caseName.str(), durationInMs, seconds );
+	reportCounter( name, caseName.str() + " calls", static_cast<double>(numCalls) );
+	return numCalls;
+}
+
+}
+
+void runThrottledListenerBenchmark()
+{
+	const char* name = "ThrottledListener";
+	const Parameters& parameters = getParameters();
+	for ( std::size_t i=0; i<parameters.numListeners.size(); ++i )
+	{
+		unsigned int numListeners = parameters.numListeners[i];
+		if ( numListeners==0 )
+			continue;
+		unsigned long long int numCalls = run( name, numListeners, 0 );
+		unsigned long long int numThrottledCalls = run( name, numListeners, throttleIntervalInMs );
+
+		std::stringstream counterName;
+		counterName << "saved calls " << numListeners << " listeners";
+		reportCounter( name, counterName.str(), static_cast<double>(numCalls - numThrottledCalls) );
+	}
+}
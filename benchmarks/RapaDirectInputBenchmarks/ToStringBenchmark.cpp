@@ -0,0 +1,82 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Benchmarks.h"
+
+#include <stdio.h>
+#include <string>
+#include "RDICommon.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ToString benchmark
+
+	Measures the toString() of each kind of Object and the GUID formatting
+	helper, which client code typically calls to display or log the state
+	of the devices.
+*/
+void runToStringBenchmark()
+{
+	const char* name = "ToString";
+
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Benchmark Pad", 1, 1, 1 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	const RDI::Objects& objects = deviceManager.getDevices()[0].second->getObjects();
+
+	// The total length of the strings keeps the calls from being optimized away
+	std::size_t length = 0;
+	const unsigned int numCalls = 100000;
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		const RDI::Object* object = objects[i];
+		double seconds = measureBestOf( getParameters().numRuns, [&]()
+			{
+				Stopwatch stopwatch;
+				for ( unsigned int j=0; j<numCalls; ++j )
+					length += object->toString().size();
+				return stopwatch.getElapsedSeconds();
+			} );
+
+		const RDI::ObjectInstance& objectInstance = object->getObjectInstance();
+		const char* caseName = objectInstance.isAxis() ? "Axis" : (objectInstance.isButton() ? "Button" : "POV");
+		reportResult( name, caseName, numCalls, seconds );
+	}
+
+	const GUID& guid = backend.getDeviceInstance( 0 ).getGuidInstance();
+	double seconds = measureBestOf( getParameters().numRuns, [&]()
+		{
+			Stopwatch stopwatch;
+			for ( unsigned int j=0; j<numCalls; ++j )
+				length += RDI::Common::GUIDToString( &guid ).size();
+			return stopwatch.getElapsedSeconds();
+		} );
+	reportResult( name, "GUIDToString", numCalls, seconds );
+	
+	if ( length==0 )
+		printf( "%s: empty strings\n", name );
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT) (http://opensource.org/licenses/MIT)
+#
+# Copyright (c) 2015 Jacques Menuet
+#
+# Compare two JSON result files written by RapaDirectInputBenchmarks --json
+# and flag the cases that got slower than a threshold. The exit code is 1 if 
+# any regression is found, so the script can be used to fail a build.
+#
+# Usage: compare_benchmarks.py baseline.json current.json [--threshold 10]
+
+import argparse
+import json
+import sys
+
+
+def load(file_name):
+    with open(file_name) as file:
+        results = json.load(file)["results"]
+    cases = {}
+    counters = {}
+    for result in results:
+        if "case" in result:
+            cases[(result["benchmark"], result["case"])] = result["ns_per_op"]
+        else:
+            counters[(result["benchmark"], result["counter"])] = result["value"]
+    return cases, counters
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark runs")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="slowdown in percent over which a case is a regression (default: 10)")
+    args = parser.parse_args()
+
+    baseline_cases, baseline_counters = load(args.baseline)
+    current_cases, current_counters = load(args.current)
+
+    regressions = 0
+    print("%-32s %-48s %12s %12s %8s" % ("Benchmark", "Case", "Baseline", "Current", "Change"))
+    for key in sorted(set(baseline_cases) | set(current_cases)):
+        baseline = baseline_cases.get(key)
+        current = current_cases.get(key)
+        if baseline is None or current is None:
+            status = "added" if baseline is None else "removed"
+            print("%-32s %-48s %12s %12s %8s" % (key[0], key[1], 
+                  "-" if baseline is None else "%.2f" % baseline,
+                  "-" if current is None else "%.2f" % current, status))
+            continue
+
+        change = (current - baseline) / baseline * 100.0 if baseline > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improvement"
+        print("%-32s %-48s %12.2f %12.2f %+7.1f%%%s" % (key[0], key[1], baseline, current, change, flag))
+
+    # The counters describe what was measured (bytes per event, dropped records, etc...)
+    for key in sorted(set(baseline_counters) & set(current_counters)):
+        if baseline_counters[key] != current_counters[key]:
+            print("%-32s %-48s %12.2f %12.2f  counter changed" % (key[0], key[1], baseline_counters[key], current_counters[key]))
+
+    print("%d regression(s) over %.1f%%" % (regressions, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,129 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "LatencyHistogram.h"
+
+namespace
+{
+
+const unsigned int subBucketBits = 5;
+const unsigned int numSubBuckets = 1 << subBucketBits;
+const unsigned int numLinearBuckets = numSubBuckets * 2;		// Values below are counted exactly
+const unsigned int maxExponent = 63;
+
+}
+
+LatencyHistogram::LatencyHistogram()
+	: mBuckets( numLinearBuckets + (maxExponent - subBucketBits) * numSubBuckets, 0 ),
+	  mCount(0),
+	  mMin(0),
+	  mMax(0),
+	  mSum(0)
+{
+}
+
+void LatencyHistogram::record( unsigned long long int valueInNs )
+{
+	++mBuckets[ getBucket(valueInNs) ];
+	if ( mCount==0 || valueInNs<mMin )
+		mMin = valueInNs;
+	if ( valueInNs>mMax )
+		mMax = valueInNs;
+	mSum += static_cast<double>(valueInNs);
+	++mCount;
+}
+
+void LatencyHistogram::reset()
+{
+	mBuckets.assign( mBuckets.size(), 0 );
+	mCount = 0;
+	mMin = 0;
+	mMax = 0;
+	mSum = 0;
+}
+
+void LatencyHistogram::merge( const LatencyHistogram& other )
+{
+	if ( other.mCount==0 )
+		return;
+	for ( std::size_t i=0; i<mBuckets.size(); ++i )
+		mBuckets[i] += other.mBuckets[i];
+	if ( mCount==0 || other.mMin<mMin )
+		mMin = other.mMin;
+	if ( other.mMax>mMax )
+		mMax = other.mMax;
+	mSum += other.mSum;
+	mCount += other.mCount;
+}
+
+double LatencyHistogram::getMean() const
+{
+	return mCount ? mSum / static_cast<double>(mCount) : 0;
+}
+
+unsigned long long int LatencyHistogram::getPercentile( double percentile ) const
+{
+	if ( mCount==0 )
+		return 0;
+
+	unsigned long long int rank = static_cast<unsigned long long int>( percentile / 100.0 * static_cast<double>(mCount) );
+	if ( rank>=mCount )
+		rank = mCount - 1;
+	
+	unsigned long long int count = 0;
+	for ( std::size_t i=0; i<mBuckets.size(); ++i )
+	{
+		count += mBuckets[i];
+		if ( count>rank )
+		{
+			unsigned long long int value = getBucketValue( i );
+			return value<mMax ? value : mMax;
+		}
+	}
+	return mMax;
+}
+
+std::size_t LatencyHistogram::getBucket( unsigned long long int value )
+{
+	if ( value<numLinearBuckets )
+		return static_cast<std::size_t>(value);
+
+	unsigned int exponent = 0;
+	while ( (value >> (exponent+1))!=0 )
+		++exponent;
+	unsigned long long int subBucket = (value >> (exponent - subBucketBits)) & (numSubBuckets - 1);
+	return numLinearBuckets + (exponent - subBucketBits - 1) * numSubBuckets + static_cast<std::size_t>(subBucket);
+}
+
+// The upper bound of the values counted in the bucket
+unsigned long long int LatencyHistogram::getBucketValue( std::size_t bucket )
+{
+	if ( bucket<numLinearBuckets )
+		return bucket;
+
+	std::size_t index = bucket - numLinearBuckets;
+	unsigned int exponent = static_cast<unsigned int>( index / numSubBuckets ) + subBucketBits + 1;
+	unsigned long long int subBucket = index % numSubBuckets;
+	unsigned long long int lowerBound = (1ULL << exponent) + (subBucket << (exponent - subBucketBits));
+	return lowerBound + (1ULL << (exponent - subBucketBits)) - 1;
+}
@@ -0,0 +1,63 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+	LatencyHistogram
+
+	Records latencies (in nanoseconds) with a bounded memory, whatever the
+	length of the run: the values are counted in buckets whose width grows 
+	with the value (32 buckets per power of 2), so the percentiles are 
+	accurate to about 3%.
+*/
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void						record( unsigned long long int valueInNs );
+	void						reset();
+	void						merge( const LatencyHistogram& other );
+
+	unsigned long long int		getCount() const			{ return mCount; }
+	unsigned long long int		getMin() const				{ return mMin; }
+	unsigned long long int		getMax() const				{ return mMax; }
+	double						getMean() const;
+
+	// The percentile is in the 0..100 range
+	unsigned long long int		getPercentile( double percentile ) const;
+
+private:
+	static std::size_t				getBucket( unsigned long long int value );
+	static unsigned long long int	getBucketValue( std::size_t bucket );
+
+	std::vector<unsigned long long int>	mBuckets;
+	unsigned long long int		mCount;
+	unsigned long long int		mMin;
+	unsigned long long int		mMax;
+	double						mSum;
+};
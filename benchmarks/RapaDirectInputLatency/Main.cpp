@@ -0,0 +1,317 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "LatencyHistogram.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+#include "RDITime.h"
+
+/*
+	Latency harness
+
+	Measures the end-to-end latency of the input path: from the moment an 
+	event enters the buffer of a device, to the moment the onObjectChanged()
+	of a listener returns. The devices come from a SimulatedBackend and the 
+	usual DeviceManager::update() loop runs at a given rate, like in a game.
+
+	The events arrive at a fixed rate, spread over the devices. An event is 
+	put in the buffer of its device by the first iteration of the loop that 
+	follows its arrival time, and its latency is measured from that arrival 
+	time, so the latency includes the wait for the next update. Each event 
+	moves an axis to a value that identifies the event, which is how the 
+	listeners find its arrival time.
+
+	The load can be made realistic with many devices and listeners, devices
+	being unplugged and plugged back periodically (the events of a device 
+	that is unplugged are skipped) and listeners doing some work in their 
+	callback.
+
+	Usage: RapaDirectInputLatency [options]
+	  --devices <n>          Number of devices (default 4)
+	  --axes <n>             Number of axes per device (default 8)
+	  --listeners <n>        Number of listeners per device (default 8)
+	  --rate <n>             Events per second, all devices included (default 8000)
+	  --update-rate <n>      Updates per second, 0 to update continuously (default 1000)
+	  --duration <s>         Length of the run in seconds (default 10)
+	  --churn <ms>           Unplug a device and plug back the previous one every n ms (default 0: never)
+	  --work <ns>            Time spent by each listener in each callback (default 0)
+	  --report <s>           Interval of the intermediate reports in seconds (default 0: none)
+*/
+namespace
+{
+
+struct Settings
+{
+	Settings()
+		: numDevices(4),
+		  numAxes(8),
+		  numListeners(8),
+		  eventsPerSecond(8000),
+		  updatesPerSecond(1000),
+		  durationInSeconds(10),
+		  churnIntervalInMs(0),
+		  listenerWorkInNs(0),
+		  reportIntervalInSeconds(0)
+	{
+	}
+
+	unsigned int	numDevices;
+	unsigned int	numAxes;
+	unsigned int	numListeners;
+	double			eventsPerSecond;
+	double			updatesPerSecond;
+	double			durationInSeconds;
+	unsigned int	churnIntervalInMs;
+	unsigned int	listenerWorkInNs;
+	double			reportIntervalInSeconds;
+};
+
+const unsigned int numValues = 65536;		// The values of an axis identify the events
+
+unsigned long long int getTimeInNs()
+{
+	static const double nsPerTick = 1e9 / static_cast<double>( RDI::Time::getTickFrequency() );
+	return static_cast<unsigned long long int>( static_cast<double>(RDI::Time::getTimeAsTicks()) * nsPerTick );
+}
+
+class LatencyListener : public RDI::Device::Listener
+{
+public:
+	LatencyListener( const std::vector<std::vector<unsigned long long int>>& arrivalTimes, unsigned int workInNs, LatencyHistogram& histogram )
+		: mArrivalTimes(arrivalTimes),
+		  mWorkInNs(workInNs),
+		  mHistogram(histogram)
+	{
+	}
+
+	virtual void onObjectChanged( RDI::Device* device, RDI::Object* object )
+	{
+		// The simulated devices are numbered in their instance GUID
+		unsigned int deviceIndex = device->getDeviceInstance().getGuidInstance().Data1 - 1;
+		unsigned long long int arrivalTime = mArrivalTimes[deviceIndex][ object->getData() % numValues ];
+		
+		unsigned long long int now = getTimeInNs();
+		if ( mWorkInNs>0 )
+		{
+			unsigned long long int endTime = now + mWorkInNs;
+			while ( now<endTime )
+				now = getTimeInNs();
+		}
+		mHistogram.record( now>arrivalTime ? now - arrivalTime : 0 );
+	}
+
+private:
+	const std::vector<std::vector<unsigned long long int>>&	mArrivalTimes;
+	unsigned int		mWorkInNs;
+	LatencyHistogram&	mHistogram;
+};
+
+class DeviceListener : public RDI::DeviceManager::Listener
+{
+public:
+	DeviceListener( std::vector<LatencyListener>& listeners ) : mListeners(listeners) {}
+
+	virtual void onDeviceConnected( RDI::DeviceManager* /*deviceManager*/, RDI::Device* device )
+	{
+		for ( std::size_t i=0; i<mListeners.size(); ++i )
+			device->addListener( &mListeners[i] );
+	}
+
+private:
+	std::vector<LatencyListener>&	mListeners;
+};
+
+void printReport( const char* title, const LatencyHistogram& histogram, unsigned long long int numNotifications, double seconds )
+{
+	printf( "%-8s %10.0f notifications/s  latency us: min %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f mean %.1f\n", 
+			title, seconds>0 ? static_cast<double>(numNotifications) / seconds : 0,
+			histogram.getMin() / 1000.0, histogram.getPercentile(50) / 1000.0, histogram.getPercentile(90) / 1000.0, 
+			histogram.getPercentile(99) / 1000.0, histogram.getPercentile(99.9) / 1000.0, histogram.getMax() / 1000.0, 
+			histogram.getMean() / 1000.0 );
+}
+
+bool parseSettings( int argc, char** argv, Settings& settings )
+{
+	for ( int i=1; i+1<argc; i+=2 )
+	{
+		const char* option = argv[i];
+		double value = atof( argv[i+1] );
+		if ( value<0 )
+			return false;
+		if ( strcmp(option, "--devices")==0 )
+			settings.numDevices = static_cast<unsigned int>(value);
+		else if ( strcmp(option, "--axes")==0 )
+			settings.numAxes = static_cast<unsigned int>(value);
+		else if ( strcmp(option, "--listeners")==0 )
+			settings.numListeners = static_cast<unsigned int>(value);
+		else if ( strcmp(option, "--rate")==0 )
+			settings.eventsPerSecond = value;
+		else if ( strcmp(option, "--update-rate")==0 )
+			settings.updatesPerSecond = value;
+		else if ( strcmp(option, "--duration")==0 )
+			settings.durationInSeconds = value;
+		else if ( strcmp(option, "--churn")==0 )
+			settings.churnIntervalInMs = static_cast<unsigned int>(value);
+		else if ( strcmp(option, "--work")==0 )
+			settings.listenerWorkInNs = static_cast<unsigned int>(value);
+		else if ( strcmp(option, "--report")==0 )
+			settings.reportIntervalInSeconds = value;
+		else
+			return false;
+	}
+	return (argc % 2)==1 && settings.numDevices>0 && settings.numAxes>0 && settings.numAxes<=8 && settings.eventsPerSecond>0;
+}
+
+}
+
+int main( int argc, char** argv )
+{
+	Settings settings;
+	if ( !parseSettings( argc, argv, settings ) )
+	{
+		printf( "Usage: %s [--devices <n>] [--axes <1..8>] [--listeners <n>] [--rate <events/s>] [--update-rate <updates/s>]\n"
+				"          [--duration <s>] [--churn <ms>] [--work <ns>] [--report <s>]\n", argv[0] );
+		return 1;
+	}
+
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<settings.numDevices; ++i )
+		backend.addDevice( "Latency Pad", settings.numAxes, 0, 0 );
+	
+	std::vector<std::vector<unsigned long long int>> arrivalTimes( settings.numDevices, std::vector<unsigned long long int>( numValues, 0 ) );
+	std::vector<unsigned int> sequences( settings.numDevices, 0 );
+	LatencyHistogram histogram;
+	LatencyHistogram totalHistogram;
+	std::vector<LatencyListener> listeners( settings.numListeners, LatencyListener( arrivalTimes, settings.listenerWorkInNs, histogram ) );
+	DeviceListener deviceListener( listeners );
+
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.addListener( &deviceListener );
+	deviceManager.update();
+
+	const unsigned long long int eventInterval = static_cast<unsigned long long int>( 1e9 / settings.eventsPerSecond );
+	const unsigned long long int updateInterval = settings.updatesPerSecond>0 ? static_cast<unsigned long long int>( 1e9 / settings.updatesPerSecond ) : 0;
+	const unsigned long long int reportInterval = static_cast<unsigned long long int>( settings.reportIntervalInSeconds * 1e9 );
+	const unsigned long long int churnInterval = settings.churnIntervalInMs * 1000000ULL;
+
+	unsigned long long int startTime = getTimeInNs();
+	unsigned long long int endTime = startTime + static_cast<unsigned long long int>( settings.durationInSeconds * 1e9 );
+	unsigned long long int nextEventTime = startTime;
+	unsigned long long int nextUpdateTime = startTime;
+	unsigned long long int nextChurnTime = startTime + churnInterval;
+	unsigned long long int reportStartTime = startTime;
+	unsigned long long int lastSimulatedTime = startTime;
+	unsigned long long int numEvents = 0;
+	unsigned long long int numSkippedEvents = 0;
+	unsigned long long int numUpdates = 0;
+	unsigned long long int totalUpdateTime = 0;
+	unsigned int nextDevice = 0;
+	unsigned int churnDevice = 0;
+
+	for ( ;; )
+	{
+		unsigned long long int now = getTimeInNs();
+		if ( now>=endTime )
+			break;
+
+		// Keep the clock of the devices (used for their timestamps) in sync
+		if ( now - lastSimulatedTime>=1000000 )
+		{
+			DWORD elapsedTimeInMs = static_cast<DWORD>( (now - lastSimulatedTime) / 1000000 );
+			backend.advance( elapsedTimeInMs );
+			lastSimulatedTime += elapsedTimeInMs * 1000000ULL;
+		}
+
+		if ( churnInterval>0 && now>=nextChurnTime )
+		{
+			// Unplug a device and plug back the one unplugged previously
+			if ( settings.numDevices>1 )
+				backend.connectDevice( churnDevice );
+			churnDevice = (churnDevice + 1) % settings.numDevices;
+			backend.disconnectDevice( churnDevice );
+			nextChurnTime += churnInterval;
+		}
+
+		// The events that arrived since the previous iteration
+		while ( nextEventTime<=now )
+		{
+			unsigned int deviceIndex = nextDevice;
+			nextDevice = (nextDevice + 1) % settings.numDevices;
+			if ( backend.isDeviceConnected( deviceIndex ) )
+			{
+				unsigned int sequence = ++sequences[deviceIndex];
+				DWORD value = sequence % numValues;
+				arrivalTimes[deviceIndex][value] = nextEventTime;
+				backend.setObjectData( deviceIndex, sequence % settings.numAxes, value );
+				++numEvents;
+			}
+			else
+			{
+				++numSkippedEvents;
+			}
+			nextEventTime += eventInterval;
+		}
+
+		unsigned long long int updateStartTime = getTimeInNs();
+		deviceManager.update();
+		totalUpdateTime += getTimeInNs() - updateStartTime;
+		++numUpdates;
+
+		if ( reportInterval>0 && now - reportStartTime>=reportInterval )
+		{
+			printReport( "interval", histogram, histogram.getCount(), static_cast<double>(now - reportStartTime) / 1e9 );
+			totalHistogram.merge( histogram );
+			histogram.reset();
+			reportStartTime = now;
+		}
+
+		if ( updateInterval>0 )
+		{
+			nextUpdateTime += updateInterval;
+			unsigned long long int time = getTimeInNs();
+			if ( nextUpdateTime>time )
+				std::this_thread::sleep_for( std::chrono::nanoseconds( nextUpdateTime - time ) );
+		}
+	}
+	double seconds = static_cast<double>(getTimeInNs() - startTime) / 1e9;
+	totalHistogram.merge( histogram );
+
+	printf( "%u devices, %u axes, %u listeners, %.0f events/s, %.0f updates/s, %.1f s, churn %u ms, work %u ns\n",
+			settings.numDevices, settings.numAxes, settings.numListeners, settings.eventsPerSecond, settings.updatesPerSecond,
+			seconds, settings.churnIntervalInMs, settings.listenerWorkInNs );
+	printReport( "total", totalHistogram, totalHistogram.getCount(), seconds );
+	printf( "events %llu, skipped (device unplugged) %llu, lost (buffer overflow) %llu\n", 
+			numEvents, numSkippedEvents, backend.getNumLostEvents() );
+	printf( "updates %llu, %.2f us per update\n", numUpdates, numUpdates ? static_cast<double>(totalUpdateTime) / numUpdates / 1000.0 : 0 );
+
+	deviceManager.removeListener( &deviceListener );
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RDIDevice.h"
+
+namespace RDI
+{
+
+/*
+	Executor
+
+	Runs tasks, usually on other threads. An Executor must run each task it
+	is given exactly once. The task must stay alive until it has run.
+*/
+class Executor
+{
+public:
+	class Task
+	{
+	public:
+		virtual ~Task() {}
+		virtual void run() = 0;
+	};
+
+	virtual ~Executor() {}
+	virtual void				execute( Task* task ) = 0;
+};
+
+/*
+	ThreadPool
+
+	An Executor running the tasks on a fixed number of threads, in the order
+	they were given. The destructor runs the remaining tasks before 
+	stopping the threads.
+*/
+class ThreadPool : public Executor
+{
+public:
+	ThreadPool( unsigned int numThreads=1 );
+	virtual ~ThreadPool();
+
+	unsigned int				getNumThreads() const		{ return static_cast<unsigned int>( mThreads.size() ); }
+	virtual void				execute( Task* task );
+
+private:
+	void						workerThread();
+
+	std::vector<std::thread>	mThreads;
+	std::mutex					mMutex;
+	std::condition_variable		mCondition;
+	std::deque<Task*>			mTasks;
+	bool						mStopRequested;
+};
+
+/*
+	AsyncListener
+
+	A Device::Listener that moves the notifications off the thread updating
+	the devices. Each change is copied into a bounded queue (as an 
+	ObjectChange, see Device::getCurrentChange()) and the Handler is called
+	later on by an Executor. So a slow Handler (logging, telemetry, UI...) 
+	doesn't make Device::update() and DeviceManager::update() slower.
+
+	The Handler gets the changes in the order they happened and is never 
+	called concurrently, even with an Executor running tasks on several 
+	threads. It runs on the threads of the Executor, so it must not access
+	the Device and its objects, only the ObjectChange it receives.
+
+	When the queue is full, the policy decides what happens to a new change:
+	- Block: the thread updating the devices waits for the Handler to make 
+	  room. No change is lost
+	- DropOldest: the oldest queued change is dropped to make room
+	- Coalesce: the queue holds at most one change per Object, a new change
+	  of an Object already queued replaces the new state of the queued one 
+	  (so the Handler sees the latest state, with the old state of the 
+	  first change). The merged change is a resync if any of its changes 
+	  was. When the queue is full of other objects, the oldest change is 
+	  dropped. Coalescing happens whether the queue is full or not
+
+	The AsyncListener can be registered to several devices, but not as a 
+	throttled Listener: the ObjectChange isn't available then (see 
+	Device::getCurrentChange()). The Coalesce policy limits the rate of the
+	changes instead. It must be removed from the devices before being 
+	destroyed. The destructor waits for the queued changes to be handled.
+*/
+class AsyncListener : public Device::Listener
+{
+public:
+	class Handler
+	{
+	public:
+		virtual ~Handler() {}
+		virtual void onObjectChanged( Device* /*device*/, const ObjectChange& /*change*/ ) {}
+	};
+
+	enum QueuePolicy
+	{
+		Block,
+		DropOldest,
+		Coalesce
+	};
+
+	AsyncListener( Handler* handler, Executor* executor, std::size_t queueCapacity=256, QueuePolicy policy=Block );
+	virtual ~AsyncListener();
+
+	Handler*					getHandler() const				{ return mHandler; }
+	Executor*					getExecutor() const				{ return mExecutor; }
+	std::size_t					getQueueCapacity() const		{ return mQueue.size(); }
+	QueuePolicy					getQueuePolicy() const			{ return mPolicy; }
+
+	virtual void				onObjectChanged( Device* device, Object* object );
+
+	// Wait for the queued changes to be handled
+	void						flush();
+
+	// Metrics
+	std::size_t					getQueueDepth() const;
+	std::size_t					getMaxQueueDepth() const;		// Since the creation of the AsyncListener
+	unsigned long long int		getNumQueuedChanges() const;
+	unsigned long long int		getNumHandledChanges() const;
+	unsigned long long int		getNumDroppedChanges() const;
+	unsigned long long int		getNumCoalescedChanges() const;
+	unsigned long long int		getNumBlockedChanges() const;	// The changes that had to wait for room in the queue
+
+private:
+	struct Notification
+	{
+		Device*					device;
+		ObjectChange			change;
+	};
+
+	// The queue position of the change of each Object of a Device, for coalescing
+	struct QueuedDevice
+	{
+		Device*								device;
+		std::vector<unsigned long long int>	positions;
+	};
+
+	class DrainTask : public Executor::Task
+	{
+	public:
+		DrainTask( AsyncListener* listener ) : mListener(listener) {}
+		virtual void run()		{ mListener->drain(); }
+	private:
+		AsyncListener*			mListener;
+	};
+
+	unsigned long long int*		findQueuedPosition( Device* device, unsigned int objectIndex );
+	void						dropOldest();
+	void						drain();
+
+	Handler*					mHandler;
+	Executor*					mExecutor;
+	QueuePolicy					mPolicy;
+	DrainTask					mDrainTask;
+
+	mutable std::mutex			mMutex;
+	std::condition_variable		mCondition;
+	std::vector<Notification>	mQueue;				// Ring buffer
+	unsigned long long int		mReadPosition;		// The positions only increase, the index in the queue is obtained by modulo
+	unsigned long long int		mWritePosition;
+	std::vector<QueuedDevice>	mQueuedDevices;		// Coalesce only, the devices with changes in the queue
+	bool						mIsDraining;		// A DrainTask has been given to the Executor and hasn't finished
+
+	std::size_t					mMaxQueueDepth;
+	unsigned long long int		mNumQueuedChanges;
+	unsigned long long int		mNumHandledChanges;
+	unsigned long long int		mNumDroppedChanges;
+	unsigned long long int		mNumCoalescedChanges;
+	unsigned long long int		mNumBlockedChanges;
+};
+
+}
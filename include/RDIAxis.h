@@ -24,10 +24,41 @@
 #pragma once
 
 #include "RDIObject.h"
+#include "RDIAxisFilter.h"
 
 namespace RDI
 {
 
+/*
+	AxisHysteresis
+
+	Decides which changes of value of an Axis are worth notifying. A change 
+	is notified only when the new value is more than a threshold away from 
+	the last notified value. Reaching the min or max of the range is always 
+	notified, so a fully pushed axis is never reported as slightly off.
+
+	With a threshold of 0, every change is notified.
+*/
+class AxisHysteresis
+{
+public:
+	AxisHysteresis( LONG minValue, LONG maxValue, LONG value );
+
+	LONG					getThreshold() const		{ return mThreshold; }
+	void					setThreshold( LONG threshold );
+
+	LONG					getNotifiedValue() const	{ return mNotifiedValue; }
+
+	// Returns true if the new value must be notified (it then becomes the notified value)
+	bool					update( LONG value );
+
+private:
+	LONG					mThreshold;
+	LONG					mMinValue;
+	LONG					mMaxValue;
+	LONG					mNotifiedValue;
+};
+
 /*
 	Axis
 
@@ -45,6 +76,12 @@ namespace RDI
 	An Axis will return its value between a min/max value range (note that 
 	as far as I could tell, all the axes I've seen report the value in
 	the 0..65535 range).	
+
+	Noisy axes can report changes of a few units all the time. A change 
+	threshold can be set on the Axis (or on all the axes of a Device, see 
+	Device::setAxisChangeThreshold()) so the listeners are only notified 
+	when the value moves significantly (see AxisHysteresis). getValue() 
+	always returns the latest value.
 */
 class Axis : public Object
 {
@@ -54,17 +91,34 @@ public:
 	LONG					getValue() const		{ return mValue; }
 	LONG					getMinValue() const		{ return mMinValue; }
 	LONG					getMaxValue() const		{ return mMaxValue; }
+
+	LONG					getChangeThreshold() const	{ return mHysteresis.getThreshold(); }
+	void					setChangeThreshold( LONG threshold );
+	
+	// The value that was last notified to the listeners
+	LONG					getNotifiedValue() const	{ return mHysteresis.getNotifiedValue(); }
+
+	// Counters of the changes of value and of the ones that were notified
+	unsigned int			getNumChanges() const			{ return mNumChanges; }
+	unsigned int			getNumNotifications() const		{ return mNumNotifications; }
 	
 	virtual std::string		toString() const;
 	virtual void			updateFrom( const DIDEVICEOBJECTDATA& entry );
+	virtual DWORD			getData() const;
 	
 protected:
 	void					setValue( LONG value );
 
 private:
+	friend class Device;
+
 	LONG	mValue;
 	LONG	mMinValue;
 	LONG	mMaxValue;
+	AxisFilterBank::Id	mFilterId;		// Set by the parent Device when the Axis is filtered
+	AxisHysteresis		mHysteresis;
+	unsigned int		mNumChanges;
+	unsigned int		mNumNotifications;
 };
 
 }
\ No newline at end of file
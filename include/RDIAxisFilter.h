@@ -0,0 +1,167 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	AxisFilter
+
+	The description of a filter that can be applied on the values of an Axis
+	to get rid of the jitter that cheap sticks and pedals exhibit at rest.
+	See Device::setAxisFilter().
+	
+	- ExponentialMovingAverage: a first order low-pass filter
+	- LowPass: a second order (biquad) Butterworth low-pass filter. The q
+	  parameter can be changed to get a different response
+	- OneEuro: the 1€ filter (http://cristal.univ-lille.fr/~casiez/1euro/).
+	  Its cutoff frequency increases with the speed of the axis so it
+	  filters heavily at rest but lags little during fast movements
+	
+	The frequencies are expressed in Hz. The beta parameter of the OneEuro
+	filter applies to the speed of the axis expressed in full ranges per 
+	second.
+*/
+struct AxisFilter
+{
+	enum Type
+	{
+		None,
+		ExponentialMovingAverage,
+		LowPass,
+		OneEuro,
+		NumTypes
+	};
+	
+	AxisFilter();
+	static AxisFilter	exponentialMovingAverage( float cutoffFrequency );
+	static AxisFilter	lowPass( float cutoffFrequency, float q=0.7071f );
+	static AxisFilter	oneEuro( float minCutoffFrequency, float beta, float derivativeCutoffFrequency=1.f );
+
+	Type	type;
+	float	cutoffFrequency;				// Minimum cutoff frequency for the OneEuro filter
+	float	q;								// LowPass only
+	float	beta;							// OneEuro only
+	float	derivativeCutoffFrequency;		// OneEuro only
+};
+
+/*
+	AxisFilterBank
+
+	The AxisFilterBank holds the state of the filters of many axes and 
+	runs them all in one pass.
+
+	The state is stored as a structure of arrays, with one set of arrays 
+	per type of filter, so that the processing of each type is a simple 
+	loop over contiguous data that the compiler can vectorize.
+
+	The samples are pushed as they come out of the DirectInput buffer, along 
+	with their timestamp, and are filtered by process(). Each sample steps the
+	filter of its axis up to its timestamp, so a burst of events is filtered
+	like the signal it samples. The samples are processed by passes: each 
+	pass takes the next sample of every axis that still has one, so the loops
+	stay over contiguous data. Finally, every axis is stepped up to the 
+	current time with its last input, so that its output keeps converging 
+	toward the input even when the device stops reporting events.
+*/
+class AxisFilterBank
+{
+public:
+	typedef unsigned int	Id;
+	static const Id			invalidId = 0xFFFFFFFF;
+
+	AxisFilterBank();
+	
+	Id						addAxis( const AxisFilter& filter, LONG minValue, LONG maxValue, LONG value );
+	void					removeAxis( Id id );
+	const AxisFilter&		getFilter( Id id ) const;
+	std::size_t				getNumAxes() const;
+	
+	// Times are in milliseconds, the time base being the one of the DirectInput timestamps
+	void					pushSample( Id id, LONG value, DWORD timeStamp );
+	void					process( DWORD currentTime );
+
+	LONG					getValue( Id id ) const;
+
+private:
+	struct Sample
+	{
+		std::size_t			index;			// Of the lane
+		float				input;			// Normalized (0..1)
+		DWORD				time;
+	};
+
+	struct Lanes
+	{
+		void				resize( std::size_t size );
+		void				swapRemove( std::size_t index );
+		bool				prepareSamples();
+		void				prepare( DWORD currentTime );
+		void				step( std::size_t index, DWORD time );
+		void				finish();
+
+		std::vector<Id>				ids;
+		std::vector<AxisFilter>		filters;
+		std::vector<float>			offset;			// value = offset + normalizedValue * scale
+		std::vector<float>			scale;
+		std::vector<float>			input;			// Normalized (0..1)
+		std::vector<DWORD>			inputTime;
+		std::vector<unsigned char>	hasInput;		// In the current pass
+		std::vector<unsigned char>	hasTime;
+		std::vector<DWORD>			lastTime;
+		std::vector<float>			dt;				// Seconds since the previous step, computed by prepare()
+		std::vector<float>			cutoff;
+		std::vector<float>			shape;			// q for LowPass, beta for OneEuro
+		std::vector<float>			derivativeCutoff;
+		std::vector<float>			y;				// Filtered value (normalized)
+		std::vector<float>			y2;
+		std::vector<float>			x1;
+		std::vector<float>			x2;
+		std::vector<float>			dx;				// Filtered derivative (OneEuro)
+		std::vector<LONG>			value;			// Filtered value (in axis units)
+		std::vector<Sample>			samples;		// Pushed since the last process, in order
+	};
+
+	struct Location
+	{
+		AxisFilter::Type	type;
+		std::size_t			index;
+	};
+
+	static void				processLanes( AxisFilter::Type type, Lanes& lanes );
+	static void				processExponentialMovingAverage( Lanes& lanes );
+	static void				processLowPass( Lanes& lanes );
+	static void				processOneEuro( Lanes& lanes );
+
+	Lanes					mLanes[AxisFilter::NumTypes];
+	std::vector<Location>	mLocations;		// Indexed by Id
+	std::vector<Id>			mFreeIds;
+};
+
+}
@@ -0,0 +1,119 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include "RDIDataFormat.h"
+#include "RDIDeviceInstance.h"
+#include "RDIObjectInstance.h"
+
+namespace RDI
+{
+
+/*
+	DeviceBackend
+
+	The access to one device, as used by a Device. It mirrors the few 
+	IDirectInputDevice8 methods RDI relies on and reports errors with the 
+	same HRESULT codes, so the Device handles every backend the same way.
+
+	The objects of the device are identified by the dwType of their
+	ObjectInstance, like DirectInput does with DIPH_BYID.
+*/
+class DeviceBackend
+{
+public:
+	virtual ~DeviceBackend() {}
+
+	// The maximum number of events buffered between two calls to getDeviceData()
+	virtual bool		setBufferSize( DWORD numEntries ) = 0;
+
+	virtual bool		enumerateObjects( ObjectInstances& objectInstances ) = 0;
+
+	// Set the layout of the state of the device. The dwOfs of the objects follow
+	// the format once it's set. Returns false if the backend keeps its own format
+	virtual bool		setDataFormat( const DataFormat& /*dataFormat*/ )		{ return false; }
+	virtual bool		getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue ) = 0;
+
+	// The user data is returned in the uAppData member of the events of the object
+	virtual bool		setObjectUserData( DWORD objectType, UINT_PTR userData ) = 0;
+
+	virtual HRESULT		acquire() = 0;
+	virtual void		unacquire() = 0;
+
+	// Like IDirectInputDevice8::GetDeviceData(): on input, numDataEntries is the
+	// size of the array, on output the number of events returned. Returns DI_OK, 
+	// DI_BUFFEROVERFLOW if events were lost, or an error (DIERR_NOTACQUIRED, 
+	// DIERR_INPUTLOST, DIERR_UNPLUGGED, etc...)
+	virtual HRESULT		getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries ) = 0;
+
+	// The current state of the given objects, encoded like the dwData of their
+	// events. Like IDirectInputDevice8::GetDeviceState(), the device must be 
+	// acquired. Returns DI_OK or an error (DIERR_UNSUPPORTED if the backend 
+	// can't provide the state)
+	virtual HRESULT		getObjectStates( const DWORD* /*objectTypes*/, DWORD* /*states*/, std::size_t /*numObjects*/ )	{ return DIERR_UNSUPPORTED; }
+
+	// True if the dwSequence of the events of the device follow each other 
+	// without gap, so a gap means that events were lost. This isn't the case 
+	// with DirectInput, whose sequence numbers are shared by all the devices
+	virtual bool		hasContiguousSequences() const		{ return false; }
+};
+
+/*
+	Backend
+
+	The source of the devices of a DeviceManager. The DirectInputBackend 
+	talks to the actual hardware through DirectInput, other backends can 
+	provide devices from a recording (see ReplayBackend) or any other 
+	source, which lets the library run without DirectInput.
+*/
+class Backend
+{
+public:
+	virtual ~Backend() {}
+
+	// List the game controllers currently connected
+	virtual void				enumerateDevices( DeviceIdentifiers& deviceInstances ) = 0;
+
+	// Returns NULL if the device can't be opened. The caller owns the returned object
+	virtual DeviceBackend*		createDeviceBackend( const DeviceInstance& deviceInstance ) = 0;
+
+	// The current time in the time base of the event timestamps (in milliseconds)
+	virtual DWORD				getTickCount() = 0;
+
+	// Returns true once after each change of the list of connected devices.
+	// A backend that can't tell always returns false (see BackendEnumerationTrigger)
+	virtual bool				hasDeviceListChanged()		{ return false; }
+
+	// The path of a device, as carried by the DeviceChangeHints of the triggers.
+	// Returns false if the backend has no such path for the device
+	virtual bool				getDevicePath( const DeviceInstance& /*deviceInstance*/, std::string& /*devicePath*/ )	{ return false; }
+
+	// Find the connected device with the given path, without enumerating all the 
+	// devices. Returns false if the device isn't found or if the backend can't do it
+	virtual bool				findDevice( const std::string& /*devicePath*/, DeviceInstance& /*deviceInstance*/ )	{ return false; }
+};
+
+}
@@ -28,10 +28,71 @@
 namespace RDI
 {
 
+/*
+	ButtonDebouncer
+
+	Filters out the chatter of a worn switch, i.e. the quick series of 
+	press/release it reports when it's pressed or released once.
+	
+	The debouncer works with the DirectInput timestamps of the events 
+	(in milliseconds) and has two modes:
+	- LeadingEdge: a change of state is accepted immediately, then the 
+	  following changes are ignored for the duration of the window. 
+	  This adds no latency
+	- TrailingEdge: a change of state is accepted only once the state has
+	  been stable for the duration of the window. This also rejects glitches
+	  (spurious presses shorter than the window) but adds latency
+	In both modes, the accepted state always ends up matching the raw state 
+	of the button once it stops changing for the duration of the window.
+
+	Since a state can be accepted when no event occurs, update() must also 
+	be called regularly with the current time.
+*/
+class ButtonDebouncer
+{
+public:
+	enum Mode
+	{
+		LeadingEdge,
+		TrailingEdge
+	};
+
+	ButtonDebouncer( bool isPressed );
+
+	Mode				getMode() const					{ return mMode; }
+	DWORD				getWindow() const				{ return mWindow; }
+	void				setWindow( DWORD windowInMs, Mode mode );
+
+	bool				isPressed() const				{ return mIsPressed; }
+	bool				isPending() const				{ return mIsRawPressed!=mIsPressed; }
+
+	// Each method returns true if the accepted state has changed
+	bool				update( bool isRawPressed, DWORD timeStamp );
+	bool				update( DWORD currentTime );
+
+	unsigned int		getNumRawEdges() const			{ return mNumRawEdges; }
+	unsigned int		getNumSuppressedEdges() const	{ return mNumRawEdges - mNumEdges; }
+
+private:
+	void				accept( DWORD time );
+
+	Mode				mMode;
+	DWORD				mWindow;
+	bool				mIsPressed;
+	bool				mIsRawPressed;
+	DWORD				mLastEdgeTime;		// Last accepted edge in LeadingEdge mode, last raw edge in TrailingEdge mode
+	unsigned int		mNumRawEdges;
+	unsigned int		mNumEdges;
+};
+
 /*
 	Button
 
 	The Button object represent a simple on/off button on a joystick.
+
+	A debounce window can be set on the Button via its parent Device 
+	(see Device::setButtonDebounce()) to filter out switch chatter 
+	before the listeners are notified (see ButtonDebouncer).
 */
 class Button : public Object
 {
@@ -42,12 +103,19 @@ public:
 	
 	virtual std::string	toString() const;
 	virtual void		updateFrom( const DIDEVICEOBJECTDATA& entry );
+	virtual DWORD		getData() const;
+
+	const ButtonDebouncer&	getDebouncer() const	{ return mDebouncer; }
 
 protected:
 	void				setPressed( bool isPressed );
 
 private:
+	friend class Device;
+	void				updateDebouncer( DWORD currentTime );
+
 	bool				mIsPressed;
+	ButtonDebouncer		mDebouncer;
 };
 
 }
@@ -23,11 +23,7 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
 #include <string>
 
@@ -39,16 +35,23 @@ class Common
 public:
 	static std::string	TCHARToUTF8( const TCHAR* tcharString );
 
+	// Convert to a null-terminated string, truncated to fit the buffer (whose size is in characters)
+	static void			UTF8ToTCHAR( const std::string& utf8String, TCHAR* tcharString, std::size_t bufferSize );
+
+#ifdef _WIN32
 	static bool			isXInputController( const GUID* pGuidProductFromDirectInput );
 
 	static const char*	HRESULTToString( HRESULT hr );
+#endif
 
 	static std::string	GUIDToString(const GUID* guid);
 
+#ifdef _WIN32
 private:
 	static std::wstring	MBCStoUTF16String( const std::string& mbcsString );
 	static std::string	UTF16toUTF8String( const std::wstring& utf16String );
 	static std::wstring	UTF8toUTF16String( const std::string& utf8String );
+#endif
 };
 
 }
@@ -0,0 +1,82 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIObjectInstance.h"
+
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	DataFormat
+
+	The layout of the state of a device, i.e. where the state of each of its
+	objects is stored in the buffer returned by GetDeviceState(). It's the 
+	portable counterpart of a DIDATAFORMAT.
+
+	The predefined c_dfDIJoystick2 format (DIJOYSTATE2) is 272 bytes large, 
+	whatever the device, and can't hold more than 8 axes, 4 POVs and 128 
+	buttons. A minimal format holds exactly the objects it's created with: 
+	the axes and POVs first, a DWORD each, then the buttons, a byte each. 
+	The size is rounded up to a multiple of 4 bytes, as DirectInput requires.
+*/
+class DataFormat
+{
+public:
+	DataFormat();
+
+	static const DWORD			joystick2DataSize = 272;		// sizeof(DIJOYSTATE2)
+
+	struct ObjectFormat
+	{
+		DWORD		objectType;		// The dwType of the ObjectInstance
+		DWORD		offset;
+	};
+	typedef std::vector<ObjectFormat> ObjectFormats;
+
+	// The axes, buttons and POVs of the list, the other objects are ignored
+	static DataFormat			createMinimal( const ObjectInstances& objectInstances );
+	
+	// The format the objects are already in, as given by their dwOfs (e.g. 
+	// c_dfDIJoystick2). The objects that don't fit in the data are ignored
+	static DataFormat			createFromOffsets( const ObjectInstances& objectInstances, DWORD dataSize );
+
+	DWORD						getDataSize() const				{ return mDataSize; }
+	const ObjectFormats&		getObjects() const				{ return mObjects; }
+	bool						isEmpty() const					{ return mObjects.empty(); }
+	int							findObject( DWORD objectType ) const;
+
+	// The state of an object in a state buffer, encoded like the dwData of its events
+	static DWORD				readState( const BYTE* data, const ObjectFormat& object );
+	static void					writeState( BYTE* data, const ObjectFormat& object, DWORD state );
+	static DWORD				getStateSize( DWORD objectType );
+
+private:
+	ObjectFormats				mObjects;
+	DWORD						mDataSize;
+};
+
+}
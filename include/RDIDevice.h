@@ -23,18 +23,144 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
+#include <memory>
+#include "RDIBackend.h"
 #include "RDIDeviceInstance.h"
+#include "RDIDirtyObjectSet.h"
+#include "RDIListenerRegistry.h"
 #include "RDIObject.h"
+#include "RDIAxisFilter.h"
+#include "RDIButton.h"
 
 namespace RDI
 {
 
+class Axis;
+
+/*
+	ObjectChange
+
+	The description of a change of an Object of a Device, as received by a
+	Device::BatchListener. The states are encoded like Object::getData() 
+	does (for an Axis with a change threshold, the old state is the value 
+	that was last notified). The timestamp is the one of the DirectInput 
+	event that caused the change, or the time of the update for the changes
+	made by the axis filters and button debouncers.
+
+	A resync change doesn't come from an event but from the state of the 
+	device, read after events were lost (see Device::requestResync()).
+*/
+struct ObjectChange
+{
+	enum Type
+	{
+		AxisChange,
+		ButtonChange,
+		POVChange
+	};
+
+	unsigned int			objectIndex;		// The index of the Object in Device::getObjects()
+	Type					type;
+	DWORD					oldData;
+	DWORD					newData;
+	DWORD					timeStamp;
+	bool					isResync;
+};
+
+/*
+	ObjectFilter
+
+	Selects the objects of a Device a Device::Listener is interested in. An 
+	Object passes the filter if it matches all of its criteria:
+	- its type (see the Types flags)
+	- its index in Device::getObjects(), if a list of indices is given
+	- its HID usage page and usage (see ObjectInstance::getUsagePage() and 
+	  getUsage()), if they're not 0
+	The default filter lets every object through.
+*/
+struct ObjectFilter
+{
+	enum Types
+	{
+		Axes	= 1 << 0,
+		Buttons	= 1 << 1,
+		POVs	= 1 << 2,
+		AllTypes = Axes | Buttons | POVs
+	};
+
+	ObjectFilter();
+	static ObjectFilter			types( unsigned int typeFlags );
+	static ObjectFilter			objects( const std::vector<unsigned int>& objectIndices );
+	static ObjectFilter			hidUsage( WORD usagePage, WORD usage=0 );
+
+	bool						accepts( const Object* object ) const;
+
+	unsigned int				typeFlags;
+	std::vector<unsigned int>	objectIndices;		// Any object if empty
+	WORD						usagePage;			// Any usage page if 0
+	WORD						usage;				// Any usage if 0
+};
+
+/*
+	ReacquireBackoff
+
+	Decides when a Device that couldn't acquire its device tries again (the
+	device was unplugged but is still in the list, another application has
+	the priority on it, etc...). After each failed attempt, the delay before
+	the next one doubles, from minDelay up to maxDelay, so a dead device 
+	doesn't cost failing calls at every update. A random part of the delay 
+	(jitter) is removed, so the devices lost at once (a hub unplugged) don't
+	retry all at the same update. A device that comes back is reacquired 
+	within maxDelay. A successful acquisition resets the delay.
+
+	The times are in milliseconds, in the time base of the Backend. With a 
+	minDelay of 0, an acquisition is attempted at every update.
+*/
+class ReacquireBackoff
+{
+public:
+	struct Settings
+	{
+		Settings();
+
+		DWORD			minDelayInMs;
+		DWORD			maxDelayInMs;
+		unsigned int	jitterPercent;		// The part of the delay that can be removed at random (0..100)
+	};
+
+	ReacquireBackoff( unsigned int seed=1 );
+
+	const Settings&		getSettings() const			{ return mSettings; }
+	void				setSettings( const Settings& settings );
+
+	// An attempt is due if the previous one didn't fail, or if its delay has elapsed
+	bool				isBackingOff() const		{ return mNumConsecutiveFailures>0; }
+	bool				isAttemptDue( DWORD currentTime ) const;
+	void				onAttempt( bool succeeded, DWORD currentTime );
+
+	DWORD				getDelay() const			{ return mDelay; }
+	DWORD				getNextAttemptTime() const	{ return mNextAttemptTime; }
+
+	// Counters
+	unsigned int		getNumAttempts() const		{ return mNumAttempts; }
+	unsigned int		getNumFailures() const		{ return mNumFailures; }
+	unsigned int		getNumSkippedPolls() const	{ return mNumSkippedPolls; }
+
+private:
+	friend class Device;
+
+	Settings			mSettings;
+	unsigned int		mRandomState;
+	unsigned int		mNumConsecutiveFailures;
+	DWORD				mDelay;						// Before the next attempt, jitter excluded
+	DWORD				mNextAttemptTime;
+	unsigned int		mNumAttempts;
+	unsigned int		mNumFailures;
+	unsigned int		mNumSkippedPolls;			// The updates that didn't attempt anything
+};
+
 /*
 	Device
 
@@ -47,10 +173,56 @@ namespace RDI
 	These can be inspected using the getObjects() method.
 
 	It's possible to register listeners to the Device so client code can
-	be notified whenever its objects change.
+	be notified whenever its objects change. A Listener is called for each
+	change, as it happens, and can be registered with an ObjectFilter so it
+	only gets the changes of the objects it cares about. The Device works 
+	out, for each Object, which listeners are interested in it when the 
+	listeners are added or removed, so the others cost nothing when it 
+	changes. A BatchListener is called once at the end of 
+	update() with all the changes of the update, which is much cheaper when
+	the objects change often and there are many listeners.
+
+	A Listener that doesn't need every change (a display refreshing at 30 Hz
+	for example) can be registered with a minimum interval between its 
+	notifications. The Device then keeps track of the objects that changed
+	since it was last notified and, once the interval has elapsed, calls it
+	at the end of update() once for each of these objects, which then have 
+	their latest value. The other listeners are not affected. A BatchListener
+	can be throttled too: it then gets a single call with one consolidated 
+	change per Object. The pending changes are notified even when the device
+	can't be read anymore.
+
+	Client code that polls the Device rather than listening to it can 
+	register a DirtyObjectSet to find out which objects changed since it 
+	last looked, without comparing the state of every Object.
+
+	The listeners can be added and removed from any thread, even from within
+	a notification, while the Device is being updated (see ListenerRegistry).
+	When removed from another thread, a listener is no longer called once the
+	remove method returns, as it waits for the update() in progress. When 
+	removed from within a notification, it can still be called until the end
+	of the update(). A Device must be updated by one thread at a time though.
+
+	A filter can be set on each Axis to remove jitter (see AxisFilter). 
+	The filters of all the axes of the Device run together at the end of 
+	update(), and the listeners are notified of the filtered values only.
+	Similarly, the buttons can be debounced (see ButtonDebouncer).
+
+	When the device can't be acquired, the Device tries again later and 
+	later (see ReacquireBackoff) and keeps the last valid state meanwhile.
+
+	Events can be lost: the buffer of the device overflows, the input is 
+	lost, or (for the backends whose sequence numbers are contiguous) a gap
+	shows in the sequence numbers. A button release could be missed that 
+	way, so the Device then reads the current state of the device and 
+	updates its objects from it. The changes are notified like the others,
+	flagged as resync changes (see ObjectChange::isResync).
 
 	Various information about the device itself (name, type, etc...) can be 
 	obtained via the DeviceInstance object associated with it.
+
+	The Device gets its objects and events from a DeviceBackend, created by
+	the Backend of the DeviceManager (DirectInput, a replayed recording, etc...)
 */
 class Device
 {
@@ -58,12 +230,21 @@ public:
 	void						update();
 
 	//HWND						getWindowHandle() const			{ return mWindowHandle; }
-	IDirectInput8*				getDirectInput() const			{ return mDirectInput; }
+	Backend*					getBackend() const				{ return mBackend; }
 	const DeviceInstance&		getDeviceInstance() const		{ return mDeviceInstance; }
 	//DWORD						getCoopSettings() const			{ return mCoopSettings; }
-	IDirectInputDevice8*		getInputDevice() const			{ return mInputDevice; }
+	DeviceBackend*				getDeviceBackend() const		{ return mDeviceBackend; }
+
+	// The minimal format built from the enabled objects of the Device. It's 
+	// empty if the backend keeps its own format
+	const DataFormat&			getDataFormat() const			{ return mDataFormat; }
 
 	const Objects&				getObjects() const { return mObjects; }
+
+	// The activity of the last update(): the number of events read and of 
+	// the changes notified (which can also come from the filters and debouncers)
+	unsigned int				getNumUpdateEvents() const		{ return mNumUpdateEvents; }
+	unsigned int				getNumUpdateChanges() const		{ return mNumUpdateChanges; }
 	
 	class Listener
 	{
@@ -72,40 +253,165 @@ public:
 	};
 
 	void						addListener( Listener* listener );
+	void						addListener( Listener* listener, const ObjectFilter& filter );
+	void						addListener( Listener* listener, const ObjectFilter& filter, DWORD minIntervalInMs );
 	bool						removeListener( Listener* listener );
-	void						removeListeners();
+	void						removeListeners();		// Only the Listeners, not the BatchListeners nor the DirtyObjectSets
+
+	// The change being notified. Only valid during a call to Listener::onObjectChanged()
+	// made as the change happens (i.e. not for a throttled Listener)
+	const ObjectChange&			getCurrentChange() const		{ return mCurrentChange; }
+
+	class BatchListener
+	{
+	public:
+		// The changes are in the order they happened. They are only valid during the call
+		virtual void onObjectsChanged( Device* /*device*/, const ObjectChange* /*changes*/, std::size_t /*numChanges*/ ) {}
+	};
+
+	void						addBatchListener( BatchListener* listener );
+	bool						removeBatchListener( BatchListener* listener );
+
+	// A throttled BatchListener gets at most one call per interval. Each Object
+	// appears once among the changes, in the order the objects first changed:
+	// the old state is the one before its first change, the new state, the 
+	// timestamp and the resync flag are the ones of its latest change
+	void						addBatchListener( BatchListener* listener, DWORD minIntervalInMs );
+
+	// The set must have one bit per Object. It's removed like a listener
+	void						addDirtyObjectSet( DirtyObjectSet* dirtyObjectSet );
+	bool						removeDirtyObjectSet( DirtyObjectSet* dirtyObjectSet );
+
+	// Set the filter applied on the values of an Axis of this Device.
+	// Use a default AxisFilter (of type None) to remove the filter
+	void						setAxisFilter( Axis* axis, const AxisFilter& filter );
+	AxisFilter					getAxisFilter( const Axis* axis ) const;
+
+	// Set the change threshold of all the axes of this Device (see Axis::setChangeThreshold())
+	void						setAxisChangeThreshold( LONG threshold );
+	LONG						getAxisChangeThreshold() const	{ return mAxisChangeThreshold; }
+
+	// Set the debounce window of a Button of this Device, or of all its buttons.
+	// A window of 0 disables the debouncing. Changing the window resets the 
+	// counters of the ButtonDebouncer
+	void						setButtonDebounce( Button* button, DWORD windowInMs, ButtonDebouncer::Mode mode );
+	void						setButtonDebounce( DWORD windowInMs, ButtonDebouncer::Mode mode );
+
+	// Disabled objects don't change nor notify anymore. Their events are dropped
+	// by the device itself when the backend accepts a DataFormat (it's updated 
+	// at the next update, which also reacquires the device), and ignored by the
+	// Device otherwise. All the objects are enabled when the Device is created.
+	// A re-enabled object is resynchronised with the state of the device 
+	bool						setObjectEnabled( Object* object, bool isEnabled );
+
+	// Enable the objects that pass the filter and disable the others
+	void						setEnabledObjects( const ObjectFilter& filter );
+	unsigned int				getNumEnabledObjects() const;
+
+	// Resynchronise the objects from the current state of the device at the 
+	// next update, like it is done when events are lost
+	void						requestResync()					{ mIsResyncNeeded = true; }
+
+	// Counters of the lost events detected and of the resyncs. A resync 
+	// fails if the backend can't provide the state of the device
+	unsigned int				getNumOverflows() const			{ return mNumOverflows; }
+	unsigned int				getNumSequenceGaps() const		{ return mNumSequenceGaps; }
+	unsigned int				getNumResyncs() const			{ return mNumResyncs; }
+	unsigned int				getNumFailedResyncs() const		{ return mNumFailedResyncs; }
+
+	// How the device is reacquired when it can't be (see ReacquireBackoff)
+	void						setReacquireSettings( const ReacquireBackoff::Settings& settings )	{ mReacquireBackoff.setSettings( settings ); }
+	const ReacquireBackoff&		getReacquireBackoff() const		{ return mReacquireBackoff; }
 	
 protected:
 	friend class DeviceManager;
-	Device( /*HWND windowHandle,*/ IDirectInput8* directInput, const DeviceInstance& identifier/*, DWORD coopSettings*/);
+	Device( /*HWND windowHandle,*/ Backend* backend, const DeviceInstance& identifier/*, DWORD coopSettings*/);
 	virtual ~Device();
 
 	bool						initialize();
 	bool						enumerateObjects();
-	static BOOL CALLBACK		enumObjectsCallback( LPCDIDEVICEOBJECTINSTANCE lpddoi, LPVOID pvRef );
 
 	void						addObject( Object* object );
 	void						deleteObjects();
 
-	static bool					getDeviceData( IDirectInputDevice8* device, LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries );
+	bool						getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries );
 	
 	friend class Object;
-	void						notifyObjectChanged( Object* object );
+	void						notifyObjectChanged( Object* object, DWORD oldData );
+	void						notifyBatchListeners();
+	void						notifyThrottledListeners( DWORD currentTime );
+
+	friend class Axis;
+	void						pushAxisFilterSample( Axis* axis, const DIDEVICEOBJECTDATA& entry );
+	void						processAxisFilters( DWORD currentTime );
+
+	void						processButtonDebouncers( DWORD currentTime );
+	void						resync( DWORD currentTime );
+	void						updateDataFormat();
 
 private:
 	//HWND						mWindowHandle;
-	IDirectInput8*				mDirectInput;
+	Backend*					mBackend;
 	DeviceInstance				mDeviceInstance;
 	//DWORD						mCoopSettings;
 	
 	static const unsigned int	mDataBufferSize = 124;
-	IDirectInputDevice8*		mInputDevice;
+	DeviceBackend*				mDeviceBackend;
+	DataFormat					mDataFormat;
 	
 	Objects						mObjects;
 
 	// Listeners
 	typedef						std::vector<Listener*> Listeners; 
-	Listeners					mListeners;
+	typedef						std::vector<BatchListener*> BatchListeners; 
+	class ThrottledListener;
+	class ThrottledBatchListener;
+	struct ListenerSnapshot
+	{
+		Listeners					listeners;
+		std::vector<ObjectFilter>	filters;				// One per listener
+		Listeners					dispatchListeners;		// The listeners interested in each Object, one object after the other
+		std::vector<unsigned int>	dispatchOffsets;		// Where the listeners of each Object start in dispatchListeners
+		std::vector<std::shared_ptr<ThrottledListener>>	throttledListeners;		// Registered in listeners in place of the client listeners
+		BatchListeners				batchListeners;
+		std::vector<std::shared_ptr<ThrottledBatchListener>>	throttledBatchListeners;	// Registered in batchListeners
+		std::vector<DirtyObjectSet*>	dirtyObjectSets;
+	};
+	void						updateDispatchLists( ListenerSnapshot& snapshot ) const;
+
+	ListenerRegistry<ListenerSnapshot>	mListenerRegistry;
+	std::vector<ObjectChange>	mChanges;				// The changes of the current update, for the batch listeners
+	ObjectChange				mCurrentChange;
+	DWORD						mTimeStamp;				// The time of the change being processed
+	unsigned int				mNumUpdateEvents;
+	unsigned int				mNumUpdateChanges;
+
+	// Axis filters
+	AxisFilterBank				mAxisFilterBank;
+	std::vector<Axis*>			mFilteredAxes;
+
+	LONG						mAxisChangeThreshold;
+
+	// Debounced buttons
+	std::vector<Button*>		mDebouncedButtons;
+
+	ReacquireBackoff			mReacquireBackoff;
+
+	// Lost events
+	bool						mHasContiguousSequences;	// Of the DeviceBackend
+	bool						mHasSequence;				// Whether mLastSequence is valid
+	DWORD						mLastSequence;
+	bool						mHasBeenAcquired;
+	bool						mIsResyncNeeded;
+	bool						mIsResyncing;
+	Objects						mResyncObjects;				// The enabled objects
+	std::vector<DWORD>			mObjectTypes;				// Of mResyncObjects
+	std::vector<DWORD>			mObjectStates;
+	bool						mIsDataFormatDirty;
+	unsigned int				mNumOverflows;
+	unsigned int				mNumSequenceGaps;
+	unsigned int				mNumResyncs;
+	unsigned int				mNumFailedResyncs;
 };
 
 }
@@ -23,18 +23,47 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
-#include <tchar.h>
+#include "RDIPlatform.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
+#include "RDITime.h"
 
 namespace RDI
 {
 
+class Backend;
+
+/*
+	DeviceChangeHint
+
+	What a trigger knows about a change of the device list: a device arrived
+	or was removed, and its path (the device interface path on Windows, as 
+	carried by WM_DEVICECHANGE). It lets the DeviceManager add or remove 
+	just that device rather than enumerating them all (see 
+	DeviceManager::applyChangeHints() and Backend::getDevicePath()).
+*/
+struct DeviceChangeHint
+{
+	enum Type
+	{
+		Arrival,
+		Removal
+	};
+
+	DeviceChangeHint();
+	DeviceChangeHint( Type type, const std::string& devicePath );
+
+	Type			type;
+	std::string		devicePath;
+};
+
+typedef std::vector<DeviceChangeHint> DeviceChangeHints;
+
 /*
 	DeviceEnumerationTrigger
 
@@ -46,14 +75,117 @@ class DeviceEnumerationTrigger
 public:
 	virtual~ DeviceEnumerationTrigger() {}
 	virtual bool	enumerationNeeded() = 0;
+
+	// Called after enumerationNeeded() returned true. Appends the hints about 
+	// the changes since the previous enumeration and returns true if they 
+	// describe all of them. Returns false if the trigger can't tell exactly 
+	// what changed, in which case all the devices are enumerated
+	virtual bool	getChangeHints( DeviceChangeHints& /*hints*/ )		{ return false; }
 };
 
+/*
+	EnumerationSignal
+
+	Hands the device changes over from the thread that is notified of them to 
+	the thread that updates the DeviceManager. The notified thread raises the
+	signal (with a DeviceChangeHint when it has one), the update thread 
+	consumes it. When nothing happened, consume() is a single atomic load.
+
+	The signals raised between two calls to consume() are merged, along with
+	their hints. A signal raised without a hint makes the merged hints 
+	incomplete, so the DeviceManager falls back on a full enumeration.
+*/
+class EnumerationSignal
+{
+public:
+	EnumerationSignal();
+
+	// From any thread
+	void			raise();
+	void			raise( const DeviceChangeHint& hint );
+
+	// From the update thread. consume() returns true if the signal was raised 
+	// since the previous call. The hints are the ones of that call
+	bool			consume();
+	bool			getChangeHints( DeviceChangeHints& hints );
+
+	unsigned int	getNumRaised() const			{ return mNumRaised.load( std::memory_order_relaxed ); }
+	unsigned int	getNumConsumed() const			{ return mNumConsumed; }
+
+private:
+	std::atomic<bool>			mIsRaised;
+	std::atomic<unsigned int>	mNumRaised;
+	std::mutex					mMutex;				// Protects the hints being collected
+	DeviceChangeHints			mHints;
+	bool						mAreHintsComplete;
+	DeviceChangeHints			mConsumedHints;		// Only used by the update thread
+	bool						mAreConsumedHintsComplete;
+	unsigned int				mNumConsumed;
+};
+
+/*
+	ThreadedEnumerationTrigger
+
+	Base class for the triggers whose notifications are received on a thread 
+	of their own. The subclass implements run(), which waits for the 
+	notifications and raises the signal, and requestStop(), which makes 
+	run() return from any thread. enumerationNeeded() only consumes the 
+	signal, so it costs an atomic load per update when nothing happens.
+
+	The subclass calls start() once it is constructed, and stop() in its 
+	destructor. start() returns once run() has called notifyStarted() (or 
+	has returned), so a notification can't be missed between the 
+	construction of the trigger and its first use. The signal is raised 
+	once at start, so the devices connected at startup get enumerated.
+*/
+class ThreadedEnumerationTrigger : public DeviceEnumerationTrigger
+{
+public:
+	virtual ~ThreadedEnumerationTrigger();
+	virtual bool	enumerationNeeded();
+	virtual bool	getChangeHints( DeviceChangeHints& hints );
+
+	EnumerationSignal&		getSignal()				{ return mSignal; }
+	bool					isRunning() const		{ return mIsRunning.load( std::memory_order_acquire ); }
+
+protected:
+	ThreadedEnumerationTrigger();
+
+	void			start();
+	void			stop();
+	void			notifyStarted();
+
+	// On the notification thread
+	virtual void	run() = 0;
+
+	// From any thread
+	virtual void	requestStop() = 0;
+
+private:
+	void			threadMain();
+
+	EnumerationSignal		mSignal;
+	std::thread				mThread;
+	std::mutex				mStartMutex;
+	std::condition_variable	mStartCondition;
+	bool					mHasStarted;
+	std::atomic<bool>		mIsRunning;
+};
+
+#ifdef _WIN32
 /*
 	WindowsHookEnumerationTrigger
 
 	A trigger based on a Windows Proc hook. The hook is installed, then
 	whenever a WM_DEVICECHANGE message is received, the trigger indicates 
 	that a device enumeration at the DeviceManager level is needed
+
+	With the invisible window, the trigger also registers for the device 
+	interface notifications, whose DBT_DEVICEARRIVAL and 
+	DBT_DEVICEREMOVECOMPLETE messages carry the path of the device. These 
+	are turned into DeviceChangeHints. The other WM_DEVICECHANGE messages 
+	(DBT_DEVNODES_CHANGED in particular) come along with them, so the hints
+	are only considered incomplete when there is none.
 */
 class WindowsHookEnumerationTrigger : public DeviceEnumerationTrigger
 {
@@ -61,6 +193,7 @@ public:
 	WindowsHookEnumerationTrigger( bool createInvisibleWindow );	
 	virtual ~WindowsHookEnumerationTrigger();
 	virtual bool	enumerationNeeded();
+	virtual bool	getChangeHints( DeviceChangeHints& hints );
 
 private:
 	bool			createInvisibleWindow();
@@ -73,8 +206,44 @@ private:
 	
 	bool			mCreateInvisibleWindow;
 	HWND			mInvisibleWindow;
+	HDEVNOTIFY		mDeviceNotification;		// The device interface notifications carry the hints
 	bool			mEnumerationNeeded;
+	DeviceChangeHints	mChangeHints;
 };	
+
+/*
+	WindowsThreadEnumerationTrigger
+
+	A trigger that owns a message-only window on a thread of its own. The 
+	window registers for the device interface notifications, and the 
+	arrival/removal of a device raises the signal along with its path (see 
+	DeviceChangeHint). 
+
+	Unlike the WindowsHookEnumerationTrigger, it doesn't touch the messages
+	of the thread that updates the DeviceManager: no hook is installed and 
+	no message is peeked or dispatched there.
+
+	If the window can't be created or registered for the notifications, 
+	isRunning() returns false once constructed, and the trigger only fires 
+	at startup.
+*/
+class WindowsThreadEnumerationTrigger : public ThreadedEnumerationTrigger
+{
+public:
+	WindowsThreadEnumerationTrigger();
+	virtual ~WindowsThreadEnumerationTrigger();
+
+protected:
+	virtual void	run();
+	virtual void	requestStop();
+
+private:
+	static LRESULT CALLBACK windowProc( HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam );
+	static const TCHAR* windowClassName;
+
+	std::atomic<HWND>	mWindow;
+};
+#endif
 	
 /*
 	TimeBasedEnumerationTrigger
@@ -93,4 +262,137 @@ private:
 	unsigned int	mNextTime;
 };	
 
+/*
+	BackendEnumerationTrigger
+
+	A trigger for the backends that know when their list of devices changes
+	(see Backend::hasDeviceListChanged()). The first call to enumerationNeeded() 
+	always returns true, so the devices connected at startup get enumerated
+*/
+class BackendEnumerationTrigger : public DeviceEnumerationTrigger
+{
+public:
+	BackendEnumerationTrigger( Backend* backend );
+	virtual bool	enumerationNeeded();
+
+private:
+	Backend*		mBackend;
+	bool			mEnumerationNeeded;
+};
+
+/*
+	DebouncedEnumerationTrigger
+
+	Wraps another trigger (the source) to limit the number of enumerations:
+	- Debouncing: when the source fires, the enumeration is delayed until it 
+	  has been quiet for the settle window, so a burst of notifications 
+	  (the WM_DEVICECHANGE messages of a hub full of controllers for example)
+	  results in a single enumeration. The delay is capped by maxDelay, so a
+	  source that never settles still gets its enumerations
+	- Rate limiting: two enumerations are at least minInterval apart
+	- Safety check: if nothing triggered an enumeration for safetyInterval, 
+	  one is done anyway, in case the source missed a change (0 disables it)
+
+	The first call to enumerationNeeded() always returns true, so the devices
+	connected at startup get enumerated without delay.
+
+	The hints of the source (see getChangeHints()) are collected as it fires
+	and merged over the burst, so the enumeration they lead to can still be
+	a targeted one. They are only complete if the source's were for each of 
+	its triggers. The startup and safety enumerations have no hints, as they
+	are about changes the source didn't report.
+
+	The trigger takes the ownership of the source. The Clock isn't owned, 
+	the SystemClock is used if none is given.
+*/
+class DebouncedEnumerationTrigger : public DeviceEnumerationTrigger
+{
+public:
+	struct Settings
+	{
+		Settings();
+
+		unsigned int	settleWindowInMs;
+		unsigned int	maxDelayInMs;
+		unsigned int	minIntervalInMs;
+		unsigned int	safetyIntervalInMs;
+	};
+
+	DebouncedEnumerationTrigger( DeviceEnumerationTrigger* source, const Settings& settings=Settings(), Clock* clock=NULL );
+	virtual ~DebouncedEnumerationTrigger();
+	virtual bool	enumerationNeeded();
+	virtual bool	getChangeHints( DeviceChangeHints& hints );
+
+	const Settings&	getSettings() const					{ return mSettings; }
+
+	// Counters. The enumerations avoided are the times the source fired minus 
+	// the enumerations it caused. The startup enumeration is caused by the 
+	// source if it fired then (as most sources do on their first call)
+	unsigned int	getNumSourceTriggers() const		{ return mNumSourceTriggers; }
+	unsigned int	getNumEnumerations() const			{ return mNumEnumerations; }
+	unsigned int	getNumSafetyEnumerations() const	{ return mNumSafetyEnumerations; }
+	unsigned int	getNumAvoidedEnumerations() const;
+
+private:
+	DeviceEnumerationTrigger*	mSource;
+	Settings		mSettings;
+	Clock*			mClock;
+	SystemClock		mSystemClock;
+	bool			mHasEnumerated;
+	bool			mIsStartupFromSource;		// The source fired for the startup enumeration
+	bool			mIsPending;					// The source fired since the last enumeration
+	unsigned int	mFirstTriggerTime;			// Of the pending burst
+	unsigned int	mLastTriggerTime;
+	unsigned int	mLastEnumerationTime;
+	unsigned int	mNumSourceTriggers;
+	unsigned int	mNumEnumerations;
+	unsigned int	mNumSafetyEnumerations;
+	DeviceChangeHints	mPendingHints;				// Of the pending burst
+	bool			mArePendingHintsComplete;
+	DeviceChangeHints	mHints;						// Of the last enumeration
+	bool			mAreHintsComplete;
+};
+
+#ifdef __linux__
+/*
+	InotifyEnumerationTrigger
+
+	A trigger for Linux based on inotify. It watches a directory where the
+	device nodes appear and disappear (/dev/input by default) and indicates
+	that a device enumeration is needed only when a file is created in it or
+	deleted from it (or moved in or out). Nothing is polled: when nothing 
+	happens, enumerationNeeded() costs a single non-blocking read.
+
+	All the events that arrived since the previous call are consumed at once,
+	so a burst of events (the several nodes of a device plugged in, or the
+	devices of a hub) results in a single enumeration. The files can be 
+	filtered on the start of their name ("event" or "js" for example).
+
+	Like the BackendEnumerationTrigger, the first call to enumerationNeeded() 
+	always returns true. If the directory can't be watched (see isWatching()),
+	the trigger never indicates an enumeration after that.
+*/
+class InotifyEnumerationTrigger : public DeviceEnumerationTrigger
+{
+public:
+	InotifyEnumerationTrigger( const std::string& directory="/dev/input", const std::string& fileNamePrefix="" );
+	virtual ~InotifyEnumerationTrigger();
+	virtual bool	enumerationNeeded();
+
+	const std::string&		getDirectory() const		{ return mDirectory; }
+	bool					isWatching() const			{ return mWatchDescriptor>=0; }
+
+	// The number of relevant events received (after filtering on the name)
+	unsigned int			getNumEvents() const		{ return mNumEvents; }
+
+private:
+	std::string		mDirectory;
+	std::string		mFileNamePrefix;
+	int				mFileDescriptor;
+	int				mWatchDescriptor;
+	bool			mEnumerationNeeded;
+	unsigned int	mNumEvents;
+};
+#endif
+
 }
\ No newline at end of file
@@ -23,12 +23,9 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
+#include <string>
 #include <vector>
 
 namespace RDI
@@ -78,5 +75,35 @@ private:
 
 typedef std::vector<DeviceInstance> DeviceIdentifiers;
 
+/*
+	DeviceListFingerprint
+
+	A cheap summary of a list of devices: their number and a hash of their 
+	instance GUIDs that doesn't depend on their order. Two lists with 
+	different fingerprints are different. Two lists with the same 
+	fingerprint are almost certainly the same (they could only differ by 
+	a hash collision or by the names of the devices).
+
+	The fingerprint can also be kept up to date as devices are added and
+	removed, without going over the whole list.
+*/
+struct DeviceListFingerprint
+{
+	DeviceListFingerprint();
+	static DeviceListFingerprint	compute( const DeviceIdentifiers& deviceInstances );
+
+	void					add( const DeviceInstance& deviceInstance );
+	void					remove( const DeviceInstance& deviceInstance );
+
+	bool operator==( const DeviceListFingerprint& other ) const		{ return numDevices==other.numDevices && hash==other.hash; }
+	bool operator!=( const DeviceListFingerprint& other ) const		{ return !(*this==other); }
+
+	unsigned int			numDevices;
+	unsigned long long int	hash;
+
+private:
+	static unsigned long long int	hashDevice( const DeviceInstance& deviceInstance );
+};
+
 }
 
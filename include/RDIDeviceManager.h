@@ -23,19 +23,16 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
 #include <vector>
 #include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIPollScheduler.h"
 
 namespace RDI
 {
 
-class DeviceEnumerationTrigger;
 	
 /*
 	DeviceManager
@@ -44,19 +41,50 @@ class DeviceEnumerationTrigger;
 	the Devices that are currently connected to the computer.
 
 	It is possible to register listeners the manager so client code can be 
-	called whenever a Device is plugged in or removed.
+	called whenever a Device is plugged in or removed. Like for the Device,
+	the listeners can be added and removed from any thread, even from 
+	within a notification (see ListenerRegistry).
+
+	The devices come from a Backend: DirectInput by default, or any other 
+	Backend passed to the constructor (see ReplayBackend for example).
 */
 class DeviceManager
 {
 public:
 	typedef std::vector<std::pair<DeviceInstance, Device*>> DeviceList;
 	
+#ifdef _WIN32
+	// The device notifications are received on a thread of their own (see 
+	// WindowsThreadEnumerationTrigger). If that thread can't create its 
+	// window, the DeviceManager falls back to a WindowsHookEnumerationTrigger,
+	// which creates an invisible window for a console application
 	DeviceManager( bool ignoreXInputControllers, bool consoleApplication /*, HWND windowHandle*/ );
+#endif
+
+	// The Backend isn't owned by the DeviceManager and must outlive it. 
+	// The DeviceManager takes the ownership of the trigger
+	DeviceManager( Backend* backend, DeviceEnumerationTrigger* enumerationTrigger );
 	virtual ~DeviceManager();
 
 	virtual void				update();
+
+	// Enumerate the devices and add/remove the ones that appeared/disappeared.
+	// When the fingerprint of the enumerated devices is the one of the current
+	// devices, which is the common case, nothing more is done
 	void						updateDeviceList();
 
+	// Add/remove just the devices the hints are about (see DeviceChangeHint). 
+	// Returns false if a hint can't be applied for sure (a device not found 
+	// by the Backend, a device whose path is unknown, etc...), in which case 
+	// updateDeviceList() must be called. update() does so when the trigger 
+	// provides hints, and only falls back on a full enumeration when needed
+	bool						applyChangeHints( const DeviceChangeHints& hints );
+
+	// Counters of the calls to updateDeviceList() and to applyChangeHints() that succeeded
+	unsigned int				getNumEnumerations() const				{ return mNumEnumerations; }
+	unsigned int				getNumUnchangedEnumerations() const		{ return mNumUnchangedEnumerations; }
+	unsigned int				getNumTargetedUpdates() const			{ return mNumTargetedUpdates; }
+
 	class Listener
 	{
 	public:
@@ -68,31 +96,41 @@ public:
 	bool						removeListener( Listener* listener );
 	void						removeListeners();
 	
+	// How the devices are polled by update(). By default, every device is 
+	// polled at every update (see PollScheduler)
+	void						setPollSettings( const PollScheduler::Settings& settings )	{ mPollScheduler.setSettings( settings ); }
+	const PollScheduler&		getPollScheduler() const								{ return mPollScheduler; }
+
+	Backend*					getBackend() const		{ return mBackend; }
 	const DeviceList&			getDevices() const		{ return mDevices; }
 	Device*						getDeviceByName( const std::string& name ) const;
 
 private:
-	void						createDirectInput();
-	void						deleteDirectInput();
-	
-	
 	void						addDevice( const DeviceInstance& identifier );
 	void						removeDevice( const DeviceInstance& identifier );
+	int							findDeviceByPath( const std::string& devicePath ) const;
 
-	static BOOL	CALLBACK		enumDevicesCallback( LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef );
 	static void					deviceListToDeviceIdentifiers( const DeviceList& list, DeviceIdentifiers& identifiers );
 	static void					calculateAddedDevicesList( const DeviceIdentifiers& previousDevices, const DeviceIdentifiers& currentDevices, DeviceIdentifiers& addedDevices );
 	static void					calculateRemovedDevicesList( const DeviceIdentifiers& previousDevices, const DeviceIdentifiers& currentDevices, DeviceIdentifiers& addedRemoved );
 	
-	bool						mIgnoreXInputControllers;
+	Backend*					mBackend;
+	bool						mOwnsBackend;
 	DeviceEnumerationTrigger*	mEnumerationTrigger;
-	static IDirectInput8*		mDirectInput;
 	//HWND						mWindowHandle;
 	DeviceList					mDevices;
+	std::vector<std::string>	mDevicePaths;				// Of mDevices, empty when unknown
+	DeviceIdentifiers			mEnumeratedDevices;			// Kept to reuse its memory
+	DeviceListFingerprint		mFingerprint;				// Of mDevices
+	DeviceChangeHints			mChangeHints;				// Kept to reuse its memory
+	unsigned int				mNumEnumerations;
+	unsigned int				mNumUnchangedEnumerations;
+	unsigned int				mNumTargetedUpdates;
+	PollScheduler				mPollScheduler;				// One device per entry of mDevices
 
 	// Listeners
 	typedef						std::vector<Listener*> Listeners; 
-	Listeners					mListeners;
+	ListenerRegistry<Listeners>	mListeners;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include "RDIBackend.h"
+
+namespace RDI
+{
+
+/*
+	DirectInputDeviceBackend
+
+	A DirectInput device (IDirectInputDevice8)
+*/
+class DirectInputDeviceBackend : public DeviceBackend
+{
+public:
+	DirectInputDeviceBackend( IDirectInputDevice8* inputDevice );
+	virtual ~DirectInputDeviceBackend();
+
+	IDirectInputDevice8*		getInputDevice() const		{ return mInputDevice; }
+
+	virtual bool				setBufferSize( DWORD numEntries );
+	virtual bool				enumerateObjects( ObjectInstances& objectInstances );
+
+	// The device starts with the c_dfDIJoystick2 format. A DataFormat replaces it
+	// with a DIDATAFORMAT holding exactly its objects
+	virtual bool				setDataFormat( const DataFormat& dataFormat );
+	virtual bool				getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue );
+	virtual bool				setObjectUserData( DWORD objectType, UINT_PTR userData );
+	virtual HRESULT				acquire();
+	virtual void				unacquire();
+	virtual HRESULT				getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries );
+
+	// Reads the immediate state of the device, in its current format. The 
+	// offsets of the objects in the state are looked up once for a given list
+	// of objects.
+	// Note that DirectInput numbers the events of all the devices with the
+	// same sequence, so hasContiguousSequences() keeps returning false
+	virtual HRESULT				getObjectStates( const DWORD* objectTypes, DWORD* states, std::size_t numObjects );
+
+private:
+	static BOOL CALLBACK		enumObjectsCallback( LPCDIDEVICEOBJECTINSTANCE lpddoi, LPVOID pvRef );
+
+	IDirectInputDevice8*		mInputDevice;
+	DWORD						mDataSize;
+	std::vector<DIOBJECTDATAFORMAT>	mObjectDataFormats;
+	std::vector<BYTE>			mState;
+	DataFormat::ObjectFormats	mRequestedObjects;		// The objects of the last call to getObjectStates()
+};
+
+/*
+	DirectInputBackend
+
+	The devices connected to the computer, as reported by DirectInput.
+	The IDirectInput8 object is shared by all the instances.
+*/
+class DirectInputBackend : public Backend
+{
+public:
+	DirectInputBackend( bool ignoreXInputControllers );
+	virtual ~DirectInputBackend();
+
+	IDirectInput8*				getDirectInput() const		{ return mDirectInput; }
+
+	virtual void				enumerateDevices( DeviceIdentifiers& deviceInstances );
+	virtual DeviceBackend*		createDeviceBackend( const DeviceInstance& deviceInstance );
+	virtual DWORD				getTickCount();
+
+	// The device interface path (DIPROP_GUIDANDPATH), as carried by WM_DEVICECHANGE.
+	// DirectInput has no lookup by path, so findDevice() isn't implemented and
+	// an arrival always leads to an enumeration
+	virtual bool				getDevicePath( const DeviceInstance& deviceInstance, std::string& devicePath );
+
+private:
+	void						createDirectInput();
+	void						deleteDirectInput();
+
+	static BOOL	CALLBACK		enumDevicesCallback( LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef );
+
+	bool						mIgnoreXInputControllers;
+	static IDirectInput8*		mDirectInput;
+};
+
+}
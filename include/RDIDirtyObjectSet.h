@@ -0,0 +1,99 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	DirtyObjects
+
+	The indices of the objects of a Device that changed, as fetched from a 
+	DirtyObjectSet. It's a bitset (one bit per Object, 64 objects per word), 
+	iterated with a count-trailing-zeros so only the set bits cost anything:
+
+		for ( unsigned int i=dirtyObjects.findFirst(); i!=DirtyObjects::npos; i=dirtyObjects.findNext(i) )
+			...
+*/
+class DirtyObjects
+{
+public:
+	static const unsigned int	npos = 0xFFFFFFFF;
+
+	DirtyObjects();
+
+	bool						isEmpty() const;
+	unsigned int				getCount() const;
+	bool						contains( unsigned int objectIndex ) const;
+
+	// Return npos when there is no (more) dirty object
+	unsigned int				findFirst() const;
+	unsigned int				findNext( unsigned int objectIndex ) const;
+
+private:
+	friend class DirtyObjectSet;
+	unsigned int				findFrom( std::size_t wordIndex, unsigned long long int word ) const;
+
+	std::vector<unsigned long long int>	mWords;
+};
+
+/*
+	DirtyObjectSet
+
+	Remembers which objects of a Device changed, for a consumer that polls 
+	the Device rather than listening to it (a simulation reading the inputs 
+	once per tick for example). Each consumer registers its own set with 
+	Device::addDirtyObjectSet(). The Device marks the objects as they are 
+	notified during update(), and the consumer gets and clears the marks 
+	with fetchAndClear(), so it only looks at the objects that changed since
+	it last did.
+
+	The marks are atomic, so fetchAndClear() can be called from another 
+	thread than the one updating the Device: a change is always either in
+	the fetched objects or left for the next fetch, never lost.
+*/
+class DirtyObjectSet
+{
+public:
+	DirtyObjectSet( std::size_t numObjects );
+	~DirtyObjectSet();
+
+	std::size_t					getNumObjects() const		{ return mNumObjects; }
+
+	void						markDirty( unsigned int objectIndex );
+	void						fetchAndClear( DirtyObjects& dirtyObjects );
+
+private:
+	DirtyObjectSet( const DirtyObjectSet& );
+	DirtyObjectSet& operator=( const DirtyObjectSet& );
+
+	std::size_t					mNumObjects;
+	std::size_t					mNumWords;
+	std::atomic<unsigned long long int>*	mWords;
+};
+
+}
@@ -0,0 +1,179 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	ListenerRegistry
+
+	Holds the listeners of a Device or DeviceManager (or anything else 
+	describing them, of type T) so they can be registered and unregistered 
+	from any thread, including from within a notification, while they are 
+	being notified.
+
+	The registry works like RCU: the dispatching thread reads the current 
+	snapshot with a single atomic load and never waits. A modification 
+	copies the snapshot, changes the copy and publishes it. The modifications
+	are serialized by a mutex, which only the registering threads wait for.
+	
+	The replaced snapshots can still be in use by the dispatching thread, so
+	they are only deleted when it calls reclaim(), which it must do at a 
+	point where it doesn't hold any snapshot (i.e. outside of a dispatch).
+	So there must be a single dispatching thread per registry.
+
+	A dispatch already in progress keeps notifying the listeners of the 
+	snapshot it started with. So after removing a listener, the registering
+	thread calls synchronize() to wait for that dispatch to finish (the grace
+	period), after which the listener is never called again and can be 
+	destroyed. The dispatching thread marks its dispatches with 
+	beginDispatch() and endDispatch() for that. A removal from within a 
+	notification doesn't wait (it would wait for itself): the removed listener
+	can still be called until the end of the dispatch. The registering thread 
+	must not hold anything a listener waits for while it synchronizes.
+*/
+template <class T>
+class ListenerRegistry
+{
+public:
+	ListenerRegistry();
+	~ListenerRegistry();
+
+	// Dispatching thread. The snapshot stays valid until the next call to reclaim()
+	const T&					get() const				{ return *mSnapshot.load( std::memory_order_seq_cst ); }
+
+	// Any thread. The modifier gets a copy of the current snapshot and returns
+	// false if it didn't change it, in which case nothing is published
+	template <class Modifier>
+	bool						modify( Modifier modifier );
+
+	// Dispatching thread, outside of a dispatch. If a modification is in 
+	// progress, the reclamation is postponed rather than waiting for it
+	void						reclaim();
+
+	// Dispatching thread. The snapshots got with get() are only used between the two
+	void						beginDispatch();
+	void						endDispatch();
+
+	// Any thread. Waits for the dispatch in progress, if any, unless it's 
+	// the one of the calling thread
+	void						synchronize() const;
+
+private:
+	ListenerRegistry( const ListenerRegistry& );
+	ListenerRegistry& operator=( const ListenerRegistry& );
+
+	std::atomic<const T*>		mSnapshot;
+	std::mutex					mMutex;					// Serializes the modifications and protects mRetiredSnapshots
+	std::vector<const T*>		mRetiredSnapshots;
+	std::atomic<bool>			mHasRetiredSnapshots;
+	std::atomic<unsigned int>	mDispatchCount;			// Odd during a dispatch
+	std::atomic<std::thread::id>	mDispatchingThread;
+};
+
+template <class T>
+ListenerRegistry<T>::ListenerRegistry()
+	: mSnapshot( new T() ),
+	  mHasRetiredSnapshots(false),
+	  mDispatchCount(0),
+	  mDispatchingThread( std::thread::id() )
+{
+}
+
+template <class T>
+ListenerRegistry<T>::~ListenerRegistry()
+{
+	for ( std::size_t i=0; i<mRetiredSnapshots.size(); ++i )
+		delete mRetiredSnapshots[i];
+	delete mSnapshot.load();
+}
+
+template <class T>
+template <class Modifier>
+bool ListenerRegistry<T>::modify( Modifier modifier )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	const T* snapshot = mSnapshot.load( std::memory_order_relaxed );
+	T* newSnapshot = new T( *snapshot );
+	if ( !modifier( *newSnapshot ) )
+	{
+		delete newSnapshot;
+		return false;
+	}
+	mSnapshot.store( newSnapshot, std::memory_order_seq_cst );
+	mRetiredSnapshots.push_back( snapshot );
+	mHasRetiredSnapshots.store( true, std::memory_order_release );
+	return true;
+}
+
+template <class T>
+void ListenerRegistry<T>::reclaim()
+{
+	if ( !mHasRetiredSnapshots.load( std::memory_order_acquire ) )
+		return;
+	std::unique_lock<std::mutex> lock( mMutex, std::try_to_lock );
+	if ( !lock.owns_lock() )
+		return;
+	for ( std::size_t i=0; i<mRetiredSnapshots.size(); ++i )
+		delete mRetiredSnapshots[i];
+	mRetiredSnapshots.clear();
+	mHasRetiredSnapshots.store( false, std::memory_order_relaxed );
+}
+
+template <class T>
+void ListenerRegistry<T>::beginDispatch()
+{
+	// The accesses to mDispatchCount and mSnapshot are sequentially 
+	// consistent: either the dispatch reads the snapshot published before 
+	// synchronize(), or synchronize() sees the dispatch in progress. Unlike 
+	// fences, ThreadSanitizer understands them
+	mDispatchingThread.store( std::this_thread::get_id(), std::memory_order_relaxed );
+	mDispatchCount.fetch_add( 1, std::memory_order_seq_cst );
+}
+
+template <class T>
+void ListenerRegistry<T>::endDispatch()
+{
+	mDispatchCount.fetch_add( 1, std::memory_order_release );
+}
+
+template <class T>
+void ListenerRegistry<T>::synchronize() const
+{
+	unsigned int dispatchCount = mDispatchCount.load( std::memory_order_seq_cst );
+	if ( (dispatchCount & 1)==0 )
+		return;
+	if ( mDispatchingThread.load( std::memory_order_relaxed )==std::this_thread::get_id() )
+		return;
+	while ( mDispatchCount.load( std::memory_order_acquire )==dispatchCount )
+		std::this_thread::yield();
+}
+
+}
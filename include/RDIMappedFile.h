@@ -0,0 +1,64 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace RDI
+{
+
+/*
+	MappedFile
+
+	A file mapped in memory for reading. The pages are loaded by the system 
+	on demand, so opening a large file is immediate and reading it doesn't
+	involve any copy.
+*/
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool					open( const std::string& fileName );
+	void					close();
+	bool					isOpen() const		{ return mData!=NULL; }
+
+	const unsigned char*	getData() const		{ return mData; }
+	std::size_t				getSize() const		{ return mSize; }
+
+private:
+	MappedFile( const MappedFile& );
+	MappedFile& operator=( const MappedFile& );
+
+	const unsigned char*	mData;
+	std::size_t				mSize;
+#ifdef _WIN32
+	void*					mFileHandle;
+	void*					mMappingHandle;
+#endif
+};
+
+}
@@ -23,11 +23,7 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
 #include <string>
 #include <vector>
@@ -53,10 +49,21 @@ public:
 	virtual void			updateFrom( const DIDEVICEOBJECTDATA& entry ) = 0;
 	virtual std::string		toString() const = 0;
 
+	// Returns the state of the Object encoded like DirectInput does in the
+	// dwData member of DIDEVICEOBJECTDATA. Passing it to updateFrom() 
+	// restores this state
+	virtual DWORD			getData() const = 0;
+
 	const ObjectInstance&	getObjectInstance() const	{ return mObjectInstance; }
 	Device*					getParentDevice() const		{ return mParentDevice; }
 
+	// The index of this Object in the list of objects of its parent Device
+	unsigned int			getIndex() const			{ return mIndex; }
+
 	bool					setUserData( UINT_PTR data );
+
+	// See Device::setObjectEnabled()
+	bool					isEnabled() const			{ return mIsEnabled; }
 	
 protected:
 	friend class Device;
@@ -65,12 +72,15 @@ protected:
 
 	static Object*			createObject( const ObjectInstance& objectInstance, Device* parentDevice );
 	
-	// Notify the parent device that this object has changed
-	void					notifyChanged();
+	// Notify the parent device that this object has changed. The previous 
+	// state is encoded like getData() does
+	void					notifyChanged( DWORD oldData );
 
 private:
 	ObjectInstance			mObjectInstance;
 	Device*					mParentDevice;
+	unsigned int			mIndex;				// Set by the parent Device
+	bool					mIsEnabled;			// Same
 };
 
 typedef std::vector<Object*> Objects;
@@ -23,12 +23,9 @@
 */
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
+#include "RDIPlatform.h"
 
+#include <string>
 #include <vector>
 
 namespace RDI
@@ -47,6 +44,7 @@ public:
 	ObjectInstance();
 	ObjectInstance( LPCDIDEVICEOBJECTINSTANCE deviceObjectInstance );
 	ObjectInstance( const ObjectInstance& other );
+	ObjectInstance( const ObjectInstance& other, DWORD dwOfs );		// The same object, at another offset (see DataFormat)
 	ObjectInstance& operator=( const ObjectInstance& other );
 	
 	// Returns a GUID_xxxx value, like GUID_XAxis, GUID_Button, etc.. This is an optional piece of information.
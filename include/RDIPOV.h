@@ -62,6 +62,7 @@ public:
 	
 	virtual std::string	toString() const;
 	virtual void		updateFrom( const DIDEVICEOBJECTDATA& entry );
+	virtual DWORD		getData() const;
 
 protected:
 	void				setValue( bool isCentered, DWORD value );
@@ -0,0 +1,185 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+/*
+	Platform
+
+	On Windows, this includes the Windows and DirectInput headers.
+
+	On the other platforms, it defines the small subset of the Windows and
+	DirectInput types, macros and constants used by RDI (with the same 
+	values), so the core of the library can be built and run without 
+	DirectInput, with a Backend that doesn't need it (see ReplayBackend).
+*/
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN 
+#define NOMINMAX 
+#include <windows.h>
+#define DIRECTINPUT_VERSION 0x0800
+#include <dinput.h>
+#include <tchar.h>
+
+#else
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t		BYTE;
+typedef uint16_t	WORD;
+typedef uint32_t	DWORD;
+typedef DWORD*		LPDWORD;
+typedef int32_t		LONG;
+typedef int			BOOL;
+typedef int32_t		HRESULT;
+typedef uintptr_t	UINT_PTR;
+typedef char		TCHAR;
+typedef void*		LPVOID;
+
+#define TRUE		1
+#define FALSE		0
+#define MAX_PATH	260
+#define CALLBACK
+
+#define LOBYTE(w)			((BYTE)(((UINT_PTR)(w)) & 0xff))
+#define HIBYTE(w)			((BYTE)((((UINT_PTR)(w)) >> 8) & 0xff))
+#define LOWORD(l)			((WORD)(((UINT_PTR)(l)) & 0xffff))
+#define HIWORD(l)			((WORD)((((UINT_PTR)(l)) >> 16) & 0xffff))
+#define MAKELONG(a, b)		((LONG)(((WORD)(a)) | ((DWORD)((WORD)(b))) << 16))
+
+#define _T(x)				x
+#define _tcsncmp			strncmp
+
+#define S_OK				((HRESULT)0L)
+#define S_FALSE				((HRESULT)1L)
+#define E_FAIL				((HRESULT)0x80004005L)
+#define E_ACCESSDENIED		((HRESULT)0x80070005L)
+#define E_INVALIDARG		((HRESULT)0x80070057L)
+#define E_NOTIMPL			((HRESULT)0x80004001L)
+#define SUCCEEDED(hr)		(((HRESULT)(hr)) >= 0)
+#define FAILED(hr)			(((HRESULT)(hr)) < 0)
+
+struct GUID
+{
+	uint32_t	Data1;
+	uint16_t	Data2;
+	uint16_t	Data3;
+	uint8_t		Data4[8];
+};
+
+inline bool operator==( const GUID& guid1, const GUID& guid2 )	{ return memcmp( &guid1, &guid2, sizeof(GUID) )==0; }
+inline bool operator!=( const GUID& guid1, const GUID& guid2 )	{ return !(guid1==guid2); }
+
+// DirectInput
+struct DIDEVICEINSTANCE
+{
+	DWORD		dwSize;
+	GUID		guidInstance;
+	GUID		guidProduct;
+	DWORD		dwDevType;
+	TCHAR		tszInstanceName[MAX_PATH];
+	TCHAR		tszProductName[MAX_PATH];
+	GUID		guidFFDriver;
+	WORD		wUsagePage;
+	WORD		wUsage;
+};
+typedef DIDEVICEINSTANCE*			LPDIDEVICEINSTANCE;
+typedef const DIDEVICEINSTANCE*		LPCDIDEVICEINSTANCE;
+
+struct DIDEVICEOBJECTINSTANCE
+{
+	DWORD		dwSize;
+	GUID		guidType;
+	DWORD		dwOfs;
+	DWORD		dwType;
+	DWORD		dwFlags;
+	TCHAR		tszName[MAX_PATH];
+	DWORD		dwFFMaxForce;
+	DWORD		dwFFForceResolution;
+	WORD		wCollectionNumber;
+	WORD		wDesignatorIndex;
+	WORD		wUsagePage;
+	WORD		wUsage;
+	DWORD		dwDimension;
+	WORD		wExponent;
+	WORD		wReportId;
+};
+typedef DIDEVICEOBJECTINSTANCE*			LPDIDEVICEOBJECTINSTANCE;
+typedef const DIDEVICEOBJECTINSTANCE*	LPCDIDEVICEOBJECTINSTANCE;
+
+struct DIDEVICEOBJECTDATA
+{
+	DWORD		dwOfs;
+	DWORD		dwData;
+	DWORD		dwTimeStamp;
+	DWORD		dwSequence;
+	UINT_PTR	uAppData;
+};
+typedef DIDEVICEOBJECTDATA*			LPDIDEVICEOBJECTDATA;
+typedef const DIDEVICEOBJECTDATA*	LPCDIDEVICEOBJECTDATA;
+
+#define DIDFT_ALL					0x00000000
+#define DIDFT_RELAXIS				0x00000001
+#define DIDFT_ABSAXIS				0x00000002
+#define DIDFT_AXIS					0x00000003
+#define DIDFT_PSHBUTTON				0x00000004
+#define DIDFT_TGLBUTTON				0x00000008
+#define DIDFT_BUTTON				0x0000000C
+#define DIDFT_POV					0x00000010
+#define DIDFT_MAKEINSTANCE(n)		((WORD)(n) << 8)
+#define DIDFT_GETTYPE(n)			LOBYTE(n)
+#define DIDFT_GETINSTANCE(n)		LOWORD((n) >> 8)
+
+#define DI8DEVTYPE_JOYSTICK			0x14
+#define DI8DEVTYPE_GAMEPAD			0x15
+#define DI8DEVTYPE_DRIVING			0x16
+#define DI8DEVTYPE_FLIGHT			0x17
+#define DI8DEVTYPE_1STPERSON		0x18
+#define GET_DIDEVICE_TYPE(dwDevType)		LOBYTE(dwDevType)
+#define GET_DIDEVICE_SUBTYPE(dwDevType)		HIBYTE(dwDevType)
+
+#define DI_OK						S_OK
+#define DI_BUFFEROVERFLOW			S_FALSE
+#define DIERR_GENERIC				E_FAIL
+#define DIERR_INVALIDPARAM			E_INVALIDARG
+#define DIERR_OTHERAPPHASPRIO		E_ACCESSDENIED
+#define DIERR_NOTACQUIRED			((HRESULT)0x8007000CL)
+#define DIERR_INPUTLOST				((HRESULT)0x8007001EL)
+#define DIERR_UNPLUGGED				((HRESULT)0x80040209L)
+#define DIERR_UNSUPPORTED			E_NOTIMPL
+
+extern const GUID GUID_XAxis;
+extern const GUID GUID_YAxis;
+extern const GUID GUID_ZAxis;
+extern const GUID GUID_RxAxis;
+extern const GUID GUID_RyAxis;
+extern const GUID GUID_RzAxis;
+extern const GUID GUID_Slider;
+extern const GUID GUID_Button;
+extern const GUID GUID_Key;
+extern const GUID GUID_POV;
+extern const GUID GUID_Unknown;
+
+#endif
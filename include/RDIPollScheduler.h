@@ -0,0 +1,113 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	PollScheduler
+
+	Decides which devices the DeviceManager polls at each update. 
+
+	- Idle backoff: a device whose updates have had no activity (no event 
+	  and no change) for idleUpdates updates is polled less and less often,
+	  its poll interval doubling after each quiet poll up to maxPollInterval
+	  updates. As soon as a poll finds some activity, the device gets polled
+	  at every update again. The events of an idle device aren't lost, they 
+	  wait in the buffer of the device, but they can be late by up to 
+	  maxPollInterval updates (and the buffer must be able to hold them)
+	- Time budget: the devices due at an update are polled in order of 
+	  priority until budgetInUs microseconds are spent. The most overdue 
+	  devices come first: the ones that have waited the most updates 
+	  relative to their poll interval (the active devices first when even).
+	  The devices left over are more overdue at the next update, so the 
+	  devices are serviced round-robin when the budget is tight, and an idle
+	  device isn't starved by the active ones. At least one device is polled
+	  at each update
+
+	With the default Settings, every device is polled at every update.
+*/
+class PollScheduler
+{
+public:
+	struct Settings
+	{
+		Settings();
+
+		unsigned int	idleUpdates;			// 0 disables the idle backoff
+		unsigned int	maxPollInterval;		// In updates
+		unsigned int	budgetInUs;				// 0 disables the time budget
+	};
+
+	PollScheduler( const Settings& settings=Settings() );
+
+	const Settings&		getSettings() const			{ return mSettings; }
+	void				setSettings( const Settings& settings );
+
+	// Kept in sync with the list of devices
+	void				addDevice();
+	void				removeDevice( std::size_t deviceIndex );
+	std::size_t			getNumDevices() const		{ return mDevices.size(); }
+
+	// At each update: schedule() gives the devices due, most urgent first.
+	// Before polling each of them, hasBudgetLeft() tells whether it can be 
+	// done (the update stops at the first false), then onPolled() reports 
+	// whether the poll found some activity
+	const std::vector<unsigned int>&	schedule();
+	bool				hasBudgetLeft();
+	void				onPolled( unsigned int deviceIndex, bool isActive );
+
+	unsigned int		getPollInterval( unsigned int deviceIndex ) const;
+
+	// Counters. The skipped polls are the ones of the idle devices not due, 
+	// the deferred ones the ones of the devices due but out of budget
+	unsigned long long int	getNumPolls() const				{ return mNumPolls; }
+	unsigned long long int	getNumSkippedPolls() const		{ return mNumSkippedPolls; }
+	unsigned long long int	getNumDeferredPolls() const		{ return mNumDeferredPolls; }
+
+private:
+	struct DeviceState
+	{
+		DeviceState();
+
+		unsigned int	pollInterval;
+		unsigned int	numWaitingUpdates;		// Since the last poll
+		unsigned int	numQuietUpdates;		// Since the last activity
+	};
+
+	Settings					mSettings;
+	unsigned long long int		mBudgetInTicks;
+	std::vector<DeviceState>	mDevices;
+	std::vector<unsigned int>	mSchedule;
+	unsigned long long int		mStartTime;			// Of the update, in ticks
+	std::size_t					mNumPolledDevices;	// At the update
+	unsigned long long int		mNumPolls;
+	unsigned long long int		mNumSkippedPolls;
+	unsigned long long int		mNumDeferredPolls;
+};
+
+}
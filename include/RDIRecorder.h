@@ -0,0 +1,76 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include "RDIDeviceManager.h"
+#include "RDIRecording.h"
+
+namespace RDI
+{
+
+/*
+	Recorder
+
+	The Recorder captures the activity of the devices of a DeviceManager 
+	into a file: the devices being connected and disconnected and every 
+	change of their objects, with their time (see Recording for the format).
+
+	The records are encoded on the thread that updates the DeviceManager
+	but written to the file by a background thread (see RecordingWriter),
+	so recording never blocks the input thread on I/O.
+*/
+class Recorder : public DeviceManager::Listener, public Device::Listener
+{
+public:
+	Recorder( DeviceManager* deviceManager, std::size_t bufferSize=1024*1024, unsigned int keyframeIntervalInMs=1000 );
+	virtual ~Recorder();
+
+	// Start recording into a new file. The devices already connected are recorded first
+	bool						start( const std::string& fileName );
+	void						stop();
+	bool						isRecording() const			{ return mWriter.isOpen(); }
+
+	const RecordingWriter&		getWriter() const			{ return mWriter; }
+
+	// Describe the objects of a Device and their current state
+	static void					getRecordedObjects( const Device* device, RecordedObjects& objects );
+
+	virtual void				onDeviceConnected( DeviceManager* deviceManager, Device* device );
+	virtual void				onDeviceDisconnecting( DeviceManager* deviceManager, Device* device );
+	virtual void				onObjectChanged( Device* device, Object* object );
+
+private:
+	void						addDevice( Device* device );
+	void						removeDevice( Device* device );
+
+	DeviceManager*				mDeviceManager;
+	RecordingWriter				mWriter;
+	
+	typedef std::vector<std::pair<Device*, unsigned int>> RecordedDevices;		// Device and its id in the recording
+	RecordedDevices				mDevices;
+};
+
+}
@@ -0,0 +1,288 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RDIDeviceInstance.h"
+#include "RDIObjectInstance.h"
+#include "RDIRingBuffer.h"
+
+namespace RDI
+{
+
+/*
+	Recording
+
+	The binary format used to record the activity of devices. 
+
+	A recording is a header followed by a sequence of records. The integers 
+	are encoded as LEB128 varints (7 bits per byte), the signed ones being 
+	zigzag-encoded first. The times are in microseconds.
+
+	The header is 'R' 'D' 'I' 'R' followed by the version (1 byte).
+	Each record starts with its type (1 byte) and the time elapsed since the
+	previous record. Then:
+	- DeviceConnected: the id of the device, its DeviceInstance (GUIDs as 16 
+	  raw bytes, strings in UTF-8 prefixed by their length), the number of 
+	  objects and, for each object, its ObjectInstance, range and data
+	- DeviceDisconnected: the id of the device
+	- ObjectChanged: the id of the device, the index of the object and its
+	  data (see Object::getData()), as a difference with the previous data
+	  of the object
+	- Keyframe: the absolute time, the number of connected devices and for 
+	  each: its id, the file offset of its DeviceConnected record and the 
+	  data of all its objects. Decoding can start at any keyframe
+	- Index: written when the recording is closed. The number of keyframes 
+	  and for each its time and file offset (as differences with the 
+	  previous keyframe)
+	
+	The file ends with a trailer: the file offset of the Index record 
+	(8 bytes, little endian) followed by 'R' 'D' 'I' 'X'. A recording that
+	wasn't closed properly has no index nor trailer, but can still be 
+	decoded from its beginning.
+*/
+class Recording
+{
+public:
+	enum RecordType
+	{
+		DeviceConnected = 1,
+		DeviceDisconnected,
+		ObjectChanged,
+		Keyframe,
+		Index
+	};
+
+	static const unsigned char	version = 1;
+	static const std::size_t	headerSize = 5;
+	static const std::size_t	trailerSize = 12;
+	static const unsigned char	headerMagic[4];
+	static const unsigned char	trailerMagic[4];
+};
+
+/*
+	RecordedObject
+
+	The description and state of an Object as stored in a recording
+*/
+struct RecordedObject
+{
+	RecordedObject();
+
+	ObjectInstance		objectInstance;
+	LONG				minValue;		// For axes only
+	LONG				maxValue;
+	DWORD				data;
+};
+
+typedef std::vector<RecordedObject> RecordedObjects;
+
+/*
+	RecordingWriter
+
+	Writes a recording to a file. The records are encoded on the calling 
+	thread and pushed into a lock-free ring buffer, from which a background 
+	thread writes them to the file. So the calling thread never waits for
+	the disk: if the ring buffer is full, the record is dropped and counted.
+
+	A dropped record never corrupts the recording: the data of the objects
+	is encoded relatively to what was actually written and a device whose
+	DeviceConnected record was dropped is described again before its next
+	record. Similarly, a device whose DeviceDisconnected record was dropped
+	stays connected in the recording until the record is written again, 
+	before the next record of any device or, at the latest, by close().
+	
+	The devices are identified by an id returned by addDevice(). Ids are 
+	not reused within a recording.
+
+	The ObjectChanged records are stamped with the time of their event (the
+	timeStamp of the ObjectChange, in milliseconds in the time base of the 
+	device), so the timing of the events survives their processing by 
+	batches in Device::update(). The time base of each device is mapped to 
+	the time of the recording by its first change, and again if it drifts 
+	away by more than maxTimeStampDriftInMs. The other records are stamped 
+	with the time they are written.
+*/
+class RecordingWriter
+{
+public:
+	// The buffer must be larger than the biggest record: the DeviceConnected
+	// record of a device with many objects takes a few KB
+	RecordingWriter( std::size_t bufferSize=1024*1024, unsigned int keyframeIntervalInMs=1000 );
+	~RecordingWriter();
+
+	bool						open( const std::string& fileName );
+	void						close();
+	bool						isOpen() const				{ return mFile!=NULL; }
+
+	unsigned int				addDevice( const DeviceInstance& deviceInstance, const RecordedObjects& objects );
+	void						removeDevice( unsigned int deviceId );
+	void						changeObject( unsigned int deviceId, unsigned int objectIndex, DWORD data, DWORD timeStamp );
+
+	static const DWORD			maxTimeStampDriftInMs = 1000;
+
+	// Counters (since the last call to open())
+	unsigned long long int		getNumRecords() const			{ return mNumRecords; }
+	unsigned long long int		getNumBytes() const				{ return mNumBytes; }
+	unsigned long long int		getNumDroppedRecords() const	{ return mNumDroppedRecords; }
+	bool						hasWriteFailed() const			{ return mWriteFailed; }
+
+private:
+	struct DeviceState
+	{
+		DeviceState();
+
+		bool					isConnected;
+		bool					isDisconnecting;		// Removed, but its DeviceDisconnected record was dropped
+		unsigned long long int	descriptorOffset;		// 0 until the DeviceConnected record is written
+		DeviceInstance			deviceInstance;
+		RecordedObjects			objects;
+		std::vector<DWORD>		encodedData;			// Data of the objects as last written
+		bool					hasTimeBase;
+		unsigned long long int	baseTime;				// The time of the recording matching baseTimeStamp
+		DWORD					baseTimeStamp;
+	};
+
+	unsigned long long int		getTime() const;
+	unsigned long long int		getEventTime( DeviceState& device, DWORD timeStamp );
+	bool						writeDescriptor( unsigned int deviceId, unsigned long long int time );
+	bool						writeKeyframe( unsigned long long int time );
+	bool						writeDisconnections( unsigned long long int time, bool isBlocking );
+	void						beginRecord( Recording::RecordType type, unsigned long long int time );
+	bool						commitRecord( unsigned long long int time );
+	void						pushBlocking( const std::vector<unsigned char>& bytes );
+	void						writerThread();
+
+	std::size_t					mBufferSize;
+	unsigned int				mKeyframeIntervalInMs;
+	ByteRingBuffer*				mRingBuffer;
+	FILE*						mFile;
+	std::thread					mThread;
+	std::atomic<bool>			mStopRequested;
+	std::atomic<bool>			mWriteFailed;
+
+	std::vector<unsigned char>	mRecord;				// The record being encoded
+	unsigned long long int		mStartTime;
+	unsigned long long int		mLastRecordTime;
+	unsigned long long int		mLastKeyframeTime;
+	unsigned long long int		mOffset;				// File offset of the next record
+	std::vector<DeviceState>	mDevices;				// Indexed by id
+	std::size_t					mNumDisconnectingDevices;
+	std::vector<std::pair<unsigned long long int, unsigned long long int>>	mKeyframes;		// Time and offset
+
+	unsigned long long int		mNumRecords;
+	unsigned long long int		mNumBytes;
+	unsigned long long int		mNumDroppedRecords;
+};
+
+/*
+	RecordedDevice
+
+	The description and state of a device, as decoded from a recording
+*/
+struct RecordedDevice
+{
+	RecordedDevice();
+
+	bool				isConnected;
+	DeviceInstance		deviceInstance;
+	RecordedObjects		objects;
+};
+
+typedef std::vector<RecordedDevice> RecordedDevices;
+
+/*
+	RecordingReader
+
+	Decodes a recording held in memory (see MappedFile) one record at a 
+	time, and maintains the state of the recorded devices as it goes.
+
+	Seeking uses the keyframes: the decoding restarts from the last keyframe
+	before the requested time rather than from the beginning. The keyframes
+	are listed in the index of the recording or, if it has none, collected
+	while reading.
+
+	A recording that is truncated or corrupted is read up to the last valid 
+	record.
+*/
+class RecordingReader
+{
+public:
+	struct Record
+	{
+		Recording::RecordType	type;
+		unsigned long long int	time;
+		unsigned int			deviceId;		// Not used by the Keyframe records
+		unsigned int			objectIndex;	// Only used by the ObjectChanged records
+	};
+
+	RecordingReader();
+
+	// The data isn't copied and must remain valid while the reader is used
+	bool						open( const unsigned char* data, std::size_t size );
+	void						close();
+	bool						isOpen() const			{ return mData!=NULL; }
+	bool						hasIndex() const		{ return mHasIndex; }
+
+	// Read the next record and apply it to the state of the devices. Returns 
+	// false at the end of the recording
+	bool						readRecord( Record& record );
+	bool						peekTime( unsigned long long int& time ) const;
+	bool						isAtEnd() const			{ return mOffset>=mEndOffset; }
+
+	// Go back to the beginning of the recording
+	void						rewind();
+
+	// After seeking, the state of the devices is the one they had at the 
+	// given time and the next record read is the first one after it
+	bool						seek( unsigned long long int time );
+
+	// The time of the last record read
+	unsigned long long int		getTime() const			{ return mTime; }
+
+	// Indexed by device id
+	const RecordedDevices&		getDevices() const		{ return mDevices; }
+
+private:
+	bool						readIndex();
+	bool						readKeyframe( std::size_t offset, bool reuseConnectedDevices, std::size_t& nextOffset );
+	bool						readDeviceDescription( std::size_t offset, unsigned int deviceId, std::size_t& nextOffset );
+
+	const unsigned char*		mData;
+	std::size_t					mSize;
+	std::size_t					mEndOffset;				// End of the records, i.e. the index if any
+	std::size_t					mOffset;				// Offset of the next record
+	unsigned long long int		mTime;
+	bool						mHasIndex;
+	std::vector<std::pair<unsigned long long int, unsigned long long int>>	mKeyframes;		// Time and offset
+	RecordedDevices				mDevices;
+};
+
+}
@@ -0,0 +1,166 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "RDIBackend.h"
+#include "RDIMappedFile.h"
+#include "RDIRecording.h"
+
+namespace RDI
+{
+
+class ReplayBackend;
+
+/*
+	ReplayDeviceBackend
+
+	A device of a ReplayBackend. Unlike with DirectInput, its events are 
+	never lost: the ones that don't fit in the array passed to getDeviceData()
+	are returned by the next call.
+*/
+class ReplayDeviceBackend : public DeviceBackend
+{
+public:
+	virtual ~ReplayDeviceBackend();
+
+	virtual bool				setBufferSize( DWORD numEntries );
+	virtual bool				enumerateObjects( ObjectInstances& objectInstances );
+	virtual bool				getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue );
+	virtual bool				setObjectUserData( DWORD objectType, UINT_PTR userData );
+	virtual HRESULT				acquire();
+	virtual void				unacquire();
+	virtual HRESULT				getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries );
+
+private:
+	friend class ReplayBackend;
+	ReplayDeviceBackend( ReplayBackend* backend, unsigned int deviceId, const RecordedDevice& device );
+
+	const RecordedDevice*		getRecordedDevice() const;
+	int							findObject( DWORD objectType ) const;
+	void						queueEvent( unsigned int objectIndex, DWORD data, DWORD timeStamp );
+
+	// Queue the events that bring the objects to their recorded state
+	void						synchronize( DWORD timeStamp );
+	void						clearEvents();
+
+	struct Event
+	{
+		unsigned int			objectIndex;
+		DWORD					data;
+		DWORD					timeStamp;
+	};
+
+	ReplayBackend*				mBackend;
+	unsigned int				mDeviceId;
+	DeviceInstance				mDeviceInstance;
+	RecordedObjects				mObjects;
+	std::vector<UINT_PTR>		mUserData;
+	std::vector<DWORD>			mDeliveredData;		// The data of the events returned by getDeviceData()
+	std::vector<DWORD>			mQueuedData;		// The data once the queued events are returned
+	std::deque<Event>			mEvents;
+	DWORD						mSequence;
+	bool						mIsAcquired;
+};
+
+/*
+	ReplayBackend
+
+	Replays a recording (see Recorder) through the normal Device and Object
+	machinery: the DeviceManager using this Backend sees the recorded devices
+	being connected and disconnected, and its devices receive the recorded 
+	events from update(), with their recorded timestamps. No hardware nor 
+	DirectInput is needed.
+
+	The recording is memory-mapped, so opening it is immediate whatever its
+	size. The replay advances each time update() is called, which should be 
+	done before each call to DeviceManager::update(), either:
+	- at the speed of the recording multiplied by a factor (1 for real time)
+	- as fast as possible: each update() replays a fixed number of records
+	seek() jumps to any time of the recording, the devices then receive 
+	the events that bring them to the state they had at that time.
+
+	Use a BackendEnumerationTrigger with the DeviceManager, so the device 
+	list gets updated as soon as it changes in the recording.
+*/
+class ReplayBackend : public Backend
+{
+public:
+	ReplayBackend();
+	virtual ~ReplayBackend();
+
+	bool						open( const std::string& fileName );
+	void						close();
+	bool						isOpen() const					{ return mReader.isOpen(); }
+
+	// 1 replays in real time, 2 twice as fast, etc... 0 replays as fast as possible
+	void						setSpeed( double speed );
+	double						getSpeed() const				{ return mSpeed; }
+
+	// The number of records replayed by each update() when replaying as fast as possible.
+	// The default matches the event buffer of a Device, so each update() of the 
+	// DeviceManager returns all the events replayed
+	void						setNumRecordsPerUpdate( unsigned int numRecords );
+	unsigned int				getNumRecordsPerUpdate() const	{ return mNumRecordsPerUpdate; }
+
+	void						update();
+	bool						seek( unsigned long long int timeInUs );
+
+	// The time of the replay, in microseconds since the beginning of the recording
+	unsigned long long int		getTime() const					{ return mTime; }
+	bool						isFinished() const				{ return mReader.isAtEnd(); }
+	
+	// The number of object changes replayed since open()
+	unsigned long long int		getNumReplayedEvents() const	{ return mNumReplayedEvents; }
+
+	virtual void				enumerateDevices( DeviceIdentifiers& deviceInstances );
+	virtual DeviceBackend*		createDeviceBackend( const DeviceInstance& deviceInstance );
+	virtual DWORD				getTickCount();
+	virtual bool				hasDeviceListChanged();
+
+private:
+	friend class ReplayDeviceBackend;
+	void						processRecord( const RecordingReader::Record& record );
+	ReplayDeviceBackend*		findDeviceBackend( unsigned int deviceId ) const;
+	bool						rebindDeviceBackend( ReplayDeviceBackend* deviceBackend, unsigned int deviceId );
+	void						removeDeviceBackend( ReplayDeviceBackend* deviceBackend );
+
+	MappedFile					mFile;
+	RecordingReader				mReader;
+	double						mSpeed;
+	unsigned int				mNumRecordsPerUpdate;
+	unsigned long long int		mTime;
+	double						mTimeRemainder;			// Fraction of microsecond not yet added to mTime
+	unsigned long long int		mLastUpdateTime;		// In microseconds, see Time
+	bool						mIsStarted;
+	bool						mDeviceListChanged;
+	unsigned long long int		mNumReplayedEvents;
+	std::vector<ReplayDeviceBackend*>	mDeviceBackends;
+};
+
+}
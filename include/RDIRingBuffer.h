@@ -0,0 +1,71 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace RDI
+{
+
+/*
+	ByteRingBuffer
+
+	A lock-free ring buffer of bytes for exactly one producer thread and one 
+	consumer thread. Neither side ever blocks: write() fails when there isn't 
+	enough free space and read() returns 0 when there is nothing to read.
+
+	A write is all or nothing, so a block of bytes written in one call 
+	(a record for example) is never split by a failure.
+*/
+class ByteRingBuffer
+{
+public:
+	// The capacity is rounded up to a power of 2
+	ByteRingBuffer( std::size_t capacity );
+
+	std::size_t					getCapacity() const			{ return mBuffer.size(); }
+
+	// Producer side
+	bool						write( const unsigned char* data, std::size_t size );
+
+	// Consumer side. Returns the number of bytes read
+	std::size_t					read( unsigned char* data, std::size_t maxSize );
+
+private:
+	std::vector<unsigned char>	mBuffer;
+	std::size_t					mMask;
+	std::size_t					mCachedReadPosition;		// Producer side only
+
+	// The positions only ever increase (and wrap around), the index in the
+	// buffer being obtained by masking. They are kept on separate cache lines 
+	// as each one is written by a different thread
+	char						mPadding0[64];
+	std::atomic<std::size_t>	mWritePosition;
+	char						mPadding1[64];
+	std::atomic<std::size_t>	mReadPosition;
+	char						mPadding2[64];
+};
+
+}
@@ -0,0 +1,271 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include "RDIPlatform.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "RDIBackend.h"
+#include "RDIRecording.h"
+
+namespace RDI
+{
+
+class SimulatedBackend;
+
+/*
+	SimulatedGenerator
+
+	The description of a source of events on a simulated device (see 
+	SimulatedBackend::addGenerator()). 
+
+	- RandomWalk: the axes of the device drift by a random amount (up to 
+	  step units) at the given rate
+	- ButtonStorm: the buttons of the device are toggled at the given rate
+	- Burst: every period, a burst of events (axes moving, buttons toggled 
+	  and POVs turned) hits the objects of the device at once
+
+	The rates are in events per second of the simulated time.
+*/
+struct SimulatedGenerator
+{
+	enum Type
+	{
+		RandomWalk,
+		ButtonStorm,
+		Burst
+	};
+
+	SimulatedGenerator();
+	static SimulatedGenerator	randomWalk( float eventsPerSecond, LONG step );
+	static SimulatedGenerator	buttonStorm( float eventsPerSecond );
+	static SimulatedGenerator	burst( unsigned int burstSize, DWORD periodInMs, LONG step );
+
+	Type			type;
+	float			eventsPerSecond;	// RandomWalk and ButtonStorm
+	LONG			step;				// RandomWalk and Burst
+	unsigned int	burstSize;			// Burst only
+	DWORD			periodInMs;			// Burst only
+};
+
+/*
+	SimulatedDeviceBackend
+
+	A device of a SimulatedBackend. It behaves like an IDirectInputDevice8:
+	the events that don't fit in its buffer are lost (and DI_BUFFEROVERFLOW
+	is returned), it must be acquired, loses the input when asked to and 
+	reports DIERR_UNPLUGGED once the device is disconnected.
+
+	Unlike DirectInput, its sequence numbers are per device, so a gap in
+	them reliably means that events were dropped.
+
+	The state of the device is kept in its DataFormat, DIJOYSTATE2 until 
+	another format is set. Like with DirectInput, the objects that aren't
+	part of the format don't report any event.
+*/
+class SimulatedDeviceBackend : public DeviceBackend
+{
+public:
+	virtual ~SimulatedDeviceBackend();
+
+	virtual bool				setBufferSize( DWORD numEntries );
+	virtual bool				enumerateObjects( ObjectInstances& objectInstances );
+	virtual bool				setDataFormat( const DataFormat& dataFormat );
+	virtual bool				getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue );
+	virtual bool				setObjectUserData( DWORD objectType, UINT_PTR userData );
+	virtual HRESULT				acquire();
+	virtual void				unacquire();
+	virtual HRESULT				getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries );
+	virtual HRESULT				getObjectStates( const DWORD* objectTypes, DWORD* states, std::size_t numObjects );
+	virtual bool				hasContiguousSequences() const		{ return true; }
+
+private:
+	friend class SimulatedBackend;
+	SimulatedDeviceBackend( SimulatedBackend* backend, unsigned int deviceIndex );
+
+	bool						isConnected() const;
+	int							findObject( DWORD objectType ) const;
+	void						queueEvent( unsigned int objectIndex, DWORD data, DWORD timeStamp );
+	void						loseInput();
+	void						dropEvents( unsigned int numEvents );
+	void						writeState();
+
+	SimulatedBackend*			mBackend;
+	unsigned int				mDeviceIndex;
+	RecordedObjects				mObjects;				// The layout when the backend was created
+	std::vector<UINT_PTR>		mUserData;
+	DataFormat					mDataFormat;
+	std::vector<int>			mFormatIndices;			// The index of each object in the format, -1 if it isn't part of it
+	std::vector<BYTE>			mState;
+	std::vector<BYTE>			mStateCopy;				// As returned by GetDeviceState()
+	DataFormat::ObjectFormats	mRequestedObjects;		// The objects of the last call to getObjectStates()
+	DWORD						mBufferSize;
+	std::deque<DIDEVICEOBJECTDATA>	mEvents;
+	DWORD						mSequence;
+	unsigned int				mNumEventsToDrop;
+	bool						mIsAcquired;
+	bool						mHasOverflowed;
+	bool						mHasLostInput;
+};
+
+/*
+	SimulatedBackend
+
+	An in-process Backend whose devices are scripted, so the library can be 
+	exercised (and benchmarked) without DirectInput nor any hardware. 
+
+	Everything is deterministic: the backend has its own clock, which only 
+	moves when advance() is called, and its own random number generator. So 
+	two runs with the same seed and the same script produce exactly the same
+	events, with the same timestamps.
+
+	A script can:
+	- add devices with any layout of axes, buttons and POVs
+	- change the data of objects, or attach generators that do so over time
+	- connect and disconnect devices, immediately or at a scheduled time
+	- make the devices fail to acquire or lose the input
+	The events are buffered by the devices like DirectInput does: when more
+	events are generated between two updates than the buffer of a device can
+	hold, the extra ones are lost.
+
+	Use a BackendEnumerationTrigger with the DeviceManager, so the device 
+	list gets updated as soon as a device is connected or disconnected.
+*/
+class SimulatedBackend : public Backend
+{
+public:
+	SimulatedBackend( unsigned int seed=1 );
+	virtual ~SimulatedBackend();
+
+	// A gamepad-like device: the axes come first, then the buttons and the POVs
+	unsigned int				addDevice( const std::string& name, unsigned int numAxes, unsigned int numButtons, unsigned int numPOVs, bool isConnected=true );
+	unsigned int				addDevice( const DeviceInstance& deviceInstance, const RecordedObjects& objects, bool isConnected=true );
+	std::size_t					getNumDevices() const								{ return mDevices.size(); }
+	const DeviceInstance&		getDeviceInstance( unsigned int deviceIndex ) const;
+	const RecordedObjects&		getObjects( unsigned int deviceIndex ) const;
+
+	static DeviceInstance		createDeviceInstance( const std::string& name, unsigned int index );
+
+	// The path of each device ("SIM#<index>"), for the DeviceChangeHints
+	static std::string			createDevicePath( unsigned int deviceIndex );
+	static void					createObjects( unsigned int numAxes, unsigned int numButtons, unsigned int numPOVs, RecordedObjects& objects );
+
+	// Hot-plug
+	void						connectDevice( unsigned int deviceIndex );
+	void						disconnectDevice( unsigned int deviceIndex );
+	bool						isDeviceConnected( unsigned int deviceIndex ) const;
+	void						scheduleConnection( unsigned int deviceIndex, DWORD time );
+	void						scheduleDisconnection( unsigned int deviceIndex, DWORD time );
+
+	// Events, timestamped with the current time
+	void						setObjectData( unsigned int deviceIndex, unsigned int objectIndex, DWORD data );
+	void						addGenerator( unsigned int deviceIndex, const SimulatedGenerator& generator );
+	void						removeGenerators( unsigned int deviceIndex );
+
+	// Faults: the next acquisitions fail with DIERR_OTHERAPPHASPRIO, or the 
+	// device gets unacquired and returns DIERR_INPUTLOST. While another 
+	// application holds the device, it loses the input and the acquisitions
+	// fail with DIERR_OTHERAPPHASPRIO until it is released
+	void						failAcquire( unsigned int deviceIndex, unsigned int numFailures );
+	void						loseInput( unsigned int deviceIndex );
+	void						holdDevice( unsigned int deviceIndex, bool isHeld );
+
+	// Fault: the next events of the device silently vanish. Unlike an overflow,
+	// nothing is reported, only their sequence numbers go missing
+	void						dropEvents( unsigned int deviceIndex, unsigned int numEvents );
+
+	// The clock, in milliseconds. The generators and the scheduled connections
+	// run one millisecond at a time
+	DWORD						getTime() const										{ return mTime; }
+	void						advance( DWORD timeInMs );
+
+	unsigned int				random();
+
+	// Counters
+	unsigned long long int		getNumEvents() const			{ return mNumEvents; }
+	unsigned long long int		getNumLostEvents() const		{ return mNumLostEvents; }
+	unsigned long long int		getNumAcquireCalls() const		{ return mNumAcquireCalls; }
+	unsigned long long int		getNumDeviceDataCalls() const	{ return mNumDeviceDataCalls; }
+
+	virtual void				enumerateDevices( DeviceIdentifiers& deviceInstances );
+	virtual DeviceBackend*		createDeviceBackend( const DeviceInstance& deviceInstance );
+	virtual DWORD				getTickCount();
+	virtual bool				hasDeviceListChanged();
+	virtual bool				getDevicePath( const DeviceInstance& deviceInstance, std::string& devicePath );
+	virtual bool				findDevice( const std::string& devicePath, DeviceInstance& deviceInstance );
+
+private:
+	friend class SimulatedDeviceBackend;
+
+	struct GeneratorState
+	{
+		SimulatedGenerator		generator;
+		float					numPendingEvents;		// Fraction of event carried over to the next millisecond
+		DWORD					nextBurstTime;
+	};
+
+	struct SimulatedDevice
+	{
+		SimulatedDevice();
+		
+		bool						isConnected;
+		DeviceInstance				deviceInstance;
+		RecordedObjects				objects;
+		std::vector<unsigned int>	axes;				// Indices of the objects of each kind
+		std::vector<unsigned int>	buttons;
+		std::vector<unsigned int>	povs;
+		std::vector<GeneratorState>	generators;
+		unsigned int				numAcquireFailures;
+		bool						isHeld;				// By another application
+	};
+
+	struct ScheduledConnection
+	{
+		DWORD					time;
+		unsigned int			deviceIndex;
+		bool					connect;
+	};
+
+	void						schedule( unsigned int deviceIndex, DWORD time, bool connect );
+	void						runGenerators( SimulatedDevice& device, unsigned int deviceIndex );
+	void						moveAxis( SimulatedDevice& device, unsigned int deviceIndex, LONG step );
+	void						toggleButton( SimulatedDevice& device, unsigned int deviceIndex );
+	void						turnPOV( SimulatedDevice& device, unsigned int deviceIndex );
+	void						removeDeviceBackend( SimulatedDeviceBackend* deviceBackend );
+
+	unsigned int				mRandomState;
+	DWORD						mTime;
+	bool						mDeviceListChanged;
+	std::vector<SimulatedDevice>		mDevices;
+	std::vector<ScheduledConnection>	mScheduledConnections;		// Sorted by time
+	std::vector<SimulatedDeviceBackend*>	mDeviceBackends;
+	unsigned long long int		mNumEvents;
+	unsigned long long int		mNumLostEvents;
+	unsigned long long int		mNumAcquireCalls;
+	unsigned long long int		mNumDeviceDataCalls;
+};
+
+}
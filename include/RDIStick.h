@@ -0,0 +1,116 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include "RDIAxis.h"
+
+namespace RDI
+{
+
+class Stick;
+typedef std::vector<Stick> Sticks;
+
+/*
+	Stick
+
+	The Stick pairs two Axis objects of a Device that physically form a
+	single 2-D stick: usually the X/Y axes of a joystick, or the Rx/Ry
+	axes of the right stick of a gamepad.
+
+	Applying a dead zone on each Axis separately results in a "square"
+	dead zone. The Stick works on the 2-D position instead: it applies a
+	radial dead zone and, optionally, a circularity correction that maps
+	the square gate reported by most devices onto a unit disc.
+
+	The processed position is exposed in cartesian coordinates (x and y
+	in the -1..1 range, oriented like the underlying axes, so y is positive
+	when the stick is pulled backward) and in polar coordinates (magnitude
+	in the 0..1 range and angle in degrees). Like for the POV, the angle
+	goes clockwise with 0 being "north" (i.e forward).
+
+	The Stick doesn't listen to its axes. Client code calls update() (or
+	updateSticks() to process many sticks in one batch) whenever it wants
+	the processed values to reflect the latest axis values.
+*/
+class Stick
+{
+public:
+	Stick( Axis* xAxis, Axis* yAxis );
+
+	struct Settings
+	{
+		Settings();
+		bool operator==( const Settings& other ) const;
+
+		float	deadZone;					// Radius under which the stick is considered centered (0..1)
+		float	saturation;					// Radius over which the stick is considered fully pushed (0..1)
+		bool	circularityCorrection;		// Map the square gate of the device onto a disc
+	};
+
+	Axis*					getXAxis() const		{ return mXAxis; }
+	Axis*					getYAxis() const		{ return mYAxis; }
+
+	const Settings&			getSettings() const		{ return mSettings; }
+	void					setSettings( const Settings& settings );
+
+	void					update();
+
+	float					getX() const			{ return mX; }
+	float					getY() const			{ return mY; }
+	float					getMagnitude() const	{ return mMagnitude; }
+
+	// The angle of the stick in degrees (0..360). It is only meaningful
+	// when the magnitude is not 0, otherwise it returns 0
+	float					getAngle() const		{ return mAngle; }
+
+	// Create a Stick for each pair of axes of the Device that is known to form a
+	// stick (GUID_XAxis/GUID_YAxis and GUID_RxAxis/GUID_RyAxis). The sticks are
+	// appended to the list
+	static void				findSticks( const Device* device, Sticks& sticks );
+
+	// Update many sticks in one go. This is faster than calling update() on
+	// each Stick as the processing is done in a single batch
+	static void				updateSticks( Sticks& sticks );
+
+	// The batched processing kernel. The input positions are normalized
+	// (-1..1) and the output arrays must be able to hold numSamples values.
+	// The angle output is optional and can be NULL
+	static void				processSamples( const Settings& settings, std::size_t numSamples,
+											const float* inX, const float* inY,
+											float* outX, float* outY, float* outMagnitude, float* outAngle );
+
+	static float			normalizeAxisValue( const Axis* axis );
+
+private:
+	Axis*					mXAxis;
+	Axis*					mYAxis;
+	Settings				mSettings;
+	float					mX;
+	float					mY;
+	float					mMagnitude;
+	float					mAngle;
+};
+
+}
@@ -37,9 +37,30 @@ public:
 	static unsigned long long int	getTickFrequency();
 	static unsigned long long int	getTimeAsTicks();
 	static unsigned int				getTimeAsMilliseconds();
+	static unsigned long long int	getTimeAsMicroseconds();
 
 private:
 	static unsigned long long int	mInitialTickCount;
 };
 
+/*
+	Clock
+
+	A source of time in milliseconds, for the classes that make decisions 
+	based on time, so they can be driven by a fake clock. SystemClock is the
+	real one (see Time::getTimeAsMilliseconds()).
+*/
+class Clock
+{
+public:
+	virtual ~Clock() {}
+	virtual unsigned int			getTimeAsMilliseconds() = 0;
+};
+
+class SystemClock : public Clock
+{
+public:
+	virtual unsigned int			getTimeAsMilliseconds();
+};
+
 }
@@ -0,0 +1,308 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIAsyncListener.h"
+
+#include <assert.h>
+#include <utility>
+
+namespace RDI
+{
+
+/*
+	ThreadPool
+*/
+ThreadPool::ThreadPool( unsigned int numThreads )
+	: mStopRequested(false)
+{
+	assert( numThreads>0 );
+	for ( unsigned int i=0; i<numThreads; ++i )
+		mThreads.push_back( std::thread( &ThreadPool::workerThread, this ) );
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mStopRequested = true;
+	}
+	mCondition.notify_all();
+	for ( std::size_t i=0; i<mThreads.size(); ++i )
+		mThreads[i].join();
+}
+
+void ThreadPool::execute( Task* task )
+{
+	assert( task );
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mTasks.push_back( task );
+	}
+	mCondition.notify_one();
+}
+
+void ThreadPool::workerThread()
+{
+	for ( ;; )
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		mCondition.wait( lock, [this]() { return mStopRequested || !mTasks.empty(); } );
+
+		// The remaining tasks are run before stopping
+		if ( mTasks.empty() )
+			return;
+		Task* task = mTasks.front();
+		mTasks.pop_front();
+		lock.unlock();
+
+		task->run();
+	}
+}
+
+/*
+	AsyncListener
+*/
+AsyncListener::AsyncListener( Handler* handler, Executor* executor, std::size_t queueCapacity, QueuePolicy policy )
+	: mHandler(handler),
+	  mExecutor(executor),
+	  mPolicy(policy),
+	  mDrainTask(this),
+	  mQueue(queueCapacity),
+	  mReadPosition(0),
+	  mWritePosition(0),
+	  mIsDraining(false),
+	  mMaxQueueDepth(0),
+	  mNumQueuedChanges(0),
+	  mNumHandledChanges(0),
+	  mNumDroppedChanges(0),
+	  mNumCoalescedChanges(0),
+	  mNumBlockedChanges(0)
+{
+	assert( mHandler );
+	assert( mExecutor );
+	assert( queueCapacity>0 );
+}
+
+AsyncListener::~AsyncListener()
+{
+	flush();
+}
+
+void AsyncListener::onObjectChanged( Device* device, Object* object )
+{
+	// A throttled Listener is called after the update, when the current 
+	// change is about another Object or is stale
+	const ObjectChange& change = device->getCurrentChange();
+	assert( change.objectIndex==object->getIndex() && change.newData==object->getData() && "An AsyncListener can't be a throttled Listener" );
+	(void)object;
+	bool mustDrain = false;
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		++mNumQueuedChanges;
+
+		// Merge the change with the queued one of the same Object, if any. The 
+		// position is only trusted if it's still in the queue and holds this Object
+		unsigned long long int* queuedPosition = NULL;
+		if ( mPolicy==Coalesce )
+		{
+			queuedPosition = findQueuedPosition( device, change.objectIndex );
+			if ( *queuedPosition>=mReadPosition && *queuedPosition<mWritePosition )
+			{
+				Notification& notification = mQueue[ *queuedPosition % mQueue.size() ];
+				if ( notification.device==device && notification.change.objectIndex==change.objectIndex )
+				{
+					notification.change.newData = change.newData;
+					notification.change.timeStamp = change.timeStamp;
+					notification.change.isResync = notification.change.isResync || change.isResync;
+					++mNumCoalescedChanges;
+					return;
+				}
+			}
+		}
+
+		// Make room
+		if ( mWritePosition - mReadPosition==mQueue.size() )
+		{
+			if ( mPolicy==Block )
+			{
+				++mNumBlockedChanges;
+				mCondition.wait( lock, [this]() { return mWritePosition - mReadPosition<mQueue.size(); } );
+			}
+			else
+			{
+				dropOldest();
+			}
+		}
+
+		Notification& notification = mQueue[ mWritePosition % mQueue.size() ];
+		notification.device = device;
+		notification.change = change;
+		if ( queuedPosition )
+			*queuedPosition = mWritePosition;
+		++mWritePosition;
+
+		std::size_t queueDepth = static_cast<std::size_t>( mWritePosition - mReadPosition );
+		if ( queueDepth>mMaxQueueDepth )
+			mMaxQueueDepth = queueDepth;
+
+		if ( !mIsDraining )
+		{
+			mIsDraining = true;
+			mustDrain = true;
+		}
+	}
+
+	// Outside of the lock, as the Executor could run the task right away
+	if ( mustDrain )
+		mExecutor->execute( &mDrainTask );
+}
+
+void AsyncListener::flush()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mCondition.wait( lock, [this]() { return !mIsDraining; } );
+}
+
+std::size_t AsyncListener::getQueueDepth() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return static_cast<std::size_t>( mWritePosition - mReadPosition );
+}
+
+std::size_t AsyncListener::getMaxQueueDepth() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mMaxQueueDepth;
+}
+
+unsigned long long int AsyncListener::getNumQueuedChanges() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mNumQueuedChanges;
+}
+
+unsigned long long int AsyncListener::getNumHandledChanges() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mNumHandledChanges;
+}
+
+unsigned long long int AsyncListener::getNumDroppedChanges() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mNumDroppedChanges;
+}
+
+unsigned long long int AsyncListener::getNumCoalescedChanges() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mNumCoalescedChanges;
+}
+
+unsigned long long int AsyncListener::getNumBlockedChanges() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mNumBlockedChanges;
+}
+
+// Called with the mutex locked
+unsigned long long int* AsyncListener::findQueuedPosition( Device* device, unsigned int objectIndex )
+{
+	QueuedDevice* queuedDevice = NULL;
+	for ( std::size_t i=0; i<mQueuedDevices.size(); ++i )
+	{
+		if ( mQueuedDevices[i].device==device )
+		{
+			queuedDevice = &mQueuedDevices[i];
+			break;
+		}
+	}
+	if ( !queuedDevice )
+	{
+		// Forget the devices whose changes have all been handled, as they may
+		// have been destroyed since
+		std::size_t numQueuedDevices = 0;
+		for ( std::size_t i=0; i<mQueuedDevices.size(); ++i )
+		{
+			const std::vector<unsigned long long int>& positions = mQueuedDevices[i].positions;
+			bool isQueued = false;
+			for ( std::size_t j=0; j<positions.size() && !isQueued; ++j )
+				isQueued = positions[j]>=mReadPosition && positions[j]<mWritePosition;
+			if ( !isQueued )
+				continue;
+			if ( numQueuedDevices!=i )
+				std::swap( mQueuedDevices[numQueuedDevices], mQueuedDevices[i] );
+			++numQueuedDevices;
+		}
+		mQueuedDevices.resize( numQueuedDevices );
+
+		mQueuedDevices.push_back( QueuedDevice() );
+		queuedDevice = &mQueuedDevices.back();
+		queuedDevice->device = device;
+	}
+	if ( objectIndex>=queuedDevice->positions.size() )
+		queuedDevice->positions.resize( objectIndex+1, 0 );
+	return &queuedDevice->positions[objectIndex];
+}
+
+// Called with the mutex locked
+void AsyncListener::dropOldest()
+{
+	assert( mWritePosition!=mReadPosition );
+	++mReadPosition;
+	++mNumDroppedChanges;
+}
+
+// Run by the Executor. Only one drain runs at a time, which keeps the changes
+// in order. A drain handles at most a queue worth of changes, then gives the 
+// thread back to the Executor so the other tasks get their turn
+void AsyncListener::drain()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	for ( std::size_t i=0; i<mQueue.size() && mReadPosition!=mWritePosition; ++i )
+	{
+		Notification notification = mQueue[ mReadPosition % mQueue.size() ];
+		++mReadPosition;
+		mCondition.notify_all();
+		lock.unlock();
+
+		mHandler->onObjectChanged( notification.device, notification.change );
+
+		lock.lock();
+		++mNumHandledChanges;
+	}
+
+	if ( mReadPosition!=mWritePosition )
+	{
+		lock.unlock();
+		mExecutor->execute( &mDrainTask );
+		return;
+	}
+
+	// Nothing is queued anymore, so no device needs to be remembered
+	mQueuedDevices.clear();
+	mIsDraining = false;
+	mCondition.notify_all();
+}
+
+}
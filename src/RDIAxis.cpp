@@ -30,36 +30,71 @@
 namespace RDI
 {
 
+/*
+	AxisHysteresis
+*/
+AxisHysteresis::AxisHysteresis( LONG minValue, LONG maxValue, LONG value )
+	: mThreshold(0),
+	  mMinValue(minValue),
+	  mMaxValue(maxValue),
+	  mNotifiedValue(value)
+{
+}
+
+void AxisHysteresis::setThreshold( LONG threshold )
+{
+	assert( threshold>=0 );
+	mThreshold = threshold;
+}
+
+bool AxisHysteresis::update( LONG value )
+{
+	if ( value==mNotifiedValue )
+		return false;
+
+	LONG delta = value>mNotifiedValue ? value-mNotifiedValue : mNotifiedValue-value;
+	if ( delta<=mThreshold && value!=mMinValue && value!=mMaxValue )
+		return false;
+	
+	mNotifiedValue = value;
+	return true;
+}
+
+/*
+	Axis
+*/
+
 Axis::Axis( const ObjectInstance& objectInstance, Device* parentDevice )
   : Object(objectInstance, parentDevice), 
 	mValue(0),
 	mMinValue(0),
-	mMaxValue(0)
+	mMaxValue(0),
+	mFilterId(AxisFilterBank::invalidId),
+	mHysteresis(0, 0, 0),
+	mNumChanges(0),
+	mNumNotifications(0)
 {
 	assert( objectInstance.isAxis() );		
 	assert( getParentDevice() );		
 
-	IDirectInputDevice8*  inputDevice = getParentDevice()->getInputDevice();
-	assert(inputDevice);
+	DeviceBackend*  deviceBackend = getParentDevice()->getDeviceBackend();
+	assert(deviceBackend);
 
 	// Get the axis value range
 	//if ((dev->dwType & DIDFT_ABSAXIS) != 0)
     //{
-	DIPROPRANGE range;
-    range.diph.dwSize = sizeof(DIPROPRANGE);
-    range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
-    range.diph.dwHow = DIPH_BYID;
-    range.diph.dwObj = objectInstance.getDwType();
-	HRESULT hr = inputDevice->GetProperty(DIPROP_RANGE, &range.diph);
-	assert( SUCCEEDED(hr) );
-	if ( SUCCEEDED(hr) )
+	LONG minValue = 0;
+	LONG maxValue = 0;
+	bool ret = deviceBackend->getAxisRange( objectInstance.getDwType(), minValue, maxValue );
+	assert( ret );
+	if ( ret )
 	{
 		// All the axes that I've seen on different devices have always had a range of 0 to 65535,
 		// whether they are sticks (that are mechanically centered) or so called sliders.
 		// So I don't expect to get usefull information here about the neutral position of a 
 		// stick/slider based on the values here (like a self-centering axis for example).
-		mMinValue = range.lMin;
-		mMaxValue = range.lMax;
+		mMinValue = minValue;
+		mMaxValue = maxValue;
 		assert( mMinValue!=mMaxValue );
 		assert( mMinValue<=mMaxValue );
 
@@ -73,6 +108,12 @@ Axis::Axis( const ObjectInstance& objectInstance, Device* parentDevice )
 		// game controller device!
 		mValue = mMinValue + (mMaxValue-mMinValue)/2;
 	}
+	mHysteresis = AxisHysteresis( mMinValue, mMaxValue, mValue );
+}
+
+void Axis::setChangeThreshold( LONG threshold )
+{
+	mHysteresis.setThreshold( threshold );
 }
 
 std::string Axis::toString() const
@@ -83,9 +124,19 @@ std::string Axis::toString() const
 	return str.str();
 }
 
+DWORD Axis::getData() const
+{
+	return static_cast<DWORD>( mValue );
+}
+
 void Axis::updateFrom( const DIDEVICEOBJECTDATA& entry )
 {
-	setValue( entry.dwData );		
+	// A filtered Axis gets its value from the filter once the parent 
+	// Device has processed all the pending entries
+	if ( mFilterId!=AxisFilterBank::invalidId )
+		getParentDevice()->pushAxisFilterSample( this, entry );
+	else
+		setValue( entry.dwData );		
 }
 
 void Axis::setValue( LONG value )
@@ -102,7 +153,15 @@ void Axis::setValue( LONG value )
 		return;
 	
 	mValue = value;
-	notifyChanged();
+	++mNumChanges;
+
+	// The listeners are told about the change since the last value they were notified of
+	LONG oldValue = mHysteresis.getNotifiedValue();
+	if ( !mHysteresis.update( value ) )
+		return;
+
+	++mNumNotifications;
+	notifyChanged( static_cast<DWORD>(oldValue) );
 }
 
 }
\ No newline at end of file
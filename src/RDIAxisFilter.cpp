@@ -0,0 +1,420 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIAxisFilter.h"
+
+#include <assert.h>
+#include <math.h>
+
+namespace RDI
+{
+
+namespace
+{
+
+const float twoPi = 6.28318531f;
+const float pi = 3.14159265f;
+
+template<typename T> void swapRemoveAt( std::vector<T>& values, std::size_t index )
+{
+	values[index] = values.back();
+	values.pop_back();
+}
+
+// Smoothing factor of a first order low-pass filter of cutoff frequency fc for a time step dt
+inline float smoothingFactor( float fc, float dt )
+{
+	float tau = 1.f / (twoPi * fc);
+	return dt / (dt + tau);
+}
+
+}
+
+/*
+	AxisFilter
+*/
+AxisFilter::AxisFilter()
+	: type(None),
+	  cutoffFrequency(0.f),
+	  q(0.7071f),
+	  beta(0.f),
+	  derivativeCutoffFrequency(1.f)
+{
+}
+
+AxisFilter AxisFilter::exponentialMovingAverage( float cutoffFrequency )
+{
+	AxisFilter filter;
+	filter.type = ExponentialMovingAverage;
+	filter.cutoffFrequency = cutoffFrequency;
+	return filter;
+}
+
+AxisFilter AxisFilter::lowPass( float cutoffFrequency, float q )
+{
+	AxisFilter filter;
+	filter.type = LowPass;
+	filter.cutoffFrequency = cutoffFrequency;
+	filter.q = q;
+	return filter;
+}
+
+AxisFilter AxisFilter::oneEuro( float minCutoffFrequency, float beta, float derivativeCutoffFrequency )
+{
+	AxisFilter filter;
+	filter.type = OneEuro;
+	filter.cutoffFrequency = minCutoffFrequency;
+	filter.beta = beta;
+	filter.derivativeCutoffFrequency = derivativeCutoffFrequency;
+	return filter;
+}
+
+/*
+	AxisFilterBank::Lanes
+*/
+void AxisFilterBank::Lanes::resize( std::size_t size )
+{
+	ids.resize( size );
+	filters.resize( size );
+	offset.resize( size );
+	scale.resize( size );
+	input.resize( size );
+	inputTime.resize( size );
+	hasInput.resize( size );
+	hasTime.resize( size );
+	lastTime.resize( size );
+	dt.resize( size );
+	cutoff.resize( size );
+	shape.resize( size );
+	derivativeCutoff.resize( size );
+	y.resize( size );
+	y2.resize( size );
+	x1.resize( size );
+	x2.resize( size );
+	dx.resize( size );
+	value.resize( size );
+}
+
+void AxisFilterBank::Lanes::swapRemove( std::size_t index )
+{
+	swapRemoveAt( ids, index );
+	swapRemoveAt( filters, index );
+	swapRemoveAt( offset, index );
+	swapRemoveAt( scale, index );
+	swapRemoveAt( input, index );
+	swapRemoveAt( inputTime, index );
+	swapRemoveAt( hasInput, index );
+	swapRemoveAt( hasTime, index );
+	swapRemoveAt( lastTime, index );
+	swapRemoveAt( dt, index );
+	swapRemoveAt( cutoff, index );
+	swapRemoveAt( shape, index );
+	swapRemoveAt( derivativeCutoff, index );
+	swapRemoveAt( y, index );
+	swapRemoveAt( y2, index );
+	swapRemoveAt( x1, index );
+	swapRemoveAt( x2, index );
+	swapRemoveAt( dx, index );
+	swapRemoveAt( value, index );
+
+	// The pending samples of the removed lane are dropped, the ones of the 
+	// last lane follow it
+	std::size_t lastIndex = ids.size();
+	std::size_t numSamples = 0;
+	for ( std::size_t i=0; i<samples.size(); ++i )
+	{
+		if ( samples[i].index==index )
+			continue;
+		samples[numSamples] = samples[i];
+		if ( samples[numSamples].index==lastIndex )
+			samples[numSamples].index = index;
+		++numSamples;
+	}
+	samples.resize( numSamples );
+}
+
+// Take the next pending sample of each lane as its input and work out the 
+// time step up to it. The lanes without a sample don't step. The samples 
+// left for the next pass keep their order. Returns false if there was none
+bool AxisFilterBank::Lanes::prepareSamples()
+{
+	if ( samples.empty() )
+		return false;
+
+	std::size_t numSamples = 0;
+	for ( std::size_t i=0; i<samples.size(); ++i )
+	{
+		const Sample& sample = samples[i];
+		if ( hasInput[sample.index] )
+		{
+			samples[numSamples++] = sample;
+			continue;
+		}
+		input[sample.index] = sample.input;
+		inputTime[sample.index] = sample.time;
+		hasInput[sample.index] = 1;
+	}
+	samples.resize( numSamples );
+
+	for ( std::size_t i=0; i<ids.size(); ++i )
+	{
+		if ( hasInput[i] )
+			step( i, inputTime[i] );
+		else
+			dt[i] = 0.f;
+		hasInput[i] = 0;
+	}
+	return true;
+}
+
+// Work out the time step of each lane up to the current time, with its 
+// last input
+void AxisFilterBank::Lanes::prepare( DWORD currentTime )
+{
+	for ( std::size_t i=0; i<ids.size(); ++i )
+		step( i, currentTime );
+}
+
+void AxisFilterBank::Lanes::step( std::size_t index, DWORD time )
+{
+	int elapsed = hasTime[index] ? static_cast<int>( time - lastTime[index] ) : 0;
+	if ( elapsed>0 || !hasTime[index] )
+		lastTime[index] = time;
+	dt[index] = elapsed>0 ? static_cast<float>(elapsed) * 0.001f : 0.f;
+	hasTime[index] = 1;
+}
+
+// Convert the normalized outputs back to axis units. The LowPass filter 
+// can slightly overshoot so the outputs are clamped to the axis range
+void AxisFilterBank::Lanes::finish()
+{
+	for ( std::size_t i=0; i<ids.size(); ++i )
+	{
+		float normalizedValue = y[i] < 0.f ? 0.f : (y[i] > 1.f ? 1.f : y[i]);
+		value[i] = static_cast<LONG>( floorf( offset[i] + normalizedValue * scale[i] + 0.5f ) );
+	}
+}
+
+/*
+	AxisFilterBank
+*/
+AxisFilterBank::AxisFilterBank()
+	: mLocations(),
+	  mFreeIds()
+{
+}
+
+AxisFilterBank::Id AxisFilterBank::addAxis( const AxisFilter& filter, LONG minValue, LONG maxValue, LONG value )
+{
+	assert( filter.type!=AxisFilter::None && filter.type<AxisFilter::NumTypes );
+	assert( filter.cutoffFrequency>0.f );
+	assert( minValue<maxValue );
+
+	Id id = 0;
+	if ( mFreeIds.empty() )
+	{
+		id = static_cast<Id>( mLocations.size() );
+		mLocations.push_back( Location() );
+	}
+	else
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+
+	Lanes& lanes = mLanes[filter.type];
+	std::size_t index = lanes.ids.size();
+	lanes.resize( index+1 );
+	mLocations[id].type = filter.type;
+	mLocations[id].index = index;
+
+	float normalizedValue = static_cast<float>(value - minValue) / static_cast<float>(maxValue - minValue);
+	lanes.ids[index] = id;
+	lanes.filters[index] = filter;
+	lanes.offset[index] = static_cast<float>(minValue);
+	lanes.scale[index] = static_cast<float>(maxValue - minValue);
+	lanes.input[index] = normalizedValue;
+	lanes.inputTime[index] = 0;
+	lanes.hasInput[index] = 0;
+	lanes.hasTime[index] = 0;
+	lanes.lastTime[index] = 0;
+	lanes.dt[index] = 0.f;
+	lanes.cutoff[index] = filter.cutoffFrequency;
+	lanes.shape[index] = filter.type==AxisFilter::LowPass ? filter.q : filter.beta;
+	lanes.derivativeCutoff[index] = filter.derivativeCutoffFrequency;
+	lanes.y[index] = normalizedValue;
+	lanes.y2[index] = normalizedValue;
+	lanes.x1[index] = normalizedValue;
+	lanes.x2[index] = normalizedValue;
+	lanes.dx[index] = 0.f;
+	lanes.value[index] = value;
+	return id;
+}
+
+void AxisFilterBank::removeAxis( Id id )
+{
+	assert( id<mLocations.size() );
+	Location location = mLocations[id];
+	Lanes& lanes = mLanes[location.type];
+	assert( lanes.ids[location.index]==id );
+
+	// The last lane of this type takes the place of the removed one
+	Id movedId = lanes.ids.back();
+	lanes.swapRemove( location.index );
+	if ( movedId!=id )
+		mLocations[movedId].index = location.index;
+	mFreeIds.push_back( id );
+}
+
+const AxisFilter& AxisFilterBank::getFilter( Id id ) const
+{
+	assert( id<mLocations.size() );
+	const Location& location = mLocations[id];
+	return mLanes[location.type].filters[location.index];
+}
+
+std::size_t AxisFilterBank::getNumAxes() const
+{
+	return mLocations.size() - mFreeIds.size();
+}
+
+void AxisFilterBank::pushSample( Id id, LONG value, DWORD timeStamp )
+{
+	assert( id<mLocations.size() );
+	const Location& location = mLocations[id];
+	Lanes& lanes = mLanes[location.type];
+	std::size_t index = location.index;
+	Sample sample;
+	sample.index = index;
+	sample.input = ( static_cast<float>(value) - lanes.offset[index] ) / lanes.scale[index];
+	sample.time = timeStamp;
+	lanes.samples.push_back( sample );
+}
+
+LONG AxisFilterBank::getValue( Id id ) const
+{
+	assert( id<mLocations.size() );
+	const Location& location = mLocations[id];
+	return mLanes[location.type].value[location.index];
+}
+
+void AxisFilterBank::process( DWORD currentTime )
+{
+	for ( int type=AxisFilter::None+1; type<AxisFilter::NumTypes; ++type )
+	{
+		Lanes& lanes = mLanes[type];
+		if ( lanes.ids.empty() )
+			continue;
+		while ( lanes.prepareSamples() )
+			processLanes( static_cast<AxisFilter::Type>(type), lanes );
+		lanes.prepare( currentTime );
+		processLanes( static_cast<AxisFilter::Type>(type), lanes );
+		lanes.finish();
+	}
+}
+
+void AxisFilterBank::processLanes( AxisFilter::Type type, Lanes& lanes )
+{
+	switch ( type )
+	{
+		case AxisFilter::ExponentialMovingAverage:	processExponentialMovingAverage( lanes ); break;
+		case AxisFilter::LowPass:					processLowPass( lanes ); break;
+		case AxisFilter::OneEuro:					processOneEuro( lanes ); break;
+		default:									break;
+	}
+}
+
+// The loops below are free of branches (the ternaries are selects) so they can be vectorized
+void AxisFilterBank::processExponentialMovingAverage( Lanes& lanes )
+{
+	std::size_t size = lanes.ids.size();
+	const float* input = &lanes.input[0];
+	const float* dt = &lanes.dt[0];
+	const float* cutoff = &lanes.cutoff[0];
+	float* y = &lanes.y[0];
+	for ( std::size_t i=0; i<size; ++i )
+	{
+		float alpha = smoothingFactor( cutoff[i], dt[i] );
+		y[i] += alpha * (input[i] - y[i]);
+	}
+}
+
+// Second order Butterworth low-pass, with coefficients obtained by bilinear 
+// transform for the time step of each sample
+void AxisFilterBank::processLowPass( Lanes& lanes )
+{
+	std::size_t size = lanes.ids.size();
+	const float* input = &lanes.input[0];
+	const float* dt = &lanes.dt[0];
+	const float* cutoff = &lanes.cutoff[0];
+	const float* q = &lanes.shape[0];
+	float* y1 = &lanes.y[0];
+	float* y2 = &lanes.y2[0];
+	float* x1 = &lanes.x1[0];
+	float* x2 = &lanes.x2[0];
+	for ( std::size_t i=0; i<size; ++i )
+	{
+		// Keep the normalized frequency below Nyquist
+		float w = cutoff[i] * dt[i];
+		w = w < 0.49f ? w : 0.49f;
+		float k = tanf( pi * w );
+		float kk = k * k;
+		float norm = 1.f / (1.f + k / q[i] + kk);
+		float b0 = kk * norm;
+		float a1 = 2.f * (kk - 1.f) * norm;
+		float a2 = (1.f - k / q[i] + kk) * norm;
+		float x = input[i];
+		float out = b0 * (x + 2.f * x1[i] + x2[i]) - a1 * y1[i] - a2 * y2[i];
+
+		// A lane that wasn't stepped in time keeps its state
+		bool stepped = dt[i] > 0.f;
+		y2[i] = stepped ? y1[i] : y2[i];
+		y1[i] = stepped ? out : y1[i];
+		x2[i] = stepped ? x1[i] : x2[i];
+		x1[i] = stepped ? x : x1[i];
+	}
+}
+
+void AxisFilterBank::processOneEuro( Lanes& lanes )
+{
+	std::size_t size = lanes.ids.size();
+	const float* input = &lanes.input[0];
+	const float* dt = &lanes.dt[0];
+	const float* minCutoff = &lanes.cutoff[0];
+	const float* beta = &lanes.shape[0];
+	const float* derivativeCutoff = &lanes.derivativeCutoff[0];
+	float* y = &lanes.y[0];
+	float* dx = &lanes.dx[0];
+	for ( std::size_t i=0; i<size; ++i )
+	{
+		float step = dt[i] > 0.001f ? dt[i] : 0.001f;
+		float rawDerivative = (input[i] - y[i]) / step;
+		float derivativeAlpha = smoothingFactor( derivativeCutoff[i], dt[i] );
+		dx[i] += derivativeAlpha * (rawDerivative - dx[i]);
+		float cutoff = minCutoff[i] + beta[i] * fabsf( dx[i] );
+		float alpha = smoothingFactor( cutoff, dt[i] );
+		y[i] += alpha * (input[i] - y[i]);
+	}
+}
+
+}
@@ -28,10 +28,86 @@
 
 namespace RDI
 {
+
+/*
+	ButtonDebouncer
+*/
+ButtonDebouncer::ButtonDebouncer( bool isPressed )
+	: mMode(LeadingEdge),
+	  mWindow(0),
+	  mIsPressed(isPressed),
+	  mIsRawPressed(isPressed),
+	  mLastEdgeTime(0),
+	  mNumRawEdges(0),
+	  mNumEdges(0)
+{
+}
+
+void ButtonDebouncer::setWindow( DWORD windowInMs, Mode mode )
+{
+	mWindow = windowInMs;
+	mMode = mode;
+}
+
+bool ButtonDebouncer::update( bool isRawPressed, DWORD timeStamp )
+{
+	if ( isRawPressed==mIsRawPressed )
+		return false;
+	mIsRawPressed = isRawPressed;
+	++mNumRawEdges;
+
+	if ( mMode==TrailingEdge )
+	{
+		// Restart the stability window
+		mLastEdgeTime = timeStamp;
+		if ( mWindow==0 && isPending() )
+		{
+			accept( timeStamp );
+			return true;
+		}
+		return false;
+	}
 	
+	// In LeadingEdge mode, a change is accepted right away unless it's 
+	// within the window that follows the last accepted one
+	bool isWindowOver = mNumEdges==0 || static_cast<int>(timeStamp - mLastEdgeTime)>=static_cast<int>(mWindow);
+	if ( isPending() && isWindowOver )
+	{
+		accept( timeStamp );
+		return true;
+	}
+	return false;
+}
+
+bool ButtonDebouncer::update( DWORD currentTime )
+{
+	if ( !isPending() )
+		return false;
+
+	// Whatever the mode, a raw state that has been stable for the duration of the
+	// window gets accepted. In LeadingEdge mode, the window since the last accepted 
+	// edge is the one that matters (the raw state can't be older than it)
+	if ( static_cast<int>(currentTime - mLastEdgeTime)<static_cast<int>(mWindow) )
+		return false;
+	accept( currentTime );
+	return true;
+}
+
+void ButtonDebouncer::accept( DWORD time )
+{
+	mIsPressed = mIsRawPressed;
+	++mNumEdges;
+	if ( mMode==LeadingEdge )
+		mLastEdgeTime = time;
+}
+
+/*
+	Button
+*/
 Button::Button( const ObjectInstance& objectInstance, Device* parentDevice )
   : Object( objectInstance, parentDevice ), 
-	mIsPressed(false)
+	mIsPressed(false),
+	mDebouncer(false)
 {
 	assert( objectInstance.isButton() );		
 }	
@@ -43,18 +119,40 @@ std::string Button::toString() const
 	return str.str();
 }
 
+DWORD Button::getData() const
+{
+	return mIsPressed ? 0x80 : 0;
+}
+
 void Button::updateFrom( const DIDEVICEOBJECTDATA& entry )
 {
 	bool isPressed = (entry.dwData & 0x80)!=0;
-	setPressed( isPressed );
+	if ( mDebouncer.getWindow()==0 )
+	{
+		setPressed( isPressed );
+		return;
+	}
+
+	// A pending state might have become stable before this entry occurred
+	if ( mDebouncer.update( entry.dwTimeStamp ) )
+		setPressed( mDebouncer.isPressed() );
+	if ( mDebouncer.update( isPressed, entry.dwTimeStamp ) )
+		setPressed( mDebouncer.isPressed() );
+}
+
+void Button::updateDebouncer( DWORD currentTime )
+{
+	if ( mDebouncer.update( currentTime ) )
+		setPressed( mDebouncer.isPressed() );
 }
 
 void Button::setPressed( bool isPressed )
 {
 	if ( isPressed==mIsPressed )
 		return;
+	DWORD oldData = getData();
 	mIsPressed = isPressed;
-	notifyChanged();
+	notifyChanged( oldData );
 }
 
 }
\ No newline at end of file
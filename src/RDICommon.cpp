@@ -23,8 +23,12 @@
 */
 #include "RDICommon.h"
 
+#include <assert.h>
+#include <algorithm>
+#ifdef _WIN32
 #include <wbemidl.h>		// For isXInputDevice()
 #include <oleauto.h>		// For isXInputDevice() (SysAllocString)
+#endif
 #include <stdio.h>			// For isXInputDevice() (swscanf)
 
 //#include "RDITime.h"
@@ -34,13 +38,45 @@ namespace RDI
 
 std::string	Common::TCHARToUTF8( const TCHAR* tcharString )
 {
+#ifdef _WIN32
 #ifdef _UNICODE
 	return UTF16toUTF8String( tcharString );
 #else
 	return UTF16toUTF8String( MBCStoUTF16String( tcharString ) );
 #endif
+#else
+	// Outside of Windows, TCHAR is char and the strings are UTF-8
+	return tcharString;
+#endif
 }
 
+void Common::UTF8ToTCHAR( const std::string& utf8String, TCHAR* buffer, std::size_t bufferSize )
+{
+	assert( bufferSize>0 );
+#ifdef _WIN32
+#ifdef _UNICODE
+	std::wstring tcharString = UTF8toUTF16String( utf8String );
+#else
+	std::wstring utf16String = UTF8toUTF16String( utf8String );
+	std::string tcharString;
+	if ( !utf16String.empty() )
+	{
+		int retStringSizeInByte = ::WideCharToMultiByte(CP_ACP, 0, utf16String.c_str(), static_cast<int>(utf16String.length()), 0, 0, 0, 0);
+		tcharString.resize( retStringSizeInByte );
+		::WideCharToMultiByte(CP_ACP, 0, utf16String.c_str(), static_cast<int>(utf16String.length()), &tcharString[0], retStringSizeInByte, 0, 0);
+	}
+#endif
+#else
+	const std::string& tcharString = utf8String;
+#endif
+	std::size_t length = std::min( tcharString.size(), bufferSize-1 );
+	for ( std::size_t i=0; i<length; ++i )
+		buffer[i] = tcharString[i];
+	buffer[length] = 0;
+}
+
+#ifdef _WIN32
+
 std::wstring Common::MBCStoUTF16String( const std::string& mbcsString )
 {
 	if( mbcsString.empty() )    
@@ -205,13 +241,18 @@ t0 = 0;
 */
     return bIsXinputDevice;
 }
+#endif
 
 std::string	Common::GUIDToString(const GUID* guid)
 {
 	// Inspired from http://stackoverflow.com/questions/1672677/print-a-guid-variable
 	const unsigned int numChars = 37;
 	char guidString[numChars];
+#ifdef _MSC_VER
     sprintf_s(	guidString, numChars,
+#else
+    snprintf(	guidString, numChars,
+#endif
 				"%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
 				guid->Data1, guid->Data2, guid->Data3,
 				guid->Data4[0], guid->Data4[1], guid->Data4[2],
@@ -220,6 +261,7 @@ std::string	Common::GUIDToString(const GUID* guid)
     return guidString;
 }
 
+#ifdef _WIN32
 // See http://msdn.microsoft.com/en-us/library/ee416869(VS.85).aspx
 const char* Common::HRESULTToString( HRESULT hr )
 {
@@ -274,5 +316,6 @@ const char* Common::HRESULTToString( HRESULT hr )
 	}
 	return "E_UNDEFINED";
 }
+#endif
 
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIDataFormat.h"
+
+#include <assert.h>
+#include <string.h>
+
+namespace RDI
+{
+
+DataFormat::DataFormat()
+	: mDataSize(0)
+{
+}
+
+DataFormat DataFormat::createMinimal( const ObjectInstances& objectInstances )
+{
+	DataFormat dataFormat;
+
+	// The DWORDs first so they're aligned, then the bytes of the buttons
+	for ( int pass=0; pass<2; ++pass )
+	{
+		for ( std::size_t i=0; i<objectInstances.size(); ++i )
+		{
+			const ObjectInstance& objectInstance = objectInstances[i];
+			bool isValue = objectInstance.isAxis() || objectInstance.isPOV();
+			if ( pass==0 ? !isValue : !objectInstance.isButton() )
+				continue;
+
+			ObjectFormat object;
+			object.objectType = objectInstance.getDwType();
+			object.offset = dataFormat.mDataSize;
+			dataFormat.mObjects.push_back( object );
+			dataFormat.mDataSize += getStateSize( object.objectType );
+		}
+	}
+	dataFormat.mDataSize = (dataFormat.mDataSize + 3) & ~3;
+	return dataFormat;
+}
+
+DataFormat DataFormat::createFromOffsets( const ObjectInstances& objectInstances, DWORD dataSize )
+{
+	DataFormat dataFormat;
+	dataFormat.mDataSize = dataSize;
+	for ( std::size_t i=0; i<objectInstances.size(); ++i )
+	{
+		const ObjectInstance& objectInstance = objectInstances[i];
+		if ( !objectInstance.isAxis() && !objectInstance.isPOV() && !objectInstance.isButton() )
+			continue;
+
+		ObjectFormat object;
+		object.objectType = objectInstance.getDwType();
+		object.offset = objectInstance.getDwOfs();
+		if ( object.offset + getStateSize( object.objectType )<=dataSize )
+			dataFormat.mObjects.push_back( object );
+	}
+	return dataFormat;
+}
+
+int DataFormat::findObject( DWORD objectType ) const
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i].objectType==objectType )
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+DWORD DataFormat::getStateSize( DWORD objectType )
+{
+	return (DIDFT_GETTYPE(objectType) & DIDFT_BUTTON) ? 1 : sizeof(DWORD);
+}
+
+DWORD DataFormat::readState( const BYTE* data, const ObjectFormat& object )
+{
+	assert( data );
+	if ( DIDFT_GETTYPE(object.objectType) & DIDFT_BUTTON )
+		return data[object.offset];
+	DWORD state;
+	memcpy( &state, data + object.offset, sizeof(DWORD) );
+	return state;
+}
+
+void DataFormat::writeState( BYTE* data, const ObjectFormat& object, DWORD state )
+{
+	assert( data );
+	if ( DIDFT_GETTYPE(object.objectType) & DIDFT_BUTTON )
+		data[object.offset] = static_cast<BYTE>( state );
+	else
+		memcpy( data + object.offset, &state, sizeof(DWORD) );
+}
+
+}
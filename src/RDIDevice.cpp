@@ -22,8 +22,10 @@
    SOFTWARE.
 */
 #include "RDIDevice.h"
+#include "RDIAxis.h"
 
 #include <assert.h>
+#include <string.h>
 #include <algorithm>
 
 /*
@@ -35,86 +37,387 @@
 namespace RDI
 {
 
-Device::Device( /*HWND windowHandle,*/ IDirectInput8* directInput, const DeviceInstance& identifier/*, DWORD coopSettings*/ )
+/*
+	ObjectFilter
+*/
+ObjectFilter::ObjectFilter()
+	: typeFlags(AllTypes),
+	  usagePage(0),
+	  usage(0)
+{
+}
+
+ObjectFilter ObjectFilter::types( unsigned int typeFlags )
+{
+	ObjectFilter filter;
+	filter.typeFlags = typeFlags;
+	return filter;
+}
+
+ObjectFilter ObjectFilter::objects( const std::vector<unsigned int>& objectIndices )
+{
+	ObjectFilter filter;
+	filter.objectIndices = objectIndices;
+	return filter;
+}
+
+ObjectFilter ObjectFilter::hidUsage( WORD usagePage, WORD usage )
+{
+	ObjectFilter filter;
+	filter.usagePage = usagePage;
+	filter.usage = usage;
+	return filter;
+}
+
+bool ObjectFilter::accepts( const Object* object ) const
+{
+	assert( object );
+	const ObjectInstance& objectInstance = object->getObjectInstance();
+	unsigned int type = objectInstance.isAxis() ? Axes : (objectInstance.isButton() ? Buttons : POVs);
+	if ( (typeFlags & type)==0 )
+		return false;
+	if ( !objectIndices.empty() && std::find( objectIndices.begin(), objectIndices.end(), object->getIndex() )==objectIndices.end() )
+		return false;
+	if ( usagePage!=0 && objectInstance.getUsagePage()!=usagePage )
+		return false;
+	if ( usage!=0 && objectInstance.getUsage()!=usage )
+		return false;
+	return true;
+}
+
+/*
+	Device::ThrottledListener
+
+	Registered in place of a throttled Listener. It remembers which objects 
+	changed until the Device notifies the Listener
+*/
+class Device::ThrottledListener : public Device::Listener
+{
+public:
+	ThrottledListener( Listener* listener, DWORD minIntervalInMs )
+		: mListener(listener),
+		  mMinInterval(minIntervalInMs),
+		  mHasNotified(false),
+		  mLastNotificationTime(0)
+	{
+	}
+
+	virtual ~ThrottledListener()
+	{
+	}
+
+	virtual void onObjectChanged( Device* /*device*/, Object* object )
+	{
+		unsigned int index = object->getIndex();
+		if ( index>=mIsDirty.size() )
+			mIsDirty.resize( index+1, false );
+		if ( mIsDirty[index] )
+			return;
+		mIsDirty[index] = true;
+		mDirtyObjects.push_back( index );
+	}
+
+	void notify( Device* device, DWORD currentTime )
+	{
+		// The first changes are notified without waiting
+		if ( mDirtyObjects.empty() || (mHasNotified && currentTime - mLastNotificationTime < mMinInterval) )
+			return;
+		mHasNotified = true;
+		mLastNotificationTime = currentTime;
+
+		const Objects& objects = device->getObjects();
+		for ( std::size_t i=0; i<mDirtyObjects.size(); ++i )
+		{
+			unsigned int index = mDirtyObjects[i];
+			mIsDirty[index] = false;
+			mListener->onObjectChanged( device, objects[index] );
+		}
+		mDirtyObjects.clear();
+	}
+
+	Listener*					mListener;
+	DWORD						mMinInterval;
+	bool						mHasNotified;
+	DWORD						mLastNotificationTime;
+	std::vector<bool>			mIsDirty;				// One per Object
+	std::vector<unsigned int>	mDirtyObjects;			// In the order they first changed
+};
+
+/*
+	Device::ThrottledBatchListener
+
+	Registered in place of a throttled BatchListener. It consolidates the 
+	changes of each Object until the Device notifies the BatchListener
+*/
+class Device::ThrottledBatchListener : public Device::BatchListener
+{
+public:
+	ThrottledBatchListener( BatchListener* listener, DWORD minIntervalInMs )
+		: mListener(listener),
+		  mMinInterval(minIntervalInMs),
+		  mHasNotified(false),
+		  mLastNotificationTime(0)
+	{
+	}
+
+	virtual ~ThrottledBatchListener()
+	{
+	}
+
+	virtual void onObjectsChanged( Device* /*device*/, const ObjectChange* changes, std::size_t numChanges )
+	{
+		for ( std::size_t i=0; i<numChanges; ++i )
+		{
+			const ObjectChange& change = changes[i];
+			unsigned int index = change.objectIndex;
+			if ( index>=mChangeIndices.size() )
+				mChangeIndices.resize( index+1, noChange );
+			if ( mChangeIndices[index]==noChange )
+			{
+				mChangeIndices[index] = static_cast<unsigned int>( mChanges.size() );
+				mChanges.push_back( change );
+				continue;
+			}
+			ObjectChange& consolidatedChange = mChanges[mChangeIndices[index]];
+			consolidatedChange.newData = change.newData;
+			consolidatedChange.timeStamp = change.timeStamp;
+			consolidatedChange.isResync = change.isResync;
+		}
+	}
+
+	void notify( Device* device, DWORD currentTime )
+	{
+		// The first changes are notified without waiting
+		if ( mChanges.empty() || (mHasNotified && currentTime - mLastNotificationTime < mMinInterval) )
+			return;
+		mHasNotified = true;
+		mLastNotificationTime = currentTime;
+
+		mListener->onObjectsChanged( device, &mChanges[0], mChanges.size() );
+		for ( std::size_t i=0; i<mChanges.size(); ++i )
+			mChangeIndices[mChanges[i].objectIndex] = noChange;
+		mChanges.clear();
+	}
+
+	static const unsigned int	noChange = 0xFFFFFFFF;
+
+	BatchListener*				mListener;
+	DWORD						mMinInterval;
+	bool						mHasNotified;
+	DWORD						mLastNotificationTime;
+	std::vector<unsigned int>	mChangeIndices;			// The index of the change of each Object in mChanges, if any
+	std::vector<ObjectChange>	mChanges;				// In the order the objects first changed
+};
+
+const unsigned int Device::ThrottledBatchListener::noChange;
+
+/*
+	ReacquireBackoff
+*/
+ReacquireBackoff::Settings::Settings()
+	: minDelayInMs(50),
+	  maxDelayInMs(1000),
+	  jitterPercent(25)
+{
+}
+
+ReacquireBackoff::ReacquireBackoff( unsigned int seed )
+	: mRandomState(seed!=0 ? seed : 0x9E3779B9),
+	  mNumConsecutiveFailures(0),
+	  mDelay(0),
+	  mNextAttemptTime(0),
+	  mNumAttempts(0),
+	  mNumFailures(0),
+	  mNumSkippedPolls(0)
+{
+}
+
+void ReacquireBackoff::setSettings( const Settings& settings )
+{
+	mSettings = settings;
+	if ( mSettings.maxDelayInMs<mSettings.minDelayInMs )
+		mSettings.maxDelayInMs = mSettings.minDelayInMs;
+	if ( mSettings.jitterPercent>100 )
+		mSettings.jitterPercent = 100;
+}
+
+bool ReacquireBackoff::isAttemptDue( DWORD currentTime ) const
+{
+	if ( !isBackingOff() || mSettings.minDelayInMs==0 )
+		return true;
+
+	// The difference is signed so the wrap around of the time doesn't matter
+	return static_cast<LONG>( currentTime - mNextAttemptTime )>=0;
+}
+
+void ReacquireBackoff::onAttempt( bool succeeded, DWORD currentTime )
+{
+	++mNumAttempts;
+	if ( succeeded )
+	{
+		mNumConsecutiveFailures = 0;
+		mDelay = 0;
+		return;
+	}
+
+	++mNumFailures;
+	++mNumConsecutiveFailures;
+	if ( mSettings.minDelayInMs==0 )
+		return;
+
+	if ( mNumConsecutiveFailures==1 )
+		mDelay = mSettings.minDelayInMs;
+	else
+		mDelay = mDelay>mSettings.maxDelayInMs / 2 ? mSettings.maxDelayInMs : mDelay * 2;
+
+	// Remove a random part of the delay (xorshift32)
+	DWORD jitter = static_cast<DWORD>( (static_cast<unsigned long long int>(mDelay) * mSettings.jitterPercent) / 100 );
+	DWORD removedDelay = 0;
+	if ( jitter>0 )
+	{
+		mRandomState ^= mRandomState << 13;
+		mRandomState ^= mRandomState >> 17;
+		mRandomState ^= mRandomState << 5;
+		removedDelay = mRandomState % (jitter + 1);
+	}
+	mNextAttemptTime = currentTime + mDelay - removedDelay;
+}
+
+/*
+	Device
+*/
+Device::Device( /*HWND windowHandle,*/ Backend* backend, const DeviceInstance& identifier/*, DWORD coopSettings*/ )
 	: //mWindowHandle(windowHandle),
-	  mDirectInput(directInput),
-	  mDeviceInstance(identifier)
+	  mBackend(backend),
+	  mDeviceInstance(identifier),
 	  //mCoopSettings(coopSettings)
+	  mDeviceBackend(NULL),
+	  mCurrentChange(),
+	  mTimeStamp(0),
+	  mNumUpdateEvents(0),
+	  mNumUpdateChanges(0),
+	  mAxisChangeThreshold(0),
+	  mReacquireBackoff( static_cast<unsigned int>( identifier.getGuidInstance().Data1 ) ),
+	  mHasContiguousSequences(false),
+	  mHasSequence(false),
+	  mLastSequence(0),
+	  mHasBeenAcquired(false),
+	  mIsResyncNeeded(false),
+	  mIsResyncing(false),
+	  mIsDataFormatDirty(false),
+	  mNumOverflows(0),
+	  mNumSequenceGaps(0),
+	  mNumResyncs(0),
+	  mNumFailedResyncs(0)
 {
 	bool ret = initialize();
 	assert(ret);
 	ret = enumerateObjects();
 	assert(ret);
+	(void)ret;		// Only checked in debug builds
+	mListenerRegistry.modify( [this]( ListenerSnapshot& snapshot ) { updateDispatchLists( snapshot ); return true; } );
 }
 
 Device::~Device()
 {
 	deleteObjects();
 
-	assert( mInputDevice );
-	mInputDevice->Unacquire();
-	mInputDevice->Release();
-	mInputDevice = NULL;
+	assert( mDeviceBackend );
+	mDeviceBackend->unacquire();
+	delete mDeviceBackend;
+	mDeviceBackend = NULL;
 }
 
 void Device::update()
 {
+	// No listener snapshot is in use here, so the replaced ones can be deleted
+	mListenerRegistry.reclaim();
+	mListenerRegistry.beginDispatch();
+
+	mNumUpdateEvents = 0;
+	mNumUpdateChanges = 0;
+
+	if ( mIsDataFormatDirty )
+		updateDataFormat();
+
 	DIDEVICEOBJECTDATA dataEntries[mDataBufferSize];
 	DWORD numDataEntries = mDataBufferSize;
 
 	// Try to get the data
-	bool ret = getDeviceData( mInputDevice, dataEntries, &numDataEntries );
+	bool ret = getDeviceData( dataEntries, &numDataEntries );
 	if ( !ret )
 	{
 		// Getting data from the device can fail if for example the device
 		// has been physically removed and we haven't yet update the device list 
-		// In the meantime, that means that we're returning the last valid state
+		// In the meantime, that means that we're returning the last valid state.
+		// The changes the throttled listeners are waiting for are still due
+		DWORD currentTime = mBackend->getTickCount();
+		notifyBatchListeners();
+		notifyThrottledListeners( currentTime );
+		mListenerRegistry.endDispatch();
 		return;
 	}
 
+	mNumUpdateEvents = numDataEntries;
 	for( unsigned int i=0; i<numDataEntries; ++i )					
 	{															
 		// Find the Object involved in the event and update it
 		const DIDEVICEOBJECTDATA& entry = dataEntries[i];
+
+		// A gap in the sequence numbers means that events were lost
+		if ( mHasContiguousSequences )
+		{
+			if ( mHasSequence && entry.dwSequence!=mLastSequence+1 )
+			{
+				++mNumSequenceGaps;
+				mIsResyncNeeded = true;
+			}
+			mHasSequence = true;
+			mLastSequence = entry.dwSequence;
+		}
 		
 		// The 0xFFFFFFFF value indicates no user data, therefore its a 
-		// DirectInput object we're not considering
+		// DirectInput object we're not considering. A disabled object keeps
+		// its user data if the backend refused to clear it
 		if ( entry.uAppData!=0xFFFFFFFF )			
 		{
 			Object* object = reinterpret_cast<Object*>( entry.uAppData );
+			if ( !object->isEnabled() )
+				continue;
+			mTimeStamp = entry.dwTimeStamp;
 			object->updateFrom( entry );
 		}
 	}
+
+	// The current time in the time base of the timestamps of the entries
+	DWORD currentTime = mBackend->getTickCount();
+	mTimeStamp = currentTime;
+	if ( mIsResyncNeeded )
+		resync( currentTime );
+	processAxisFilters( currentTime );
+	processButtonDebouncers( currentTime );
+
+	notifyBatchListeners();
+	notifyThrottledListeners( currentTime );
+	mListenerRegistry.endDispatch();
 }
 
 bool Device::initialize()
 {
-	IDirectInput8* directInput = getDirectInput();
 	const DeviceInstance& deviceIndentifier = getDeviceInstance();
 	
-	DIPROPDWORD dipdw;
-	dipdw.diph.dwSize       = sizeof(DIPROPDWORD);
-	dipdw.diph.dwHeaderSize = sizeof(DIPROPHEADER);
-	dipdw.diph.dwObj        = 0;
-	dipdw.diph.dwHow        = DIPH_DEVICE;
-	dipdw.dwData            = mDataBufferSize;
-
-	HRESULT hr = 0;
-	GUID deviceGuid = deviceIndentifier.getGuidInstance();
-	hr = directInput->CreateDevice( deviceGuid, &mInputDevice, NULL );
-	assert( SUCCEEDED(hr) );
-
-	hr = mInputDevice->SetDataFormat( &c_dfDIJoystick2 );
-	assert( SUCCEEDED(hr) );		// Note: if we want to return false, we need to delete the device
+	mDeviceBackend = mBackend->createDeviceBackend( deviceIndentifier );
+	assert( mDeviceBackend );		// Note: if we want to return false, we need to delete the device
 
 /*	HWND hWnd = HWND( getWindowHandle() );
 	hr = mInputDevice->SetCooperativeLevel(hWnd, getCoopSettings());
 	assert( SUCCEEDED(hr) );		// Note: same here
 */
-	hr = mInputDevice->SetProperty( DIPROP_BUFFERSIZE, &dipdw.diph );
-	assert( SUCCEEDED(hr) );		// Note: same here
+	mHasContiguousSequences = mDeviceBackend->hasContiguousSequences();
 
-	return true;
+	bool ret = mDeviceBackend->setBufferSize( mDataBufferSize );
+	assert( ret );		// Note: same here
+	return ret;
 }
 
 bool Device::enumerateObjects()
@@ -123,10 +426,24 @@ bool Device::enumerateObjects()
 
 	// Enumerate the ObjectInstances making up this device
 	ObjectInstances objectInstances;
-	HRESULT hr = 0;
-	// See http://msdn.microsoft.com/en-us/library/windows/desktop/microsoft.directx_sdk.idirectinputdevice8.idirectinputdevice8.enumobjects(v=vs.85).aspx
-	hr = mInputDevice->EnumObjects(enumObjectsCallback, &objectInstances, DIDFT_ALL);
-	assert( SUCCEEDED(hr) );
+	bool ret = mDeviceBackend->enumerateObjects( objectInstances );
+	assert( ret );
+	if ( !ret )
+		return false;
+
+	// Make the state of the device hold exactly its objects, rather than the
+	// fixed layout of DIJOYSTATE2. The offsets of the objects change with the 
+	// format, so they're enumerated again
+	DataFormat dataFormat = DataFormat::createMinimal( objectInstances );
+	if ( mDeviceBackend->setDataFormat( dataFormat ) )
+	{
+		mDataFormat = dataFormat;
+		objectInstances.clear();
+		ret = mDeviceBackend->enumerateObjects( objectInstances );
+		assert( ret );
+		if ( !ret )
+			return false;
+	}
 	
 	// Create Object using this ObjectInstances and add them to this Device
 	for ( std::size_t i=0; i<objectInstances.size(); ++i )
@@ -140,6 +457,7 @@ bool Device::enumerateObjects()
 			if ( object->setUserData( reinterpret_cast<UINT_PTR>(object) ) )
 			{
 				// Add the Object to our list
+				object->mIndex = static_cast<unsigned int>( mObjects.size() );
 				mObjects.push_back( object );
 			}
 			else
@@ -156,19 +474,13 @@ bool Device::enumerateObjects()
 	return true;
 }
 
-BOOL CALLBACK Device::enumObjectsCallback( LPCDIDEVICEOBJECTINSTANCE lpddoi, LPVOID pvRef )
-{
-	ObjectInstances* objectInstances = static_cast<ObjectInstances*>( pvRef );
-	assert(objectInstances);
-	ObjectInstance identifier( lpddoi );
-	objectInstances->push_back( identifier );
-	return DIENUM_CONTINUE;
-}
-
 void Device::addObject( Object* object )
 {
 	assert(object);
+	object->mIndex = static_cast<unsigned int>( mObjects.size() );
 	mObjects.push_back(object);
+	mResyncObjects.clear();
+	mListenerRegistry.modify( [this]( ListenerSnapshot& snapshot ) { updateDispatchLists( snapshot ); return true; } );
 }
 
 void Device::deleteObjects()
@@ -178,42 +490,100 @@ void Device::deleteObjects()
 	mObjects.clear();
 }
 
-bool Device::getDeviceData( IDirectInputDevice8* device, LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )
+// Work out which listeners are interested in each Object. The lists are 
+// stored one after the other in a single array, in the order the listeners
+// were added
+void Device::updateDispatchLists( ListenerSnapshot& snapshot ) const
+{
+	snapshot.dispatchListeners.clear();
+	snapshot.dispatchOffsets.resize( mObjects.size() + 1 );
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		snapshot.dispatchOffsets[i] = static_cast<unsigned int>( snapshot.dispatchListeners.size() );
+		for ( std::size_t j=0; j<snapshot.listeners.size(); ++j )
+		{
+			if ( snapshot.filters[j].accepts( mObjects[i] ) )
+				snapshot.dispatchListeners.push_back( snapshot.listeners[j] );
+		}
+	}
+	snapshot.dispatchOffsets[mObjects.size()] = static_cast<unsigned int>( snapshot.dispatchListeners.size() );
+}
+
+bool Device::getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )
 {
 	// This method can detect unplugged devices with the HRESULT code DIERR_UNPLUGGED.
 	// In foreground cooperative mode, this is only detectable if the window has the focus.
 
 	// This method is heavily inspired from OIS code
+	DeviceBackend* device = mDeviceBackend;
+	const DWORD bufferSize = *numDataEntries;
 	bool result = false;
 	HRESULT hr;
-	hr = device->GetDeviceData( sizeof(DIDEVICEOBJECTDATA), dataEntries, numDataEntries, 0 );
+	if ( mReacquireBackoff.isBackingOff() && mReacquireBackoff.getSettings().minDelayInMs>0 )
+	{
+		// The device isn't acquired since the last attempt failed. Wait for the
+		// next attempt, then go straight to the acquisition
+		if ( !mReacquireBackoff.isAttemptDue( mBackend->getTickCount() ) )
+		{
+			++mReacquireBackoff.mNumSkippedPolls;
+			*numDataEntries = 0;
+			return false;
+		}
+		hr = DIERR_NOTACQUIRED;
+	}
+	else
+	{
+		hr = device->getDeviceData( dataEntries, numDataEntries );
+	}
 
 	//std::string str = "After GetDeviceData " + HRESULTToString( hr ) + "\n";
 	//OutputDebugString( str.c_str() );
 	if ( hr==DIERR_NOTACQUIRED || hr==DIERR_INPUTLOST )
 	{
-		hr = device->Acquire();
+		hr = device->acquire();
 		//str = "After Acquire " + HRESULTToString( hr ) + "\n";
 		//OutputDebugString( str.c_str() );
-		if ( hr==DI_OK || hr==S_FALSE )
+		bool isAcquired = ( hr==DI_OK || hr==S_FALSE );
+		mReacquireBackoff.onAttempt( isAcquired, mBackend->getTickCount() );
+		if ( isAcquired )
 		{
-			// Device got acquired (S_FALSE simply means it was already acquired) 
-			hr = device->GetDeviceData( sizeof(DIDEVICEOBJECTDATA), dataEntries, numDataEntries, 0 );
+			// The events that occurred while the device wasn't acquired are lost. 
+			// The sequence numbers start over
+			if ( mHasBeenAcquired )
+				mIsResyncNeeded = true;
+			mHasBeenAcquired = true;
+			mHasSequence = false;
+
+			// Device got acquired (S_FALSE simply means it was already acquired).
+			// The failed call emptied the count, the whole buffer is available again
+			*numDataEntries = bufferSize;
+			hr = device->getDeviceData( dataEntries, numDataEntries );
 
 			//str = "After second GetDeviceData " + HRESULTToString( hr ) + "\n";
 			//OutputDebugString( str.c_str() );
-			result = ( hr==DI_OK );
+			if ( hr==DI_BUFFEROVERFLOW )
+			{
+				// The buffer filled up since the acquisition. Like below, the
+				// events are returned and the objects resynchronised
+				++mNumOverflows;
+				mIsResyncNeeded = true;
+			}
+			result = ( hr==DI_OK || hr==DI_BUFFEROVERFLOW );
 		}
 		else
 		{
-			// Failed to acquire, better luck next update
+			// Failed to acquire, better luck at the next attempt
+			*numDataEntries = 0;
 			result = false;
 		}
 	}
 	else if ( hr==DI_BUFFEROVERFLOW )
 	{
 		// The call to GetDeviceData() returned a full buffer, so we return it.
-		// We certainly have lost some events but there's nothing we can do
+		// Some events were lost, the objects are resynchronised with the state
+		// of the device once the buffer is processed
+		++mNumOverflows;
+		mIsResyncNeeded = true;
 		result = true;
 	}
 	else if ( hr==DI_OK )
@@ -237,33 +607,434 @@ bool Device::getDeviceData( IDirectInputDevice8* device, LPDIDEVICEOBJECTDATA da
 }
 
 // Called by contained Objects to notify that they've changed
-void Device::notifyObjectChanged( Object* object )
+void Device::notifyObjectChanged( Object* object, DWORD oldData )
 {
-	// Notify
-	for ( Listeners::iterator itr=mListeners.begin(); itr!=mListeners.end(); ++itr )
-		(*itr)->onObjectChanged( this, object );
+	unsigned int index = object->getIndex();
+	const ObjectInstance& objectInstance = object->getObjectInstance();
+	mCurrentChange.objectIndex = index;
+	mCurrentChange.type = objectInstance.isAxis() ? ObjectChange::AxisChange : (objectInstance.isButton() ? ObjectChange::ButtonChange : ObjectChange::POVChange);
+	mCurrentChange.oldData = oldData;
+	mCurrentChange.newData = object->getData();
+	mCurrentChange.timeStamp = mTimeStamp;
+	mCurrentChange.isResync = mIsResyncing;
+	++mNumUpdateChanges;
+
+	const ListenerSnapshot& listeners = mListenerRegistry.get();
+	for ( std::size_t i=0; i<listeners.dirtyObjectSets.size(); ++i )
+		listeners.dirtyObjectSets[i]->markDirty( index );
+
+	// Notify the listeners interested in this Object
+	assert( index+1<listeners.dispatchOffsets.size() );
+	for ( unsigned int i=listeners.dispatchOffsets[index]; i<listeners.dispatchOffsets[index+1]; ++i )
+		listeners.dispatchListeners[i]->onObjectChanged( this, object );
+
+	// Keep the change for the batch listeners
+	if ( !listeners.batchListeners.empty() )
+		mChanges.push_back( mCurrentChange );
+}
+
+void Device::notifyBatchListeners()
+{
+	if ( mChanges.empty() )
+		return;
+
+	// The vector keeps its capacity, so the following updates don't allocate
+	const BatchListeners& batchListeners = mListenerRegistry.get().batchListeners;
+	for ( BatchListeners::const_iterator itr=batchListeners.begin(); itr!=batchListeners.end(); ++itr )
+		(*itr)->onObjectsChanged( this, &mChanges[0], mChanges.size() );
+	mChanges.clear();
+}
+
+void Device::notifyThrottledListeners( DWORD currentTime )
+{
+	const ListenerSnapshot& listeners = mListenerRegistry.get();
+	for ( std::size_t i=0; i<listeners.throttledListeners.size(); ++i )
+		listeners.throttledListeners[i]->notify( this, currentTime );
+	for ( std::size_t i=0; i<listeners.throttledBatchListeners.size(); ++i )
+		listeners.throttledBatchListeners[i]->notify( this, currentTime );
+}
+
+void Device::setAxisFilter( Axis* axis, const AxisFilter& filter )
+{
+	assert( axis );
+	assert( axis->getParentDevice()==this );
+
+	// Remove the previous filter if any
+	if ( axis->mFilterId!=AxisFilterBank::invalidId )
+	{
+		mAxisFilterBank.removeAxis( axis->mFilterId );
+		axis->mFilterId = AxisFilterBank::invalidId;
+		std::vector<Axis*>::iterator itr = std::find( mFilteredAxes.begin(), mFilteredAxes.end(), axis );
+		assert( itr!=mFilteredAxes.end() );
+		mFilteredAxes.erase( itr );
+	}
+
+	if ( filter.type==AxisFilter::None )
+		return;
+	
+	axis->mFilterId = mAxisFilterBank.addAxis( filter, axis->getMinValue(), axis->getMaxValue(), axis->getValue() );
+	mFilteredAxes.push_back( axis );
+}
+
+AxisFilter Device::getAxisFilter( const Axis* axis ) const
+{
+	assert( axis );
+	if ( axis->mFilterId==AxisFilterBank::invalidId )
+		return AxisFilter();
+	return mAxisFilterBank.getFilter( axis->mFilterId );
+}
+
+void Device::setAxisChangeThreshold( LONG threshold )
+{
+	assert( threshold>=0 );
+	mAxisChangeThreshold = threshold;
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i]->getObjectInstance().isAxis() )
+			static_cast<Axis*>( mObjects[i] )->setChangeThreshold( threshold );
+	}
+}
+
+// Called by a filtered Axis when an entry concerning it is found in the buffer
+void Device::pushAxisFilterSample( Axis* axis, const DIDEVICEOBJECTDATA& entry )
+{
+	assert( axis->mFilterId!=AxisFilterBank::invalidId );
+	mAxisFilterBank.pushSample( axis->mFilterId, static_cast<LONG>(entry.dwData), entry.dwTimeStamp );
+}
+
+// Run the filters of all the filtered axes in one go, then update the axes 
+// (and notify the listeners) with the filtered values
+void Device::processAxisFilters( DWORD currentTime )
+{
+	if ( mFilteredAxes.empty() )
+		return;
+
+	// The filters of the disabled axes keep converging, but their output is 
+	// ignored until they are enabled again
+	mAxisFilterBank.process( currentTime );
+	for ( std::size_t i=0; i<mFilteredAxes.size(); ++i )
+	{
+		Axis* axis = mFilteredAxes[i];
+		if ( axis->isEnabled() )
+			axis->setValue( mAxisFilterBank.getValue( axis->mFilterId ) );
+	}
+}
+
+void Device::setButtonDebounce( Button* button, DWORD windowInMs, ButtonDebouncer::Mode mode )
+{
+	assert( button );
+	assert( button->getParentDevice()==this );
+
+	button->mDebouncer = ButtonDebouncer( button->isPressed() );
+	button->mDebouncer.setWindow( windowInMs, mode );
+	
+	std::vector<Button*>::iterator itr = std::find( mDebouncedButtons.begin(), mDebouncedButtons.end(), button );
+	if ( windowInMs>0 && itr==mDebouncedButtons.end() )
+		mDebouncedButtons.push_back( button );
+	else if ( windowInMs==0 && itr!=mDebouncedButtons.end() )
+		mDebouncedButtons.erase( itr );
+}
+
+void Device::setButtonDebounce( DWORD windowInMs, ButtonDebouncer::Mode mode )
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i]->getObjectInstance().isButton() )
+			setButtonDebounce( static_cast<Button*>( mObjects[i] ), windowInMs, mode );
+	}
+}
+
+// Accept the button states that have become stable since the last update
+void Device::processButtonDebouncers( DWORD currentTime )
+{
+	for ( std::size_t i=0; i<mDebouncedButtons.size(); ++i )
+	{
+		if ( mDebouncedButtons[i]->isEnabled() )
+			mDebouncedButtons[i]->updateDebouncer( currentTime );
+	}
+}
+
+void Device::resync( DWORD currentTime )
+{
+	mIsResyncNeeded = false;
+	if ( mResyncObjects.empty() )
+	{
+		mObjectTypes.clear();
+		for ( std::size_t i=0; i<mObjects.size(); ++i )
+		{
+			if ( !mObjects[i]->isEnabled() )
+				continue;
+			mResyncObjects.push_back( mObjects[i] );
+			mObjectTypes.push_back( mObjects[i]->getObjectInstance().getDwType() );
+		}
+		mObjectStates.resize( mObjectTypes.size() );
+	}
+	if ( mResyncObjects.empty() )
+		return;
+
+	HRESULT hr = mDeviceBackend->getObjectStates( &mObjectTypes[0], &mObjectStates[0], mObjectTypes.size() );
+	if ( FAILED(hr) )
+	{
+		++mNumFailedResyncs;
+		return;
+	}
+	++mNumResyncs;
+
+	// Each state goes through the objects like an event would (filters, debouncers, 
+	// etc...), so only the objects whose state differs get changed
+	mIsResyncing = true;
+	DIDEVICEOBJECTDATA entry;
+	memset( &entry, 0, sizeof(entry) );
+	entry.dwTimeStamp = currentTime;
+	for ( std::size_t i=0; i<mResyncObjects.size(); ++i )
+	{
+		Object* object = mResyncObjects[i];
+		entry.dwOfs = object->getObjectInstance().getDwOfs();
+		entry.dwData = mObjectStates[i];
+		entry.uAppData = reinterpret_cast<UINT_PTR>( object );
+		object->updateFrom( entry );
+	}
+	mIsResyncing = false;
+}
+
+bool Device::setObjectEnabled( Object* object, bool isEnabled )
+{
+	assert( object && object->getParentDevice()==this );
+	if ( object->mIsEnabled==isEnabled )
+		return true;
+
+	// The 0xFFFFFFFF user data makes update() skip the events of the object.
+	// If the backend refuses it, update() skips them as the object is disabled
+	UINT_PTR userData = isEnabled ? reinterpret_cast<UINT_PTR>(object) : 0xFFFFFFFF;
+	if ( !object->setUserData( userData ) && isEnabled && mDataFormat.isEmpty() )
+		return false;
+
+	// A pending state of a debounced button is dropped, the resync gets the 
+	// current one when the button is enabled again
+	if ( !isEnabled && object->getObjectInstance().isButton() )
+	{
+		Button* button = static_cast<Button*>( object );
+		const ButtonDebouncer& debouncer = button->getDebouncer();
+		if ( debouncer.isPending() )
+			setButtonDebounce( button, debouncer.getWindow(), debouncer.getMode() );
+	}
+
+	object->mIsEnabled = isEnabled;
+	mResyncObjects.clear();
+	if ( !mDataFormat.isEmpty() )
+		mIsDataFormatDirty = true;
+	if ( isEnabled )
+		requestResync();
+	return true;
+}
+
+void Device::setEnabledObjects( const ObjectFilter& filter )
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+		setObjectEnabled( mObjects[i], filter.accepts( mObjects[i] ) );
+}
+
+unsigned int Device::getNumEnabledObjects() const
+{
+	unsigned int numEnabledObjects = 0;
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i]->isEnabled() )
+			++numEnabledObjects;
+	}
+	return numEnabledObjects;
+}
+
+// Leave the disabled objects out of the data format, so the device doesn't 
+// even buffer their events. The format can only be set while the device isn't
+// acquired, it gets reacquired by getDeviceData(). When every object is 
+// disabled, the format is kept and their events are skipped
+void Device::updateDataFormat()
+{
+	mIsDataFormatDirty = false;
+
+	ObjectInstances objectInstances;
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i]->isEnabled() )
+			objectInstances.push_back( mObjects[i]->getObjectInstance() );
+	}
+	if ( objectInstances.empty() )
+		return;
+	DataFormat dataFormat = DataFormat::createMinimal( objectInstances );
+
+	mDeviceBackend->unacquire();
+	if ( !mDeviceBackend->setDataFormat( dataFormat ) )
+		return;
+	mDataFormat = dataFormat;
+	mHasSequence = false;
+
+	// The user data of the objects that are back in the format
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i]->isEnabled() )
+			mObjects[i]->setUserData( reinterpret_cast<UINT_PTR>(mObjects[i]) );
+	}
 }
 
 void Device::addListener( Listener* listener )
+{
+	addListener( listener, ObjectFilter() );
+}
+
+void Device::addListener( Listener* listener, const ObjectFilter& filter )
 {
 	assert(listener);
-	mListeners.push_back(listener);
+	mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			snapshot.listeners.push_back(listener);
+			snapshot.filters.push_back(filter);
+			updateDispatchLists( snapshot );
+			return true;
+		} );
+}
+
+void Device::addListener( Listener* listener, const ObjectFilter& filter, DWORD minIntervalInMs )
+{
+	assert(listener);
+	if ( minIntervalInMs==0 )
+	{
+		addListener( listener, filter );
+		return;
+	}
+	std::shared_ptr<ThrottledListener> throttledListener( new ThrottledListener( listener, minIntervalInMs ) );
+	mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			snapshot.throttledListeners.push_back(throttledListener);
+			snapshot.listeners.push_back(throttledListener.get());
+			snapshot.filters.push_back(filter);
+			updateDispatchLists( snapshot );
+			return true;
+		} );
 }
 
 bool Device::removeListener( Listener* listener )
 {
-	Listeners::iterator itr = std::find( mListeners.begin(), mListeners.end(), listener );
-	if ( itr==mListeners.end() )
-		return false;
-	mListeners.erase( itr );
-	return true;
+	bool ret = mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			// A throttled Listener is registered via its ThrottledListener. The 
+			// ThrottledListener is deleted along with the last snapshot using it
+			Listener* registeredListener = listener;
+			for ( std::size_t i=0; i<snapshot.throttledListeners.size(); ++i )
+			{
+				if ( snapshot.throttledListeners[i]->mListener==listener )
+				{
+					registeredListener = snapshot.throttledListeners[i].get();
+					snapshot.throttledListeners.erase( snapshot.throttledListeners.begin() + i );
+					break;
+				}
+			}
+
+			Listeners::iterator itr = std::find( snapshot.listeners.begin(), snapshot.listeners.end(), registeredListener );
+			if ( itr==snapshot.listeners.end() )
+				return false;
+			snapshot.filters.erase( snapshot.filters.begin() + (itr - snapshot.listeners.begin()) );
+			snapshot.listeners.erase( itr );
+			updateDispatchLists( snapshot );
+			return true;
+		} );
+
+	// Once it returns, the removed listener is no longer in use by an update()
+	// in progress on another thread (see ListenerRegistry)
+	mListenerRegistry.synchronize();
+	return ret;
 }
 
 void Device::removeListeners()
 {
-	Listeners listeners = mListeners; // The copy is on purpose here
-	for ( Listeners::iterator itr=listeners.begin(); itr!=listeners.end(); ++itr )
-		removeListener( *itr );
+	mListenerRegistry.modify( [this]( ListenerSnapshot& snapshot ) 
+		{
+			// The BatchListeners and the DirtyObjectSets have their own remove methods
+			snapshot.listeners.clear();
+			snapshot.filters.clear();
+			snapshot.throttledListeners.clear();
+			updateDispatchLists( snapshot );
+			return true;
+		} );
+	mListenerRegistry.synchronize();
+}
+
+void Device::addBatchListener( BatchListener* listener )
+{
+	assert(listener);
+	mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			snapshot.batchListeners.push_back(listener);
+			return true;
+		} );
+}
+
+void Device::addBatchListener( BatchListener* listener, DWORD minIntervalInMs )
+{
+	assert(listener);
+	if ( minIntervalInMs==0 )
+	{
+		addBatchListener( listener );
+		return;
+	}
+	std::shared_ptr<ThrottledBatchListener> throttledListener( new ThrottledBatchListener( listener, minIntervalInMs ) );
+	mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			snapshot.throttledBatchListeners.push_back(throttledListener);
+			snapshot.batchListeners.push_back(throttledListener.get());
+			return true;
+		} );
+}
+
+bool Device::removeBatchListener( BatchListener* listener )
+{
+	bool ret = mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			// Like for the throttled listeners (see removeListener())
+			BatchListener* registeredListener = listener;
+			for ( std::size_t i=0; i<snapshot.throttledBatchListeners.size(); ++i )
+			{
+				if ( snapshot.throttledBatchListeners[i]->mListener==listener )
+				{
+					registeredListener = snapshot.throttledBatchListeners[i].get();
+					snapshot.throttledBatchListeners.erase( snapshot.throttledBatchListeners.begin() + i );
+					break;
+				}
+			}
+
+			BatchListeners::iterator itr = std::find( snapshot.batchListeners.begin(), snapshot.batchListeners.end(), registeredListener );
+			if ( itr==snapshot.batchListeners.end() )
+				return false;
+			snapshot.batchListeners.erase( itr );
+			return true;
+		} );
+	mListenerRegistry.synchronize();
+	return ret;
+}
+
+void Device::addDirtyObjectSet( DirtyObjectSet* dirtyObjectSet )
+{
+	assert(dirtyObjectSet);
+	assert(dirtyObjectSet->getNumObjects()==mObjects.size());
+	mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			snapshot.dirtyObjectSets.push_back(dirtyObjectSet);
+			return true;
+		} );
+}
+
+bool Device::removeDirtyObjectSet( DirtyObjectSet* dirtyObjectSet )
+{
+	bool ret = mListenerRegistry.modify( [&]( ListenerSnapshot& snapshot ) 
+		{
+			std::vector<DirtyObjectSet*>::iterator itr = std::find( snapshot.dirtyObjectSets.begin(), snapshot.dirtyObjectSets.end(), dirtyObjectSet );
+			if ( itr==snapshot.dirtyObjectSets.end() )
+				return false;
+			snapshot.dirtyObjectSets.erase( itr );
+			return true;
+		} );
+	mListenerRegistry.synchronize();
+	return ret;
 }
 
 }
@@ -27,16 +27,176 @@
 #include <algorithm>
 #include "RDITime.h"
 #include "RDICommon.h"
+#include "RDIBackend.h"
+
+#ifdef _WIN32
+#include <string.h>
+#include <dbt.h>
+#endif
+
+#ifdef __linux__
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 /*
 	Notes:
-	- Maybe an the "invisible" window code of the WindowsHookEnumerationTrigger could be moved into a InvisibleWindowEnumerationTrigger class. 
-	  It would create the invisible window and handle the WM_DEVICECHANGE message in its WndProc normally (without a hook). 
-	  This would be cleaner
+	- The WindowsThreadEnumerationTrigger handles WM_DEVICECHANGE in the WndProc of its own window (without a hook). 
+	  The WindowsHookEnumerationTrigger is kept for the applications that rely on it
 */
 namespace RDI
 {
 
+/*
+	DeviceChangeHint
+*/
+DeviceChangeHint::DeviceChangeHint()
+	: type(Arrival)
+{
+}
+
+DeviceChangeHint::DeviceChangeHint( Type hintType, const std::string& path )
+	: type(hintType),
+	  devicePath(path)
+{
+}
+
+/*
+	EnumerationSignal
+*/
+EnumerationSignal::EnumerationSignal()
+	: mIsRaised(false),
+	  mNumRaised(0),
+	  mAreHintsComplete(true),
+	  mAreConsumedHintsComplete(true),
+	  mNumConsumed(0)
+{
+}
+
+void EnumerationSignal::raise()
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	mAreHintsComplete = false;
+	mNumRaised.fetch_add( 1, std::memory_order_relaxed );
+	mIsRaised.store( true, std::memory_order_release );
+}
+
+void EnumerationSignal::raise( const DeviceChangeHint& hint )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	mHints.push_back( hint );
+	mNumRaised.fetch_add( 1, std::memory_order_relaxed );
+	mIsRaised.store( true, std::memory_order_release );
+}
+
+bool EnumerationSignal::consume()
+{
+	// The common case: nothing happened
+	if ( !mIsRaised.load( std::memory_order_acquire ) )
+		return false;
+
+	// The hints are taken along with the signal, so the ones raised in the 
+	// meantime are left for the next call. Swapping the vectors keeps their memory
+	std::lock_guard<std::mutex> lock( mMutex );
+	mIsRaised.store( false, std::memory_order_relaxed );
+	mConsumedHints.clear();
+	mConsumedHints.swap( mHints );
+	mAreConsumedHintsComplete = mAreHintsComplete;
+	mAreHintsComplete = true;
+	++mNumConsumed;
+	return true;
+}
+
+bool EnumerationSignal::getChangeHints( DeviceChangeHints& hints )
+{
+	hints.insert( hints.end(), mConsumedHints.begin(), mConsumedHints.end() );
+	mConsumedHints.clear();
+	return mAreConsumedHintsComplete;
+}
+
+/*
+	ThreadedEnumerationTrigger
+*/
+ThreadedEnumerationTrigger::ThreadedEnumerationTrigger()
+	: mHasStarted(false),
+	  mIsRunning(false)
+{
+	// The devices connected at startup get enumerated
+	mSignal.raise();
+}
+
+ThreadedEnumerationTrigger::~ThreadedEnumerationTrigger()
+{
+	// The subclass must have stopped the thread, as run() is one of its methods
+	assert( !mThread.joinable() );
+}
+
+bool ThreadedEnumerationTrigger::enumerationNeeded()
+{
+	return mSignal.consume();
+}
+
+bool ThreadedEnumerationTrigger::getChangeHints( DeviceChangeHints& hints )
+{
+	return mSignal.getChangeHints( hints );
+}
+
+void ThreadedEnumerationTrigger::start()
+{
+	assert( !mThread.joinable() );
+	mHasStarted = false;
+	mIsRunning.store( true, std::memory_order_release );
+	mThread = std::thread( &ThreadedEnumerationTrigger::threadMain, this );
+
+	std::unique_lock<std::mutex> lock( mStartMutex );
+	while ( !mHasStarted )
+		mStartCondition.wait( lock );
+}
+
+void ThreadedEnumerationTrigger::stop()
+{
+	if ( !mThread.joinable() )
+		return;
+	requestStop();
+	mThread.join();
+}
+
+void ThreadedEnumerationTrigger::notifyStarted()
+{
+	std::lock_guard<std::mutex> lock( mStartMutex );
+	mHasStarted = true;
+	mStartCondition.notify_all();
+}
+
+void ThreadedEnumerationTrigger::threadMain()
+{
+	run();
+
+	// In case run() failed before being ready
+	mIsRunning.store( false, std::memory_order_release );
+	notifyStarted();
+}
+
+#ifdef _WIN32
+// Returns true if the WM_DEVICECHANGE message is about the arrival/removal of a 
+// device interface (see RegisterDeviceNotification()), whose path it carries
+static bool getDeviceChangeHint( WPARAM wParam, LPARAM lParam, DeviceChangeHint& hint )
+{
+	if ( (wParam!=DBT_DEVICEARRIVAL && wParam!=DBT_DEVICEREMOVECOMPLETE) || lParam==0 )
+		return false;
+
+	const DEV_BROADCAST_HDR* header = reinterpret_cast<const DEV_BROADCAST_HDR*>( lParam );
+	if ( header->dbch_devicetype!=DBT_DEVTYP_DEVICEINTERFACE )
+		return false;
+
+	const DEV_BROADCAST_DEVICEINTERFACE* deviceInterface = reinterpret_cast<const DEV_BROADCAST_DEVICEINTERFACE*>( header );
+	hint.type = wParam==DBT_DEVICEARRIVAL ? DeviceChangeHint::Arrival : DeviceChangeHint::Removal;
+	hint.devicePath = Common::TCHARToUTF8( deviceInterface->dbcc_name );
+	return true;
+}
+
 /*
 	WindowsHookEnumerationTrigger
 */
@@ -47,12 +207,20 @@ const TCHAR* WindowsHookEnumerationTrigger::invisibleWindowClassName = _T("Windo
 WindowsHookEnumerationTrigger::WindowsHookEnumerationTrigger( bool doCreateInvisibleWindow )
 	:	mCreateInvisibleWindow( doCreateInvisibleWindow ),
 		mInvisibleWindow(NULL),
+		mDeviceNotification(NULL),
 		mEnumerationNeeded(false)		
 {
 	if ( mCreateInvisibleWindow )
 	{
 		bool ret = createInvisibleWindow();
 		assert( ret );
+
+		// Ask for the notifications of all the device interfaces, which come with their path
+		DEV_BROADCAST_DEVICEINTERFACE filter;
+		memset( &filter, 0, sizeof(filter) );
+		filter.dbcc_size = sizeof(filter);
+		filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+		mDeviceNotification = RegisterDeviceNotification( mInvisibleWindow, &filter, DEVICE_NOTIFY_WINDOW_HANDLE | DEVICE_NOTIFY_ALL_INTERFACE_CLASSES );
 	}
 
 	// We initialize mEnumerationNeeded to true so a first enumeration is triggered immediately 
@@ -86,6 +254,12 @@ WindowsHookEnumerationTrigger::~WindowsHookEnumerationTrigger()
 		mHookHandle = 0;
 	}
 
+	if ( mDeviceNotification )
+	{
+		UnregisterDeviceNotification( mDeviceNotification );
+		mDeviceNotification = NULL;
+	}
+
 	if ( mCreateInvisibleWindow )
 	{
 		/*BOOL ret =*/ DestroyWindow( mInvisibleWindow );
@@ -116,6 +290,14 @@ bool WindowsHookEnumerationTrigger::enumerationNeeded()
 	return ret;
 }
 
+bool WindowsHookEnumerationTrigger::getChangeHints( DeviceChangeHints& hints )
+{
+	bool ret = !mChangeHints.empty();
+	hints.insert( hints.end(), mChangeHints.begin(), mChangeHints.end() );
+	mChangeHints.clear();
+	return ret;
+}
+
 LRESULT CALLBACK WindowsHookEnumerationTrigger::invisibleWindowWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
 	// We could check for WM_DEVICECHANGE here, but we use a hook for that
@@ -180,8 +362,17 @@ LRESULT CALLBACK WindowsHookEnumerationTrigger::wndProcHook( int nCode, WPARAM w
 		const CWPSTRUCT& params = *reinterpret_cast<CWPSTRUCT*>(lParam);
 		if ( params.message==WM_DEVICECHANGE )
 		{
+			// The arrival and removal of a device interface come with its path
+			DeviceChangeHint hint;
+			bool hasHint = getDeviceChangeHint( params.wParam, params.lParam, hint );
+
 			for ( std::size_t i=0; i<WindowsHookEnumerationTrigger::mTriggerInstances.size(); ++i )
-				WindowsHookEnumerationTrigger::mTriggerInstances[i]->mEnumerationNeeded = true;
+			{
+				WindowsHookEnumerationTrigger* trigger = WindowsHookEnumerationTrigger::mTriggerInstances[i];
+				trigger->mEnumerationNeeded = true;
+				if ( hasHint )
+					trigger->mChangeHints.push_back( hint );
+			}
 		}
 	}
 
@@ -189,6 +380,107 @@ LRESULT CALLBACK WindowsHookEnumerationTrigger::wndProcHook( int nCode, WPARAM w
 	return CallNextHookEx( NULL, nCode, wParam, lParam );
 }
 
+/*
+	WindowsThreadEnumerationTrigger
+*/
+const TCHAR* WindowsThreadEnumerationTrigger::windowClassName = _T("RDIWindowsThreadEnumerationTrigger");
+
+WindowsThreadEnumerationTrigger::WindowsThreadEnumerationTrigger()
+	: mWindow(NULL)
+{
+	// If the window can't be created, isRunning() returns false (see DeviceManager)
+	start();
+}
+
+WindowsThreadEnumerationTrigger::~WindowsThreadEnumerationTrigger()
+{
+	stop();
+}
+
+void WindowsThreadEnumerationTrigger::run()
+{
+	HINSTANCE hInstance = GetModuleHandle(NULL);
+	WNDCLASSEX wc;
+	memset( &wc, 0, sizeof(wc) );
+	wc.cbSize = sizeof(WNDCLASSEX);
+	if ( GetClassInfoEx( hInstance, windowClassName, &wc )==0 )
+	{
+		memset( &wc, 0, sizeof(wc) );
+		wc.cbSize        = sizeof(WNDCLASSEX);
+		wc.lpfnWndProc   = windowProc;
+		wc.hInstance     = hInstance;
+		wc.lpszClassName = windowClassName;
+		if ( !RegisterClassEx(&wc) )
+			return;
+	}
+
+	// A message-only window doesn't receive the broadcast messages, but does 
+	// receive the notifications it registers for
+	HWND hwnd = CreateWindowEx( 0, windowClassName, _T(""), 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, hInstance, NULL );
+	if ( hwnd==NULL )
+		return;
+	SetWindowLongPtr( hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this) );
+
+	DEV_BROADCAST_DEVICEINTERFACE filter;
+	memset( &filter, 0, sizeof(filter) );
+	filter.dbcc_size = sizeof(filter);
+	filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+	HDEVNOTIFY deviceNotification = RegisterDeviceNotification( hwnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE | DEVICE_NOTIFY_ALL_INTERFACE_CLASSES );
+	if ( deviceNotification==NULL )
+	{
+		DestroyWindow( hwnd );
+		return;
+	}
+
+	mWindow.store( hwnd );
+	notifyStarted();
+
+	// Until the window is destroyed (see requestStop())
+	MSG msg;
+	while ( GetMessage( &msg, NULL, 0, 0 )>0 )
+	{
+		TranslateMessage( &msg );
+		DispatchMessage( &msg );
+	}
+
+	UnregisterDeviceNotification( deviceNotification );
+	mWindow.store( NULL );
+}
+
+void WindowsThreadEnumerationTrigger::requestStop()
+{
+	// The window is destroyed on its thread, which ends the message loop
+	HWND hwnd = mWindow.load();
+	if ( hwnd )
+		PostMessage( hwnd, WM_CLOSE, 0, 0 );
+}
+
+LRESULT CALLBACK WindowsThreadEnumerationTrigger::windowProc( HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam )
+{
+	if ( msg==WM_DEVICECHANGE )
+	{
+		WindowsThreadEnumerationTrigger* trigger = reinterpret_cast<WindowsThreadEnumerationTrigger*>( GetWindowLongPtr( hwnd, GWLP_USERDATA ) );
+		if ( trigger && (wParam==DBT_DEVICEARRIVAL || wParam==DBT_DEVICEREMOVECOMPLETE) )
+		{
+			DeviceChangeHint hint;
+			if ( getDeviceChangeHint( wParam, lParam, hint ) )
+				trigger->getSignal().raise( hint );
+			else
+				trigger->getSignal().raise();
+		}
+		return TRUE;
+	}
+
+	if ( msg==WM_DESTROY )
+	{
+		PostQuitMessage( 0 );
+		return 0;
+	}
+	return DefWindowProc( hwnd, msg, wParam, lParam );
+}
+
+#endif
+
 /*
 	TimeBasedEnumerationTrigger
 */
@@ -237,5 +529,200 @@ int TimeBasedEnumerationTrigger::updateNextTime()
 	return numIntervalsDone;
 }
 
+/*
+	BackendEnumerationTrigger
+*/
+BackendEnumerationTrigger::BackendEnumerationTrigger( Backend* backend )
+	: mBackend(backend),
+	  mEnumerationNeeded(true)
+{
+	assert( mBackend );
+}
+
+bool BackendEnumerationTrigger::enumerationNeeded()
+{
+	bool deviceListChanged = mBackend->hasDeviceListChanged();
+	bool ret = mEnumerationNeeded || deviceListChanged;
+	mEnumerationNeeded = false;
+	return ret;
+}
+
+/*
+	DebouncedEnumerationTrigger
+*/
+DebouncedEnumerationTrigger::Settings::Settings()
+	: settleWindowInMs(250),
+	  maxDelayInMs(2000),
+	  minIntervalInMs(1000),
+	  safetyIntervalInMs(30000)
+{
+}
+
+DebouncedEnumerationTrigger::DebouncedEnumerationTrigger( DeviceEnumerationTrigger* source, const Settings& settings, Clock* clock )
+	: mSource(source),
+	  mSettings(settings),
+	  mClock(clock),
+	  mHasEnumerated(false),
+	  mIsStartupFromSource(false),
+	  mIsPending(false),
+	  mFirstTriggerTime(0),
+	  mLastTriggerTime(0),
+	  mLastEnumerationTime(0),
+	  mNumSourceTriggers(0),
+	  mNumEnumerations(0),
+	  mNumSafetyEnumerations(0),
+	  mArePendingHintsComplete(true),
+	  mAreHintsComplete(false)
+{
+	assert( mSource );
+	if ( !mClock )
+		mClock = &mSystemClock;
 }
 
+DebouncedEnumerationTrigger::~DebouncedEnumerationTrigger()
+{
+	delete mSource;
+	mSource = NULL;
+}
+
+bool DebouncedEnumerationTrigger::enumerationNeeded()
+{
+	// The source is always polled, so it keeps its own state up to date
+	unsigned int currentTime = mClock->getTimeAsMilliseconds();
+	if ( mSource->enumerationNeeded() )
+	{
+		++mNumSourceTriggers;
+		if ( !mSource->getChangeHints( mPendingHints ) )
+			mArePendingHintsComplete = false;
+		if ( !mIsPending )
+		{
+			mIsPending = true;
+			mFirstTriggerTime = currentTime;
+		}
+		mLastTriggerTime = currentTime;
+	}
+
+	bool enumerate = false;
+	bool isFromSource = false;
+	if ( !mHasEnumerated )
+	{
+		enumerate = true;
+		mIsStartupFromSource = mIsPending;
+	}
+	else if ( mIsPending )
+	{
+		bool isSettled = currentTime - mLastTriggerTime >= mSettings.settleWindowInMs;
+		bool isOverdue = currentTime - mFirstTriggerTime >= mSettings.maxDelayInMs;
+		bool isRateLimited = currentTime - mLastEnumerationTime < mSettings.minIntervalInMs;
+		enumerate = (isSettled || isOverdue) && !isRateLimited;
+		isFromSource = true;
+	}
+	else if ( mSettings.safetyIntervalInMs!=0 && currentTime - mLastEnumerationTime >= mSettings.safetyIntervalInMs )
+	{
+		enumerate = true;
+		++mNumSafetyEnumerations;
+	}
+
+	if ( enumerate )
+	{
+		mHasEnumerated = true;
+		mIsPending = false;
+		mLastEnumerationTime = currentTime;
+		++mNumEnumerations;
+
+		// Swapping the vectors keeps their memory
+		mHints.clear();
+		mHints.swap( mPendingHints );
+		mAreHintsComplete = isFromSource && mArePendingHintsComplete;
+		mArePendingHintsComplete = true;
+	}
+	return enumerate;
+}
+
+bool DebouncedEnumerationTrigger::getChangeHints( DeviceChangeHints& hints )
+{
+	hints.insert( hints.end(), mHints.begin(), mHints.end() );
+	mHints.clear();
+	return mAreHintsComplete;
+}
+
+unsigned int DebouncedEnumerationTrigger::getNumAvoidedEnumerations() const
+{
+	// The startup enumeration is caused by the source only if it fired then
+	unsigned int numStartupEnumerations = mHasEnumerated && !mIsStartupFromSource ? 1 : 0;
+	unsigned int numSourceEnumerations = mNumEnumerations - mNumSafetyEnumerations - numStartupEnumerations;
+	return mNumSourceTriggers>numSourceEnumerations ? mNumSourceTriggers - numSourceEnumerations : 0;
+}
+
+#ifdef __linux__
+/*
+	InotifyEnumerationTrigger
+*/
+InotifyEnumerationTrigger::InotifyEnumerationTrigger( const std::string& directory, const std::string& fileNamePrefix )
+	: mDirectory(directory),
+	  mFileNamePrefix(fileNamePrefix),
+	  mFileDescriptor(-1),
+	  mWatchDescriptor(-1),
+	  mEnumerationNeeded(true),
+	  mNumEvents(0)
+{
+	mFileDescriptor = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if ( mFileDescriptor<0 )
+		return;
+	mWatchDescriptor = inotify_add_watch( mFileDescriptor, mDirectory.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR );
+}
+
+InotifyEnumerationTrigger::~InotifyEnumerationTrigger()
+{
+	if ( mFileDescriptor>=0 )
+		close( mFileDescriptor );		// Removes the watch too
+	mFileDescriptor = -1;
+	mWatchDescriptor = -1;
+}
+
+bool InotifyEnumerationTrigger::enumerationNeeded()
+{
+	bool ret = mEnumerationNeeded;
+	mEnumerationNeeded = false;
+	if ( !isWatching() )
+		return ret;
+
+	// Consume all the pending events. The buffer is aligned like inotify_event
+	// as the events are read directly from it
+	union
+	{
+		inotify_event	event;
+		char			bytes[16 * 1024];
+	} buffer;
+	for ( ;; )
+	{
+		ssize_t size = read( mFileDescriptor, buffer.bytes, sizeof(buffer.bytes) );
+		if ( size<0 && errno==EINTR )
+			continue;
+		if ( size<=0 )
+			break;		// EAGAIN: no more event
+
+		for ( ssize_t offset=0; offset<size; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>( buffer.bytes + offset );
+			offset += sizeof(inotify_event) + event->len;
+
+			// The queue overflowed: events were lost, so enumerate to be safe
+			if ( event->mask & IN_Q_OVERFLOW )
+			{
+				ret = true;
+				continue;
+			}
+			if ( (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))==0 )
+				continue;
+			if ( !mFileNamePrefix.empty() && (event->len==0 || strncmp( event->name, mFileNamePrefix.c_str(), mFileNamePrefix.size() )!=0) )
+				continue;
+			++mNumEvents;
+			ret = true;
+		}
+	}
+	return ret;
+}
+#endif
+
+}
@@ -23,7 +23,7 @@
 */
 #include "RDIDeviceInstance.h"
 
-#include <tchar.h>
+#include <assert.h>
 #include "RDICommon.h"
 
 namespace RDI
@@ -95,4 +95,52 @@ std::string	DeviceInstance::getProductName() const
 	return mProductName;
 }
 
-}
\ No newline at end of file
+/*
+	DeviceListFingerprint
+*/
+DeviceListFingerprint::DeviceListFingerprint()
+	: numDevices(0),
+	  hash(0)
+{
+}
+
+DeviceListFingerprint DeviceListFingerprint::compute( const DeviceIdentifiers& deviceInstances )
+{
+	DeviceListFingerprint fingerprint;
+	for ( std::size_t i=0; i<deviceInstances.size(); ++i )
+		fingerprint.add( deviceInstances[i] );
+	return fingerprint;
+}
+
+void DeviceListFingerprint::add( const DeviceInstance& deviceInstance )
+{
+	++numDevices;
+	hash += hashDevice( deviceInstance );
+}
+
+void DeviceListFingerprint::remove( const DeviceInstance& deviceInstance )
+{
+	assert( numDevices>0 );
+	--numDevices;
+	hash -= hashDevice( deviceInstance );
+}
+
+unsigned long long int DeviceListFingerprint::hashDevice( const DeviceInstance& deviceInstance )
+{
+	// FNV-1a of the GUID, finalized so close GUIDs give unrelated hashes. The hashes
+	// of the devices are summed, so the order of the devices doesn't matter
+	const GUID& guid = deviceInstance.getGuidInstance();
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>( &guid );
+	unsigned long long int deviceHash = 14695981039346656037ULL;
+	for ( std::size_t i=0; i<sizeof(GUID); ++i )
+	{
+		deviceHash ^= bytes[i];
+		deviceHash *= 1099511628211ULL;
+	}
+	deviceHash ^= deviceHash >> 33;
+	deviceHash *= 0xff51afd7ed558ccdULL;
+	deviceHash ^= deviceHash >> 33;
+	return deviceHash;
+}
+
+}
@@ -24,10 +24,14 @@
 #include "RDIDeviceManager.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <algorithm>
 #include "RDITime.h"
 #include "RDICommon.h"
 #include "RDIDeviceEnumerationTrigger.h"
+#ifdef _WIN32
+#include "RDIDirectInputBackend.h"
+#endif
 
 /*
 	Notes:
@@ -37,37 +41,84 @@
 namespace RDI
 {
 
-IDirectInput8* DeviceManager::mDirectInput = NULL;
-
+#ifdef _WIN32
 DeviceManager::DeviceManager( bool ignoreXInputControllers, bool consoleApplication /*, HWND windowHandle*/ )
-	:	mIgnoreXInputControllers(ignoreXInputControllers),
+	:	mBackend(NULL),
+		mOwnsBackend(true),
 		mEnumerationTrigger(NULL),
 		//mWindowHandle(windowHandle),
-		mDevices()
+		mDevices(),
+		mNumEnumerations(0),
+		mNumUnchangedEnumerations(0),
+		mNumTargetedUpdates(0)
 {
-	createDirectInput();
-	mEnumerationTrigger = new WindowsHookEnumerationTrigger( consoleApplication );
+	mBackend = new DirectInputBackend( ignoreXInputControllers );
+	WindowsThreadEnumerationTrigger* threadTrigger = new WindowsThreadEnumerationTrigger();
+	if ( threadTrigger->isRunning() )
+	{
+		mEnumerationTrigger = threadTrigger;
+	}
+	else
+	{
+		// Without its window, the trigger would only fire at startup and the 
+		// devices plugged in later would go unnoticed
+		delete threadTrigger;
+		mEnumerationTrigger = new WindowsHookEnumerationTrigger( consoleApplication );
+	}
 	//mEnumerationTrigger = new TimeBasedEnumerationTrigger(3000);
 }
+#endif
+
+DeviceManager::DeviceManager( Backend* backend, DeviceEnumerationTrigger* enumerationTrigger )
+	:	mBackend(backend),
+		mOwnsBackend(false),
+		mEnumerationTrigger(enumerationTrigger),
+		mDevices(),
+		mNumEnumerations(0),
+		mNumUnchangedEnumerations(0),
+		mNumTargetedUpdates(0)
+{
+	assert( mBackend );
+	assert( mEnumerationTrigger );
+}
 
 DeviceManager::~DeviceManager()
 {
+	// The devices are deleted before the backend they come from
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+		delete mDevices[i].second;
+	mDevices.clear();
+	mDevicePaths.clear();
+
 	delete mEnumerationTrigger;
 	mEnumerationTrigger = NULL;
-	deleteDirectInput();
+	if ( mOwnsBackend )
+		delete mBackend;
+	mBackend = NULL;
 }
 
 void DeviceManager::update()
 {
-	// Update the list of connected Device (if needed)
+	// No listener snapshot is in use here, so the replaced ones can be deleted
+	mListeners.reclaim();
+
+	// Update the list of connected Device (if needed). When the trigger knows 
+	// what changed, only the devices concerned are added/removed
 	if ( mEnumerationTrigger->enumerationNeeded() )
-		updateDeviceList();
+	{
+		mChangeHints.clear();
+		if ( !mEnumerationTrigger->getChangeHints( mChangeHints ) || !applyChangeHints( mChangeHints ) )
+			updateDeviceList();
+	}
 
-	// Update the devices
-	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	// Update the devices that are due, as long as the time budget allows
+	const std::vector<unsigned int>& polledDevices = mPollScheduler.schedule();
+	for ( std::size_t i=0; i<polledDevices.size() && mPollScheduler.hasBudgetLeft(); ++i )
 	{
-		Device* device = mDevices[i].second;
+		unsigned int deviceIndex = polledDevices[i];
+		Device* device = mDevices[deviceIndex].second;
 		device->update();
+		mPollScheduler.onPolled( deviceIndex, device->getNumUpdateEvents()>0 || device->getNumUpdateChanges()>0 );
 		
 /*		Device* dev = static_cast<Device*>(device);
 		printf("name:%s\n", dev->getDeviceInstance().getInstanceName() );//, dev->getDeviceInstance().getInstanceId()
@@ -81,20 +132,28 @@ void DeviceManager::update()
 
 void DeviceManager::updateDeviceList()
 {
+	mListeners.reclaim();
+
+	// Get an up to date list of device identifiers. The vector keeps its 
+	// capacity, so this doesn't allocate once it has grown
+	++mNumEnumerations;
+	mEnumeratedDevices.clear();
+	mBackend->enumerateDevices( mEnumeratedDevices );
+
+	// Most of the time nothing has changed, which the fingerprint tells cheaply
+	DeviceListFingerprint fingerprint = DeviceListFingerprint::compute( mEnumeratedDevices );
+	if ( fingerprint==mFingerprint )
+	{
+		++mNumUnchangedEnumerations;
+		return;
+	}
+
 	// Get the previous list of device identifiers
 	DeviceIdentifiers previousDeviceIdentifiers;
 	deviceListToDeviceIdentifiers( mDevices, previousDeviceIdentifiers );
 
-	// Get an up to date version
-	DeviceIdentifiers currentDeviceIdentifiers;
-	std::pair<DeviceIdentifiers*, bool> enumDevicesCallbackUserData = std::make_pair( &currentDeviceIdentifiers, true );
-
-	HRESULT hr = 0;
-	// With a DI8DEVCLASS_ALL enumeration, the mouse and keyboard are ALWAYS returned as attached devices even if you unplug them from your computer
-	hr = mDirectInput->EnumDevices( DI8DEVCLASS_GAMECTRL /*DI8DEVCLASS_ALL*/, enumDevicesCallback, &enumDevicesCallbackUserData, DIEDFL_ATTACHEDONLY ); 
-	assert( SUCCEEDED(hr) );
-	
 	// Work out the differences between the two
+	const DeviceIdentifiers& currentDeviceIdentifiers = mEnumeratedDevices;
 	DeviceIdentifiers addedDeviceIdentifiers;
 	calculateAddedDevicesList( previousDeviceIdentifiers, currentDeviceIdentifiers, addedDeviceIdentifiers );
 	
@@ -116,35 +175,93 @@ void DeviceManager::updateDeviceList()
 	}
 }	
 
+bool DeviceManager::applyChangeHints( const DeviceChangeHints& hints )
+{
+	mListeners.reclaim();
+
+	for ( std::size_t i=0; i<hints.size(); ++i )
+	{
+		const DeviceChangeHint& hint = hints[i];
+		if ( hint.type==DeviceChangeHint::Removal )
+		{
+			int index = findDeviceByPath( hint.devicePath );
+			if ( index>=0 )
+			{
+				DeviceInstance identifier = mDevices[index].first;
+				removeDevice( identifier );
+			}
+			else
+			{
+				// Not one of our devices (the notifications also come for other 
+				// kinds of devices), unless the path of one of them is unknown
+				if ( std::find( mDevicePaths.begin(), mDevicePaths.end(), std::string() )!=mDevicePaths.end() )
+					return false;
+			}
+		}
+		else
+		{
+			// Several notifications can come for the same device
+			if ( findDeviceByPath( hint.devicePath )>=0 )
+				continue;
+
+			DeviceInstance identifier;
+			if ( !mBackend->findDevice( hint.devicePath, identifier ) )
+				return false;
+			
+			bool isKnown = false;
+			for ( std::size_t j=0; j<mDevices.size() && !isKnown; ++j )
+				isKnown = mDevices[j].first==identifier;
+			if ( !isKnown )
+				addDevice( identifier );
+		}
+	}
+
+	++mNumTargetedUpdates;
+	return true;
+}
+
 void DeviceManager::addDevice( const DeviceInstance& identifier )
 {
 	// Create the device
-	Device* device = new Device( /*mWindowHandle,*/ mDirectInput, identifier/*, DISCL_FOREGROUND | DISCL_NONEXCLUSIVE*/ );
+	Device* device = new Device( /*mWindowHandle,*/ mBackend, identifier/*, DISCL_FOREGROUND | DISCL_NONEXCLUSIVE*/ );
 	
 	// Add it to the list
+	std::string devicePath;
+	mBackend->getDevicePath( identifier, devicePath );
 	mDevices.push_back( std::make_pair( identifier, device ) );		
+	mDevicePaths.push_back( devicePath );
+	mFingerprint.add( identifier );
+	mPollScheduler.addDevice();
 
 	// Notify
-	for ( Listeners::iterator itr=mListeners.begin(); itr!=mListeners.end(); ++itr )
+	mListeners.beginDispatch();
+	const Listeners& listeners = mListeners.get();
+	for ( Listeners::const_iterator itr=listeners.begin(); itr!=listeners.end(); ++itr )
 		(*itr)->onDeviceConnected( this, device );
+	mListeners.endDispatch();
 }
 
 void DeviceManager::removeDevice( const DeviceInstance& identifier )
 {
-	DeviceList::iterator itr;
 	Device* device = NULL;
-	for ( itr=mDevices.begin(); itr!=mDevices.end(); ++itr )
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
 	{
-		if ( identifier==(*itr).first )
+		if ( identifier==mDevices[i].first )
 		{
-			device = (*itr).second;
+			device = mDevices[i].second;
 	
 			// Notify
-			for ( Listeners::iterator itr2=mListeners.begin(); itr2!=mListeners.end(); ++itr2 )
-				(*itr2)->onDeviceDisconnecting( this, device );
+			mListeners.beginDispatch();
+			const Listeners& listeners = mListeners.get();
+			for ( Listeners::const_iterator itr=listeners.begin(); itr!=listeners.end(); ++itr )
+				(*itr)->onDeviceDisconnecting( this, device );
+			mListeners.endDispatch();
 
 			// Remove the device from the list
-			mDevices.erase(itr);
+			mDevices.erase( mDevices.begin()+i );
+			mDevicePaths.erase( mDevicePaths.begin()+i );
+			mFingerprint.remove( identifier );
+			mPollScheduler.removeDevice( i );
 			break;
 		}
 	}
@@ -153,59 +270,25 @@ void DeviceManager::removeDevice( const DeviceInstance& identifier )
 	delete device;
 }
 
-void DeviceManager::createDirectInput()
-{
-	if ( !mDirectInput )
-	{
-		HINSTANCE hInst = GetModuleHandle(0);
-		HRESULT hr;
-		hr = DirectInput8Create( hInst, DIRECTINPUT_VERSION, IID_IDirectInput8, (VOID**)&mDirectInput, NULL );
-		assert( SUCCEEDED(hr) );	
-	}
-	else 
-	{
-		mDirectInput->AddRef();
-	}
-}
-
-void DeviceManager::deleteDirectInput()
+int DeviceManager::findDeviceByPath( const std::string& devicePath ) const
 {
-	if( mDirectInput )
-	{
-		if ( mDirectInput->Release()==0 )
-			mDirectInput = NULL;
-	}
-}
-
-BOOL CALLBACK DeviceManager::enumDevicesCallback( LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef )
-{
-	assert( pvRef );
-	std::pair<DeviceIdentifiers*, bool>* userData = static_cast<std::pair<DeviceIdentifiers*, bool>*>( pvRef );
-	
-	DeviceIdentifiers* deviceIdentifers = userData->first;
-	assert( deviceIdentifers );
-	
-	bool ignoreXInputController = userData->second;
+	if ( devicePath.empty() )
+		return -1;
 
-	if ( ignoreXInputController )
+	// The device paths aren't case sensitive
+	for ( std::size_t i=0; i<mDevicePaths.size(); ++i )
 	{
-		if ( Common::isXInputController( &lpddi->guidProduct ) )
-			return DIENUM_CONTINUE;
-	}
+		const std::string& path = mDevicePaths[i];
+		if ( path.size()!=devicePath.size() )
+			continue;
 
-	DeviceInstance identifier( lpddi );
-	DWORD deviceType = identifier.getDeviceType();
-	if( deviceType == DI8DEVTYPE_JOYSTICK ||
-		deviceType == DI8DEVTYPE_GAMEPAD ||
-		deviceType == DI8DEVTYPE_1STPERSON ||
-		deviceType == DI8DEVTYPE_DRIVING ||
-		deviceType == DI8DEVTYPE_FLIGHT )			 
-	//	deviceType == DI8DEVTYPE_MOUSE ||
-	//	deviceType == DI8DEVTYPE_KEYBOARD )
-	{
-		deviceIdentifers->push_back( identifier );
+		std::size_t j = 0;
+		while ( j<path.size() && tolower( static_cast<unsigned char>(path[j]) )==tolower( static_cast<unsigned char>(devicePath[j]) ) )
+			++j;
+		if ( j==path.size() )
+			return static_cast<int>(i);
 	}
-	return DIENUM_CONTINUE;
+	return -1;
 }
 
 void DeviceManager::deviceListToDeviceIdentifiers( const DeviceList& list, DeviceIdentifiers& identifiers )
@@ -240,23 +323,35 @@ void DeviceManager::calculateRemovedDevicesList( const DeviceIdentifiers& previo
 void DeviceManager::addListener( Listener* listener )
 {
 	assert(listener);
-	mListeners.push_back(listener);
+	mListeners.modify( [listener]( Listeners& listeners ) 
+		{
+			listeners.push_back(listener);
+			return true;
+		} );
 }
 
 bool DeviceManager::removeListener( Listener* listener )
 {
-	Listeners::iterator itr = std::find( mListeners.begin(), mListeners.end(), listener );
-	if ( itr==mListeners.end() )
-		return false;
-	mListeners.erase( itr );
-	return true;
+	bool ret = mListeners.modify( [listener]( Listeners& listeners ) 
+		{
+			Listeners::iterator itr = std::find( listeners.begin(), listeners.end(), listener );
+			if ( itr==listeners.end() )
+				return false;
+			listeners.erase( itr );
+			return true;
+		} );
+	mListeners.synchronize();
+	return ret;
 }
 
 void DeviceManager::removeListeners()
 {
-	Listeners listeners = mListeners; // The copy is on purpose here
-	for ( Listeners::iterator itr=listeners.begin(); itr!=listeners.end(); ++itr )
-		removeListener( *itr );
+	mListeners.modify( []( Listeners& listeners ) 
+		{
+			listeners.clear();
+			return true;
+		} );
+	mListeners.synchronize();
 }
 
 Device* DeviceManager::getDeviceByName( const std::string& name ) const
@@ -0,0 +1,314 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIDirectInputBackend.h"
+
+#include <assert.h>
+#include "RDICommon.h"
+
+namespace RDI
+{
+
+/*
+	DirectInputDeviceBackend
+*/
+DirectInputDeviceBackend::DirectInputDeviceBackend( IDirectInputDevice8* inputDevice )
+	: mInputDevice(inputDevice),
+	  mDataSize(DataFormat::joystick2DataSize)
+{
+	assert( mInputDevice );
+}
+
+DirectInputDeviceBackend::~DirectInputDeviceBackend()
+{
+	assert( mInputDevice );
+	mInputDevice->Unacquire();
+	mInputDevice->Release();
+	mInputDevice = NULL;
+}
+
+bool DirectInputDeviceBackend::setBufferSize( DWORD numEntries )
+{
+	DIPROPDWORD dipdw;
+	dipdw.diph.dwSize       = sizeof(DIPROPDWORD);
+	dipdw.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	dipdw.diph.dwObj        = 0;
+	dipdw.diph.dwHow        = DIPH_DEVICE;
+	dipdw.dwData            = numEntries;
+	HRESULT hr = mInputDevice->SetProperty( DIPROP_BUFFERSIZE, &dipdw.diph );
+	return SUCCEEDED(hr);
+}
+
+bool DirectInputDeviceBackend::enumerateObjects( ObjectInstances& objectInstances )
+{
+	// See http://msdn.microsoft.com/en-us/library/windows/desktop/microsoft.directx_sdk.idirectinputdevice8.idirectinputdevice8.enumobjects(v=vs.85).aspx
+	HRESULT hr = mInputDevice->EnumObjects(enumObjectsCallback, &objectInstances, DIDFT_ALL);
+	return SUCCEEDED(hr);
+}
+
+BOOL CALLBACK DirectInputDeviceBackend::enumObjectsCallback( LPCDIDEVICEOBJECTINSTANCE lpddoi, LPVOID pvRef )
+{
+	ObjectInstances* objectInstances = static_cast<ObjectInstances*>( pvRef );
+	assert(objectInstances);
+	ObjectInstance identifier( lpddoi );
+	objectInstances->push_back( identifier );
+	return DIENUM_CONTINUE;
+}
+
+bool DirectInputDeviceBackend::getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue )
+{
+	DIPROPRANGE range;
+    range.diph.dwSize = sizeof(DIPROPRANGE);
+    range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+    range.diph.dwHow = DIPH_BYID;
+    range.diph.dwObj = objectType;
+	HRESULT hr = mInputDevice->GetProperty(DIPROP_RANGE, &range.diph);
+	if ( FAILED(hr) )
+		return false;
+	minValue = range.lMin;
+	maxValue = range.lMax;
+	return true;
+}
+
+bool DirectInputDeviceBackend::setObjectUserData( DWORD objectType, UINT_PTR userData )
+{
+	DIPROPPOINTER diptr;
+	diptr.diph.dwSize       = sizeof(DIPROPPOINTER);
+	diptr.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	diptr.diph.dwHow        = DIPH_BYID;
+	diptr.diph.dwObj        = objectType;
+	diptr.uData             = userData;
+	HRESULT hr = mInputDevice->SetProperty( DIPROP_APPDATA, &diptr.diph );
+	return SUCCEEDED(hr);
+}
+
+HRESULT DirectInputDeviceBackend::acquire()
+{
+	return mInputDevice->Acquire();
+}
+
+void DirectInputDeviceBackend::unacquire()
+{
+	mInputDevice->Unacquire();
+}
+
+HRESULT DirectInputDeviceBackend::getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )
+{
+	return mInputDevice->GetDeviceData( sizeof(DIDEVICEOBJECTDATA), dataEntries, numDataEntries, 0 );
+}
+
+bool DirectInputDeviceBackend::setDataFormat( const DataFormat& dataFormat )
+{
+	const DataFormat::ObjectFormats& objects = dataFormat.getObjects();
+	if ( objects.empty() )
+		return false;
+
+	std::vector<DIOBJECTDATAFORMAT> objectDataFormats( objects.size() );
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		DIOBJECTDATAFORMAT& objectDataFormat = objectDataFormats[i];
+		objectDataFormat.pguid = NULL;
+		objectDataFormat.dwOfs = objects[i].offset;
+		objectDataFormat.dwType = objects[i].objectType;
+		objectDataFormat.dwFlags = 0;
+	}
+
+	DIDATAFORMAT format;
+	format.dwSize = sizeof(DIDATAFORMAT);
+	format.dwObjSize = sizeof(DIOBJECTDATAFORMAT);
+	format.dwFlags = DIDF_ABSAXIS;
+	format.dwDataSize = dataFormat.getDataSize();
+	format.dwNumObjs = static_cast<DWORD>( objectDataFormats.size() );
+	format.rgodf = &objectDataFormats[0];
+	HRESULT hr = mInputDevice->SetDataFormat( &format );
+	if ( FAILED(hr) )
+		return false;
+
+	mObjectDataFormats.swap( objectDataFormats );
+	mDataSize = dataFormat.getDataSize();
+	mRequestedObjects.clear();
+	return true;
+}
+
+HRESULT DirectInputDeviceBackend::getObjectStates( const DWORD* objectTypes, DWORD* states, std::size_t numObjects )
+{
+	mState.resize( mDataSize );
+	HRESULT hr = mInputDevice->GetDeviceState( mDataSize, &mState[0] );
+	if ( FAILED(hr) )
+		return hr;
+
+	bool isCached = mRequestedObjects.size()==numObjects;
+	for ( std::size_t i=0; i<numObjects && isCached; ++i )
+		isCached = mRequestedObjects[i].objectType==objectTypes[i];
+	if ( !isCached )
+	{
+		mRequestedObjects.clear();
+		for ( std::size_t i=0; i<numObjects; ++i )
+		{
+			DIDEVICEOBJECTINSTANCE objectInstance;
+			objectInstance.dwSize = sizeof(DIDEVICEOBJECTINSTANCE);
+			hr = mInputDevice->GetObjectInfo( &objectInstance, objectTypes[i], DIPH_BYID );
+			if ( FAILED(hr) || objectInstance.dwOfs + DataFormat::getStateSize( objectTypes[i] )>mDataSize )
+			{
+				mRequestedObjects.clear();
+				return FAILED(hr) ? hr : DIERR_INVALIDPARAM;
+			}
+			DataFormat::ObjectFormat object;
+			object.objectType = objectTypes[i];
+			object.offset = objectInstance.dwOfs;
+			mRequestedObjects.push_back( object );
+		}
+	}
+
+	for ( std::size_t i=0; i<numObjects; ++i )
+		states[i] = DataFormat::readState( &mState[0], mRequestedObjects[i] );
+	return DI_OK;
+}
+
+/*
+	DirectInputBackend
+*/
+IDirectInput8* DirectInputBackend::mDirectInput = NULL;
+
+DirectInputBackend::DirectInputBackend( bool ignoreXInputControllers )
+	: mIgnoreXInputControllers(ignoreXInputControllers)
+{
+	createDirectInput();
+}
+
+DirectInputBackend::~DirectInputBackend()
+{
+	deleteDirectInput();
+}
+
+void DirectInputBackend::enumerateDevices( DeviceIdentifiers& deviceInstances )
+{
+	std::pair<DeviceIdentifiers*, bool> enumDevicesCallbackUserData = std::make_pair( &deviceInstances, mIgnoreXInputControllers );
+
+	HRESULT hr = 0;
+	// With a DI8DEVCLASS_ALL enumeration, the mouse and keyboard are ALWAYS returned as attached devices even if you unplug them from your computer
+	hr = mDirectInput->EnumDevices( DI8DEVCLASS_GAMECTRL /*DI8DEVCLASS_ALL*/, enumDevicesCallback, &enumDevicesCallbackUserData, DIEDFL_ATTACHEDONLY ); 
+	assert( SUCCEEDED(hr) );
+}
+
+DeviceBackend* DirectInputBackend::createDeviceBackend( const DeviceInstance& deviceInstance )
+{
+	IDirectInputDevice8* inputDevice = NULL;
+	GUID deviceGuid = deviceInstance.getGuidInstance();
+	HRESULT hr = mDirectInput->CreateDevice( deviceGuid, &inputDevice, NULL );
+	if ( FAILED(hr) )
+		return NULL;
+
+	hr = inputDevice->SetDataFormat( &c_dfDIJoystick2 );
+	if ( FAILED(hr) )
+	{
+		inputDevice->Release();
+		return NULL;
+	}
+	return new DirectInputDeviceBackend( inputDevice );
+}
+
+DWORD DirectInputBackend::getTickCount()
+{
+	// The DirectInput timestamps are based on the system tick count
+	return GetTickCount();
+}
+
+bool DirectInputBackend::getDevicePath( const DeviceInstance& deviceInstance, std::string& devicePath )
+{
+	IDirectInputDevice8* inputDevice = NULL;
+	GUID deviceGuid = deviceInstance.getGuidInstance();
+	HRESULT hr = mDirectInput->CreateDevice( deviceGuid, &inputDevice, NULL );
+	if ( FAILED(hr) )
+		return false;
+
+	DIPROPGUIDANDPATH guidAndPath;
+	guidAndPath.diph.dwSize = sizeof(DIPROPGUIDANDPATH);
+	guidAndPath.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	guidAndPath.diph.dwObj = 0;
+	guidAndPath.diph.dwHow = DIPH_DEVICE;
+	hr = inputDevice->GetProperty( DIPROP_GUIDANDPATH, &guidAndPath.diph );
+	inputDevice->Release();
+	if ( FAILED(hr) )
+		return false;
+
+	devicePath = Common::UTF16toUTF8String( guidAndPath.wszPath );
+	return true;
+}
+
+void DirectInputBackend::createDirectInput()
+{
+	if ( !mDirectInput )
+	{
+		HINSTANCE hInst = GetModuleHandle(0);
+		HRESULT hr;
+		hr = DirectInput8Create( hInst, DIRECTINPUT_VERSION, IID_IDirectInput8, (VOID**)&mDirectInput, NULL );
+		assert( SUCCEEDED(hr) );	
+	}
+	else 
+	{
+		mDirectInput->AddRef();
+	}
+}
+
+void DirectInputBackend::deleteDirectInput()
+{
+	if( mDirectInput )
+	{
+		if ( mDirectInput->Release()==0 )
+			mDirectInput = NULL;
+	}
+}
+
+BOOL CALLBACK DirectInputBackend::enumDevicesCallback( LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef )
+{
+	assert( pvRef );
+	std::pair<DeviceIdentifiers*, bool>* userData = static_cast<std::pair<DeviceIdentifiers*, bool>*>( pvRef );
+	
+	DeviceIdentifiers* deviceIdentifers = userData->first;
+	assert( deviceIdentifers );
+	
+	bool ignoreXInputController = userData->second;
+
+	if ( ignoreXInputController )
+	{
+		if ( Common::isXInputController( &lpddi->guidProduct ) )
+			return DIENUM_CONTINUE;
+	}
+
+	DeviceInstance identifier( lpddi );
+	DWORD deviceType = identifier.getDeviceType();
+	if( deviceType == DI8DEVTYPE_JOYSTICK ||
+		deviceType == DI8DEVTYPE_GAMEPAD ||
+		deviceType == DI8DEVTYPE_1STPERSON ||
+		deviceType == DI8DEVTYPE_DRIVING ||
+		deviceType == DI8DEVTYPE_FLIGHT )			 
+	//	deviceType == DI8DEVTYPE_MOUSE ||
+	//	deviceType == DI8DEVTYPE_KEYBOARD )
+	{
+		deviceIdentifers->push_back( identifier );
+	}
+	return DIENUM_CONTINUE;
+}
+
+}
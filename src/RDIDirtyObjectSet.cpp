@@ -0,0 +1,195 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIDirtyObjectSet.h"
+
+#include <assert.h>
+#include <stddef.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace RDI
+{
+
+namespace
+{
+
+const unsigned int numBitsPerWord = 64;
+
+// The index of the lowest set bit of a non-zero word. The 64-bit intrinsics 
+// of Visual Studio only exist on x64, on x86 the word is split in two halves
+inline unsigned int countTrailingZeros( unsigned long long int word )
+{
+	assert( word!=0 );
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index = 0;
+	_BitScanForward64( &index, word );
+	return static_cast<unsigned int>( index );
+#elif defined(_MSC_VER) && defined(_M_IX86)
+	unsigned long index = 0;
+	unsigned long lowWord = static_cast<unsigned long>( word );
+	if ( _BitScanForward( &index, lowWord ) )
+		return static_cast<unsigned int>( index );
+	_BitScanForward( &index, static_cast<unsigned long>( word >> 32 ) );
+	return static_cast<unsigned int>( index ) + 32;
+#elif defined(_MSC_VER)
+	unsigned int index = 0;
+	while ( (word & 1)==0 )
+	{
+		word >>= 1;
+		++index;
+	}
+	return index;
+#else
+	return static_cast<unsigned int>( __builtin_ctzll( word ) );
+#endif
+}
+
+inline unsigned int countBits( unsigned long long int word )
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return static_cast<unsigned int>( __popcnt64( word ) );
+#elif defined(_MSC_VER) && defined(_M_IX86)
+	return __popcnt( static_cast<unsigned int>( word ) ) + __popcnt( static_cast<unsigned int>( word >> 32 ) );
+#elif defined(_MSC_VER)
+	unsigned int numBits = 0;
+	for ( ; word!=0; word &= word - 1 )
+		++numBits;
+	return numBits;
+#else
+	return static_cast<unsigned int>( __builtin_popcountll( word ) );
+#endif
+}
+
+}
+
+/*
+	DirtyObjects
+*/
+const unsigned int DirtyObjects::npos;
+
+DirtyObjects::DirtyObjects()
+{
+}
+
+bool DirtyObjects::isEmpty() const
+{
+	for ( std::size_t i=0; i<mWords.size(); ++i )
+	{
+		if ( mWords[i]!=0 )
+			return false;
+	}
+	return true;
+}
+
+unsigned int DirtyObjects::getCount() const
+{
+	unsigned int count = 0;
+	for ( std::size_t i=0; i<mWords.size(); ++i )
+		count += countBits( mWords[i] );
+	return count;
+}
+
+bool DirtyObjects::contains( unsigned int objectIndex ) const
+{
+	std::size_t wordIndex = objectIndex / numBitsPerWord;
+	if ( wordIndex>=mWords.size() )
+		return false;
+	return ( mWords[wordIndex] & (1ULL << (objectIndex % numBitsPerWord)) )!=0;
+}
+
+unsigned int DirtyObjects::findFirst() const
+{
+	if ( mWords.empty() )
+		return npos;
+	return findFrom( 0, mWords[0] );
+}
+
+unsigned int DirtyObjects::findNext( unsigned int objectIndex ) const
+{
+	unsigned int nextIndex = objectIndex + 1;
+	std::size_t wordIndex = nextIndex / numBitsPerWord;
+	if ( wordIndex>=mWords.size() )
+		return npos;
+	unsigned int bitIndex = nextIndex % numBitsPerWord;
+	return findFrom( wordIndex, mWords[wordIndex] & (~0ULL << bitIndex) );
+}
+
+// The first set bit of word (the word at wordIndex, possibly with its first bits 
+// cleared) or of the words after it
+unsigned int DirtyObjects::findFrom( std::size_t wordIndex, unsigned long long int word ) const
+{
+	for ( ;; )
+	{
+		if ( word!=0 )
+			return static_cast<unsigned int>( wordIndex * numBitsPerWord + countTrailingZeros( word ) );
+		if ( ++wordIndex>=mWords.size() )
+			return npos;
+		word = mWords[wordIndex];
+	}
+}
+
+/*
+	DirtyObjectSet
+*/
+DirtyObjectSet::DirtyObjectSet( std::size_t numObjects )
+	: mNumObjects(numObjects),
+	  mNumWords( (numObjects + numBitsPerWord - 1) / numBitsPerWord ),
+	  mWords(NULL)
+{
+	mWords = new std::atomic<unsigned long long int>[mNumWords];
+	for ( std::size_t i=0; i<mNumWords; ++i )
+		mWords[i].store( 0, std::memory_order_relaxed );
+}
+
+DirtyObjectSet::~DirtyObjectSet()
+{
+	delete[] mWords;
+	mWords = NULL;
+}
+
+void DirtyObjectSet::markDirty( unsigned int objectIndex )
+{
+	assert( objectIndex<mNumObjects );
+	std::atomic<unsigned long long int>& word = mWords[objectIndex / numBitsPerWord];
+	unsigned long long int bit = 1ULL << (objectIndex % numBitsPerWord);
+
+	// An object usually changes many times between two fetches, so the bit is
+	// tested first to avoid a read-modify-write when it's already set
+	if ( (word.load( std::memory_order_relaxed ) & bit)==0 )
+		word.fetch_or( bit, std::memory_order_release );
+}
+
+void DirtyObjectSet::fetchAndClear( DirtyObjects& dirtyObjects )
+{
+	dirtyObjects.mWords.resize( mNumWords );
+	for ( std::size_t i=0; i<mNumWords; ++i )
+	{
+		// Cheap test first, the exchange only for the words with marks
+		unsigned long long int word = mWords[i].load( std::memory_order_relaxed );
+		dirtyObjects.mWords[i] = word!=0 ? mWords[i].exchange( 0, std::memory_order_acquire ) : 0;
+	}
+}
+
+}
@@ -0,0 +1,148 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIMappedFile.h"
+
+#include "RDIPlatform.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RDI
+{
+
+MappedFile::MappedFile()
+	: mData(NULL),
+	  mSize(0)
+#ifdef _WIN32
+	  , mFileHandle(INVALID_HANDLE_VALUE),
+	  mMappingHandle(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open( const std::string& fileName )
+{
+	close();
+
+	HANDLE fileHandle = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( fileHandle==INVALID_HANDLE_VALUE )
+		return false;
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( fileHandle, &size ) || size.QuadPart==0 )
+	{
+		// An empty file can't be mapped
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMapping( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( !mappingHandle )
+	{
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	void* data = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if ( !data )
+	{
+		CloseHandle( mappingHandle );
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	mFileHandle = fileHandle;
+	mMappingHandle = mappingHandle;
+	mData = static_cast<const unsigned char*>(data);
+	mSize = static_cast<std::size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if ( mData )
+		UnmapViewOfFile( mData );
+	if ( mMappingHandle )
+		CloseHandle( mMappingHandle );
+	if ( mFileHandle!=INVALID_HANDLE_VALUE )
+		CloseHandle( mFileHandle );
+	mData = NULL;
+	mSize = 0;
+	mMappingHandle = NULL;
+	mFileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open( const std::string& fileName )
+{
+	close();
+
+	int fileDescriptor = ::open( fileName.c_str(), O_RDONLY );
+	if ( fileDescriptor<0 )
+		return false;
+
+	struct stat fileStatus;
+	if ( fstat( fileDescriptor, &fileStatus )!=0 || fileStatus.st_size==0 )
+	{
+		// An empty file can't be mapped
+		::close( fileDescriptor );
+		return false;
+	}
+
+	std::size_t size = static_cast<std::size_t>(fileStatus.st_size);
+	void* data = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+	
+	// The mapping stays valid once the file is closed
+	::close( fileDescriptor );
+	if ( data==MAP_FAILED )
+		return false;
+
+	mData = static_cast<const unsigned char*>(data);
+	mSize = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if ( mData )
+		munmap( const_cast<unsigned char*>(mData), mSize );
+	mData = NULL;
+	mSize = 0;
+}
+
+#endif
+
+}
@@ -34,7 +34,9 @@ namespace RDI
 
 Object::Object( const ObjectInstance& objectInstance, Device* parentDevice )
 	: mObjectInstance(objectInstance),
-	  mParentDevice(parentDevice)
+	  mParentDevice(parentDevice),
+	  mIndex(0),
+	  mIsEnabled(true)
 {
 	assert(mParentDevice);
 }
@@ -45,19 +47,10 @@ Object::~Object()
 
 bool Object::setUserData( UINT_PTR data )
 {
-	IDirectInputDevice8* inputDevice = getParentDevice()->getInputDevice();
-	assert(inputDevice);
+	DeviceBackend* deviceBackend = getParentDevice()->getDeviceBackend();
+	assert(deviceBackend);
 
-	DIPROPPOINTER diptr;
-	diptr.diph.dwSize       = sizeof(DIPROPPOINTER);
-	diptr.diph.dwHeaderSize = sizeof(DIPROPHEADER);
-	diptr.diph.dwHow        = DIPH_BYID;
-	diptr.diph.dwObj        = getObjectInstance().getDwType();
-	diptr.uData             = data;
-
-	HRESULT hr = 0;
-	hr = inputDevice->SetProperty( DIPROP_APPDATA, &diptr.diph );
-	return SUCCEEDED(hr);
+	return deviceBackend->setObjectUserData( getObjectInstance().getDwType(), data );
 }
 
 Object*	Object::createObject( const ObjectInstance& objectInstance, Device* parentDevice )
@@ -71,8 +64,8 @@ Object*	Object::createObject( const ObjectInstance& objectInstance, Device* pare
 	return NULL;
 }
 
-void Object::notifyChanged()
+void Object::notifyChanged( DWORD oldData )
 {
-	getParentDevice()->notifyObjectChanged(this);
+	getParentDevice()->notifyObjectChanged( this, oldData );
 }
 }
\ No newline at end of file
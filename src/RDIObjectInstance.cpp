@@ -47,6 +47,13 @@ ObjectInstance::ObjectInstance( const ObjectInstance& other )
 	memcpy( &mDeviceObjectInstance, &(other.mDeviceObjectInstance), sizeof(DIDEVICEOBJECTINSTANCE) );
 }
 
+ObjectInstance::ObjectInstance( const ObjectInstance& other, DWORD dwOfs )
+	: mName( other.mName )
+{
+	memcpy( &mDeviceObjectInstance, &(other.mDeviceObjectInstance), sizeof(DIDEVICEOBJECTINSTANCE) );
+	mDeviceObjectInstance.dwOfs = dwOfs;
+}
+
 ObjectInstance& ObjectInstance::operator=( const ObjectInstance& other )
 {
 	memcpy( &mDeviceObjectInstance, &(other.mDeviceObjectInstance), sizeof(DIDEVICEOBJECTINSTANCE) );
@@ -57,6 +57,11 @@ DWORD POV::getAngle() const
 	return mAngle; 
 }
 
+DWORD POV::getData() const
+{
+	return mIsCentered ? 0xFFFF : mAngle;
+}
+
 void POV::updateFrom( const DIDEVICEOBJECTDATA& entry )
 {
 	if ( LOWORD(entry.dwData)==0xFFFF )
@@ -71,9 +76,10 @@ void POV::setValue( bool isCentered, DWORD angle )
 	assert( angle>=0 && angle<=35999 );
 	if ( isCentered==mIsCentered && angle==mAngle )
 		return;
+	DWORD oldData = getData();
 	mIsCentered = isCentered;
 	mAngle = angle;
-	notifyChanged();
+	notifyChanged( oldData );
 }
 
 
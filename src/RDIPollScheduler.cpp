@@ -0,0 +1,161 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIPollScheduler.h"
+
+#include <assert.h>
+#include <algorithm>
+#include "RDITime.h"
+
+namespace RDI
+{
+
+/*
+	PollScheduler
+*/
+PollScheduler::Settings::Settings()
+	: idleUpdates(0),
+	  maxPollInterval(8),
+	  budgetInUs(0)
+{
+}
+
+PollScheduler::DeviceState::DeviceState()
+	: pollInterval(1),
+	  numWaitingUpdates(0),
+	  numQuietUpdates(0)
+{
+}
+
+PollScheduler::PollScheduler( const Settings& settings )
+	: mBudgetInTicks(0),
+	  mStartTime(0),
+	  mNumPolledDevices(0),
+	  mNumPolls(0),
+	  mNumSkippedPolls(0),
+	  mNumDeferredPolls(0)
+{
+	setSettings( settings );
+}
+
+void PollScheduler::setSettings( const Settings& settings )
+{
+	mSettings = settings;
+	if ( mSettings.maxPollInterval<1 )
+		mSettings.maxPollInterval = 1;
+	mBudgetInTicks = (static_cast<unsigned long long int>(mSettings.budgetInUs) * Time::getTickFrequency()) / 1000000;
+
+	// The devices start over at full rate
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+		mDevices[i] = DeviceState();
+}
+
+void PollScheduler::addDevice()
+{
+	mDevices.push_back( DeviceState() );
+}
+
+void PollScheduler::removeDevice( std::size_t deviceIndex )
+{
+	assert( deviceIndex<mDevices.size() );
+	mDevices.erase( mDevices.begin() + deviceIndex );
+}
+
+const std::vector<unsigned int>& PollScheduler::schedule()
+{
+	mSchedule.clear();
+	mNumPolledDevices = 0;
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		DeviceState& device = mDevices[i];
+		++device.numWaitingUpdates;
+		if ( device.numWaitingUpdates>=device.pollInterval )
+			mSchedule.push_back( static_cast<unsigned int>(i) );
+		else
+			++mNumSkippedPolls;
+	}
+
+	// The order only matters when the devices may not all be polled. The 
+	// most overdue devices come first: the ones that have waited the most 
+	// updates relative to their poll interval (compared without dividing). 
+	// A deferred idle device thus gets more and more urgent, like the active
+	// ones do, rather than waiting for all of them to be polled
+	if ( mBudgetInTicks>0 )
+	{
+		const std::vector<DeviceState>& devices = mDevices;
+		std::sort( mSchedule.begin(), mSchedule.end(), [&devices]( unsigned int index1, unsigned int index2 )
+			{
+				const DeviceState& device1 = devices[index1];
+				const DeviceState& device2 = devices[index2];
+				unsigned long long int overdueness1 = static_cast<unsigned long long int>(device1.numWaitingUpdates) * device2.pollInterval;
+				unsigned long long int overdueness2 = static_cast<unsigned long long int>(device2.numWaitingUpdates) * device1.pollInterval;
+				if ( overdueness1!=overdueness2 )
+					return overdueness1>overdueness2;
+				if ( device1.pollInterval!=device2.pollInterval )
+					return device1.pollInterval<device2.pollInterval;
+				return index1<index2;
+			} );
+		mStartTime = Time::getTimeAsTicks();
+	}
+	return mSchedule;
+}
+
+bool PollScheduler::hasBudgetLeft()
+{
+	if ( mBudgetInTicks==0 || mNumPolledDevices==0 )
+		return true;
+	if ( Time::getTimeAsTicks() - mStartTime < mBudgetInTicks )
+		return true;
+
+	mNumDeferredPolls += mSchedule.size() - mNumPolledDevices;
+	return false;
+}
+
+void PollScheduler::onPolled( unsigned int deviceIndex, bool isActive )
+{
+	assert( deviceIndex<mDevices.size() );
+	DeviceState& device = mDevices[deviceIndex];
+	++mNumPolls;
+	++mNumPolledDevices;
+
+	if ( isActive )
+	{
+		device.pollInterval = 1;
+		device.numQuietUpdates = 0;
+	}
+	else
+	{
+		device.numQuietUpdates += device.numWaitingUpdates;
+		if ( mSettings.idleUpdates>0 && device.numQuietUpdates>=mSettings.idleUpdates )
+			device.pollInterval = std::min( device.pollInterval * 2, mSettings.maxPollInterval );
+	}
+	device.numWaitingUpdates = 0;
+}
+
+unsigned int PollScheduler::getPollInterval( unsigned int deviceIndex ) const
+{
+	assert( deviceIndex<mDevices.size() );
+	return mDevices[deviceIndex].pollInterval;
+}
+
+}
@@ -0,0 +1,137 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIRecorder.h"
+
+#include <assert.h>
+#include "RDIAxis.h"
+
+namespace RDI
+{
+
+Recorder::Recorder( DeviceManager* deviceManager, std::size_t bufferSize, unsigned int keyframeIntervalInMs )
+	: mDeviceManager(deviceManager),
+	  mWriter(bufferSize, keyframeIntervalInMs)
+{
+	assert( mDeviceManager );
+}
+
+Recorder::~Recorder()
+{
+	stop();
+}
+
+bool Recorder::start( const std::string& fileName )
+{
+	assert( !isRecording() );
+	if ( isRecording() )
+		return false;
+
+	if ( !mWriter.open( fileName ) )
+		return false;
+
+	const DeviceManager::DeviceList& devices = mDeviceManager->getDevices();
+	for ( DeviceManager::DeviceList::const_iterator itr=devices.begin(); itr!=devices.end(); ++itr )
+		addDevice( (*itr).second );
+	
+	mDeviceManager->addListener( this );
+	return true;
+}
+
+void Recorder::stop()
+{
+	if ( !isRecording() )
+		return;
+
+	mDeviceManager->removeListener( this );
+	while ( !mDevices.empty() )
+		removeDevice( mDevices.back().first );
+	
+	mWriter.close();
+}
+
+void Recorder::getRecordedObjects( const Device* device, RecordedObjects& objects )
+{
+	const Objects& deviceObjects = device->getObjects();
+	objects.resize( deviceObjects.size() );
+	for ( std::size_t i=0; i<deviceObjects.size(); ++i )
+	{
+		const Object* object = deviceObjects[i];
+		RecordedObject& recordedObject = objects[i];
+		recordedObject.objectInstance = object->getObjectInstance();
+		recordedObject.data = object->getData();
+		if ( object->getObjectInstance().isAxis() )
+		{
+			const Axis* axis = static_cast<const Axis*>(object);
+			recordedObject.minValue = axis->getMinValue();
+			recordedObject.maxValue = axis->getMaxValue();
+		}
+	}
+}
+
+void Recorder::onDeviceConnected( DeviceManager* /*deviceManager*/, Device* device )
+{
+	addDevice( device );
+}
+
+void Recorder::onDeviceDisconnecting( DeviceManager* /*deviceManager*/, Device* device )
+{
+	removeDevice( device );
+}
+
+void Recorder::onObjectChanged( Device* device, Object* object )
+{
+	for ( RecordedDevices::const_iterator itr=mDevices.begin(); itr!=mDevices.end(); ++itr )
+	{
+		if ( (*itr).first==device )
+		{
+			mWriter.changeObject( (*itr).second, object->getIndex(), object->getData(), device->getCurrentChange().timeStamp );
+			return;
+		}
+	}
+}
+
+void Recorder::addDevice( Device* device )
+{
+	RecordedObjects objects;
+	getRecordedObjects( device, objects );
+	unsigned int deviceId = mWriter.addDevice( device->getDeviceInstance(), objects );
+	mDevices.push_back( std::make_pair( device, deviceId ) );
+	device->addListener( this );
+}
+
+void Recorder::removeDevice( Device* device )
+{
+	for ( RecordedDevices::iterator itr=mDevices.begin(); itr!=mDevices.end(); ++itr )
+	{
+		if ( (*itr).first==device )
+		{
+			device->removeListener( this );
+			mWriter.removeDevice( (*itr).second );
+			mDevices.erase( itr );
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,907 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIRecording.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include "RDITime.h"
+#include "RDICommon.h"
+
+namespace RDI
+{
+
+namespace
+{
+
+void writeVarUInt( std::vector<unsigned char>& bytes, unsigned long long int value )
+{
+	while ( value>=0x80 )
+	{
+		bytes.push_back( static_cast<unsigned char>( (value & 0x7F) | 0x80 ) );
+		value >>= 7;
+	}
+	bytes.push_back( static_cast<unsigned char>(value) );
+}
+
+void writeVarInt( std::vector<unsigned char>& bytes, long long int value )
+{
+	// Zigzag encoding, so small negative values are encoded as small positive ones
+	unsigned long long int zigzag = (static_cast<unsigned long long int>(value) << 1) ^ static_cast<unsigned long long int>(value >> 63);
+	writeVarUInt( bytes, zigzag );
+}
+
+void writeGUID( std::vector<unsigned char>& bytes, const GUID& guid )
+{
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(&guid);
+	bytes.insert( bytes.end(), data, data + sizeof(GUID) );
+}
+
+void writeString( std::vector<unsigned char>& bytes, const std::string& text )
+{
+	writeVarUInt( bytes, text.size() );
+	bytes.insert( bytes.end(), text.begin(), text.end() );
+}
+
+void writeObjectInstance( std::vector<unsigned char>& bytes, const ObjectInstance& objectInstance )
+{
+	writeGUID( bytes, objectInstance.getGuidType() );
+	writeVarUInt( bytes, objectInstance.getDwOfs() );
+	writeVarUInt( bytes, objectInstance.getDwType() );
+	writeVarUInt( bytes, objectInstance.getDwFlags() );
+	writeString( bytes, objectInstance.getName() );
+	writeVarUInt( bytes, objectInstance.getDwFFMaxForce() );
+	writeVarUInt( bytes, objectInstance.getFFForceResolution() );
+	writeVarUInt( bytes, objectInstance.getCollectionNumber() );
+	writeVarUInt( bytes, objectInstance.getDesignatorIndex() );
+	writeVarUInt( bytes, objectInstance.getUsagePage() );
+	writeVarUInt( bytes, objectInstance.getUsage() );
+	writeVarUInt( bytes, objectInstance.getDimension() );
+	writeVarUInt( bytes, objectInstance.getExponent() );
+	writeVarUInt( bytes, objectInstance.getReportId() );
+}
+
+// Reads the encoded values, never past the end of the data
+class ByteReader
+{
+public:
+	ByteReader( const unsigned char* data, std::size_t size, std::size_t offset )
+		: mData(data),
+		  mSize(size),
+		  mOffset(offset)
+	{
+	}
+
+	std::size_t getOffset() const		{ return mOffset; }
+
+	bool readByte( unsigned char& value )
+	{
+		if ( mOffset>=mSize )
+			return false;
+		value = mData[mOffset++];
+		return true;
+	}
+
+	bool readVarUInt( unsigned long long int& value )
+	{
+		value = 0;
+		for ( unsigned int shift=0; shift<64; shift+=7 )
+		{
+			unsigned char byte = 0;
+			if ( !readByte( byte ) )
+				return false;
+			value |= static_cast<unsigned long long int>( byte & 0x7F ) << shift;
+			if ( (byte & 0x80)==0 )
+				return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	bool readVarUInt( T& value )
+	{
+		unsigned long long int value64 = 0;
+		if ( !readVarUInt( value64 ) || value64>static_cast<T>(-1) )
+			return false;
+		value = static_cast<T>(value64);
+		return true;
+	}
+
+	bool readVarInt( long long int& value )
+	{
+		unsigned long long int zigzag = 0;
+		if ( !readVarUInt( zigzag ) )
+			return false;
+		value = static_cast<long long int>( zigzag >> 1 ) ^ -static_cast<long long int>( zigzag & 1 );
+		return true;
+	}
+
+	bool readGUID( GUID& guid )
+	{
+		if ( mSize - mOffset<sizeof(GUID) )
+			return false;
+		memcpy( &guid, mData + mOffset, sizeof(GUID) );
+		mOffset += sizeof(GUID);
+		return true;
+	}
+
+	bool readString( std::string& text )
+	{
+		std::size_t length = 0;
+		if ( !readVarUInt( length ) || mSize - mOffset<length )
+			return false;
+		text.assign( reinterpret_cast<const char*>(mData + mOffset), length );
+		mOffset += length;
+		return true;
+	}
+
+private:
+	const unsigned char*	mData;
+	std::size_t				mSize;
+	std::size_t				mOffset;
+};
+
+bool readObjectInstance( ByteReader& reader, ObjectInstance& objectInstance )
+{
+	DIDEVICEOBJECTINSTANCE instance;
+	memset( &instance, 0, sizeof(instance) );
+	instance.dwSize = sizeof(instance);
+	std::string name;
+	bool ret =	reader.readGUID( instance.guidType ) &&
+				reader.readVarUInt( instance.dwOfs ) &&
+				reader.readVarUInt( instance.dwType ) &&
+				reader.readVarUInt( instance.dwFlags ) &&
+				reader.readString( name ) &&
+				reader.readVarUInt( instance.dwFFMaxForce ) &&
+				reader.readVarUInt( instance.dwFFForceResolution ) &&
+				reader.readVarUInt( instance.wCollectionNumber ) &&
+				reader.readVarUInt( instance.wDesignatorIndex ) &&
+				reader.readVarUInt( instance.wUsagePage ) &&
+				reader.readVarUInt( instance.wUsage ) &&
+				reader.readVarUInt( instance.dwDimension ) &&
+				reader.readVarUInt( instance.wExponent ) &&
+				reader.readVarUInt( instance.wReportId );
+	if ( !ret )
+		return false;
+	Common::UTF8ToTCHAR( name, instance.tszName, MAX_PATH );
+	objectInstance = ObjectInstance( &instance );
+	return true;
+}
+
+}
+
+const unsigned char Recording::version;
+const std::size_t Recording::headerSize;
+const std::size_t Recording::trailerSize;
+const unsigned char Recording::headerMagic[4] = { 'R', 'D', 'I', 'R' };
+const unsigned char Recording::trailerMagic[4] = { 'R', 'D', 'I', 'X' };
+
+RecordedObject::RecordedObject()
+	: minValue(0),
+	  maxValue(0),
+	  data(0)
+{
+}
+
+RecordedDevice::RecordedDevice()
+	: isConnected(false)
+{
+}
+
+RecordingWriter::DeviceState::DeviceState()
+	: isConnected(false),
+	  isDisconnecting(false),
+	  descriptorOffset(0),
+	  hasTimeBase(false),
+	  baseTime(0),
+	  baseTimeStamp(0)
+{
+}
+
+RecordingWriter::RecordingWriter( std::size_t bufferSize, unsigned int keyframeIntervalInMs )
+	: mBufferSize(bufferSize),
+	  mKeyframeIntervalInMs(keyframeIntervalInMs),
+	  mRingBuffer(NULL),
+	  mFile(NULL),
+	  mStopRequested(false),
+	  mWriteFailed(false),
+	  mStartTime(0),
+	  mLastRecordTime(0),
+	  mLastKeyframeTime(0),
+	  mOffset(0),
+	  mNumDisconnectingDevices(0),
+	  mNumRecords(0),
+	  mNumBytes(0),
+	  mNumDroppedRecords(0)
+{
+	assert( mBufferSize>0 );
+}
+
+RecordingWriter::~RecordingWriter()
+{
+	close();
+}
+
+bool RecordingWriter::open( const std::string& fileName )
+{
+	assert( !isOpen() );
+	if ( isOpen() )
+		return false;
+
+	mFile = fopen( fileName.c_str(), "wb" );
+	if ( !mFile )
+		return false;
+
+	mRingBuffer = new ByteRingBuffer( mBufferSize );
+	mStopRequested = false;
+	mWriteFailed = false;
+	mStartTime = Time::getTimeAsMicroseconds();
+	mLastRecordTime = 0;
+	mLastKeyframeTime = 0;
+	mOffset = 0;
+	mDevices.clear();
+	mNumDisconnectingDevices = 0;
+	mKeyframes.clear();
+	mNumRecords = 0;
+	mNumBytes = 0;
+	mNumDroppedRecords = 0;
+
+	// The header always fits in the empty ring buffer
+	mRecord.clear();
+	mRecord.insert( mRecord.end(), Recording::headerMagic, Recording::headerMagic + 4 );
+	mRecord.push_back( Recording::version );
+	pushBlocking( mRecord );
+
+	mThread = std::thread( &RecordingWriter::writerThread, this );
+	return true;
+}
+
+void RecordingWriter::close()
+{
+	if ( !isOpen() )
+		return;
+
+	unsigned long long int time = getTime();
+	writeDisconnections( time, true );
+
+	// Index of the keyframes, followed by the trailer pointing at it
+	unsigned long long int indexOffset = mOffset;
+	beginRecord( Recording::Index, time );
+	writeVarUInt( mRecord, mKeyframes.size() );
+	unsigned long long int previousTime = 0;
+	unsigned long long int previousOffset = 0;
+	for ( std::size_t i=0; i<mKeyframes.size(); ++i )
+	{
+		writeVarUInt( mRecord, mKeyframes[i].first - previousTime );
+		writeVarUInt( mRecord, mKeyframes[i].second - previousOffset );
+		previousTime = mKeyframes[i].first;
+		previousOffset = mKeyframes[i].second;
+	}
+	for ( int i=0; i<8; ++i )
+		mRecord.push_back( static_cast<unsigned char>( indexOffset >> (i*8) ) );
+	mRecord.insert( mRecord.end(), Recording::trailerMagic, Recording::trailerMagic + 4 );
+	pushBlocking( mRecord );
+	++mNumRecords;
+
+	// The writer thread drains the ring buffer before exiting
+	mStopRequested = true;
+	mThread.join();
+	
+	fclose( mFile );
+	mFile = NULL;
+	delete mRingBuffer;
+	mRingBuffer = NULL;
+}
+
+unsigned int RecordingWriter::addDevice( const DeviceInstance& deviceInstance, const RecordedObjects& objects )
+{
+	unsigned int deviceId = static_cast<unsigned int>( mDevices.size() );
+	mDevices.push_back( DeviceState() );
+	if ( !isOpen() )
+		return deviceId;
+
+	DeviceState& device = mDevices.back();
+	device.isConnected = true;
+	device.deviceInstance = deviceInstance;
+	device.objects = objects;
+	device.encodedData.resize( objects.size() );
+	for ( std::size_t i=0; i<objects.size(); ++i )
+		device.encodedData[i] = objects[i].data;
+
+	// If it doesn't fit in the ring buffer, it's written again before the next record of the device
+	unsigned long long int time = getTime();
+	writeDisconnections( time, false );
+	writeDescriptor( deviceId, time );
+	return deviceId;
+}
+
+void RecordingWriter::removeDevice( unsigned int deviceId )
+{
+	assert( deviceId<mDevices.size() );
+	if ( !isOpen() || deviceId>=mDevices.size() )
+		return;
+
+	DeviceState& device = mDevices[deviceId];
+	if ( !device.isConnected || device.isDisconnecting )
+		return;
+
+	// A device that was never described is simply forgotten. Otherwise it 
+	// stays connected until its DeviceDisconnected record is written
+	if ( device.descriptorOffset==0 )
+	{
+		device.isConnected = false;
+		device.objects.clear();
+		device.encodedData.clear();
+		return;
+	}
+	device.isDisconnecting = true;
+	++mNumDisconnectingDevices;
+	writeDisconnections( getTime(), false );
+}
+
+void RecordingWriter::changeObject( unsigned int deviceId, unsigned int objectIndex, DWORD data, DWORD timeStamp )
+{
+	assert( deviceId<mDevices.size() );
+	if ( !isOpen() || deviceId>=mDevices.size() )
+		return;
+
+	DeviceState& device = mDevices[deviceId];
+	assert( objectIndex<device.objects.size() );
+	if ( !device.isConnected || device.isDisconnecting || objectIndex>=device.objects.size() )
+		return;
+	
+	// The latest data is also needed for the DeviceConnected record and the keyframes
+	device.objects[objectIndex].data = data;
+
+	unsigned long long int time = getEventTime( device, timeStamp );
+	writeDisconnections( time, false );
+	if ( device.descriptorOffset==0 )
+	{
+		// The DeviceConnected record describes the current data, so no ObjectChanged record is needed
+		writeDescriptor( deviceId, time );
+		return;
+	}
+
+	if ( time - mLastKeyframeTime >= static_cast<unsigned long long int>(mKeyframeIntervalInMs) * 1000 )
+	{
+		// The keyframe describes the current data too
+		if ( writeKeyframe( time ) )
+			return;
+	}
+
+	beginRecord( Recording::ObjectChanged, time );
+	writeVarUInt( mRecord, deviceId );
+	writeVarUInt( mRecord, objectIndex );
+	writeVarInt( mRecord, static_cast<int>( data - device.encodedData[objectIndex] ) );
+	if ( commitRecord( time ) )
+		device.encodedData[objectIndex] = data;
+}
+
+unsigned long long int RecordingWriter::getTime() const
+{
+	unsigned long long int time = Time::getTimeAsMicroseconds() - mStartTime;
+	
+	// The times must never go backward, as they are delta-encoded
+	return time>mLastRecordTime ? time : mLastRecordTime;
+}
+
+unsigned long long int RecordingWriter::getEventTime( DeviceState& device, DWORD timeStamp )
+{
+	unsigned long long int currentTime = getTime();
+	if ( device.hasTimeBase )
+	{
+		// The difference is signed so the wrap around of the time stamps doesn't matter
+		long long int elapsed = static_cast<long long int>( static_cast<LONG>( timeStamp - device.baseTimeStamp ) ) * 1000;
+		long long int time = static_cast<long long int>( device.baseTime ) + elapsed;
+		long long int drift = time - static_cast<long long int>( currentTime );
+		if ( time>=0 && drift<=maxTimeStampDriftInMs * 1000LL && drift>=-(maxTimeStampDriftInMs * 1000LL) )
+		{
+			// The times must never go backward, as they are delta-encoded
+			unsigned long long int eventTime = static_cast<unsigned long long int>( time );
+			return eventTime>mLastRecordTime ? eventTime : mLastRecordTime;
+		}
+	}
+
+	device.hasTimeBase = true;
+	device.baseTime = currentTime;
+	device.baseTimeStamp = timeStamp;
+	return currentTime;
+}
+
+bool RecordingWriter::writeDescriptor( unsigned int deviceId, unsigned long long int time )
+{
+	DeviceState& device = mDevices[deviceId];
+	const DeviceInstance& deviceInstance = device.deviceInstance;
+	unsigned long long int offset = mOffset;
+
+	beginRecord( Recording::DeviceConnected, time );
+	writeVarUInt( mRecord, deviceId );
+	writeGUID( mRecord, deviceInstance.getGuidInstance() );
+	writeGUID( mRecord, deviceInstance.getGuidProduct() );
+	writeVarUInt( mRecord, deviceInstance.getDwDevType() );
+	writeString( mRecord, deviceInstance.getInstanceName() );
+	writeString( mRecord, deviceInstance.getProductName() );
+	writeGUID( mRecord, deviceInstance.getFFDriver() );
+	writeVarUInt( mRecord, deviceInstance.getUsagePage() );
+	writeVarUInt( mRecord, deviceInstance.getUsage() );
+	writeVarUInt( mRecord, device.objects.size() );
+	for ( std::size_t i=0; i<device.objects.size(); ++i )
+	{
+		const RecordedObject& object = device.objects[i];
+		writeObjectInstance( mRecord, object.objectInstance );
+		writeVarInt( mRecord, object.minValue );
+		writeVarInt( mRecord, object.maxValue );
+		writeVarUInt( mRecord, object.data );
+	}
+	if ( !commitRecord( time ) )
+		return false;
+
+	device.descriptorOffset = offset;
+	for ( std::size_t i=0; i<device.objects.size(); ++i )
+		device.encodedData[i] = device.objects[i].data;
+	return true;
+}
+
+bool RecordingWriter::writeKeyframe( unsigned long long int time )
+{
+	unsigned long long int offset = mOffset;
+	
+	std::size_t numDevices = 0;
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		if ( mDevices[i].isConnected && mDevices[i].descriptorOffset!=0 )
+			++numDevices;
+	}
+
+	beginRecord( Recording::Keyframe, time );
+	writeVarUInt( mRecord, time );
+	writeVarUInt( mRecord, numDevices );
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		const DeviceState& device = mDevices[i];
+		if ( !device.isConnected || device.descriptorOffset==0 )
+			continue;
+		writeVarUInt( mRecord, i );
+		writeVarUInt( mRecord, device.descriptorOffset );
+		for ( std::size_t j=0; j<device.objects.size(); ++j )
+			writeVarUInt( mRecord, device.objects[j].data );
+	}
+	if ( !commitRecord( time ) )
+		return false;
+
+	// The data of the keyframe is the new reference for the following ObjectChanged records
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		DeviceState& device = mDevices[i];
+		if ( !device.isConnected || device.descriptorOffset==0 )
+			continue;
+		for ( std::size_t j=0; j<device.objects.size(); ++j )
+			device.encodedData[j] = device.objects[j].data;
+	}
+	mLastKeyframeTime = time;
+	mKeyframes.push_back( std::make_pair( time, offset ) );
+	return true;
+}
+
+// Write the DeviceDisconnected records that were dropped, in the order of 
+// the ids. Returns false if one is dropped again. When blocking (on close), 
+// waits for the writer thread to make room instead
+bool RecordingWriter::writeDisconnections( unsigned long long int time, bool isBlocking )
+{
+	for ( std::size_t i=0; i<mDevices.size() && mNumDisconnectingDevices>0; ++i )
+	{
+		DeviceState& device = mDevices[i];
+		if ( !device.isDisconnecting )
+			continue;
+
+		beginRecord( Recording::DeviceDisconnected, time );
+		writeVarUInt( mRecord, i );
+		if ( isBlocking )
+		{
+			pushBlocking( mRecord );
+			mLastRecordTime = time;
+			++mNumRecords;
+		}
+		else if ( !commitRecord( time ) )
+		{
+			return false;
+		}
+
+		device.isConnected = false;
+		device.isDisconnecting = false;
+		device.objects.clear();
+		device.encodedData.clear();
+		--mNumDisconnectingDevices;
+	}
+	return true;
+}
+
+void RecordingWriter::beginRecord( Recording::RecordType type, unsigned long long int time )
+{
+	mRecord.clear();
+	mRecord.push_back( static_cast<unsigned char>(type) );
+	writeVarUInt( mRecord, time - mLastRecordTime );
+}
+
+bool RecordingWriter::commitRecord( unsigned long long int time )
+{
+	if ( !mRingBuffer->write( mRecord.data(), mRecord.size() ) )
+	{
+		++mNumDroppedRecords;
+		return false;
+	}
+	mLastRecordTime = time;
+	mOffset += mRecord.size();
+	mNumBytes += mRecord.size();
+	++mNumRecords;
+	return true;
+}
+
+void RecordingWriter::pushBlocking( const std::vector<unsigned char>& bytes )
+{
+	// Used only when opening and closing, where waiting for the writer thread is acceptable.
+	// A block larger than the ring buffer is pushed in pieces
+	std::size_t position = 0;
+	while ( position<bytes.size() )
+	{
+		std::size_t size = std::min( bytes.size() - position, mRingBuffer->getCapacity() );
+		while ( !mRingBuffer->write( bytes.data() + position, size ) )
+			std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+		position += size;
+	}
+	mOffset += bytes.size();
+	mNumBytes += bytes.size();
+}
+
+void RecordingWriter::writerThread()
+{
+	std::vector<unsigned char> buffer( 64*1024 );
+	for ( ;; )
+	{
+		// The stop flag is read before draining, so everything pushed before it was set gets written
+		bool stopRequested = mStopRequested;
+		std::size_t size = mRingBuffer->read( buffer.data(), buffer.size() );
+		if ( size>0 )
+		{
+			if ( fwrite( buffer.data(), 1, size, mFile )!=size )
+				mWriteFailed = true;
+			continue;
+		}
+		if ( stopRequested )
+			break;
+		std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+	}
+	fflush( mFile );
+}
+
+/*
+	RecordingReader
+*/
+RecordingReader::RecordingReader()
+	: mData(NULL),
+	  mSize(0),
+	  mEndOffset(0),
+	  mOffset(0),
+	  mTime(0),
+	  mHasIndex(false)
+{
+}
+
+bool RecordingReader::open( const unsigned char* data, std::size_t size )
+{
+	close();
+	if ( !data || size<Recording::headerSize )
+		return false;
+	if ( memcmp( data, Recording::headerMagic, 4 )!=0 || data[4]!=Recording::version )
+		return false;
+
+	mData = data;
+	mSize = size;
+	mEndOffset = size;
+	mHasIndex = readIndex();
+	rewind();
+	return true;
+}
+
+void RecordingReader::close()
+{
+	mData = NULL;
+	mSize = 0;
+	mEndOffset = 0;
+	mOffset = 0;
+	mTime = 0;
+	mHasIndex = false;
+	mKeyframes.clear();
+	mDevices.clear();
+}
+
+void RecordingReader::rewind()
+{
+	mOffset = Recording::headerSize;
+	mTime = 0;
+	mDevices.clear();
+}
+
+bool RecordingReader::peekTime( unsigned long long int& time ) const
+{
+	if ( isAtEnd() )
+		return false;
+	ByteReader reader( mData, mEndOffset, mOffset );
+	unsigned char type = 0;
+	unsigned long long int deltaTime = 0;
+	if ( !reader.readByte( type ) || !reader.readVarUInt( deltaTime ) )
+		return false;
+	time = mTime + deltaTime;
+	return true;
+}
+
+bool RecordingReader::readRecord( Record& record )
+{
+	if ( isAtEnd() )
+		return false;
+
+	ByteReader reader( mData, mEndOffset, mOffset );
+	unsigned char type = 0;
+	unsigned long long int deltaTime = 0;
+	bool ret = reader.readByte( type ) && reader.readVarUInt( deltaTime );
+	std::size_t nextOffset = 0;
+	
+	record.type = static_cast<Recording::RecordType>(type);
+	record.time = mTime + deltaTime;
+	record.deviceId = 0;
+	record.objectIndex = 0;
+	if ( ret )
+	{
+		switch ( type )
+		{
+			case Recording::DeviceConnected:
+				ret = reader.readVarUInt( record.deviceId ) && readDeviceDescription( mOffset, record.deviceId, nextOffset );
+				if ( ret )
+					mDevices[record.deviceId].isConnected = true;
+				break;
+
+			case Recording::DeviceDisconnected:
+				ret = reader.readVarUInt( record.deviceId ) && record.deviceId<mDevices.size();
+				if ( ret )
+					mDevices[record.deviceId].isConnected = false;
+				nextOffset = reader.getOffset();
+				break;
+
+			case Recording::ObjectChanged:
+			{
+				long long int deltaData = 0;
+				ret = reader.readVarUInt( record.deviceId ) && reader.readVarUInt( record.objectIndex ) && reader.readVarInt( deltaData ) &&
+					  record.deviceId<mDevices.size() && record.objectIndex<mDevices[record.deviceId].objects.size();
+				if ( ret )
+					mDevices[record.deviceId].objects[record.objectIndex].data += static_cast<DWORD>( static_cast<int>(deltaData) );
+				nextOffset = reader.getOffset();
+				break;
+			}
+
+			case Recording::Keyframe:
+				if ( mKeyframes.empty() || mOffset>mKeyframes.back().second )
+					mKeyframes.push_back( std::make_pair( record.time, static_cast<unsigned long long int>(mOffset) ) );
+				ret = readKeyframe( mOffset, true, nextOffset );
+				break;
+
+			default:
+				// The Index record, if any, is never part of the records
+				ret = false;
+				break;
+		}
+	}
+
+	if ( !ret )
+	{
+		// Corrupted or truncated recording, ignore the rest of it
+		mOffset = mEndOffset;
+		return false;
+	}
+	mOffset = nextOffset;
+	mTime = record.time;
+	return true;
+}
+
+bool RecordingReader::seek( unsigned long long int time )
+{
+	if ( !isOpen() )
+		return false;
+
+	// The last keyframe at or before the time
+	std::size_t numKeyframes = mKeyframes.size();
+	std::size_t keyframeIndex = numKeyframes;
+	for ( std::size_t i=0; i<numKeyframes && mKeyframes[i].first<=time; ++i )
+		keyframeIndex = i;
+
+	// Only use it if it's a shortcut
+	if ( keyframeIndex<numKeyframes && (time<mTime || mKeyframes[keyframeIndex].first>mTime) )
+	{
+		std::size_t nextOffset = 0;
+		mDevices.clear();
+		if ( readKeyframe( static_cast<std::size_t>(mKeyframes[keyframeIndex].second), false, nextOffset ) )
+		{
+			mOffset = nextOffset;
+			mTime = mKeyframes[keyframeIndex].first;
+		}
+		else
+		{
+			rewind();
+		}
+	}
+	else if ( time<mTime )
+	{
+		rewind();
+	}
+
+	unsigned long long int nextTime = 0;
+	Record record;
+	while ( peekTime( nextTime ) && nextTime<=time )
+		readRecord( record );
+	return true;
+}
+
+bool RecordingReader::readIndex()
+{
+	if ( mSize<Recording::headerSize + Recording::trailerSize )
+		return false;
+	const unsigned char* trailer = mData + mSize - Recording::trailerSize;
+	if ( memcmp( trailer + 8, Recording::trailerMagic, 4 )!=0 )
+		return false;
+
+	unsigned long long int indexOffset = 0;
+	for ( int i=0; i<8; ++i )
+		indexOffset |= static_cast<unsigned long long int>( trailer[i] ) << (i*8);
+	if ( indexOffset<Recording::headerSize || indexOffset>=mSize - Recording::trailerSize )
+		return false;
+
+	ByteReader reader( mData, mSize - Recording::trailerSize, static_cast<std::size_t>(indexOffset) );
+	unsigned char type = 0;
+	unsigned long long int deltaTime = 0;
+	std::size_t numKeyframes = 0;
+	if ( !reader.readByte( type ) || type!=Recording::Index || !reader.readVarUInt( deltaTime ) || !reader.readVarUInt( numKeyframes ) )
+		return false;
+
+	std::vector<std::pair<unsigned long long int, unsigned long long int>> keyframes;
+	unsigned long long int time = 0;
+	unsigned long long int offset = 0;
+	for ( std::size_t i=0; i<numKeyframes; ++i )
+	{
+		unsigned long long int deltaOffset = 0;
+		if ( !reader.readVarUInt( deltaTime ) || !reader.readVarUInt( deltaOffset ) )
+			return false;
+		time += deltaTime;
+		offset += deltaOffset;
+		if ( offset>=indexOffset )
+			return false;
+		keyframes.push_back( std::make_pair( time, offset ) );
+	}
+
+	mKeyframes.swap( keyframes );
+	mEndOffset = static_cast<std::size_t>(indexOffset);
+	return true;
+}
+
+// Read the Keyframe record at the given offset. The devices it doesn't list are 
+// disconnected. The description of the ones that are already connected can be 
+// reused instead of being read again
+bool RecordingReader::readKeyframe( std::size_t offset, bool reuseConnectedDevices, std::size_t& nextOffset )
+{
+	ByteReader reader( mData, mEndOffset, offset );
+	unsigned char type = 0;
+	unsigned long long int deltaTime = 0;
+	unsigned long long int time = 0;
+	std::size_t numDevices = 0;
+	if ( !reader.readByte( type ) || type!=Recording::Keyframe || !reader.readVarUInt( deltaTime ) || 
+		 !reader.readVarUInt( time ) || !reader.readVarUInt( numDevices ) )
+		return false;
+
+	std::vector<bool> isListed( mDevices.size(), false );
+	for ( std::size_t i=0; i<numDevices; ++i )
+	{
+		unsigned int deviceId = 0;
+		std::size_t descriptionOffset = 0;
+		if ( !reader.readVarUInt( deviceId ) || !reader.readVarUInt( descriptionOffset ) )
+			return false;
+
+		bool isKnown = reuseConnectedDevices && deviceId<mDevices.size() && mDevices[deviceId].isConnected;
+		std::size_t descriptionEndOffset = 0;
+		if ( !isKnown && !readDeviceDescription( descriptionOffset, deviceId, descriptionEndOffset ) )
+			return false;
+
+		RecordedDevice& device = mDevices[deviceId];
+		device.isConnected = true;
+		for ( std::size_t j=0; j<device.objects.size(); ++j )
+		{
+			if ( !reader.readVarUInt( device.objects[j].data ) )
+				return false;
+		}
+		if ( deviceId>=isListed.size() )
+			isListed.resize( deviceId+1, false );
+		isListed[deviceId] = true;
+	}
+	
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		if ( i>=isListed.size() || !isListed[i] )
+			mDevices[i].isConnected = false;
+	}
+	nextOffset = reader.getOffset();
+	return true;
+}
+
+// Read the description of a device from the DeviceConnected record at the given offset
+bool RecordingReader::readDeviceDescription( std::size_t offset, unsigned int deviceId, std::size_t& nextOffset )
+{
+	ByteReader reader( mData, mEndOffset, offset );
+	unsigned char type = 0;
+	unsigned long long int deltaTime = 0;
+	unsigned int recordDeviceId = 0;
+	if ( !reader.readByte( type ) || type!=Recording::DeviceConnected || !reader.readVarUInt( deltaTime ) ||
+		 !reader.readVarUInt( recordDeviceId ) || recordDeviceId!=deviceId )
+		return false;
+
+	DIDEVICEINSTANCE instance;
+	memset( &instance, 0, sizeof(instance) );
+	instance.dwSize = sizeof(instance);
+	std::string instanceName;
+	std::string productName;
+	std::size_t numObjects = 0;
+	bool ret =	reader.readGUID( instance.guidInstance ) &&
+				reader.readGUID( instance.guidProduct ) &&
+				reader.readVarUInt( instance.dwDevType ) &&
+				reader.readString( instanceName ) &&
+				reader.readString( productName ) &&
+				reader.readGUID( instance.guidFFDriver ) &&
+				reader.readVarUInt( instance.wUsagePage ) &&
+				reader.readVarUInt( instance.wUsage ) &&
+				reader.readVarUInt( numObjects );
+	if ( !ret )
+		return false;
+	Common::UTF8ToTCHAR( instanceName, instance.tszInstanceName, MAX_PATH );
+	Common::UTF8ToTCHAR( productName, instance.tszProductName, MAX_PATH );
+
+	RecordedObjects objects;
+	for ( std::size_t i=0; i<numObjects; ++i )
+	{
+		RecordedObject object;
+		long long int minValue = 0;
+		long long int maxValue = 0;
+		if ( !readObjectInstance( reader, object.objectInstance ) || !reader.readVarInt( minValue ) || 
+			 !reader.readVarInt( maxValue ) || !reader.readVarUInt( object.data ) )
+			return false;
+		object.minValue = static_cast<LONG>(minValue);
+		object.maxValue = static_cast<LONG>(maxValue);
+		objects.push_back( object );
+	}
+
+	if ( deviceId>=mDevices.size() )
+		mDevices.resize( deviceId+1 );
+	RecordedDevice& device = mDevices[deviceId];
+	device.deviceInstance = DeviceInstance( &instance );
+	device.objects.swap( objects );
+	nextOffset = reader.getOffset();
+	return true;
+}
+
+}
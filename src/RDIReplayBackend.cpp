@@ -0,0 +1,450 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIReplayBackend.h"
+
+#include <algorithm>
+#include <assert.h>
+#include "RDITime.h"
+
+namespace RDI
+{
+
+/*
+	ReplayDeviceBackend
+*/
+ReplayDeviceBackend::ReplayDeviceBackend( ReplayBackend* backend, unsigned int deviceId, const RecordedDevice& device )
+	: mBackend(backend),
+	  mDeviceId(deviceId),
+	  mDeviceInstance(device.deviceInstance),
+	  mObjects(device.objects),
+	  mUserData(device.objects.size(), 0xFFFFFFFF),
+	  mDeliveredData(device.objects.size(), 0),
+	  mQueuedData(device.objects.size(), 0),
+	  mSequence(0),
+	  mIsAcquired(false)
+{
+	assert( mBackend );
+
+	// Start from the state the objects have when a Device creates them (see 
+	// Axis and POV), then queue the events that bring them to the recorded state
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		const RecordedObject& object = mObjects[i];
+		DWORD data = 0;
+		if ( object.objectInstance.isAxis() )
+			data = static_cast<DWORD>( object.minValue + (object.maxValue-object.minValue)/2 );
+		else if ( object.objectInstance.isPOV() )
+			data = 0xFFFF;
+		mDeliveredData[i] = data;
+		mQueuedData[i] = data;
+	}
+	synchronize( mBackend->getTickCount() );
+}
+
+ReplayDeviceBackend::~ReplayDeviceBackend()
+{
+	if ( mBackend )
+		mBackend->removeDeviceBackend( this );
+}
+
+const RecordedDevice* ReplayDeviceBackend::getRecordedDevice() const
+{
+	if ( !mBackend )
+		return NULL;
+	const RecordedDevices& devices = mBackend->mReader.getDevices();
+	if ( mDeviceId>=devices.size() )
+		return NULL;
+	return &devices[mDeviceId];
+}
+
+int ReplayDeviceBackend::findObject( DWORD objectType ) const
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i].objectInstance.getDwType()==objectType )
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+bool ReplayDeviceBackend::setBufferSize( DWORD /*numEntries*/ )
+{
+	// The events are never lost, whatever the size of the buffer
+	return true;
+}
+
+bool ReplayDeviceBackend::enumerateObjects( ObjectInstances& objectInstances )
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+		objectInstances.push_back( mObjects[i].objectInstance );
+	return true;
+}
+
+bool ReplayDeviceBackend::getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue )
+{
+	int index = findObject( objectType );
+	if ( index<0 || !mObjects[index].objectInstance.isAxis() )
+		return false;
+	minValue = mObjects[index].minValue;
+	maxValue = mObjects[index].maxValue;
+	return true;
+}
+
+bool ReplayDeviceBackend::setObjectUserData( DWORD objectType, UINT_PTR userData )
+{
+	int index = findObject( objectType );
+	if ( index<0 )
+		return false;
+	mUserData[index] = userData;
+	return true;
+}
+
+HRESULT ReplayDeviceBackend::acquire()
+{
+	if ( !mBackend )
+		return DIERR_UNPLUGGED;
+	if ( mIsAcquired )
+		return S_FALSE;
+	mIsAcquired = true;
+	return DI_OK;
+}
+
+void ReplayDeviceBackend::unacquire()
+{
+	mIsAcquired = false;
+}
+
+HRESULT ReplayDeviceBackend::getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )
+{
+	assert( numDataEntries );
+	if ( !mIsAcquired )
+	{
+		*numDataEntries = 0;
+		return DIERR_NOTACQUIRED;
+	}
+
+	// The events of a device are all returned before it's reported unplugged
+	DWORD numEntries = static_cast<DWORD>( std::min<std::size_t>( *numDataEntries, mEvents.size() ) );
+	for ( DWORD i=0; i<numEntries; ++i )
+	{
+		const Event& event = mEvents.front();
+		DIDEVICEOBJECTDATA& entry = dataEntries[i];
+		entry.dwOfs = mObjects[event.objectIndex].objectInstance.getDwOfs();
+		entry.dwData = event.data;
+		entry.dwTimeStamp = event.timeStamp;
+		entry.dwSequence = ++mSequence;
+		entry.uAppData = mUserData[event.objectIndex];
+		mDeliveredData[event.objectIndex] = event.data;
+		mEvents.pop_front();
+	}
+	*numDataEntries = numEntries;
+
+	if ( numEntries==0 )
+	{
+		const RecordedDevice* device = getRecordedDevice();
+		if ( !device || !device->isConnected )
+			return DIERR_UNPLUGGED;
+	}
+	return DI_OK;
+}
+
+void ReplayDeviceBackend::queueEvent( unsigned int objectIndex, DWORD data, DWORD timeStamp )
+{
+	assert( objectIndex<mObjects.size() );
+	Event event;
+	event.objectIndex = objectIndex;
+	event.data = data;
+	event.timeStamp = timeStamp;
+	mEvents.push_back( event );
+	mQueuedData[objectIndex] = data;
+}
+
+void ReplayDeviceBackend::synchronize( DWORD timeStamp )
+{
+	const RecordedDevice* device = getRecordedDevice();
+	if ( !device || device->objects.size()!=mObjects.size() )
+		return;
+
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		DWORD data = device->objects[i].data;
+		if ( data!=mQueuedData[i] )
+			queueEvent( static_cast<unsigned int>(i), data, timeStamp );
+	}
+}
+
+void ReplayDeviceBackend::clearEvents()
+{
+	mEvents.clear();
+	mQueuedData = mDeliveredData;
+}
+
+/*
+	ReplayBackend
+*/
+ReplayBackend::ReplayBackend()
+	: mSpeed(1),
+	  mNumRecordsPerUpdate(124),
+	  mTime(0),
+	  mTimeRemainder(0),
+	  mLastUpdateTime(0),
+	  mIsStarted(false),
+	  mDeviceListChanged(false),
+	  mNumReplayedEvents(0)
+{
+}
+
+ReplayBackend::~ReplayBackend()
+{
+	// The Devices may outlive us, their backend then behaves as unplugged
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+		mDeviceBackends[i]->mBackend = NULL;
+	mDeviceBackends.clear();
+	close();
+}
+
+bool ReplayBackend::open( const std::string& fileName )
+{
+	close();
+	if ( !mFile.open( fileName ) )
+		return false;
+	if ( !mReader.open( mFile.getData(), mFile.getSize() ) )
+	{
+		mFile.close();
+		return false;
+	}
+	return true;
+}
+
+void ReplayBackend::close()
+{
+	mReader.close();
+	mFile.close();
+	mTime = 0;
+	mTimeRemainder = 0;
+	mIsStarted = false;
+	mDeviceListChanged = true;
+	mNumReplayedEvents = 0;
+}
+
+void ReplayBackend::setSpeed( double speed )
+{
+	assert( speed>=0 );
+	mSpeed = speed;
+	mIsStarted = false;
+}
+
+void ReplayBackend::setNumRecordsPerUpdate( unsigned int numRecords )
+{
+	assert( numRecords>0 );
+	mNumRecordsPerUpdate = numRecords;
+}
+
+void ReplayBackend::update()
+{
+	if ( !isOpen() )
+		return;
+
+	RecordingReader::Record record;
+	if ( mSpeed==0 )
+	{
+		for ( unsigned int i=0; i<mNumRecordsPerUpdate && mReader.readRecord(record); ++i )
+		{
+			mTime = record.time;
+			processRecord( record );
+		}
+		return;
+	}
+
+	// Advance the time of the replay by the time elapsed since the last update
+	unsigned long long int now = Time::getTimeAsMicroseconds();
+	if ( !mIsStarted )
+	{
+		mLastUpdateTime = now;
+		mIsStarted = true;
+	}
+	double elapsedTime = static_cast<double>(now - mLastUpdateTime) * mSpeed + mTimeRemainder;
+	unsigned long long int elapsedTimeInUs = static_cast<unsigned long long int>( elapsedTime );
+	mTimeRemainder = elapsedTime - static_cast<double>(elapsedTimeInUs);
+	mLastUpdateTime = now;
+	mTime += elapsedTimeInUs;
+
+	unsigned long long int time = 0;
+	while ( mReader.peekTime(time) && time<=mTime && mReader.readRecord(record) )
+		processRecord( record );
+}
+
+bool ReplayBackend::seek( unsigned long long int timeInUs )
+{
+	if ( !isOpen() )
+		return false;
+	if ( !mReader.seek( timeInUs ) )
+		return false;
+
+	mTime = timeInUs;
+	mTimeRemainder = 0;
+	mIsStarted = false;
+	mDeviceListChanged = true;
+
+	// The events not yet returned belong to the previous position, and the 
+	// devices may have other ids at the new one
+	DWORD timeStamp = getTickCount();
+	const RecordedDevices& devices = mReader.getDevices();
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+	{
+		ReplayDeviceBackend* deviceBackend = mDeviceBackends[i];
+		for ( std::size_t j=0; j<devices.size(); ++j )
+		{
+			if ( rebindDeviceBackend( deviceBackend, static_cast<unsigned int>(j) ) )
+				break;
+		}
+		deviceBackend->clearEvents();
+		deviceBackend->synchronize( timeStamp );
+	}
+	return true;
+}
+
+void ReplayBackend::processRecord( const RecordingReader::Record& record )
+{
+	DWORD timeStamp = static_cast<DWORD>( record.time / 1000 );
+	switch ( record.type )
+	{
+		case Recording::ObjectChanged:
+		{
+			ReplayDeviceBackend* deviceBackend = findDeviceBackend( record.deviceId );
+			if ( deviceBackend )
+			{
+				const RecordedDevice& device = mReader.getDevices()[record.deviceId];
+				deviceBackend->queueEvent( record.objectIndex, device.objects[record.objectIndex].data, timeStamp );
+			}
+			++mNumReplayedEvents;
+		}
+		break;
+
+		case Recording::DeviceConnected:
+		{
+			mDeviceListChanged = true;
+			
+			// A device unplugged and plugged back gets a new id in the recording, but the 
+			// DeviceManager may not have noticed it was gone. Its Device then carries on 
+			// with the new id
+			for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+			{
+				if ( rebindDeviceBackend( mDeviceBackends[i], record.deviceId ) )
+				{
+					mDeviceBackends[i]->synchronize( timeStamp );
+					break;
+				}
+			}
+		}
+		break;
+
+		case Recording::DeviceDisconnected:
+			mDeviceListChanged = true;
+			break;
+
+		case Recording::Keyframe:
+			for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+				mDeviceBackends[i]->synchronize( timeStamp );
+			break;
+
+		default:
+			break;
+	}
+}
+
+bool ReplayBackend::rebindDeviceBackend( ReplayDeviceBackend* deviceBackend, unsigned int deviceId )
+{
+	// Only a backend whose device is gone can be bound to another device
+	const RecordedDevice* previousDevice = deviceBackend->getRecordedDevice();
+	if ( previousDevice && previousDevice->isConnected )
+		return false;
+
+	const RecordedDevice& device = mReader.getDevices()[deviceId];
+	if ( !device.isConnected || 
+		 !(device.deviceInstance==deviceBackend->mDeviceInstance) ||
+		 device.objects.size()!=deviceBackend->mObjects.size() ||
+		 findDeviceBackend( deviceId ) )
+		return false;
+
+	deviceBackend->mDeviceId = deviceId;
+	return true;
+}
+
+ReplayDeviceBackend* ReplayBackend::findDeviceBackend( unsigned int deviceId ) const
+{
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+	{
+		if ( mDeviceBackends[i]->mDeviceId==deviceId )
+			return mDeviceBackends[i];
+	}
+	return NULL;
+}
+
+void ReplayBackend::removeDeviceBackend( ReplayDeviceBackend* deviceBackend )
+{
+	std::vector<ReplayDeviceBackend*>::iterator itr = std::find( mDeviceBackends.begin(), mDeviceBackends.end(), deviceBackend );
+	if ( itr!=mDeviceBackends.end() )
+		mDeviceBackends.erase( itr );
+}
+
+void ReplayBackend::enumerateDevices( DeviceIdentifiers& deviceInstances )
+{
+	const RecordedDevices& devices = mReader.getDevices();
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		if ( devices[i].isConnected )
+			deviceInstances.push_back( devices[i].deviceInstance );
+	}
+}
+
+DeviceBackend* ReplayBackend::createDeviceBackend( const DeviceInstance& deviceInstance )
+{
+	const RecordedDevices& devices = mReader.getDevices();
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		const RecordedDevice& device = devices[i];
+		if ( device.isConnected && device.deviceInstance==deviceInstance )
+		{
+			ReplayDeviceBackend* deviceBackend = new ReplayDeviceBackend( this, static_cast<unsigned int>(i), device );
+			mDeviceBackends.push_back( deviceBackend );
+			return deviceBackend;
+		}
+	}
+	return NULL;
+}
+
+DWORD ReplayBackend::getTickCount()
+{
+	return static_cast<DWORD>( mTime / 1000 );
+}
+
+bool ReplayBackend::hasDeviceListChanged()
+{
+	bool changed = mDeviceListChanged;
+	mDeviceListChanged = false;
+	return changed;
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIRingBuffer.h"
+
+#include <assert.h>
+#include <string.h>
+
+namespace RDI
+{
+
+ByteRingBuffer::ByteRingBuffer( std::size_t capacity )
+	: mBuffer(),
+	  mMask(0),
+	  mCachedReadPosition(0),
+	  mWritePosition(0),
+	  mReadPosition(0)
+{
+	std::size_t size = 1;
+	while ( size<capacity )
+		size <<= 1;
+	mBuffer.resize( size );
+	mMask = size - 1;
+}
+
+bool ByteRingBuffer::write( const unsigned char* data, std::size_t size )
+{
+	std::size_t writePosition = mWritePosition.load( std::memory_order_relaxed );
+	
+	// The read position shared with the consumer is only loaded when the 
+	// last known one doesn't leave enough free space
+	std::size_t freeSize = mBuffer.size() - (writePosition - mCachedReadPosition);
+	if ( size>freeSize )
+	{
+		mCachedReadPosition = mReadPosition.load( std::memory_order_acquire );
+		freeSize = mBuffer.size() - (writePosition - mCachedReadPosition);
+		if ( size>freeSize )
+			return false;
+	}
+
+	// Copy in up to two parts, when the data wraps around the end of the buffer
+	std::size_t index = writePosition & mMask;
+	std::size_t firstPartSize = mBuffer.size() - index;
+	if ( firstPartSize>size )
+		firstPartSize = size;
+	memcpy( &mBuffer[index], data, firstPartSize );
+	if ( size>firstPartSize )
+		memcpy( &mBuffer[0], data + firstPartSize, size - firstPartSize );
+
+	mWritePosition.store( writePosition + size, std::memory_order_release );
+	return true;
+}
+
+std::size_t ByteRingBuffer::read( unsigned char* data, std::size_t maxSize )
+{
+	std::size_t readPosition = mReadPosition.load( std::memory_order_relaxed );
+	std::size_t writePosition = mWritePosition.load( std::memory_order_acquire );
+	std::size_t size = writePosition - readPosition;
+	if ( size>maxSize )
+		size = maxSize;
+	if ( size==0 )
+		return 0;
+
+	std::size_t index = readPosition & mMask;
+	std::size_t firstPartSize = mBuffer.size() - index;
+	if ( firstPartSize>size )
+		firstPartSize = size;
+	memcpy( data, &mBuffer[index], firstPartSize );
+	if ( size>firstPartSize )
+		memcpy( data + firstPartSize, &mBuffer[0], size - firstPartSize );
+
+	mReadPosition.store( readPosition + size, std::memory_order_release );
+	return size;
+}
+
+}
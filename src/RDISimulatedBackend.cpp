@@ -0,0 +1,802 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDISimulatedBackend.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+#include <sstream>
+#include "RDICommon.h"
+
+namespace RDI
+{
+
+/*
+	SimulatedGenerator
+*/
+SimulatedGenerator::SimulatedGenerator()
+	: type(RandomWalk),
+	  eventsPerSecond(0),
+	  step(0),
+	  burstSize(0),
+	  periodInMs(0)
+{
+}
+
+SimulatedGenerator SimulatedGenerator::randomWalk( float eventsPerSecond, LONG step )
+{
+	assert( eventsPerSecond>=0 );
+	assert( step>0 );
+	SimulatedGenerator generator;
+	generator.type = RandomWalk;
+	generator.eventsPerSecond = eventsPerSecond;
+	generator.step = step;
+	return generator;
+}
+
+SimulatedGenerator SimulatedGenerator::buttonStorm( float eventsPerSecond )
+{
+	assert( eventsPerSecond>=0 );
+	SimulatedGenerator generator;
+	generator.type = ButtonStorm;
+	generator.eventsPerSecond = eventsPerSecond;
+	return generator;
+}
+
+SimulatedGenerator SimulatedGenerator::burst( unsigned int burstSize, DWORD periodInMs, LONG step )
+{
+	assert( periodInMs>0 );
+	assert( step>0 );
+	SimulatedGenerator generator;
+	generator.type = Burst;
+	generator.step = step;
+	generator.burstSize = burstSize;
+	generator.periodInMs = periodInMs;
+	return generator;
+}
+
+/*
+	SimulatedDeviceBackend
+*/
+SimulatedDeviceBackend::SimulatedDeviceBackend( SimulatedBackend* backend, unsigned int deviceIndex )
+	: mBackend(backend),
+	  mDeviceIndex(deviceIndex),
+	  mObjects(backend->getObjects(deviceIndex)),
+	  mUserData(mObjects.size(), 0xFFFFFFFF),
+	  mBufferSize(0),
+	  mSequence(0),
+	  mNumEventsToDrop(0),
+	  mIsAcquired(false),
+	  mHasOverflowed(false),
+	  mHasLostInput(false)
+{
+	ObjectInstances objectInstances;
+	enumerateObjects( objectInstances );
+	setDataFormat( DataFormat::createFromOffsets( objectInstances, DataFormat::joystick2DataSize ) );
+}
+
+SimulatedDeviceBackend::~SimulatedDeviceBackend()
+{
+	if ( mBackend )
+		mBackend->removeDeviceBackend( this );
+}
+
+bool SimulatedDeviceBackend::isConnected() const
+{
+	return mBackend && mBackend->isDeviceConnected( mDeviceIndex );
+}
+
+int SimulatedDeviceBackend::findObject( DWORD objectType ) const
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		if ( mObjects[i].objectInstance.getDwType()==objectType )
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+bool SimulatedDeviceBackend::setBufferSize( DWORD numEntries )
+{
+	mBufferSize = numEntries;
+	while ( mEvents.size()>mBufferSize )
+		mEvents.pop_back();
+	return true;
+}
+
+bool SimulatedDeviceBackend::enumerateObjects( ObjectInstances& objectInstances )
+{
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+		objectInstances.push_back( mObjects[i].objectInstance );
+	return true;
+}
+
+bool SimulatedDeviceBackend::setDataFormat( const DataFormat& dataFormat )
+{
+	if ( mIsAcquired )
+		return false;
+
+	const DataFormat::ObjectFormats& formatObjects = dataFormat.getObjects();
+	for ( std::size_t i=0; i<formatObjects.size(); ++i )
+	{
+		if ( findObject( formatObjects[i].objectType )<0 )
+			return false;
+	}
+
+	mDataFormat = dataFormat;
+	mFormatIndices.resize( mObjects.size() );
+	for ( std::size_t i=0; i<mObjects.size(); ++i )
+	{
+		ObjectInstance& objectInstance = mObjects[i].objectInstance;
+		int index = mDataFormat.findObject( objectInstance.getDwType() );
+		mFormatIndices[i] = index;
+		if ( index>=0 )
+			objectInstance = ObjectInstance( objectInstance, formatObjects[index].offset );
+	}
+	mRequestedObjects.clear();
+	writeState();
+	return true;
+}
+
+bool SimulatedDeviceBackend::getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue )
+{
+	int index = findObject( objectType );
+	if ( index<0 || !mObjects[index].objectInstance.isAxis() )
+		return false;
+	minValue = mObjects[index].minValue;
+	maxValue = mObjects[index].maxValue;
+	return true;
+}
+
+bool SimulatedDeviceBackend::setObjectUserData( DWORD objectType, UINT_PTR userData )
+{
+	int index = findObject( objectType );
+	if ( index<0 || mFormatIndices[index]<0 )
+		return false;
+	mUserData[index] = userData;
+	return true;
+}
+
+HRESULT SimulatedDeviceBackend::acquire()
+{
+	++mBackend->mNumAcquireCalls;
+	if ( !isConnected() )
+		return DIERR_UNPLUGGED;
+
+	SimulatedBackend::SimulatedDevice& device = mBackend->mDevices[mDeviceIndex];
+	if ( device.numAcquireFailures>0 )
+	{
+		--device.numAcquireFailures;
+		return DIERR_OTHERAPPHASPRIO;
+	}
+	if ( device.isHeld )
+		return DIERR_OTHERAPPHASPRIO;
+
+	if ( mIsAcquired )
+		return S_FALSE;
+	mIsAcquired = true;
+	mHasLostInput = false;
+	return DI_OK;
+}
+
+void SimulatedDeviceBackend::unacquire()
+{
+	mIsAcquired = false;
+	mEvents.clear();
+	mHasOverflowed = false;
+}
+
+HRESULT SimulatedDeviceBackend::getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )
+{
+	assert( numDataEntries );
+	++mBackend->mNumDeviceDataCalls;
+	if ( mHasLostInput )
+	{
+		// Reported once, then the device is simply not acquired
+		mHasLostInput = false;
+		*numDataEntries = 0;
+		return DIERR_INPUTLOST;
+	}
+	if ( !mIsAcquired )
+	{
+		*numDataEntries = 0;
+		return DIERR_NOTACQUIRED;
+	}
+
+	DWORD numEntries = static_cast<DWORD>( std::min<std::size_t>( *numDataEntries, mEvents.size() ) );
+	for ( DWORD i=0; i<numEntries; ++i )
+	{
+		dataEntries[i] = mEvents.front();
+		mEvents.pop_front();
+	}
+	*numDataEntries = numEntries;
+
+	if ( mHasOverflowed )
+	{
+		mHasOverflowed = false;
+		return DI_BUFFEROVERFLOW;
+	}
+	return DI_OK;
+}
+
+HRESULT SimulatedDeviceBackend::getObjectStates( const DWORD* objectTypes, DWORD* states, std::size_t numObjects )
+{
+	if ( !mIsAcquired )
+		return DIERR_NOTACQUIRED;
+
+	// Like GetDeviceState(), the whole state is copied
+	mStateCopy = mState;
+	
+	// The objects are looked up in the format once, as the same ones are 
+	// usually requested again
+	bool isCached = mRequestedObjects.size()==numObjects;
+	for ( std::size_t i=0; i<numObjects && isCached; ++i )
+		isCached = mRequestedObjects[i].objectType==objectTypes[i];
+	if ( !isCached )
+	{
+		mRequestedObjects.clear();
+		for ( std::size_t i=0; i<numObjects; ++i )
+		{
+			int index = mDataFormat.findObject( objectTypes[i] );
+			if ( index<0 )
+			{
+				mRequestedObjects.clear();
+				return DIERR_INVALIDPARAM;
+			}
+			mRequestedObjects.push_back( mDataFormat.getObjects()[index] );
+		}
+	}
+
+	for ( std::size_t i=0; i<numObjects; ++i )
+		states[i] = DataFormat::readState( &mStateCopy[0], mRequestedObjects[i] );
+	return DI_OK;
+}
+
+void SimulatedDeviceBackend::queueEvent( unsigned int objectIndex, DWORD data, DWORD timeStamp )
+{
+	int formatIndex = mFormatIndices[objectIndex];
+	if ( formatIndex<0 )
+		return;
+	DataFormat::writeState( &mState[0], mDataFormat.getObjects()[formatIndex], data );
+
+	// Like DirectInput, the events are only buffered while the device is acquired
+	// and the ones that don't fit in the buffer are lost
+	if ( !mIsAcquired )
+		return;
+	if ( mEvents.size()>=mBufferSize )
+	{
+		mHasOverflowed = true;
+		++mBackend->mNumLostEvents;
+		return;
+	}
+	if ( mNumEventsToDrop>0 )
+	{
+		--mNumEventsToDrop;
+		++mSequence;
+		++mBackend->mNumLostEvents;
+		return;
+	}
+
+	DIDEVICEOBJECTDATA entry;
+	entry.dwOfs = mObjects[objectIndex].objectInstance.getDwOfs();
+	entry.dwData = data;
+	entry.dwTimeStamp = timeStamp;
+	entry.dwSequence = ++mSequence;
+	entry.uAppData = mUserData[objectIndex];
+	mEvents.push_back( entry );
+}
+
+void SimulatedDeviceBackend::loseInput()
+{
+	if ( mIsAcquired )
+		mHasLostInput = true;
+	unacquire();
+}
+
+void SimulatedDeviceBackend::dropEvents( unsigned int numEvents )
+{
+	mNumEventsToDrop = numEvents;
+}
+
+void SimulatedDeviceBackend::writeState()
+{
+	mState.assign( std::max<DWORD>( mDataFormat.getDataSize(), 1 ), 0 );
+	if ( !mBackend )
+		return;
+	const RecordedObjects& objects = mBackend->getObjects( mDeviceIndex );
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		if ( mFormatIndices[i]>=0 )
+			DataFormat::writeState( &mState[0], mDataFormat.getObjects()[mFormatIndices[i]], objects[i].data );
+	}
+}
+
+/*
+	SimulatedBackend
+*/
+SimulatedBackend::SimulatedDevice::SimulatedDevice()
+	: isConnected(false),
+	  numAcquireFailures(0),
+	  isHeld(false)
+{
+}
+
+SimulatedBackend::SimulatedBackend( unsigned int seed )
+	: mRandomState(seed!=0 ? seed : 0x9E3779B9),
+	  mTime(0),
+	  mDeviceListChanged(false),
+	  mNumEvents(0),
+	  mNumLostEvents(0),
+	  mNumAcquireCalls(0),
+	  mNumDeviceDataCalls(0)
+{
+}
+
+SimulatedBackend::~SimulatedBackend()
+{
+	// The Devices may outlive us, their backend then behaves as unplugged
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+		mDeviceBackends[i]->mBackend = NULL;
+}
+
+unsigned int SimulatedBackend::addDevice( const std::string& name, unsigned int numAxes, unsigned int numButtons, unsigned int numPOVs, bool isConnected )
+{
+	RecordedObjects objects;
+	createObjects( numAxes, numButtons, numPOVs, objects );
+	return addDevice( createDeviceInstance( name, static_cast<unsigned int>(mDevices.size()) ), objects, isConnected );
+}
+
+unsigned int SimulatedBackend::addDevice( const DeviceInstance& deviceInstance, const RecordedObjects& objects, bool isConnected )
+{
+	unsigned int deviceIndex = static_cast<unsigned int>( mDevices.size() );
+	mDevices.push_back( SimulatedDevice() );
+	
+	SimulatedDevice& device = mDevices.back();
+	device.deviceInstance = deviceInstance;
+	device.objects = objects;
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		const ObjectInstance& objectInstance = objects[i].objectInstance;
+		unsigned int objectIndex = static_cast<unsigned int>(i);
+		if ( objectInstance.isAxis() )
+			device.axes.push_back( objectIndex );
+		else if ( objectInstance.isButton() )
+			device.buttons.push_back( objectIndex );
+		else if ( objectInstance.isPOV() )
+			device.povs.push_back( objectIndex );
+	}
+
+	if ( isConnected )
+		connectDevice( deviceIndex );
+	return deviceIndex;
+}
+
+const DeviceInstance& SimulatedBackend::getDeviceInstance( unsigned int deviceIndex ) const
+{
+	assert( deviceIndex<mDevices.size() );
+	return mDevices[deviceIndex].deviceInstance;
+}
+
+const RecordedObjects& SimulatedBackend::getObjects( unsigned int deviceIndex ) const
+{
+	assert( deviceIndex<mDevices.size() );
+	return mDevices[deviceIndex].objects;
+}
+
+DeviceInstance SimulatedBackend::createDeviceInstance( const std::string& name, unsigned int index )
+{
+	// The DeviceManager tells the devices apart by their instance GUID and names
+	DIDEVICEINSTANCE deviceInstance;
+	memset( &deviceInstance, 0, sizeof(deviceInstance) );
+	deviceInstance.dwSize = sizeof(deviceInstance);
+	deviceInstance.guidInstance.Data1 = index + 1;
+	deviceInstance.guidInstance.Data2 = 0x5349;		// "SI"
+	deviceInstance.guidProduct.Data2 = 0x5349;
+	deviceInstance.dwDevType = DI8DEVTYPE_GAMEPAD;
+	Common::UTF8ToTCHAR( name, deviceInstance.tszInstanceName, MAX_PATH );
+	Common::UTF8ToTCHAR( name, deviceInstance.tszProductName, MAX_PATH );
+	return DeviceInstance( &deviceInstance );
+}
+
+std::string SimulatedBackend::createDevicePath( unsigned int deviceIndex )
+{
+	std::stringstream path;
+	path << "SIM#" << deviceIndex;
+	return path.str();
+}
+
+void SimulatedBackend::createObjects( unsigned int numAxes, unsigned int numButtons, unsigned int numPOVs, RecordedObjects& objects )
+{
+	// The offsets are the ones of the DIJOYSTATE2 structure, like with the c_dfDIJoystick2 data format,
+	// and the usages the ones of the HID Generic Desktop and Button pages
+	const GUID* axisGuids[] = { &GUID_XAxis, &GUID_YAxis, &GUID_ZAxis, &GUID_RxAxis, &GUID_RyAxis, &GUID_RzAxis, &GUID_Slider, &GUID_Slider };
+	const WORD axisUsages[] = { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x36 };
+	const WORD genericDesktopUsagePage = 0x01;
+	const WORD buttonUsagePage = 0x09;
+	const WORD hatSwitchUsage = 0x39;
+	const unsigned int maxNumAxes = sizeof(axisGuids)/sizeof(axisGuids[0]);
+	const unsigned int maxNumPOVs = 4;
+	const unsigned int maxNumButtons = 128;
+	assert( numAxes<=maxNumAxes && numPOVs<=maxNumPOVs && numButtons<=maxNumButtons );
+	numAxes = std::min( numAxes, maxNumAxes );
+	numPOVs = std::min( numPOVs, maxNumPOVs );
+	numButtons = std::min( numButtons, maxNumButtons );
+
+	struct Kind
+	{
+		unsigned int	count;
+		DWORD			type;
+		DWORD			offset;
+		DWORD			offsetStep;
+		const char*		name;
+	};
+	const Kind kinds[] = 
+	{
+		{ numAxes,		DIDFT_ABSAXIS,		0,	4,	"Axis" },
+		{ numButtons,	DIDFT_PSHBUTTON,	48,	1,	"Button" },
+		{ numPOVs,		DIDFT_POV,			32,	4,	"POV" }
+	};
+
+	for ( std::size_t k=0; k<sizeof(kinds)/sizeof(kinds[0]); ++k )
+	{
+		const Kind& kind = kinds[k];
+		for ( unsigned int i=0; i<kind.count; ++i )
+		{
+			DIDEVICEOBJECTINSTANCE objectInstance;
+			memset( &objectInstance, 0, sizeof(objectInstance) );
+			objectInstance.dwSize = sizeof(objectInstance);
+			objectInstance.dwOfs = kind.offset + i * kind.offsetStep;
+			objectInstance.dwType = kind.type | DIDFT_MAKEINSTANCE(i);
+			
+			RecordedObject object;
+			if ( kind.type==DIDFT_ABSAXIS )
+			{
+				objectInstance.guidType = *axisGuids[i];
+				objectInstance.wUsagePage = genericDesktopUsagePage;
+				objectInstance.wUsage = axisUsages[i];
+				object.minValue = 0;
+				object.maxValue = 65535;
+				object.data = 32767;
+			}
+			else if ( kind.type==DIDFT_POV )
+			{
+				objectInstance.guidType = GUID_POV;
+				objectInstance.wUsagePage = genericDesktopUsagePage;
+				objectInstance.wUsage = hatSwitchUsage;
+				object.data = 0xFFFF;
+			}
+			else
+			{
+				objectInstance.guidType = GUID_Button;
+				objectInstance.wUsagePage = buttonUsagePage;
+				objectInstance.wUsage = static_cast<WORD>(i + 1);
+			}
+
+			std::stringstream name;
+			name << kind.name << " " << i;
+			Common::UTF8ToTCHAR( name.str(), objectInstance.tszName, MAX_PATH );
+			object.objectInstance = ObjectInstance( &objectInstance );
+			objects.push_back( object );
+		}
+	}
+}
+
+void SimulatedBackend::connectDevice( unsigned int deviceIndex )
+{
+	assert( deviceIndex<mDevices.size() );
+	SimulatedDevice& device = mDevices[deviceIndex];
+	if ( device.isConnected )
+		return;
+	device.isConnected = true;
+	mDeviceListChanged = true;
+}
+
+void SimulatedBackend::disconnectDevice( unsigned int deviceIndex )
+{
+	assert( deviceIndex<mDevices.size() );
+	SimulatedDevice& device = mDevices[deviceIndex];
+	if ( !device.isConnected )
+		return;
+	device.isConnected = false;
+	mDeviceListChanged = true;
+	
+	// The devices that were acquired lose the input and can't be acquired again
+	loseInput( deviceIndex );
+}
+
+bool SimulatedBackend::isDeviceConnected( unsigned int deviceIndex ) const
+{
+	assert( deviceIndex<mDevices.size() );
+	return mDevices[deviceIndex].isConnected;
+}
+
+void SimulatedBackend::scheduleConnection( unsigned int deviceIndex, DWORD time )
+{
+	schedule( deviceIndex, time, true );
+}
+
+void SimulatedBackend::scheduleDisconnection( unsigned int deviceIndex, DWORD time )
+{
+	schedule( deviceIndex, time, false );
+}
+
+void SimulatedBackend::schedule( unsigned int deviceIndex, DWORD time, bool connect )
+{
+	assert( deviceIndex<mDevices.size() );
+	ScheduledConnection connection;
+	connection.time = time;
+	connection.deviceIndex = deviceIndex;
+	connection.connect = connect;
+
+	// After the ones scheduled at the same time, so they happen in the order they were scheduled
+	std::vector<ScheduledConnection>::iterator itr = mScheduledConnections.begin();
+	while ( itr!=mScheduledConnections.end() && itr->time<=time )
+		++itr;
+	mScheduledConnections.insert( itr, connection );
+}
+
+void SimulatedBackend::setObjectData( unsigned int deviceIndex, unsigned int objectIndex, DWORD data )
+{
+	assert( deviceIndex<mDevices.size() );
+	SimulatedDevice& device = mDevices[deviceIndex];
+	assert( objectIndex<device.objects.size() );
+	device.objects[objectIndex].data = data;
+	if ( !device.isConnected )
+		return;
+
+	++mNumEvents;
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+	{
+		if ( mDeviceBackends[i]->mDeviceIndex==deviceIndex )
+			mDeviceBackends[i]->queueEvent( objectIndex, data, mTime );
+	}
+}
+
+void SimulatedBackend::addGenerator( unsigned int deviceIndex, const SimulatedGenerator& generator )
+{
+	assert( deviceIndex<mDevices.size() );
+	GeneratorState state;
+	state.generator = generator;
+	state.numPendingEvents = 0;
+	state.nextBurstTime = mTime + generator.periodInMs;
+	mDevices[deviceIndex].generators.push_back( state );
+}
+
+void SimulatedBackend::removeGenerators( unsigned int deviceIndex )
+{
+	assert( deviceIndex<mDevices.size() );
+	mDevices[deviceIndex].generators.clear();
+}
+
+void SimulatedBackend::failAcquire( unsigned int deviceIndex, unsigned int numFailures )
+{
+	assert( deviceIndex<mDevices.size() );
+	mDevices[deviceIndex].numAcquireFailures = numFailures;
+}
+
+void SimulatedBackend::loseInput( unsigned int deviceIndex )
+{
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+	{
+		if ( mDeviceBackends[i]->mDeviceIndex==deviceIndex )
+			mDeviceBackends[i]->loseInput();
+	}
+}
+
+void SimulatedBackend::holdDevice( unsigned int deviceIndex, bool isHeld )
+{
+	assert( deviceIndex<mDevices.size() );
+	if ( isHeld && !mDevices[deviceIndex].isHeld )
+		loseInput( deviceIndex );
+	mDevices[deviceIndex].isHeld = isHeld;
+}
+
+void SimulatedBackend::dropEvents( unsigned int deviceIndex, unsigned int numEvents )
+{
+	for ( std::size_t i=0; i<mDeviceBackends.size(); ++i )
+	{
+		if ( mDeviceBackends[i]->mDeviceIndex==deviceIndex )
+			mDeviceBackends[i]->dropEvents( numEvents );
+	}
+}
+
+void SimulatedBackend::advance( DWORD timeInMs )
+{
+	for ( DWORD i=0; i<timeInMs; ++i )
+	{
+		++mTime;
+
+		while ( !mScheduledConnections.empty() && mScheduledConnections.front().time<=mTime )
+		{
+			ScheduledConnection connection = mScheduledConnections.front();
+			mScheduledConnections.erase( mScheduledConnections.begin() );
+			if ( connection.connect )
+				connectDevice( connection.deviceIndex );
+			else
+				disconnectDevice( connection.deviceIndex );
+		}
+
+		for ( std::size_t j=0; j<mDevices.size(); ++j )
+		{
+			if ( mDevices[j].isConnected )
+				runGenerators( mDevices[j], static_cast<unsigned int>(j) );
+		}
+	}
+}
+
+unsigned int SimulatedBackend::random()
+{
+	// xorshift32
+	unsigned int x = mRandomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	mRandomState = x;
+	return x;
+}
+
+void SimulatedBackend::runGenerators( SimulatedDevice& device, unsigned int deviceIndex )
+{
+	for ( std::size_t i=0; i<device.generators.size(); ++i )
+	{
+		GeneratorState& state = device.generators[i];
+		const SimulatedGenerator& generator = state.generator;
+		switch ( generator.type )
+		{
+			case SimulatedGenerator::RandomWalk:
+			case SimulatedGenerator::ButtonStorm:
+				state.numPendingEvents += generator.eventsPerSecond / 1000.f;
+				while ( state.numPendingEvents>=1.f )
+				{
+					state.numPendingEvents -= 1.f;
+					if ( generator.type==SimulatedGenerator::RandomWalk )
+						moveAxis( device, deviceIndex, generator.step );
+					else
+						toggleButton( device, deviceIndex );
+				}
+				break;
+
+			case SimulatedGenerator::Burst:
+				if ( mTime>=state.nextBurstTime )
+				{
+					state.nextBurstTime += generator.periodInMs;
+					std::size_t numObjects = device.axes.size() + device.buttons.size() + device.povs.size();
+					for ( unsigned int j=0; j<generator.burstSize && numObjects>0; ++j )
+					{
+						std::size_t kind = random() % numObjects;
+						if ( kind<device.axes.size() )
+							moveAxis( device, deviceIndex, generator.step );
+						else if ( kind<device.axes.size() + device.buttons.size() )
+							toggleButton( device, deviceIndex );
+						else
+							turnPOV( device, deviceIndex );
+					}
+				}
+				break;
+		}
+	}
+}
+
+void SimulatedBackend::moveAxis( SimulatedDevice& device, unsigned int deviceIndex, LONG step )
+{
+	if ( device.axes.empty() )
+		return;
+	unsigned int objectIndex = device.axes[ random() % device.axes.size() ];
+	const RecordedObject& object = device.objects[objectIndex];
+	
+	long long int value = static_cast<LONG>(object.data) + static_cast<long long int>( random() % (2*step+1) ) - step;
+	value = std::max<long long int>( value, object.minValue );
+	value = std::min<long long int>( value, object.maxValue );
+	setObjectData( deviceIndex, objectIndex, static_cast<DWORD>(value) );
+}
+
+void SimulatedBackend::toggleButton( SimulatedDevice& device, unsigned int deviceIndex )
+{
+	if ( device.buttons.empty() )
+		return;
+	unsigned int objectIndex = device.buttons[ random() % device.buttons.size() ];
+	setObjectData( deviceIndex, objectIndex, device.objects[objectIndex].data ? 0 : 0x80 );
+}
+
+void SimulatedBackend::turnPOV( SimulatedDevice& device, unsigned int deviceIndex )
+{
+	if ( device.povs.empty() )
+		return;
+	unsigned int objectIndex = device.povs[ random() % device.povs.size() ];
+	
+	// One of the 8 directions or centered
+	unsigned int direction = random() % 9;
+	setObjectData( deviceIndex, objectIndex, direction<8 ? direction*4500 : 0xFFFF );
+}
+
+void SimulatedBackend::removeDeviceBackend( SimulatedDeviceBackend* deviceBackend )
+{
+	std::vector<SimulatedDeviceBackend*>::iterator itr = std::find( mDeviceBackends.begin(), mDeviceBackends.end(), deviceBackend );
+	if ( itr!=mDeviceBackends.end() )
+		mDeviceBackends.erase( itr );
+}
+
+void SimulatedBackend::enumerateDevices( DeviceIdentifiers& deviceInstances )
+{
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		if ( mDevices[i].isConnected )
+			deviceInstances.push_back( mDevices[i].deviceInstance );
+	}
+}
+
+DeviceBackend* SimulatedBackend::createDeviceBackend( const DeviceInstance& deviceInstance )
+{
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		if ( mDevices[i].isConnected && mDevices[i].deviceInstance==deviceInstance )
+		{
+			SimulatedDeviceBackend* deviceBackend = new SimulatedDeviceBackend( this, static_cast<unsigned int>(i) );
+			mDeviceBackends.push_back( deviceBackend );
+			return deviceBackend;
+		}
+	}
+	return NULL;
+}
+
+DWORD SimulatedBackend::getTickCount()
+{
+	return mTime;
+}
+
+bool SimulatedBackend::hasDeviceListChanged()
+{
+	bool changed = mDeviceListChanged;
+	mDeviceListChanged = false;
+	return changed;
+}
+
+bool SimulatedBackend::getDevicePath( const DeviceInstance& deviceInstance, std::string& devicePath )
+{
+	for ( std::size_t i=0; i<mDevices.size(); ++i )
+	{
+		if ( mDevices[i].deviceInstance==deviceInstance )
+		{
+			devicePath = createDevicePath( static_cast<unsigned int>(i) );
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SimulatedBackend::findDevice( const std::string& devicePath, DeviceInstance& deviceInstance )
+{
+	// The path holds the index of the device
+	unsigned int deviceIndex = 0;
+	std::stringstream stream( devicePath );
+	if ( stream.get()!='S' || stream.get()!='I' || stream.get()!='M' || stream.get()!='#' || !(stream >> deviceIndex) )
+		return false;
+	if ( deviceIndex>=mDevices.size() || !mDevices[deviceIndex].isConnected || createDevicePath(deviceIndex)!=devicePath )
+		return false;
+
+	deviceInstance = mDevices[deviceIndex].deviceInstance;
+	return true;
+}
+
+}
@@ -0,0 +1,206 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "RDIStick.h"
+#include "RDIDevice.h"
+
+#include <assert.h>
+#include <math.h>
+
+namespace RDI
+{
+
+Stick::Settings::Settings()
+	: deadZone(0.15f),
+	  saturation(1.f),
+	  circularityCorrection(true)
+{
+}
+
+bool Stick::Settings::operator==( const Settings& other ) const
+{
+	return deadZone==other.deadZone && 
+		   saturation==other.saturation && 
+		   circularityCorrection==other.circularityCorrection;
+}
+
+Stick::Stick( Axis* xAxis, Axis* yAxis )
+	: mXAxis(xAxis),
+	  mYAxis(yAxis),
+	  mSettings(),
+	  mX(0.f),
+	  mY(0.f),
+	  mMagnitude(0.f),
+	  mAngle(0.f)
+{
+	assert( mXAxis );
+	assert( mYAxis );
+	assert( mXAxis!=mYAxis );
+}
+
+void Stick::setSettings( const Settings& settings )
+{
+	assert( settings.deadZone>=0.f && settings.deadZone<1.f );
+	assert( settings.saturation>settings.deadZone && settings.saturation<=1.f );
+	mSettings = settings;
+}
+
+void Stick::update()
+{
+	float x = normalizeAxisValue( mXAxis );
+	float y = normalizeAxisValue( mYAxis );
+	processSamples( mSettings, 1, &x, &y, &mX, &mY, &mMagnitude, &mAngle );
+}
+
+void Stick::findSticks( const Device* device, Sticks& sticks )
+{
+	assert( device );
+
+	// The pairs of axis types that are known to form a stick
+	const GUID* pairs[][2] = { { &GUID_XAxis, &GUID_YAxis }, { &GUID_RxAxis, &GUID_RyAxis } };
+	const std::size_t numPairs = sizeof(pairs) / sizeof(pairs[0]);
+
+	const Objects& objects = device->getObjects();
+	for ( std::size_t i=0; i<numPairs; ++i )
+	{
+		Axis* xAxis = NULL;
+		Axis* yAxis = NULL;
+		for ( std::size_t j=0; j<objects.size(); ++j )
+		{
+			const ObjectInstance& objectInstance = objects[j]->getObjectInstance();
+			if ( !objectInstance.isAxis() )
+				continue;
+			if ( !xAxis && objectInstance.getGuidType()==*pairs[i][0] )
+				xAxis = static_cast<Axis*>( objects[j] );
+			else if ( !yAxis && objectInstance.getGuidType()==*pairs[i][1] )
+				yAxis = static_cast<Axis*>( objects[j] );
+		}
+		if ( xAxis && yAxis )
+			sticks.push_back( Stick( xAxis, yAxis ) );
+	}
+}
+
+void Stick::updateSticks( Sticks& sticks )
+{
+	if ( sticks.empty() )
+		return;
+
+	// Gather the normalized axis values in contiguous arrays (structure-of-arrays)
+	// so the kernel can process them in a single pass
+	std::size_t numSticks = sticks.size();
+	std::vector<float> values( numSticks * 6 );
+	float* inX = &values[0];
+	float* inY = inX + numSticks;
+	float* outX = inY + numSticks;
+	float* outY = outX + numSticks;
+	float* outMagnitude = outY + numSticks;
+	float* outAngle = outMagnitude + numSticks;
+	for ( std::size_t i=0; i<numSticks; ++i )
+	{
+		inX[i] = normalizeAxisValue( sticks[i].mXAxis );
+		inY[i] = normalizeAxisValue( sticks[i].mYAxis );
+	}
+
+	// Run the kernel on each range of consecutive sticks sharing the same
+	// settings (in practice, all the sticks usually share the same ones)
+	std::size_t start = 0;
+	while ( start<numSticks )
+	{
+		std::size_t end = start + 1;
+		while ( end<numSticks && sticks[end].mSettings==sticks[start].mSettings )
+			++end;
+		processSamples( sticks[start].mSettings, end-start, 
+						inX+start, inY+start, outX+start, outY+start, outMagnitude+start, outAngle+start );
+		start = end;
+	}
+
+	// Scatter the results back
+	for ( std::size_t i=0; i<numSticks; ++i )
+	{
+		Stick& stick = sticks[i];
+		stick.mX = outX[i];
+		stick.mY = outY[i];
+		stick.mMagnitude = outMagnitude[i];
+		stick.mAngle = outAngle[i];
+	}
+}
+
+void Stick::processSamples( const Settings& settings, std::size_t numSamples, 
+							const float* inX, const float* inY, 
+							float* outX, float* outY, float* outMagnitude, float* outAngle )
+{
+	assert( inX && inY && outX && outY && outMagnitude );
+	
+	const float deadZone = settings.deadZone;
+	const float invRange = 1.f / (settings.saturation - settings.deadZone);
+	const float correction = settings.circularityCorrection ? 0.5f : 0.f;
+	
+	// This loop is kept free of branches and function calls (other than sqrtf)
+	// so the compiler can vectorize it
+	for ( std::size_t i=0; i<numSamples; ++i )
+	{
+		float x = inX[i];
+		float y = inY[i];
+
+		// Circularity correction: map the square [-1,1]x[-1,1] onto the unit disc.
+		// With no correction, the corners of the square simply get clamped below
+		float cx = x * sqrtf( 1.f - correction * y * y );
+		float cy = y * sqrtf( 1.f - correction * x * x );
+
+		// Radial dead zone, rescaled so the output magnitude covers the whole 0..1 range
+		float magnitude = sqrtf( cx * cx + cy * cy );
+		float scaled = (magnitude - deadZone) * invRange;
+		scaled = scaled < 0.f ? 0.f : scaled;
+		scaled = scaled > 1.f ? 1.f : scaled;
+		float scale = magnitude > 0.f ? scaled / magnitude : 0.f;
+
+		outX[i] = cx * scale;
+		outY[i] = cy * scale;
+		outMagnitude[i] = scaled;
+	}
+
+	if ( !outAngle )
+		return;
+
+	// The y axis points backward, so north (forward) is -y. The angle goes clockwise
+	const float radiansToDegrees = 57.2957795f;
+	for ( std::size_t i=0; i<numSamples; ++i )
+	{
+		float angle = atan2f( outX[i], -outY[i] ) * radiansToDegrees;
+		angle = angle < 0.f ? angle + 360.f : angle;
+		outAngle[i] = outMagnitude[i] > 0.f ? angle : 0.f;
+	}
+}
+
+float Stick::normalizeAxisValue( const Axis* axis )
+{
+	assert( axis );
+	float minValue = static_cast<float>( axis->getMinValue() );
+	float maxValue = static_cast<float>( axis->getMaxValue() );
+	float value = static_cast<float>( axis->getValue() );
+	if ( maxValue<=minValue )
+		return 0.f;
+	return ( (value - minValue) / (maxValue - minValue) ) * 2.f - 1.f;
+}
+
+}
@@ -23,9 +23,10 @@
 */
 #include "RDITime.h"
 
-#define WIN32_LEAN_AND_MEAN 
-#define NOMINMAX 
-#include <windows.h>
+#include "RDIPlatform.h"
+#ifndef _WIN32
+#include <time.h>
+#endif
 
 namespace RDI
 {
@@ -34,17 +35,28 @@ unsigned long long int Time::mInitialTickCount = 0xffffffffffffffffUL;
 
 unsigned long long int Time::getTickFrequency()
 {
+#ifdef _WIN32
 	LARGE_INTEGER frequency;
 	QueryPerformanceFrequency(&frequency);
 	return frequency.QuadPart;
+#else
+	// The ticks are the nanoseconds of the monotonic clock
+	return 1000000000ULL;
+#endif
 }
 
 unsigned long long int Time::getTimeAsTicks()
 {
 	unsigned long long int tickCount;
+#ifdef _WIN32
 	LARGE_INTEGER l;
 	QueryPerformanceCounter(&l);
 	tickCount = l.QuadPart;
+#else
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	tickCount = static_cast<unsigned long long int>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
 	if ( mInitialTickCount==0xffffffffffffffffUL )
 		mInitialTickCount = tickCount;
 	tickCount -= mInitialTickCount;
@@ -57,4 +69,20 @@ unsigned int Time::getTimeAsMilliseconds()
 	return millecondsTime;
 }
 
-}
\ No newline at end of file
+unsigned long long int Time::getTimeAsMicroseconds()
+{
+	// Split the conversion so it doesn't overflow for large tick counts
+	unsigned long long int ticks = getTimeAsTicks();
+	unsigned long long int frequency = getTickFrequency();
+	return (ticks / frequency) * 1000000 + ((ticks % frequency) * 1000000) / frequency;
+}
+
+/*
+	SystemClock
+*/
+unsigned int SystemClock::getTimeAsMilliseconds()
+{
+	return Time::getTimeAsMilliseconds();
+}
+
+}
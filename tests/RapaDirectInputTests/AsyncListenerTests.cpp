@@ -0,0 +1,155 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIAsyncListener.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	AsyncListener tests
+
+	The changes of a simulated device go through an AsyncListener whose 
+	Executor only runs the tasks when asked, so the changes pile up in the
+	queue and get coalesced.
+*/
+namespace
+{
+
+class ManualExecutor : public RDI::Executor
+{
+public:
+	virtual void execute( Task* task )		{ mTasks.push_back( task ); }
+	void runTasks()
+	{
+		while ( !mTasks.empty() )
+		{
+			Task* task = mTasks.front();
+			mTasks.erase( mTasks.begin() );
+			task->run();
+		}
+	}
+	std::vector<Task*>	mTasks;
+};
+
+class RecordingHandler : public RDI::AsyncListener::Handler
+{
+public:
+	virtual void onObjectChanged( RDI::Device* /*device*/, const RDI::ObjectChange& change )		{ mChanges.push_back( change ); }
+	std::vector<RDI::ObjectChange>	mChanges;
+};
+
+void update( RDI::SimulatedBackend& backend, RDI::DeviceManager& deviceManager )
+{
+	backend.advance( 16 );
+	deviceManager.update();
+}
+
+// A resync change merged into a queued one keeps the merged change a resync
+void testCoalescedResync()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 4, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	ManualExecutor executor;
+	RecordingHandler handler;
+	RDI::AsyncListener listener( &handler, &executor, 16, RDI::AsyncListener::Coalesce );
+	device->addListener( &listener );
+
+	backend.setObjectData( 0, 2, 0x80 );
+	update( backend, deviceManager );
+	backend.loseInput( 0 );
+	backend.setObjectData( 0, 2, 0 );
+	update( backend, deviceManager );
+	update( backend, deviceManager );
+	CHECK( device->getNumResyncs()==1 );
+	CHECK( listener.getNumCoalescedChanges()==1 );
+
+	executor.runTasks();
+	if ( CHECK( handler.mChanges.size()==1 ) )
+	{
+		const RDI::ObjectChange& change = handler.mChanges[0];
+		CHECK( change.objectIndex==2 );
+		CHECK( change.oldData==0 );
+		CHECK( change.newData==0 );
+		CHECK( change.isResync );
+	}
+
+	// Not coalesced with the handled one
+	backend.setObjectData( 0, 2, 0x80 );
+	update( backend, deviceManager );
+	executor.runTasks();
+	if ( CHECK( handler.mChanges.size()==2 ) )
+		CHECK( !handler.mChanges[1].isResync );
+	device->removeListener( &listener );
+}
+
+// The changes of devices destroyed in between don't get mixed up
+void testDestroyedDevices()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 4, 0 );
+	backend.addDevice( "Test Pad", 2, 4, 0, false );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+
+	ManualExecutor executor;
+	RecordingHandler handler;
+	RDI::AsyncListener listener( &handler, &executor, 16, RDI::AsyncListener::Coalesce );
+	for ( unsigned int i=0; i<20; ++i )
+	{
+		// One of the devices comes and goes, the other stays
+		unsigned int deviceIndex = i % 2;
+		if ( i>=2 )
+			backend.connectDevice( deviceIndex );
+		update( backend, deviceManager );
+		const RDI::DeviceManager::DeviceList& devices = deviceManager.getDevices();
+		for ( std::size_t j=0; j<devices.size(); ++j )
+			devices[j].second->addListener( &listener );
+		backend.setObjectData( deviceIndex, 2, i % 4 < 2 ? 0x80 : 0 );
+		update( backend, deviceManager );
+		for ( std::size_t j=0; j<devices.size(); ++j )
+			devices[j].second->removeListener( &listener );
+		executor.runTasks();
+		backend.disconnectDevice( deviceIndex );
+	}
+	CHECK( listener.getNumCoalescedChanges()==0 );
+	CHECK( handler.mChanges.size()==listener.getNumQueuedChanges() );
+}
+
+}
+
+void testAsyncListener()
+{
+	testCoalescedResync();
+	testDestroyedDevices();
+}
@@ -0,0 +1,118 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIAxisFilter.h"
+
+/*
+	AxisFilter tests
+
+	A burst of samples pushed into an AxisFilterBank and processed at once 
+	must be filtered like the same samples processed one at a time, at 
+	their timestamp: every sample counts, with its own time step.
+*/
+namespace
+{
+
+const unsigned int numAxes = 3;
+const unsigned int numSamples = 40;
+
+// A noisy ramp, with a different number of samples per axis
+LONG getSample( unsigned int axis, unsigned int sample )
+{
+	LONG noise = (sample * 7919 + axis * 104729) % 2001 - 1000;
+	return static_cast<LONG>( sample * 1500 ) + noise + 2000;
+}
+
+DWORD getTime( unsigned int axis, unsigned int sample )
+{
+	return 1000 + sample * (2 + axis) + (sample % 3);
+}
+
+void testBurst( const RDI::AxisFilter& filter )
+{
+	const DWORD endTime = 1200;
+
+	RDI::AxisFilterBank burstBank;
+	std::vector<RDI::AxisFilterBank::Id> burstIds;
+	for ( unsigned int axis=0; axis<numAxes; ++axis )
+		burstIds.push_back( burstBank.addAxis( filter, 0, 65535, 0 ) );
+	burstBank.process( 1000 );
+	for ( unsigned int axis=0; axis<numAxes; ++axis )
+	{
+		for ( unsigned int sample=0; sample<numSamples; ++sample )
+			burstBank.pushSample( burstIds[axis], getSample( axis, sample ), getTime( axis, sample ) );
+	}
+	burstBank.process( endTime );
+
+	for ( unsigned int axis=0; axis<numAxes; ++axis )
+	{
+		// Every sample counts: one at a time
+		RDI::AxisFilterBank singleBank;
+		RDI::AxisFilterBank::Id id = singleBank.addAxis( filter, 0, 65535, 0 );
+		singleBank.process( 1000 );
+		for ( unsigned int sample=0; sample<numSamples; ++sample )
+		{
+			singleBank.pushSample( id, getSample( axis, sample ), getTime( axis, sample ) );
+			singleBank.process( getTime( axis, sample ) );
+		}
+		singleBank.process( endTime );
+		CHECK( singleBank.getValue( id )==burstBank.getValue( burstIds[axis] ) );
+
+		// The last sample alone gives something else
+		RDI::AxisFilterBank lastBank;
+		id = lastBank.addAxis( filter, 0, 65535, 0 );
+		lastBank.process( 1000 );
+		lastBank.pushSample( id, getSample( axis, numSamples - 1 ), getTime( axis, numSamples - 1 ) );
+		lastBank.process( endTime );
+		CHECK( lastBank.getValue( id )!=burstBank.getValue( burstIds[axis] ) );
+	}
+}
+
+// The pending samples of a removed axis don't go to the axis that takes its place
+void testRemoveAxis()
+{
+	RDI::AxisFilter filter = RDI::AxisFilter::exponentialMovingAverage( 5.f );
+	RDI::AxisFilterBank bank;
+	RDI::AxisFilterBank::Id removedId = bank.addAxis( filter, 0, 65535, 0 );
+	RDI::AxisFilterBank::Id keptId = bank.addAxis( filter, 0, 65535, 0 );
+	bank.process( 0 );
+	bank.pushSample( removedId, 65535, 10 );
+	bank.pushSample( keptId, 0, 10 );
+	bank.removeAxis( removedId );
+	bank.process( 20 );
+	CHECK( bank.getNumAxes()==1 );
+	CHECK( bank.getValue( keptId )==0 );
+}
+
+}
+
+void testAxisFilter()
+{
+	testBurst( RDI::AxisFilter::exponentialMovingAverage( 5.f ) );
+	testBurst( RDI::AxisFilter::lowPass( 10.f ) );
+	testBurst( RDI::AxisFilter::oneEuro( 1.f, 0.5f ) );
+	testRemoveAxis();
+}
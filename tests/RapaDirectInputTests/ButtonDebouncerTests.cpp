@@ -0,0 +1,234 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIButton.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ButtonDebouncer tests
+
+	The edges of a worn switch (bursts of bounces after each press and 
+	release, and the odd glitch) go through a ButtonDebouncer in both modes,
+	directly and through a Device.
+*/
+namespace
+{
+
+const DWORD window = 10;
+
+struct Edge
+{
+	bool	isPressed;
+	DWORD	timeStamp;
+};
+
+// A deterministic sequence of chattering presses
+void generateChatter( unsigned int numPresses, std::vector<Edge>& edges )
+{
+	unsigned int random = 29;
+	DWORD time = 1000;
+	bool isPressed = false;
+	for ( unsigned int i=0; i<numPresses*2; ++i )
+	{
+		isPressed = !isPressed;
+		Edge edge = { isPressed, time };
+		edges.push_back( edge );
+		random = random * 1664525 + 1013904223;
+		unsigned int numBounces = ( (random >> 16) % 5 ) * 2;
+		for ( unsigned int j=0; j<numBounces; ++j )
+		{
+			time += (j % 2);
+			Edge bounce = { (j % 2)==0 ? !isPressed : isPressed, time };
+			edges.push_back( bounce );
+		}
+
+		// Hold the state, with a glitch in the middle of one release in four
+		DWORD hold = 40 + ( (random >> 8) % 160 );
+		if ( !isPressed && (i % 8)==1 )
+		{
+			Edge glitchStart = { true, time + hold/2 };
+			Edge glitchEnd = { false, time + hold/2 + 1 };
+			edges.push_back( glitchStart );
+			edges.push_back( glitchEnd );
+		}
+		time += hold;
+	}
+}
+
+// Returns the number of presses accepted by the debouncer. Like Device::update(),
+// the debouncer is given the current time every 4 ms
+unsigned int debounce( RDI::ButtonDebouncer& debouncer, const std::vector<Edge>& edges )
+{
+	unsigned int numPresses = 0;
+	DWORD nextUpdateTime = edges.front().timeStamp;
+	for ( std::size_t i=0; i<edges.size(); ++i )
+	{
+		const Edge& edge = edges[i];
+		while ( static_cast<int>(edge.timeStamp - nextUpdateTime)>0 )
+		{
+			if ( debouncer.update( nextUpdateTime ) && debouncer.isPressed() )
+				++numPresses;
+			nextUpdateTime += 4;
+		}
+		if ( debouncer.update( edge.timeStamp ) && debouncer.isPressed() )
+			++numPresses;
+		if ( debouncer.update( edge.isPressed, edge.timeStamp ) && debouncer.isPressed() )
+			++numPresses;
+	}
+	if ( debouncer.update( edges.back().timeStamp + window ) && debouncer.isPressed() )
+		++numPresses;
+	return numPresses;
+}
+
+void testWithoutWindow()
+{
+	RDI::ButtonDebouncer debouncer( false );
+	CHECK( debouncer.update( true, 100 ) && debouncer.isPressed() );
+	CHECK( debouncer.update( false, 101 ) && !debouncer.isPressed() );
+	CHECK( !debouncer.update( false, 102 ) );
+	CHECK( debouncer.getNumSuppressedEdges()==0 );
+}
+
+void testLeadingEdge()
+{
+	RDI::ButtonDebouncer debouncer( false );
+	debouncer.setWindow( window, RDI::ButtonDebouncer::LeadingEdge );
+
+	// The press is accepted right away, the bounces that follow are not
+	CHECK( debouncer.update( true, 100 ) && debouncer.isPressed() );
+	CHECK( !debouncer.update( false, 101 ) && debouncer.isPressed() );
+	CHECK( !debouncer.update( true, 102 ) && debouncer.isPressed() );
+	CHECK( !debouncer.update( false, 103 ) );
+	CHECK( debouncer.isPending() );
+
+	// The last raw state is accepted once the window is over
+	CHECK( !debouncer.update( 109 ) );
+	CHECK( debouncer.update( 110 ) && !debouncer.isPressed() );
+	CHECK( !debouncer.isPending() );
+	CHECK( debouncer.getNumRawEdges()==4 );
+	CHECK( debouncer.getNumSuppressedEdges()==2 );
+}
+
+void testTrailingEdge()
+{
+	RDI::ButtonDebouncer debouncer( false );
+	debouncer.setWindow( window, RDI::ButtonDebouncer::TrailingEdge );
+
+	// The press is only accepted once it has been stable for the window
+	CHECK( !debouncer.update( true, 100 ) && !debouncer.isPressed() );
+	CHECK( !debouncer.update( false, 101 ) );
+	CHECK( !debouncer.update( true, 102 ) );
+	CHECK( !debouncer.update( 111 ) );
+	CHECK( debouncer.update( 112 ) && debouncer.isPressed() );
+
+	// A glitch shorter than the window is rejected
+	CHECK( !debouncer.update( false, 200 ) );
+	CHECK( !debouncer.update( true, 201 ) );
+	CHECK( !debouncer.update( 250 ) && debouncer.isPressed() );
+	CHECK( !debouncer.isPending() );
+}
+
+void testChatter()
+{
+	const unsigned int numPresses = 2000;
+	std::vector<Edge> edges;
+	generateChatter( numPresses, edges );
+
+	// The trailing edge mode also rejects the glitches, so it sees the real presses
+	RDI::ButtonDebouncer trailingEdgeDebouncer( false );
+	trailingEdgeDebouncer.setWindow( window, RDI::ButtonDebouncer::TrailingEdge );
+	CHECK( debounce( trailingEdgeDebouncer, edges )==numPresses );
+	CHECK( !trailingEdgeDebouncer.isPressed() );
+
+	// The leading edge mode lets the glitches through, but not the bounces
+	RDI::ButtonDebouncer leadingEdgeDebouncer( false );
+	leadingEdgeDebouncer.setWindow( window, RDI::ButtonDebouncer::LeadingEdge );
+	unsigned int numLeadingEdgePresses = debounce( leadingEdgeDebouncer, edges );
+	CHECK( numLeadingEdgePresses>=numPresses );
+	CHECK( numLeadingEdgePresses<=numPresses + numPresses/4 );
+	CHECK( !leadingEdgeDebouncer.isPressed() );
+}
+
+class PressListener : public RDI::Device::Listener
+{
+public:
+	PressListener() : mNumPresses(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* object )
+	{
+		RDI::Button* button = static_cast<RDI::Button*>( object );
+		if ( button->isPressed() )
+			++mNumPresses;
+	}
+	unsigned int mNumPresses;
+};
+
+// The pending state of a debounced button is accepted by update() even when no event comes
+void testDevice()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 0, 1, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	device->setButtonDebounce( window, RDI::ButtonDebouncer::TrailingEdge );
+	PressListener listener;
+	device->addListener( &listener );
+	deviceManager.update();
+
+	backend.setObjectData( 0, 0, 0x80 );
+	backend.advance( 1 );
+	backend.setObjectData( 0, 0, 0 );
+	backend.advance( 1 );
+	backend.setObjectData( 0, 0, 0x80 );
+	deviceManager.update();
+	CHECK( listener.mNumPresses==0 );
+	for ( int i=0; i<5; ++i )
+	{
+		backend.advance( 4 );
+		deviceManager.update();
+	}
+	CHECK( listener.mNumPresses==1 );
+	const RDI::Button* button = static_cast<const RDI::Button*>( device->getObjects()[0] );
+	CHECK( button->isPressed() );
+	CHECK( button->getDebouncer().getNumSuppressedEdges()==2 );
+	device->removeListeners();
+}
+
+}
+
+void testButtonDebouncer()
+{
+	testWithoutWindow();
+	testLeadingEdge();
+	testTrailingEdge();
+	testChatter();
+	testDevice();
+}
@@ -0,0 +1,141 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIDataFormat.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	DataFormat tests
+
+	Simulated devices of different sizes are set to the DIJOYSTATE2 layout 
+	and to the minimal DataFormat built from their objects. The state of 
+	each object must read back the same from both.
+*/
+namespace
+{
+
+// The data of each object, as set on the device
+DWORD getData( const RDI::ObjectInstance& objectInstance, std::size_t index )
+{
+	if ( objectInstance.isAxis() )
+		return static_cast<DWORD>( 1000 + index * 100 );
+	if ( objectInstance.isButton() )
+		return index % 3==0 ? 0x80 : 0;
+	return index % 2==0 ? 9000 : 0xFFFFFFFF;		// POV
+}
+
+void testLayout( unsigned int numAxes, unsigned int numButtons, unsigned int numPOVs )
+{
+	RDI::SimulatedBackend backend;
+	unsigned int deviceIndex = backend.addDevice( "Test Pad", numAxes, numButtons, numPOVs );
+	RDI::DeviceBackend* deviceBackend = backend.createDeviceBackend( backend.getDeviceInstance( deviceIndex ) );
+	RDI::ObjectInstances objectInstances;
+	deviceBackend->enumerateObjects( objectInstances );
+	if ( !CHECK( objectInstances.size()==numAxes + numButtons + numPOVs ) )
+	{
+		delete deviceBackend;
+		return;
+	}
+
+	// A DWORD per axis and POV, a byte per button, rounded up to a DWORD
+	RDI::DataFormat minimalFormat = RDI::DataFormat::createMinimal( objectInstances );
+	CHECK( minimalFormat.getDataSize()==((numAxes + numPOVs) * 4 + numButtons + 3) / 4 * 4 );
+	CHECK( minimalFormat.getDataSize()<=RDI::DataFormat::joystick2DataSize );
+	CHECK( minimalFormat.getObjects().size()==objectInstances.size() );
+	RDI::DataFormat joystick2Format = RDI::DataFormat::createFromOffsets( objectInstances, RDI::DataFormat::joystick2DataSize );
+	CHECK( joystick2Format.getDataSize()==RDI::DataFormat::joystick2DataSize );
+	CHECK( joystick2Format.getObjects().size()==objectInstances.size() );
+
+	// The objects don't overlap
+	std::vector<bool> isUsed( minimalFormat.getDataSize(), false );
+	const RDI::DataFormat::ObjectFormats& objects = minimalFormat.getObjects();
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		DWORD stateSize = RDI::DataFormat::getStateSize( objects[i].objectType );
+		if ( !CHECK( objects[i].offset + stateSize<=minimalFormat.getDataSize() ) )
+			continue;
+		for ( DWORD j=0; j<stateSize; ++j )
+		{
+			CHECK( !isUsed[objects[i].offset + j] );
+			isUsed[objects[i].offset + j] = true;
+		}
+	}
+
+	std::vector<DWORD> objectTypes;
+	for ( std::size_t i=0; i<objectInstances.size(); ++i )
+	{
+		objectTypes.push_back( objectInstances[i].getDwType() );
+		CHECK( minimalFormat.findObject( objectTypes.back() )>=0 );
+		backend.setObjectData( deviceIndex, static_cast<unsigned int>(i), getData( objectInstances[i], i ) );
+	}
+
+	for ( int minimal=0; minimal<2; ++minimal )
+	{
+		CHECK( deviceBackend->setDataFormat( minimal ? minimalFormat : joystick2Format ) );
+		deviceBackend->acquire();
+		std::vector<DWORD> states( objectTypes.size(), 0x12345678 );
+		if ( !CHECK( SUCCEEDED( deviceBackend->getObjectStates( &objectTypes[0], &states[0], states.size() ) ) ) )
+			continue;
+		for ( std::size_t i=0; i<objectInstances.size(); ++i )
+			CHECK( states[i]==getData( objectInstances[i], i ) );
+		deviceBackend->unacquire();
+	}
+	delete deviceBackend;
+}
+
+void testReadWriteState()
+{
+	BYTE data[8] = { 0 };
+	RDI::ObjectInstances objectInstances;
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 1, 1, 0 );
+	RDI::DeviceBackend* deviceBackend = backend.createDeviceBackend( backend.getDeviceInstance( 0 ) );
+	deviceBackend->enumerateObjects( objectInstances );
+	delete deviceBackend;
+
+	RDI::DataFormat dataFormat = RDI::DataFormat::createMinimal( objectInstances );
+	if ( !CHECK( dataFormat.getDataSize()==sizeof(data) && dataFormat.getObjects().size()==2 ) )
+		return;
+	const RDI::DataFormat::ObjectFormat& axis = dataFormat.getObjects()[0];
+	const RDI::DataFormat::ObjectFormat& button = dataFormat.getObjects()[1];
+	RDI::DataFormat::writeState( data, axis, 65535 );
+	RDI::DataFormat::writeState( data, button, 0x80 );
+	CHECK( RDI::DataFormat::readState( data, axis )==65535 );
+	CHECK( RDI::DataFormat::readState( data, button )==0x80 );
+	RDI::DataFormat::writeState( data, button, 0 );
+	CHECK( RDI::DataFormat::readState( data, button )==0 );
+	CHECK( RDI::DataFormat::readState( data, axis )==65535 );
+}
+
+}
+
+void testDataFormat()
+{
+	testLayout( 2, 6, 0 );		// A basic pad
+	testLayout( 6, 16, 1 );		// A gamepad
+	testLayout( 8, 128, 4 );	// The largest device DIJOYSTATE2 can hold
+	testReadWriteState();
+}
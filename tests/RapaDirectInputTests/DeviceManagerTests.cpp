@@ -0,0 +1,194 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+#include "RDITime.h"
+
+/*
+	DeviceManager tests
+
+	Simulated devices are plugged and unplugged, and the DeviceManager 
+	updates its list from the DeviceChangeHints when it can, or falls back
+	on a full enumeration.
+*/
+namespace
+{
+
+// Fires whenever hints are queued, and passes them on
+class ScriptedHintTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	ScriptedHintTrigger() : mHasFired(false) {}
+
+	void			addHint( const RDI::DeviceChangeHint& hint )		{ mHints.push_back( hint ); }
+
+	virtual bool	enumerationNeeded()
+	{
+		// The first call fires without hints, like the other triggers do at startup
+		bool ret = !mHasFired || !mHints.empty();
+		mHasFired = true;
+		return ret;
+	}
+	virtual bool	getChangeHints( RDI::DeviceChangeHints& hints )
+	{
+		hints.insert( hints.end(), mHints.begin(), mHints.end() );
+		bool ret = !mHints.empty();
+		mHints.clear();
+		return ret;
+	}
+
+private:
+	bool					mHasFired;
+	RDI::DeviceChangeHints	mHints;
+};
+
+class FakeClock : public RDI::Clock
+{
+public:
+	FakeClock() : mTime(0) {}
+	virtual unsigned int getTimeAsMilliseconds()	{ return mTime; }
+	unsigned int	mTime;
+};
+
+void testApplyChangeHints()
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<3; ++i )
+		backend.addDevice( "Test Pad", 2, 2, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==3 ) )
+		return;
+
+	RDI::DeviceChangeHints hints( 1 );
+	hints[0].devicePath = RDI::SimulatedBackend::createDevicePath( 1 );
+	for ( unsigned int i=0; i<10; ++i )
+	{
+		if ( backend.isDeviceConnected( 1 ) )
+		{
+			backend.disconnectDevice( 1 );
+			hints[0].type = RDI::DeviceChangeHint::Removal;
+		}
+		else
+		{
+			backend.connectDevice( 1 );
+			hints[0].type = RDI::DeviceChangeHint::Arrival;
+		}
+		CHECK( deviceManager.applyChangeHints( hints ) );
+		CHECK( deviceManager.getDevices().size()==(backend.isDeviceConnected( 1 ) ? 3u : 2u) );
+	}
+	CHECK( deviceManager.getNumTargetedUpdates()==10 );
+
+	// A device the backend doesn't know can't be added from its hint
+	hints[0] = RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, "USB#UnknownDevice" );
+	CHECK( !deviceManager.applyChangeHints( hints ) );
+}
+
+// The hints that can't be applied make update() fall back on an enumeration
+void testFallback()
+{
+	const unsigned int numDevices = 3;
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+		backend.addDevice( "Test Pad", 2, 2, 0 );
+	ScriptedHintTrigger* trigger = new ScriptedHintTrigger();
+	RDI::DeviceManager deviceManager( &backend, trigger );
+	deviceManager.update();
+	CHECK( deviceManager.getDevices().size()==numDevices );
+	CHECK( deviceManager.getNumEnumerations()==1 );
+
+	const unsigned int numNotifications = 40;
+	for ( unsigned int i=0; i<numNotifications; ++i )
+	{
+		if ( i%4==3 )
+		{
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, "USB#UnknownDevice" ) );
+		}
+		else if ( backend.isDeviceConnected( 0 ) )
+		{
+			backend.disconnectDevice( 0 );
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Removal, RDI::SimulatedBackend::createDevicePath(0) ) );
+		}
+		else
+		{
+			backend.connectDevice( 0 );
+			trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, RDI::SimulatedBackend::createDevicePath(0) ) );
+		}
+		deviceManager.update();
+		std::size_t numConnectedDevices = backend.isDeviceConnected( 0 ) ? numDevices : numDevices - 1;
+		CHECK( deviceManager.getDevices().size()==numConnectedDevices );
+	}
+	CHECK( deviceManager.getNumTargetedUpdates()==numNotifications / 4 * 3 );
+	CHECK( deviceManager.getNumEnumerations()==1 + numNotifications / 4 );
+}
+
+// The hints of a burst get through a DebouncedEnumerationTrigger
+void testDebouncedHints()
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<4; ++i )
+		backend.addDevice( "Test Pad", 2, 2, 0, false );
+	FakeClock clock;
+	ScriptedHintTrigger* trigger = new ScriptedHintTrigger();
+	RDI::DebouncedEnumerationTrigger::Settings settings;
+	RDI::DeviceManager deviceManager( &backend, new RDI::DebouncedEnumerationTrigger( trigger, settings, &clock ) );
+	deviceManager.update();
+	CHECK( deviceManager.getDevices().empty() );
+	CHECK( deviceManager.getNumEnumerations()==1 );
+
+	// A hub with 4 pads, plugged in after the startup enumeration
+	clock.mTime = settings.minIntervalInMs;
+	for ( unsigned int i=0; i<4; ++i )
+	{
+		backend.connectDevice( i );
+		trigger->addHint( RDI::DeviceChangeHint( RDI::DeviceChangeHint::Arrival, RDI::SimulatedBackend::createDevicePath(i) ) );
+		deviceManager.update();
+		clock.mTime += 10;
+	}
+	CHECK( deviceManager.getDevices().empty() );
+	clock.mTime += settings.settleWindowInMs;
+	deviceManager.update();
+	CHECK( deviceManager.getDevices().size()==4 );
+	CHECK( deviceManager.getNumTargetedUpdates()==1 );
+	CHECK( deviceManager.getNumEnumerations()==1 );
+
+	// The safety enumeration has no hints
+	clock.mTime += settings.safetyIntervalInMs;
+	deviceManager.update();
+	CHECK( deviceManager.getNumTargetedUpdates()==1 );
+	CHECK( deviceManager.getNumEnumerations()==2 );
+}
+
+}
+
+void testDeviceManager()
+{
+	testApplyChangeHints();
+	testFallback();
+	testDebouncedHints();
+}
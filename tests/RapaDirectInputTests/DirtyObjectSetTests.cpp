@@ -0,0 +1,116 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIDirtyObjectSet.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	DirtyObjectSet tests
+
+	The marks of a DirtyObjectSet on both sides of the 32-bit and 64-bit 
+	boundaries, and a set registered on a Device.
+*/
+namespace
+{
+
+void testMarks()
+{
+	RDI::DirtyObjectSet dirtyObjectSet( 130 );
+	RDI::DirtyObjects dirtyObjects;
+	dirtyObjectSet.fetchAndClear( dirtyObjects );
+	CHECK( dirtyObjects.isEmpty() );
+	CHECK( dirtyObjects.findFirst()==RDI::DirtyObjects::npos );
+
+	const unsigned int objectIndices[] = { 0, 31, 32, 63, 64, 100, 129 };
+	const unsigned int numObjectIndices = sizeof(objectIndices)/sizeof(objectIndices[0]);
+	for ( unsigned int i=0; i<numObjectIndices; ++i )
+		dirtyObjectSet.markDirty( objectIndices[i] );
+	dirtyObjectSet.markDirty( 31 );
+	dirtyObjectSet.fetchAndClear( dirtyObjects );
+	CHECK( dirtyObjects.getCount()==numObjectIndices );
+	CHECK( !dirtyObjects.contains( 1 ) );
+	CHECK( dirtyObjects.contains( 129 ) );
+
+	unsigned int i = 0;
+	for ( unsigned int objectIndex=dirtyObjects.findFirst(); objectIndex!=RDI::DirtyObjects::npos; objectIndex=dirtyObjects.findNext(objectIndex) )
+	{
+		if ( !CHECK( i<numObjectIndices ) )
+			break;
+		CHECK( objectIndex==objectIndices[i] );
+		++i;
+	}
+	CHECK( i==numObjectIndices );
+
+	// The marks were cleared by the fetch
+	dirtyObjectSet.fetchAndClear( dirtyObjects );
+	CHECK( dirtyObjects.isEmpty() );
+}
+
+// Removing the listeners of a Device keeps its DirtyObjectSets and BatchListeners
+class NullBatchListener : public RDI::Device::BatchListener
+{
+public:
+	virtual void onObjectsChanged( RDI::Device* /*device*/, const RDI::ObjectChange* /*changes*/, std::size_t /*numChanges*/ ) {}
+};
+
+void testDevice()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 4, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	RDI::DirtyObjectSet dirtyObjectSet( device->getObjects().size() );
+	NullBatchListener batchListener;
+	device->addDirtyObjectSet( &dirtyObjectSet );
+	device->addBatchListener( &batchListener );
+	device->removeListeners();
+
+	backend.setObjectData( 0, 1, 1000 );
+	backend.setObjectData( 0, 3, 0x80 );
+	backend.advance( 1 );
+	device->update();
+	RDI::DirtyObjects dirtyObjects;
+	dirtyObjectSet.fetchAndClear( dirtyObjects );
+	CHECK( dirtyObjects.getCount()==2 );
+	CHECK( dirtyObjects.contains( 1 ) );
+	CHECK( dirtyObjects.contains( 3 ) );
+
+	CHECK( device->removeBatchListener( &batchListener ) );
+	CHECK( device->removeDirtyObjectSet( &dirtyObjectSet ) );
+}
+
+}
+
+void testDirtyObjectSet()
+{
+	testMarks();
+	testDevice();
+}
@@ -0,0 +1,328 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDITime.h"
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+/*
+	EnumerationTrigger tests
+
+	Scripted notifications go through a DebouncedEnumerationTrigger driven 
+	by a fake clock, one call per frame. On Linux, files are created in and
+	deleted from a temporary directory watched by an InotifyEnumerationTrigger.
+*/
+namespace
+{
+
+const unsigned int frameInMs = 16;
+
+class FakeClock : public RDI::Clock
+{
+public:
+	FakeClock() : mTime(0) {}
+	virtual unsigned int getTimeAsMilliseconds()	{ return mTime; }
+	unsigned int	mTime;
+};
+
+// Fires on the first call, like the other triggers do at startup, then at 
+// the scripted times (in ms), once per call at most for each of them
+class ScriptedTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	ScriptedTrigger( FakeClock* clock ) : mClock(clock), mHasFired(false), mNext(0) {}
+	void addTime( unsigned int time )		{ mTimes.push_back( time ); }
+	virtual bool enumerationNeeded()
+	{
+		if ( !mHasFired )
+		{
+			mHasFired = true;
+			return true;
+		}
+		if ( mNext<mTimes.size() && mTimes[mNext]<=mClock->mTime )
+		{
+			++mNext;
+			return true;
+		}
+		return false;
+	}
+	FakeClock*					mClock;
+	bool						mHasFired;
+	std::vector<unsigned int>	mTimes;
+	std::size_t					mNext;
+};
+
+// Returns the times of the enumerations between the two times
+std::vector<unsigned int> run( RDI::DeviceEnumerationTrigger& trigger, FakeClock& clock, unsigned int startTime, unsigned int endTime )
+{
+	std::vector<unsigned int> times;
+	for ( clock.mTime=startTime; clock.mTime<endTime; clock.mTime+=frameInMs )
+	{
+		if ( trigger.enumerationNeeded() )
+			times.push_back( clock.mTime );
+	}
+	return times;
+}
+
+RDI::DebouncedEnumerationTrigger::Settings createSettings()
+{
+	RDI::DebouncedEnumerationTrigger::Settings settings;
+	settings.settleWindowInMs = 250;
+	settings.maxDelayInMs = 2000;
+	settings.minIntervalInMs = 1000;
+	settings.safetyIntervalInMs = 0;
+	return settings;
+}
+
+// A burst of notifications results in a single enumeration, once it has settled
+void testBurst()
+{
+	FakeClock clock;
+	ScriptedTrigger* source = new ScriptedTrigger( &clock );
+	for ( unsigned int i=0; i<12; ++i )
+		source->addTime( 5000 + i * 20 );
+	RDI::DebouncedEnumerationTrigger trigger( source, createSettings(), &clock );
+
+	std::vector<unsigned int> times = run( trigger, clock, 0, 10000 );
+	if ( !CHECK( times.size()==2 ) )
+		return;
+	CHECK( times[0]==0 );		// At startup
+	CHECK( times[1]>=5220 + 250 && times[1]<5220 + 250 + frameInMs * 2 );
+	CHECK( trigger.getNumSourceTriggers()==13 );
+	CHECK( trigger.getNumAvoidedEnumerations()==11 );
+}
+
+// A source that only fires at startup avoids nothing
+void testIdleSource()
+{
+	FakeClock clock;
+	RDI::DebouncedEnumerationTrigger trigger( new ScriptedTrigger( &clock ), createSettings(), &clock );
+
+	std::vector<unsigned int> times = run( trigger, clock, 0, 10000 );
+	CHECK( times.size()==1 );
+	CHECK( trigger.getNumSourceTriggers()==1 );
+	CHECK( trigger.getNumAvoidedEnumerations()==0 );
+}
+
+// A source that never settles still gets its enumerations, no closer than the minimum interval
+void testFlakySource()
+{
+	FakeClock clock;
+	ScriptedTrigger* source = new ScriptedTrigger( &clock );
+	for ( unsigned int time=2000; time<7000; time+=100 )
+		source->addTime( time );
+	RDI::DebouncedEnumerationTrigger trigger( source, createSettings(), &clock );
+
+	std::vector<unsigned int> times = run( trigger, clock, 0, 10000 );
+	if ( !CHECK( times.size()>=3 ) )
+		return;
+	CHECK( times[1]>=2000 + 2000 && times[1]<2000 + 2000 + frameInMs );
+	for ( std::size_t i=1; i<times.size(); ++i )
+		CHECK( times[i] - times[i-1]>=1000 );
+	CHECK( times.back()>=7000 );
+}
+
+// Notifications right after an enumeration wait for the minimum interval
+void testRateLimit()
+{
+	FakeClock clock;
+	ScriptedTrigger* source = new ScriptedTrigger( &clock );
+	source->addTime( 16 );
+	RDI::DebouncedEnumerationTrigger trigger( source, createSettings(), &clock );
+
+	std::vector<unsigned int> times = run( trigger, clock, 0, 3000 );
+	if ( !CHECK( times.size()==2 ) )
+		return;
+	CHECK( times[1]>=1000 && times[1]<1000 + frameInMs );
+}
+
+// Without notification, an enumeration is done every safety interval
+void testSafetyEnumerations()
+{
+	FakeClock clock;
+	RDI::DebouncedEnumerationTrigger::Settings settings = createSettings();
+	settings.safetyIntervalInMs = 30000;
+	RDI::DebouncedEnumerationTrigger trigger( new ScriptedTrigger( &clock ), settings, &clock );
+
+	std::vector<unsigned int> times = run( trigger, clock, 0, 100000 );
+	CHECK( times.size()==4 );
+	CHECK( trigger.getNumSafetyEnumerations()==3 );
+	CHECK( trigger.getNumAvoidedEnumerations()==0 );
+}
+
+#ifdef __linux__
+bool createFile( const std::string& fileName )
+{
+	FILE* file = fopen( fileName.c_str(), "w" );
+	if ( !file )
+		return false;
+	fclose( file );
+	return true;
+}
+
+// Returns the number of files created
+unsigned int createFiles( const std::string& directory, const char* prefix, unsigned int numFiles )
+{
+	unsigned int numCreatedFiles = 0;
+	for ( unsigned int i=0; i<numFiles; ++i )
+	{
+		char fileName[32];
+		sprintf( fileName, "%s%u", prefix, i );
+		if ( createFile( directory + "/" + fileName ) )
+			++numCreatedFiles;
+	}
+	return numCreatedFiles;
+}
+
+void removeFiles( const std::string& directory, const char* prefix, unsigned int numFiles )
+{
+	for ( unsigned int i=0; i<numFiles; ++i )
+	{
+		char fileName[32];
+		sprintf( fileName, "%s%u", prefix, i );
+		remove( (directory + "/" + fileName).c_str() );
+	}
+}
+
+unsigned int getMaxQueuedEvents()
+{
+	unsigned int maxQueuedEvents = 0;
+	FILE* file = fopen( "/proc/sys/fs/inotify/max_queued_events", "r" );
+	if ( !file )
+		return 0;
+	if ( fscanf( file, "%u", &maxQueuedEvents )!=1 )
+		maxQueuedEvents = 0;
+	fclose( file );
+	return maxQueuedEvents;
+}
+
+void testInotify()
+{
+	char directoryName[] = "/tmp/RDIInotifyTestsXXXXXX";
+	if ( !CHECK( mkdtemp( directoryName )!=NULL ) )
+		return;
+	const std::string directory = directoryName;
+	const std::string fileName = directory + "/event0";
+
+	{
+		RDI::InotifyEnumerationTrigger trigger( directory );
+		if ( CHECK( trigger.isWatching() ) )
+		{
+			CHECK( trigger.getDirectory()==directory );
+
+			// At startup, then only when a file appears or disappears
+			CHECK( trigger.enumerationNeeded() );
+			CHECK( !trigger.enumerationNeeded() );
+			CHECK( createFile( fileName ) );
+			CHECK( trigger.enumerationNeeded() );
+			CHECK( !trigger.enumerationNeeded() );
+			CHECK( remove( fileName.c_str() )==0 );
+			CHECK( trigger.enumerationNeeded() );
+			CHECK( trigger.getNumEvents()==2 );
+
+			// Moved in and out
+			const std::string outsideFileName = directory + "_outside";
+			CHECK( createFile( outsideFileName ) );
+			CHECK( !trigger.enumerationNeeded() );
+			CHECK( rename( outsideFileName.c_str(), fileName.c_str() )==0 );
+			CHECK( trigger.enumerationNeeded() );
+			CHECK( rename( fileName.c_str(), outsideFileName.c_str() )==0 );
+			CHECK( trigger.enumerationNeeded() );
+			remove( outsideFileName.c_str() );
+
+			// A burst of events results in a single enumeration
+			CHECK( createFiles( directory, "event", 20 )==20 );
+			CHECK( trigger.enumerationNeeded() );
+			CHECK( !trigger.enumerationNeeded() );
+			CHECK( trigger.getNumEvents()==24 );
+			removeFiles( directory, "event", 20 );
+			CHECK( trigger.enumerationNeeded() );
+		}
+	}
+
+	// Filtered on the start of the names
+	{
+		RDI::InotifyEnumerationTrigger trigger( directory, "event" );
+		CHECK( trigger.enumerationNeeded() );
+		CHECK( createFiles( directory, "js", 3 )==3 );
+		CHECK( !trigger.enumerationNeeded() );
+		CHECK( createFile( fileName ) );
+		CHECK( trigger.enumerationNeeded() );
+		CHECK( trigger.getNumEvents()==1 );
+		removeFiles( directory, "js", 3 );
+		CHECK( !trigger.enumerationNeeded() );
+		CHECK( remove( fileName.c_str() )==0 );
+		CHECK( trigger.enumerationNeeded() );
+		CHECK( trigger.getNumEvents()==2 );
+	}
+
+	// When the queue overflows, the events are lost, including the ones that
+	// would pass the filter: an enumeration is needed even though none of the
+	// events received does
+	unsigned int maxQueuedEvents = getMaxQueuedEvents();
+	if ( maxQueuedEvents>0 && maxQueuedEvents<=65536 )
+	{
+		RDI::InotifyEnumerationTrigger trigger( directory, "event" );
+		CHECK( trigger.enumerationNeeded() );
+		unsigned int numFiles = maxQueuedEvents + 16;
+		CHECK( createFiles( directory, "other", numFiles )==numFiles );
+		CHECK( trigger.enumerationNeeded() );
+		CHECK( trigger.getNumEvents()==0 );
+		removeFiles( directory, "other", numFiles );
+	}
+
+	CHECK( rmdir( directory.c_str() )==0 );
+
+	// A directory that can't be watched: only the startup enumeration
+	{
+		RDI::InotifyEnumerationTrigger trigger( directory );
+		CHECK( !trigger.isWatching() );
+		CHECK( trigger.enumerationNeeded() );
+		CHECK( !trigger.enumerationNeeded() );
+		CHECK( trigger.getNumEvents()==0 );
+	}
+}
+#endif
+
+}
+
+void testEnumerationTrigger()
+{
+	testBurst();
+	testIdleSource();
+	testFlakySource();
+	testRateLimit();
+	testSafetyEnumerations();
+#ifdef __linux__
+	testInotify();
+#endif
+}
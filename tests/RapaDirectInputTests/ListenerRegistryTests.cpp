@@ -0,0 +1,156 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ListenerRegistry tests
+
+	A thread keeps adding and removing listeners of a Device while another 
+	one updates it. A listener must not be called once removeListener() has
+	returned, since it could have been destroyed by then. The listeners take
+	their time so the removals often happen in the middle of a dispatch.
+*/
+namespace
+{
+
+const unsigned int numRegistrations = 2000;
+
+class SlowListener : public RDI::Device::Listener
+{
+public:
+	SlowListener( std::atomic<unsigned int>& numLateCalls ) 
+		: mNumLateCalls(numLateCalls), 
+		  mIsRemoved(false)
+	{
+	}
+
+	virtual ~SlowListener()
+	{
+	}
+
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* /*object*/ )
+	{
+		// Still running once removed is as bad as being called once removed
+		std::this_thread::sleep_for( std::chrono::microseconds(5) );
+		if ( mIsRemoved )
+			++mNumLateCalls;
+	}
+
+	std::atomic<unsigned int>&	mNumLateCalls;
+	std::atomic<bool>			mIsRemoved;
+};
+
+// Removes itself from within its notification, which must not wait for the update in progress
+class SelfRemovingListener : public RDI::Device::Listener
+{
+public:
+	SelfRemovingListener() : mNumCalls(0) {}
+	virtual void onObjectChanged( RDI::Device* device, RDI::Object* /*object*/ )
+	{
+		++mNumCalls;
+		device->removeListener( this );
+	}
+	unsigned int mNumCalls;
+};
+
+void testConcurrentRegistration()
+{
+	RDI::SimulatedBackend backend;
+	unsigned int deviceIndex = backend.addDevice( "Test Pad", 6, 16, 1 );
+	backend.addGenerator( deviceIndex, RDI::SimulatedGenerator::randomWalk(4000, 64) );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	std::atomic<bool> stopRequested( false );
+	std::thread updateThread( [&]() 
+		{
+			while ( !stopRequested )
+			{
+				backend.advance( 1 );
+				device->update();
+				std::this_thread::sleep_for( std::chrono::microseconds(10) );
+			}
+		} );
+
+	std::atomic<unsigned int> numLateCalls( 0 );
+	for ( unsigned int i=0; i<numRegistrations; ++i )
+	{
+		SlowListener* listener = new SlowListener( numLateCalls );
+		device->addListener( listener );
+		std::this_thread::sleep_for( std::chrono::microseconds(i % 50) );
+		CHECK( device->removeListener( listener ) );
+		listener->mIsRemoved = true;
+		std::this_thread::sleep_for( std::chrono::microseconds(20) );
+		delete listener;
+	}
+
+	stopRequested = true;
+	updateThread.join();
+	CHECK( numLateCalls==0 );
+}
+
+void testRemovalFromNotification()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 0, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+
+	SelfRemovingListener listener;
+	device->addListener( &listener );
+	backend.setObjectData( 0, 0, 100 );
+	backend.setObjectData( 0, 1, 100 );
+	backend.advance( 1 );
+	device->update();
+
+	// Removed during the first call
+	unsigned int numCalls = listener.mNumCalls;
+	CHECK( numCalls>=1 );
+	backend.setObjectData( 0, 0, 200 );
+	backend.advance( 1 );
+	device->update();
+	CHECK( listener.mNumCalls==numCalls );
+}
+
+}
+
+void testListenerRegistry()
+{
+	testConcurrentRegistration();
+	testRemovalFromNotification();
+}
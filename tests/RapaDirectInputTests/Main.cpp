@@ -0,0 +1,113 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <cstddef>
+#include <stdio.h>
+#include <string.h>
+
+/*
+	Usage: RapaDirectInputTests [options]
+	  --test <name>          Only run the test with this name (as ctest does)
+	  --filter <text>        Only run the tests whose name contains the text
+	Returns 0 if all the checks passed
+*/
+namespace
+{
+
+struct Test
+{
+	const char*		name;
+	void			(*run)();
+};
+
+const Test tests[] =
+{
+	{ "AsyncListener",		testAsyncListener },
+	{ "AxisFilter",			testAxisFilter },
+	{ "ButtonDebouncer",	testButtonDebouncer },
+	{ "DataFormat",			testDataFormat },
+	{ "DeviceManager",		testDeviceManager },
+	{ "DirtyObjectSet",		testDirtyObjectSet },
+	{ "EnumerationTrigger",	testEnumerationTrigger },
+	{ "ListenerRegistry",	testListenerRegistry },
+	{ "ObjectEnable",		testObjectEnable },
+	{ "PollScheduler",		testPollScheduler },
+	{ "Reacquire",			testReacquire },
+	{ "Recording",			testRecording },
+	{ "Resync",				testResync },
+	{ "ThrottledListener",	testThrottledListener }
+};
+
+}
+
+int main( int argc, char** argv )
+{
+	const char* name = NULL;
+	const char* filter = NULL;
+	for ( int i=1; i<argc; ++i )
+	{
+		const char* option = argv[i];
+		const char* value = i+1<argc ? argv[i+1] : NULL;
+		bool ret = value!=NULL;
+		if ( ret && strcmp(option, "--test")==0 )
+			name = value;
+		else if ( ret && strcmp(option, "--filter")==0 )
+			filter = value;
+		else
+			ret = false;
+
+		if ( !ret )
+		{
+			printf( "Usage: %s [--test <name>] [--filter <text>]\n", argv[0] );
+			return 1;
+		}
+		++i;
+	}
+
+	unsigned int numTests = 0;
+	unsigned int numFailedTests = 0;
+	for ( std::size_t i=0; i<sizeof(tests)/sizeof(tests[0]); ++i )
+	{
+		const Test& test = tests[i];
+		if ( (name && strcmp( test.name, name )!=0) || (filter && !strstr( test.name, filter )) )
+			continue;
+
+		unsigned int numFailedChecks = getNumFailedChecks();
+		test.run();
+		bool hasPassed = getNumFailedChecks()==numFailedChecks;
+		printf( "%-24s %s\n", test.name, hasPassed ? "passed" : "FAILED" );
+		++numTests;
+		if ( !hasPassed )
+			++numFailedTests;
+	}
+
+	if ( numTests==0 )
+	{
+		printf( "No test to run\n" );
+		return 1;
+	}
+	printf( "%u of %u tests passed\n", numTests - numFailedTests, numTests );
+	return numFailedTests==0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIAxis.h"
+#include "RDIButton.h"
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ObjectEnable tests
+
+	The objects of a simulated device are disabled and enabled again, some 
+	of them filtered or debounced. A disabled object must not change nor be
+	notified, and gets its current state back once enabled again. That's
+	also the case with a backend that supports neither the DataFormats nor
+	the removal of the user data of the objects.
+*/
+namespace
+{
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener( std::size_t numObjects ) : mNumChanges(numObjects, 0), mNumDisabledChanges(0) {}
+	virtual void onObjectChanged( RDI::Device* device, RDI::Object* object )
+	{
+		++mNumChanges[device->getCurrentChange().objectIndex];
+		if ( !object->isEnabled() )
+			++mNumDisabledChanges;
+	}
+	void reset()
+	{
+		mNumChanges.assign( mNumChanges.size(), 0 );
+	}
+	std::vector<unsigned int>	mNumChanges;			// One per Object
+	unsigned int				mNumDisabledChanges;
+};
+
+// Like an old backend: the DataFormats are rejected and the user data of an
+// object can't be cleared
+class LegacyDeviceBackend : public RDI::DeviceBackend
+{
+public:
+	LegacyDeviceBackend( RDI::DeviceBackend* deviceBackend ) : mDeviceBackend(deviceBackend) {}
+	virtual ~LegacyDeviceBackend()		{ delete mDeviceBackend; }
+	virtual bool setBufferSize( DWORD numEntries )									{ return mDeviceBackend->setBufferSize( numEntries ); }
+	virtual bool enumerateObjects( RDI::ObjectInstances& objectInstances )			{ return mDeviceBackend->enumerateObjects( objectInstances ); }
+	virtual bool getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue )	{ return mDeviceBackend->getAxisRange( objectType, minValue, maxValue ); }
+	virtual bool setObjectUserData( DWORD objectType, UINT_PTR userData )
+	{
+		return userData!=0xFFFFFFFF && mDeviceBackend->setObjectUserData( objectType, userData );
+	}
+	virtual HRESULT acquire()														{ return mDeviceBackend->acquire(); }
+	virtual void unacquire()														{ mDeviceBackend->unacquire(); }
+	virtual HRESULT getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )	{ return mDeviceBackend->getDeviceData( dataEntries, numDataEntries ); }
+	RDI::DeviceBackend*		mDeviceBackend;
+};
+
+class LegacyBackend : public RDI::Backend
+{
+public:
+	LegacyBackend( RDI::SimulatedBackend* backend ) : mBackend(backend) {}
+	virtual void enumerateDevices( RDI::DeviceIdentifiers& deviceInstances )		{ mBackend->enumerateDevices( deviceInstances ); }
+	virtual RDI::DeviceBackend* createDeviceBackend( const RDI::DeviceInstance& deviceInstance )
+	{
+		return new LegacyDeviceBackend( mBackend->createDeviceBackend( deviceInstance ) );
+	}
+	virtual DWORD getTickCount()													{ return mBackend->getTickCount(); }
+	RDI::SimulatedBackend*	mBackend;
+};
+
+void update( RDI::SimulatedBackend& backend, RDI::Device* device, DWORD timeInMs )
+{
+	for ( DWORD time=0; time<timeInMs; time+=4 )
+	{
+		backend.advance( 4 );
+		device->update();
+	}
+}
+
+// A filtered axis and a debounced button, disabled while their filter and 
+// debouncer are still busy
+void testFilteredObjects()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 2, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	RDI::Axis* axis = static_cast<RDI::Axis*>( device->getObjects()[0] );
+	RDI::Button* button = static_cast<RDI::Button*>( device->getObjects()[2] );
+	device->setAxisFilter( axis, RDI::AxisFilter::lowPass( 2.f ) );
+	device->setButtonDebounce( button, 10, RDI::ButtonDebouncer::TrailingEdge );
+	CountingListener listener( device->getObjects().size() );
+	device->addListener( &listener );
+
+	backend.setObjectData( 0, 0, 60000 );
+	backend.setObjectData( 0, 2, 0x80 );
+	update( backend, device, 4 );
+	CHECK( button->getDebouncer().isPending() );
+	LONG value = axis->getValue();
+	CHECK( value<60000 );
+
+	CHECK( device->setObjectEnabled( axis, false ) );
+	CHECK( device->setObjectEnabled( button, false ) );
+	CHECK( device->getNumEnabledObjects()==2 );
+	listener.reset();
+	update( backend, device, 500 );
+	CHECK( listener.mNumChanges[0]==0 );
+	CHECK( listener.mNumChanges[2]==0 );
+	CHECK( axis->getValue()==value );
+	CHECK( !button->isPressed() );
+	CHECK( !button->getDebouncer().isPending() );
+
+	// The events of the disabled objects are skipped
+	backend.setObjectData( 0, 0, 30000 );
+	backend.setObjectData( 0, 3, 0x80 );
+	update( backend, device, 20 );
+	CHECK( listener.mNumChanges[0]==0 );
+	CHECK( listener.mNumChanges[3]==1 );
+
+	// Enabled again, they catch up with the state of the device
+	CHECK( device->setObjectEnabled( axis, true ) );
+	CHECK( device->setObjectEnabled( button, true ) );
+	update( backend, device, 2000 );
+	CHECK( listener.mNumChanges[0]>0 );
+	CHECK( listener.mNumChanges[2]==1 );
+	CHECK( axis->getValue()>29000 && axis->getValue()<31000 );
+	CHECK( button->isPressed() );
+	CHECK( listener.mNumDisabledChanges==0 );
+	device->removeListeners();
+}
+
+// A busy wheel with most of its objects disabled, filtered and debounced
+void testBusyDevice()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Wheel", 6, 30, 1 );
+	backend.addGenerator( 0, RDI::SimulatedGenerator::buttonStorm( 1500.f ) );
+	backend.addGenerator( 0, RDI::SimulatedGenerator::randomWalk( 4500.f, 100 ) );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	const RDI::Objects& objects = device->getObjects();
+	for ( std::size_t i=0; i<objects.size(); ++i )
+	{
+		if ( objects[i]->getObjectInstance().isAxis() )
+			device->setAxisFilter( static_cast<RDI::Axis*>( objects[i] ), RDI::AxisFilter::oneEuro( 1.f, 0.5f ) );
+	}
+	device->setButtonDebounce( 5, RDI::ButtonDebouncer::LeadingEdge );
+
+	// The objects come in the order of the layout: the axes, then the buttons
+	std::vector<unsigned int> objectIndices;
+	objectIndices.push_back( 0 );
+	for ( unsigned int i=6; i<12; ++i )
+		objectIndices.push_back( i );
+	device->setEnabledObjects( RDI::ObjectFilter::objects( objectIndices ) );
+	CHECK( device->getNumEnabledObjects()==objectIndices.size() );
+
+	CountingListener listener( objects.size() );
+	device->addListener( &listener );
+	update( backend, device, 2000 );
+	CHECK( listener.mNumDisabledChanges==0 );
+	unsigned int numChanges = 0;
+	for ( std::size_t i=0; i<objectIndices.size(); ++i )
+		numChanges += listener.mNumChanges[objectIndices[i]];
+	CHECK( numChanges>0 );
+
+	// Everything disabled
+	device->setEnabledObjects( RDI::ObjectFilter::types( 0 ) );
+	CHECK( device->getNumEnabledObjects()==0 );
+	update( backend, device, 500 );
+	CHECK( listener.mNumDisabledChanges==0 );
+	device->removeListeners();
+}
+
+// The disabled objects of a legacy backend still report events
+void testLegacyBackend()
+{
+	RDI::SimulatedBackend simulatedBackend;
+	simulatedBackend.addDevice( "Test Pad", 2, 2, 0 );
+	LegacyBackend backend( &simulatedBackend );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&simulatedBackend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	RDI::Button* button = static_cast<RDI::Button*>( device->getObjects()[2] );
+	CountingListener listener( device->getObjects().size() );
+	device->addListener( &listener );
+
+	CHECK( device->setObjectEnabled( button, false ) );
+	simulatedBackend.setObjectData( 0, 2, 0x80 );
+	simulatedBackend.setObjectData( 0, 3, 0x80 );
+	update( simulatedBackend, device, 20 );
+	CHECK( !button->isPressed() );
+	CHECK( listener.mNumChanges[2]==0 );
+	CHECK( listener.mNumChanges[3]==1 );
+	CHECK( listener.mNumDisabledChanges==0 );
+	device->removeListeners();
+}
+
+}
+
+void testObjectEnable()
+{
+	testFilteredObjects();
+	testBusyDevice();
+	testLegacyBackend();
+}
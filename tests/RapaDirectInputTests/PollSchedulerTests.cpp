@@ -0,0 +1,168 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <algorithm>
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIPollScheduler.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	PollScheduler tests
+
+	The idle backoff of a PollScheduler, and the order of the devices when 
+	the budget only allows a few polls per update. The budget is simulated
+	by polling a fixed number of devices from the schedule.
+*/
+namespace
+{
+
+RDI::PollScheduler::Settings createSettings( unsigned int idleUpdates, unsigned int maxPollInterval, unsigned int budgetInUs )
+{
+	RDI::PollScheduler::Settings settings;
+	settings.idleUpdates = idleUpdates;
+	settings.maxPollInterval = maxPollInterval;
+	settings.budgetInUs = budgetInUs;
+	return settings;
+}
+
+// Polls the first numPolls devices of the schedule, all active but the idle one.
+// Returns the number of updates since the idle device was last polled, at worst
+unsigned int runUpdates( RDI::PollScheduler& scheduler, unsigned int idleDevice, unsigned int numUpdates, unsigned int numPolls, std::vector<unsigned int>& numDevicePolls )
+{
+	unsigned int numWaitingUpdates = 0;
+	unsigned int maxWaitingUpdates = 0;
+	for ( unsigned int i=0; i<numUpdates; ++i )
+	{
+		const std::vector<unsigned int>& schedule = scheduler.schedule();
+		++numWaitingUpdates;
+		for ( std::size_t j=0; j<schedule.size() && j<numPolls; ++j )
+		{
+			unsigned int deviceIndex = schedule[j];
+			scheduler.onPolled( deviceIndex, deviceIndex!=idleDevice );
+			++numDevicePolls[deviceIndex];
+			if ( deviceIndex==idleDevice )
+			{
+				maxWaitingUpdates = std::max( maxWaitingUpdates, numWaitingUpdates );
+				numWaitingUpdates = 0;
+			}
+		}
+	}
+	return std::max( maxWaitingUpdates, numWaitingUpdates );
+}
+
+void testIdleBackoff()
+{
+	RDI::PollScheduler scheduler( createSettings( 4, 8, 0 ) );
+	scheduler.addDevice();
+	scheduler.addDevice();
+	std::vector<unsigned int> numDevicePolls( 2, 0 );
+	runUpdates( scheduler, 1, 100, 2, numDevicePolls );
+	CHECK( scheduler.getPollInterval( 0 )==1 );
+	CHECK( scheduler.getPollInterval( 1 )==8 );
+	CHECK( numDevicePolls[0]==100 );
+	CHECK( numDevicePolls[1]<100/4 );
+
+	// Back at full rate as soon as a poll finds some activity
+	const std::vector<unsigned int>& schedule = scheduler.schedule();
+	for ( std::size_t i=0; i<schedule.size(); ++i )
+		scheduler.onPolled( schedule[i], true );
+	for ( unsigned int i=0; i<8 && scheduler.getPollInterval( 1 )!=1; ++i )
+	{
+		const std::vector<unsigned int>& nextSchedule = scheduler.schedule();
+		for ( std::size_t j=0; j<nextSchedule.size(); ++j )
+			scheduler.onPolled( nextSchedule[j], true );
+	}
+	CHECK( scheduler.getPollInterval( 1 )==1 );
+}
+
+// One poll per update for 5 devices: the active devices are polled in turn,
+// and the idle one isn't starved by them
+void testTightBudget()
+{
+	const unsigned int numDevices = 5;
+	const unsigned int idleDevice = 2;
+	const unsigned int maxPollInterval = 8;
+	RDI::PollScheduler scheduler( createSettings( 1, maxPollInterval, 1 ) );
+	for ( unsigned int i=0; i<numDevices; ++i )
+		scheduler.addDevice();
+
+	std::vector<unsigned int> numDevicePolls( numDevices, 0 );
+	unsigned int maxWaitingUpdates = runUpdates( scheduler, idleDevice, 1000, 1, numDevicePolls );
+	CHECK( scheduler.getPollInterval( idleDevice )==maxPollInterval );
+	CHECK( numDevicePolls[idleDevice]>0 );
+	CHECK( maxWaitingUpdates<=maxPollInterval * numDevices );
+	for ( unsigned int i=0; i<numDevices; ++i )
+	{
+		if ( i!=idleDevice )
+			CHECK( numDevicePolls[i]>=1000 / numDevices );
+	}
+}
+
+// Through the DeviceManager, an idle device that starts being used is polled at full rate again
+void testSnapBack()
+{
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<4; ++i )
+		backend.addDevice( "Test Pad", 2, 2, 0 );
+	backend.addGenerator( 0, RDI::SimulatedGenerator::randomWalk( 500.f, 300 ) );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.setPollSettings( createSettings( 10, 8, 0 ) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==4 ) )
+		return;
+	for ( unsigned int i=0; i<100; ++i )
+	{
+		backend.advance( 16 );
+		deviceManager.update();
+	}
+	const RDI::PollScheduler& scheduler = deviceManager.getPollScheduler();
+	CHECK( scheduler.getPollInterval( 0 )==1 );
+	CHECK( scheduler.getPollInterval( 1 )==8 );
+
+	const RDI::Object* object = deviceManager.getDevices()[1].second->getObjects()[0];
+	backend.setObjectData( 1, 0, 1000 );
+	unsigned int numUpdates = 0;
+	while ( object->getData()!=1000 && numUpdates<100 )
+	{
+		backend.advance( 16 );
+		deviceManager.update();
+		++numUpdates;
+	}
+	CHECK( numUpdates<=8 );
+	CHECK( scheduler.getPollInterval( 1 )==1 );
+	CHECK( backend.getNumLostEvents()==0 );
+}
+
+}
+
+void testPollScheduler()
+{
+	testIdleBackoff();
+	testTightBudget();
+	testSnapBack();
+}
@@ -0,0 +1,203 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <algorithm>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Reacquire tests
+
+	The delays of a ReacquireBackoff are checked on their own, then simulated 
+	devices are held by another application or unplugged (but left in the 
+	device list) and must be reacquired within maxDelay once they come back,
+	without any call to their backend while they back off.
+*/
+namespace
+{
+
+// Only fires for the enumeration at startup
+class StartupTrigger : public RDI::DeviceEnumerationTrigger
+{
+public:
+	StartupTrigger() : mHasFired(false) {}
+	virtual bool enumerationNeeded()
+	{
+		bool ret = !mHasFired;
+		mHasFired = true;
+		return ret;
+	}
+	bool mHasFired;
+};
+
+void testBackoff()
+{
+	RDI::ReacquireBackoff::Settings settings;
+	settings.minDelayInMs = 50;
+	settings.maxDelayInMs = 1000;
+	settings.jitterPercent = 0;
+	RDI::ReacquireBackoff backoff;
+	backoff.setSettings( settings );
+	CHECK( !backoff.isBackingOff() );
+	CHECK( backoff.isAttemptDue( 0 ) );
+
+	// The delay doubles up to maxDelay
+	DWORD time = 0;
+	DWORD expectedDelays[] = { 50, 100, 200, 400, 800, 1000, 1000 };
+	for ( std::size_t i=0; i<sizeof(expectedDelays)/sizeof(expectedDelays[0]); ++i )
+	{
+		backoff.onAttempt( false, time );
+		CHECK( backoff.isBackingOff() );
+		CHECK( backoff.getDelay()==expectedDelays[i] );
+		CHECK( backoff.getNextAttemptTime()==time + expectedDelays[i] );
+		CHECK( !backoff.isAttemptDue( time + expectedDelays[i] - 1 ) );
+		CHECK( backoff.isAttemptDue( time + expectedDelays[i] ) );
+		time += expectedDelays[i];
+	}
+	CHECK( backoff.getNumAttempts()==7 );
+	CHECK( backoff.getNumFailures()==7 );
+
+	// A success starts over from minDelay
+	backoff.onAttempt( true, time );
+	CHECK( !backoff.isBackingOff() );
+	CHECK( backoff.isAttemptDue( time ) );
+	backoff.onAttempt( false, time );
+	CHECK( backoff.getDelay()==50 );
+
+	// The jitter only shortens the delay
+	settings.jitterPercent = 25;
+	RDI::ReacquireBackoff jitteredBackoff( 1234 );
+	jitteredBackoff.setSettings( settings );
+	time = 0;
+	for ( unsigned int i=0; i<100; ++i )
+	{
+		jitteredBackoff.onAttempt( false, time );
+		DWORD delay = jitteredBackoff.getNextAttemptTime() - time;
+		CHECK( delay<=jitteredBackoff.getDelay() );
+		CHECK( delay>=jitteredBackoff.getDelay() - jitteredBackoff.getDelay() / 4 );
+		time = jitteredBackoff.getNextAttemptTime();
+	}
+
+	// Without minDelay, an attempt is always due
+	settings.minDelayInMs = 0;
+	RDI::ReacquireBackoff eagerBackoff;
+	eagerBackoff.setSettings( settings );
+	eagerBackoff.onAttempt( false, 0 );
+	CHECK( eagerBackoff.isBackingOff() );
+	CHECK( eagerBackoff.isAttemptDue( 0 ) );
+
+	// The settings are sanitized
+	settings.minDelayInMs = 500;
+	settings.maxDelayInMs = 100;
+	settings.jitterPercent = 150;
+	backoff.setSettings( settings );
+	CHECK( backoff.getSettings().maxDelayInMs==500 );
+	CHECK( backoff.getSettings().jitterPercent==100 );
+}
+
+// Device 0 is held by another application and device 1 unplugged, from 
+// 1 s to 5 s. Device 2 stays available
+void testOutages( const RDI::ReacquireBackoff::Settings& settings )
+{
+	const DWORD frameInMs = 16;
+	const DWORD startTime = 1000;
+	const DWORD endTime = 5000;
+
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<3; ++i )
+		backend.addDevice( "Test Pad", 2, 4, 0 );
+	RDI::DeviceManager deviceManager( &backend, new StartupTrigger() );
+	deviceManager.update();
+	const RDI::DeviceManager::DeviceList& devices = deviceManager.getDevices();
+	if ( !CHECK( devices.size()==3 ) )
+		return;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+		devices[i].second->setReacquireSettings( settings );
+
+	unsigned long long int numCallsDuringOutage = 0;
+	DWORD reacquireTimes[2] = { 0, 0 };
+	for ( DWORD time=0; time<8000; time+=frameInMs )
+	{
+		backend.advance( frameInMs );
+		bool isOut = backend.getTime()>=startTime && backend.getTime()<endTime;
+		backend.holdDevice( 0, isOut );
+		if ( isOut==backend.isDeviceConnected( 1 ) )
+		{
+			if ( isOut )
+				backend.disconnectDevice( 1 );
+			else
+				backend.connectDevice( 1 );
+		}
+
+		unsigned long long int numCalls = backend.getNumAcquireCalls() + backend.getNumDeviceDataCalls();
+		deviceManager.update();
+		if ( isOut )
+			numCallsDuringOutage += backend.getNumAcquireCalls() + backend.getNumDeviceDataCalls() - numCalls;
+
+		// A device is reacquired once it doesn't back off anymore
+		for ( unsigned int i=0; i<2; ++i )
+		{
+			if ( backend.getTime()>=endTime && reacquireTimes[i]==0 && !devices[i].second->getReacquireBackoff().isBackingOff() )
+				reacquireTimes[i] = backend.getTime();
+		}
+		CHECK( !devices[2].second->getReacquireBackoff().isBackingOff() );
+	}
+
+	// Both are reacquired within maxDelay (plus a frame)
+	DWORD maxReacquireTime = endTime + std::max<DWORD>( settings.maxDelayInMs, frameInMs ) + frameInMs;
+	for ( unsigned int i=0; i<2; ++i )
+	{
+		const RDI::ReacquireBackoff& backoff = devices[i].second->getReacquireBackoff();
+		CHECK( reacquireTimes[i]>0 && reacquireTimes[i]<=maxReacquireTime );
+		CHECK( backoff.getNumFailures()>0 );
+		if ( settings.minDelayInMs>0 )
+			CHECK( backoff.getNumSkippedPolls()>0 );
+		else
+			CHECK( backoff.getNumSkippedPolls()==0 );
+	}
+	CHECK( devices[2].second->getReacquireBackoff().getNumFailures()==0 );
+
+	// 250 updates during the outage, each polling the available device at 
+	// least. Every update also costs calls to the lost devices without backoff
+	unsigned long long int numUpdates = (endTime - startTime) / frameInMs;
+	if ( settings.minDelayInMs>0 )
+		CHECK( numCallsDuringOutage<numUpdates * 2 );
+	else
+		CHECK( numCallsDuringOutage>=numUpdates * 3 );
+}
+
+}
+
+void testReacquire()
+{
+	testBackoff();
+
+	RDI::ReacquireBackoff::Settings settings;
+	testOutages( settings );
+	settings.minDelayInMs = 0;
+	testOutages( settings );
+}
@@ -0,0 +1,171 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIMappedFile.h"
+#include "RDIRecorder.h"
+#include "RDIRecording.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Recording tests
+
+	Devices are connected, flooded with changes and disconnected right away 
+	through a RecordingWriter whose ring buffer is tiny, so many records are
+	dropped, the DeviceDisconnected ones included. The recording must still
+	be consistent when read back: every device ends up disconnected.
+
+	The events a Device processes in one update are recorded with the time
+	of their event, not the time they were processed.
+*/
+namespace
+{
+
+const char* fileName = "RDIRecordingTests.rdi";
+const unsigned int numDevices = 50;
+
+void testDroppedDisconnections()
+{
+	RDI::RecordedObjects objects;
+	RDI::SimulatedBackend::createObjects( 2, 2, 0, objects );
+
+	RDI::RecordingWriter writer( 256 );
+	if ( !CHECK( writer.open( fileName ) ) )
+		return;
+	for ( unsigned int i=0; i<numDevices; ++i )
+	{
+		// Let the writer thread drain the ring buffer, so the device gets described
+		std::this_thread::sleep_for( std::chrono::milliseconds(3) );
+		RDI::DeviceInstance deviceInstance = RDI::SimulatedBackend::createDeviceInstance( "Test Pad", i );
+		unsigned int deviceId = writer.addDevice( deviceInstance, objects );
+		CHECK( deviceId==i );
+		for ( DWORD data=0; data<200; ++data )
+			writer.changeObject( deviceId, data % 2, data * 100, data );
+		writer.removeDevice( deviceId );
+	}
+	CHECK( writer.getNumDroppedRecords()>0 );
+	writer.close();
+	CHECK( !writer.hasWriteFailed() );
+
+	RDI::MappedFile file;
+	if ( !CHECK( file.open( fileName ) ) )
+		return;
+	RDI::RecordingReader reader;
+	if ( CHECK( reader.open( file.getData(), file.getSize() ) ) )
+	{
+		unsigned int numConnections = 0;
+		unsigned int numDisconnections = 0;
+		RDI::RecordingReader::Record record;
+		while ( reader.readRecord( record ) )
+		{
+			if ( record.type==RDI::Recording::DeviceConnected )
+				++numConnections;
+			else if ( record.type==RDI::Recording::DeviceDisconnected )
+				++numDisconnections;
+		}
+		CHECK( numConnections>0 );
+		CHECK( numDisconnections==numConnections );
+
+		const RDI::RecordedDevices& devices = reader.getDevices();
+		for ( std::size_t i=0; i<devices.size(); ++i )
+			CHECK( !devices[i].isConnected );
+	}
+	reader.close();
+	file.close();
+	remove( fileName );
+}
+
+// Returns the times of the ObjectChanged records
+std::vector<unsigned long long int> readChangeTimes()
+{
+	std::vector<unsigned long long int> times;
+	RDI::MappedFile file;
+	if ( !CHECK( file.open( fileName ) ) )
+		return times;
+	RDI::RecordingReader reader;
+	if ( CHECK( reader.open( file.getData(), file.getSize() ) ) )
+	{
+		RDI::RecordingReader::Record record;
+		while ( reader.readRecord( record ) )
+		{
+			if ( record.type==RDI::Recording::ObjectChanged )
+				times.push_back( record.time );
+		}
+	}
+	reader.close();
+	file.close();
+	return times;
+}
+
+void testEventTimes()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 2, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+
+	RDI::Recorder recorder( &deviceManager );
+	if ( !CHECK( recorder.start( fileName ) ) )
+		return;
+
+	// Three events processed by a single update
+	backend.advance( 16 );
+	backend.setObjectData( 0, 2, 0x80 );
+	backend.advance( 5 );
+	backend.setObjectData( 0, 3, 0x80 );
+	backend.advance( 32 );
+	backend.setObjectData( 0, 2, 0 );
+	backend.advance( 16 );
+	deviceManager.update();
+
+	// A time stamp far from the time of the recording maps it again
+	backend.advance( 60000 );
+	backend.setObjectData( 0, 3, 0 );
+	deviceManager.update();
+	recorder.stop();
+
+	std::vector<unsigned long long int> times = readChangeTimes();
+	if ( CHECK( times.size()==4 ) )
+	{
+		CHECK( times[1] - times[0]==5000 );
+		CHECK( times[2] - times[1]==32000 );
+		CHECK( times[3]>=times[2] );
+		CHECK( times[3] - times[2]<RDI::RecordingWriter::maxTimeStampDriftInMs * 1000ULL );
+	}
+	remove( fileName );
+}
+
+}
+
+void testRecording()
+{
+	testDroppedDisconnections();
+	testEventTimes();
+}
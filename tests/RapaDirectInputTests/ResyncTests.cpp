@@ -0,0 +1,335 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDIObject.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	Resync tests
+
+	Events of simulated devices get lost: a gap in the sequence numbers, an
+	overflow of the buffer, the input lost, an overflow right after the 
+	device got acquired again. A BatchListener mirrors the state
+	of the objects twice: from all the changes, and from the changes that 
+	come from events only. The first must match the state of the device once
+	the Device has resynchronised, while the second misses what was lost.
+*/
+namespace
+{
+
+class MirrorListener : public RDI::Device::BatchListener
+{
+public:
+	MirrorListener( const RDI::Device* device )
+		: mNumResyncChanges(0)
+	{
+		const RDI::Objects& objects = device->getObjects();
+		for ( std::size_t i=0; i<objects.size(); ++i )
+			mStates.push_back( objects[i]->getData() );
+		mEventStates = mStates;
+	}
+
+	virtual ~MirrorListener() {}
+
+	virtual void onObjectsChanged( RDI::Device* /*device*/, const RDI::ObjectChange* changes, std::size_t numChanges )
+	{
+		for ( std::size_t i=0; i<numChanges; ++i )
+		{
+			const RDI::ObjectChange& change = changes[i];
+			mStates[change.objectIndex] = change.newData;
+			if ( change.isResync )
+				++mNumResyncChanges;
+			else
+				mEventStates[change.objectIndex] = change.newData;
+		}
+	}
+
+	// Returns the number of objects whose mirrored state doesn't match the 
+	// one of the device
+	unsigned int getNumStuckObjects( const RDI::RecordedObjects& objects, bool fromEventsOnly ) const
+	{
+		const std::vector<DWORD>& states = fromEventsOnly ? mEventStates : mStates;
+		unsigned int numStuckObjects = 0;
+		for ( std::size_t i=0; i<objects.size(); ++i )
+		{
+			if ( states[i]!=objects[i].data )
+				++numStuckObjects;
+		}
+		return numStuckObjects;
+	}
+
+	std::vector<DWORD>	mStates;
+	std::vector<DWORD>	mEventStates;
+	unsigned int		mNumResyncChanges;
+};
+
+unsigned int findDevice( const RDI::SimulatedBackend& backend, const RDI::Device* device )
+{
+	for ( unsigned int i=0; i<backend.getNumDevices(); ++i )
+	{
+		if ( backend.getDeviceInstance(i)==device->getDeviceInstance() )
+			return i;
+	}
+	CHECK( false );
+	return 0;
+}
+
+// Once armed, fills the buffer of the device past its size right after it
+// got acquired again, as a busy device would before its events are read
+class BusyDeviceBackend : public RDI::DeviceBackend
+{
+public:
+	BusyDeviceBackend( RDI::DeviceBackend* deviceBackend, RDI::SimulatedBackend* backend ) 
+		: mDeviceBackend(deviceBackend), mBackend(backend), mIsArmed(false) {}
+	virtual ~BusyDeviceBackend()		{ delete mDeviceBackend; }
+	virtual bool setBufferSize( DWORD numEntries )									{ return mDeviceBackend->setBufferSize( numEntries ); }
+	virtual bool enumerateObjects( RDI::ObjectInstances& objectInstances )			{ return mDeviceBackend->enumerateObjects( objectInstances ); }
+	virtual bool setDataFormat( const RDI::DataFormat& dataFormat )					{ return mDeviceBackend->setDataFormat( dataFormat ); }
+	virtual bool getAxisRange( DWORD objectType, LONG& minValue, LONG& maxValue )	{ return mDeviceBackend->getAxisRange( objectType, minValue, maxValue ); }
+	virtual bool setObjectUserData( DWORD objectType, UINT_PTR userData )			{ return mDeviceBackend->setObjectUserData( objectType, userData ); }
+	virtual HRESULT acquire()
+	{
+		HRESULT hr = mDeviceBackend->acquire();
+		if ( hr==DI_OK && mIsArmed )
+		{
+			mIsArmed = false;
+			for ( DWORD i=1; i<=1000; ++i )
+				mBackend->setObjectData( 0, 0, i * 10 );
+			mBackend->setObjectData( 0, 2, 0x80 );
+		}
+		return hr;
+	}
+	virtual void unacquire()														{ mDeviceBackend->unacquire(); }
+	virtual HRESULT getDeviceData( LPDIDEVICEOBJECTDATA dataEntries, LPDWORD numDataEntries )	{ return mDeviceBackend->getDeviceData( dataEntries, numDataEntries ); }
+	virtual HRESULT getObjectStates( const DWORD* objectTypes, DWORD* states, std::size_t numObjects )	{ return mDeviceBackend->getObjectStates( objectTypes, states, numObjects ); }
+	virtual bool hasContiguousSequences() const										{ return mDeviceBackend->hasContiguousSequences(); }
+	RDI::DeviceBackend*		mDeviceBackend;
+	RDI::SimulatedBackend*	mBackend;
+	bool					mIsArmed;
+};
+
+class BusyBackend : public RDI::Backend
+{
+public:
+	BusyBackend( RDI::SimulatedBackend* backend ) : mBackend(backend), mDeviceBackend(NULL) {}
+	virtual void enumerateDevices( RDI::DeviceIdentifiers& deviceInstances )		{ mBackend->enumerateDevices( deviceInstances ); }
+	virtual RDI::DeviceBackend* createDeviceBackend( const RDI::DeviceInstance& deviceInstance )
+	{
+		mDeviceBackend = new BusyDeviceBackend( mBackend->createDeviceBackend( deviceInstance ), mBackend );
+		return mDeviceBackend;
+	}
+	virtual DWORD getTickCount()													{ return mBackend->getTickCount(); }
+	RDI::SimulatedBackend*	mBackend;
+	BusyDeviceBackend*		mDeviceBackend;
+};
+
+enum Loss
+{
+	SequenceGap,
+	Overflow,
+	LostInput
+};
+
+// Button 2 is pressed, but the event is lost
+void testLoss( Loss loss )
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 4, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	MirrorListener listener( device );
+	device->addBatchListener( &listener );
+
+	// An event first, so the Device knows where the sequence numbers are
+	backend.setObjectData( 0, 3, 0x80 );
+	backend.advance( 16 );
+	device->update();
+	CHECK( device->getNumResyncs()==0 );
+
+	switch ( loss )
+	{
+	case SequenceGap:
+		backend.dropEvents( 0, 1 );
+		backend.setObjectData( 0, 2, 0x80 );
+		backend.setObjectData( 0, 3, 0 );		// Shows the gap
+		break;
+	case Overflow:
+		for ( DWORD i=0; i<1000; ++i )
+			backend.setObjectData( 0, 0, i * 10 );
+		backend.setObjectData( 0, 2, 0x80 );
+		break;
+	case LostInput:
+		backend.loseInput( 0 );
+		backend.setObjectData( 0, 2, 0x80 );
+		break;
+	}
+	backend.advance( 16 );
+	device->update();
+	backend.advance( 16 );
+	device->update();
+
+	CHECK( device->getNumSequenceGaps()==(loss==SequenceGap ? 1u : 0u) );
+	CHECK( device->getNumOverflows()==(loss==Overflow ? 1u : 0u) );
+	CHECK( device->getNumResyncs()==1 );
+	CHECK( device->getNumFailedResyncs()==0 );
+	CHECK( listener.mNumResyncChanges>0 );
+	CHECK( listener.mStates[2]==0x80 );
+	CHECK( listener.mEventStates[2]==0 );
+	CHECK( listener.getNumStuckObjects( backend.getObjects(0), false )==0 );
+
+	// Nothing lost anymore, nothing to resync
+	backend.setObjectData( 0, 2, 0 );
+	backend.advance( 16 );
+	device->update();
+	CHECK( device->getNumResyncs()==1 );
+	CHECK( listener.mEventStates[2]==0 );
+	device->removeBatchListener( &listener );
+}
+
+// The buffer overflows between the acquisition of the device and the read
+// of its events. What fits in the buffer is still delivered
+void testOverflowOnReacquire()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 4, 0 );
+	BusyBackend busyBackend( &backend );
+	RDI::DeviceManager deviceManager( &busyBackend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 && busyBackend.mDeviceBackend ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	MirrorListener listener( device );
+	device->addBatchListener( &listener );
+	DWORD axisData = listener.mEventStates[0];
+
+	backend.setObjectData( 0, 3, 0x80 );
+	backend.advance( 16 );
+	device->update();
+
+	busyBackend.mDeviceBackend->mIsArmed = true;
+	backend.loseInput( 0 );
+	backend.advance( 16 );
+	device->update();
+	CHECK( !busyBackend.mDeviceBackend->mIsArmed );
+	CHECK( device->getNumOverflows()==1 );
+	CHECK( listener.mEventStates[0]!=axisData );
+
+	backend.advance( 16 );
+	device->update();
+	CHECK( device->getNumResyncs()==1 );
+	CHECK( device->getNumFailedResyncs()==0 );
+	CHECK( listener.mStates[2]==0x80 );
+	CHECK( listener.mEventStates[2]==0 );
+	CHECK( listener.getNumStuckObjects( backend.getObjects(0), false )==0 );
+	device->removeBatchListener( &listener );
+}
+
+// Busy gamepads lose events of all kinds. Once left alone, none of their 
+// objects is stuck
+void testBusyDevices()
+{
+	const unsigned int numDevices = 4;
+	const DWORD frameInMs = 16;
+
+	RDI::SimulatedBackend backend;
+	for ( unsigned int i=0; i<numDevices; ++i )
+	{
+		backend.addDevice( "Test Pad", 6, 16, 1 );
+		backend.addGenerator( i, RDI::SimulatedGenerator::buttonStorm( 200.f ) );
+		backend.addGenerator( i, RDI::SimulatedGenerator::randomWalk( 400.f, 500 ) );
+	}
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	const RDI::DeviceManager::DeviceList& devices = deviceManager.getDevices();
+	if ( !CHECK( devices.size()==numDevices ) )
+		return;
+
+	std::vector<MirrorListener*> listeners;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		listeners.push_back( new MirrorListener( devices[i].second ) );
+		devices[i].second->addBatchListener( listeners.back() );
+	}
+
+	for ( DWORD time=frameInMs; time<=10000; time+=frameInMs )
+	{
+		DWORD previousTime = time - frameInMs;
+		unsigned int deviceIndex = (time / frameInMs) % numDevices;
+		if ( time/1000!=previousTime/1000 )
+			backend.dropEvents( deviceIndex, 3 );
+		if ( time/1500!=previousTime/1500 )
+			backend.advance( 400 );
+		if ( time/2500!=previousTime/2500 )
+			backend.loseInput( deviceIndex );
+		backend.advance( frameInMs );
+		deviceManager.update();
+	}
+
+	for ( unsigned int i=0; i<numDevices; ++i )
+		backend.removeGenerators( i );
+	backend.advance( frameInMs );
+	deviceManager.update();
+
+	unsigned int numSequenceGaps = 0;
+	unsigned int numOverflows = 0;
+	unsigned int numStuckObjectsWithoutResync = 0;
+	for ( std::size_t i=0; i<devices.size(); ++i )
+	{
+		const RDI::Device* device = devices[i].second;
+		numSequenceGaps += device->getNumSequenceGaps();
+		numOverflows += device->getNumOverflows();
+		CHECK( device->getNumResyncs()>0 );
+
+		const RDI::RecordedObjects& objects = backend.getObjects( findDevice( backend, device ) );
+		CHECK( listeners[i]->getNumStuckObjects( objects, false )==0 );
+		numStuckObjectsWithoutResync += listeners[i]->getNumStuckObjects( objects, true );
+	}
+	CHECK( numSequenceGaps>0 );
+	CHECK( numOverflows>0 );
+	CHECK( numStuckObjectsWithoutResync>0 );
+
+	for ( std::size_t i=0; i<devices.size(); ++i )
+		devices[i].second->removeBatchListener( listeners[i] );
+	for ( std::size_t i=0; i<listeners.size(); ++i )
+		delete listeners[i];
+}
+
+}
+
+void testResync()
+{
+	testLoss( SequenceGap );
+	testLoss( Overflow );
+	testLoss( LostInput );
+	testOverflowOnReacquire();
+	testBusyDevices();
+}
@@ -0,0 +1,55 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#pragma once
+
+/*
+	Tests
+
+	The checks of the behaviour of the library. Each test is a function 
+	that exercises a feature (usually through a SimulatedBackend, so no 
+	device is needed) and states its expectations with CHECK(). A failed 
+	check is reported with its location and the test carries on, so a run
+	lists all the failures.
+*/
+#define CHECK( condition )		checkCondition( (condition), #condition, __FILE__, __LINE__ )
+
+// Returns the condition
+bool				checkCondition( bool condition, const char* text, const char* fileName, int line );
+unsigned int		getNumFailedChecks();
+
+// The tests
+void testAsyncListener();
+void testAxisFilter();
+void testButtonDebouncer();
+void testDataFormat();
+void testDeviceManager();
+void testDirtyObjectSet();
+void testEnumerationTrigger();
+void testListenerRegistry();
+void testObjectEnable();
+void testPollScheduler();
+void testReacquire();
+void testRecording();
+void testResync();
+void testThrottledListener();
@@ -0,0 +1,203 @@
+/*
+   The MIT License (MIT) (http://opensource.org/licenses/MIT)
+   
+   Copyright (c) 2015 Jacques Menuet
+   
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+   
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+#include "Tests.h"
+
+#include <vector>
+#include "RDIDevice.h"
+#include "RDIDeviceEnumerationTrigger.h"
+#include "RDIDeviceManager.h"
+#include "RDISimulatedBackend.h"
+
+/*
+	ThrottledListener tests
+
+	The axes of a simulated gamepad change every few milliseconds while 
+	throttled listeners, one per object and batched, look at them.
+*/
+namespace
+{
+
+const DWORD interval = 100;
+
+class CountingListener : public RDI::Device::Listener
+{
+public:
+	CountingListener() : mNumCalls(0), mLastData(0) {}
+	virtual void onObjectChanged( RDI::Device* /*device*/, RDI::Object* object )
+	{
+		++mNumCalls;
+		mLastData = object->getData();
+	}
+	unsigned int	mNumCalls;
+	DWORD			mLastData;
+};
+
+class RecordingBatchListener : public RDI::Device::BatchListener
+{
+public:
+	virtual void onObjectsChanged( RDI::Device* /*device*/, const RDI::ObjectChange* changes, std::size_t numChanges )
+	{
+		mBatches.push_back( std::vector<RDI::ObjectChange>( changes, changes + numChanges ) );
+	}
+	std::vector< std::vector<RDI::ObjectChange> >	mBatches;
+};
+
+// Sets the data of an axis, then updates the device a millisecond later
+void changeAxis( RDI::SimulatedBackend& backend, RDI::Device* device, unsigned int objectIndex, DWORD data )
+{
+	backend.setObjectData( 0, objectIndex, data );
+	backend.advance( 1 );
+	device->update();
+}
+
+void wait( RDI::SimulatedBackend& backend, RDI::Device* device, DWORD timeInMs )
+{
+	backend.advance( timeInMs );
+	device->update();
+}
+
+void testInterval()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 0, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	CountingListener listener;
+	CountingListener throttledListener;
+	device->addListener( &listener );
+	device->addListener( &throttledListener, RDI::ObjectFilter(), interval );
+
+	// The first change is notified right away, the next ones wait for the 
+	// interval and only the latest value is notified
+	changeAxis( backend, device, 0, 100 );
+	CHECK( throttledListener.mNumCalls==1 );
+	for ( DWORD i=1; i<=10; ++i )
+		changeAxis( backend, device, 0, 100 + i );
+	CHECK( listener.mNumCalls==11 );
+	CHECK( throttledListener.mNumCalls==1 );
+	wait( backend, device, interval );
+	CHECK( throttledListener.mNumCalls==2 );
+	CHECK( throttledListener.mLastData==110 );
+
+	// Nothing is notified when nothing changed
+	wait( backend, device, interval*2 );
+	CHECK( throttledListener.mNumCalls==2 );
+
+	CHECK( device->removeListener( &throttledListener ) );
+	changeAxis( backend, device, 1, 200 );
+	CHECK( throttledListener.mNumCalls==2 );
+	device->removeListeners();
+}
+
+// The pending changes are notified while the device can't be read
+void testLostDevice()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 0, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	CountingListener throttledListener;
+	RecordingBatchListener batchListener;
+	device->addListener( &throttledListener, RDI::ObjectFilter(), interval );
+	device->addBatchListener( &batchListener, interval );
+
+	changeAxis( backend, device, 0, 100 );
+	changeAxis( backend, device, 0, 150 );
+	CHECK( throttledListener.mNumCalls==1 );
+	CHECK( batchListener.mBatches.size()==1 );
+
+	backend.holdDevice( 0, true );
+	wait( backend, device, interval );
+	CHECK( throttledListener.mNumCalls==2 );
+	CHECK( throttledListener.mLastData==150 );
+	CHECK( batchListener.mBatches.size()==2 );
+	backend.holdDevice( 0, false );
+	CHECK( device->removeBatchListener( &batchListener ) );
+	device->removeListeners();
+}
+
+// A throttled BatchListener gets one change per object, with the state 
+// before its first change and after its latest one
+void testBatch()
+{
+	RDI::SimulatedBackend backend;
+	backend.addDevice( "Test Pad", 2, 0, 0 );
+	RDI::DeviceManager deviceManager( &backend, new RDI::BackendEnumerationTrigger(&backend) );
+	deviceManager.update();
+	if ( !CHECK( deviceManager.getDevices().size()==1 ) )
+		return;
+	RDI::Device* device = deviceManager.getDevices()[0].second;
+	RecordingBatchListener batchListener;
+	device->addBatchListener( &batchListener, interval );
+
+	changeAxis( backend, device, 1, 100 );
+	if ( !CHECK( batchListener.mBatches.size()==1 ) )
+		return;
+	CHECK( batchListener.mBatches[0].size()==1 );
+
+	changeAxis( backend, device, 1, 200 );
+	changeAxis( backend, device, 0, 300 );
+	changeAxis( backend, device, 1, 400 );
+	changeAxis( backend, device, 1, 500 );
+	CHECK( batchListener.mBatches.size()==1 );
+	wait( backend, device, interval );
+	if ( !CHECK( batchListener.mBatches.size()==2 ) )
+		return;
+	const std::vector<RDI::ObjectChange>& changes = batchListener.mBatches[1];
+	if ( !CHECK( changes.size()==2 ) )
+		return;
+	CHECK( changes[0].objectIndex==1 );
+	CHECK( changes[0].oldData==100 );
+	CHECK( changes[0].newData==500 );
+	CHECK( changes[1].objectIndex==0 );
+	CHECK( changes[1].newData==300 );
+	CHECK( changes[0].timeStamp>changes[1].timeStamp );
+
+	// The consolidated changes start over after the notification
+	wait( backend, device, interval );
+	CHECK( batchListener.mBatches.size()==2 );
+	changeAxis( backend, device, 0, 600 );
+	if ( !CHECK( batchListener.mBatches.size()==3 ) )
+		return;
+	CHECK( batchListener.mBatches[2].size()==1 );
+	CHECK( batchListener.mBatches[2][0].oldData==300 );
+
+	CHECK( device->removeBatchListener( &batchListener ) );
+	CHECK( !device->removeBatchListener( &batchListener ) );
+}
+
+}
+
+void testThrottledListener()
+{
+	testInterval();
+	testLostDevice();
+	testBatch();
+}